@@ -0,0 +1,197 @@
+/// file      : bench/ast.c
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Compare memory usage and traversal speed of pointer based expression
+/// trees (McExpr) and the compact index based store (McAst), on a large
+/// randomly generated comma separated list of expressions.
+
+#include <Misra/Mc/Parser/ASTNodeTypes.h>
+#include <Misra/Mc/Parser/Ast.h>
+#include <Misra/Std/Clock.h>
+#include <Misra/Std/Container/Str.h>
+#include <Misra/Std/Log.h>
+
+// platform
+#include <malloc.h>
+#include <stdlib.h>
+
+#define NITEMS    4096
+#define MAX_DEPTH 10
+#define NROUNDS   20
+
+static const char* const binary_ops[] = {"+", "-", "*", "<", "==", "&", "|", "^", "&&"};
+
+#define NBINARY_OPS (sizeof (binary_ops) / sizeof (binary_ops[0]))
+
+static void gen_expr (Str* code, u32 depth) {
+    u32 r = rand();
+    if (!depth || r % 8 == 0) {
+        if (r % 3) {
+            StrAppendf (code, "%u", r % 1000);
+        } else {
+            StrAppendf (code, "%u.5", r % 1000);
+        }
+        return;
+    }
+
+    switch (r % 16) {
+        case 0 :
+            StrAppendf (code, "-");
+            gen_expr (code, depth - 1);
+            break;
+        case 1 :
+            StrAppendf (code, "(");
+            gen_expr (code, depth - 1);
+            StrAppendf (code, " ? ");
+            gen_expr (code, depth - 1);
+            StrAppendf (code, " : ");
+            gen_expr (code, depth - 1);
+            StrAppendf (code, ")");
+            break;
+        default :
+            StrAppendf (code, "(");
+            gen_expr (code, depth - 1);
+            StrAppendf (code, " %s ", binary_ops[r % NBINARY_OPS]);
+            gen_expr (code, depth - 1);
+            StrAppendf (code, ")");
+            break;
+    }
+}
+
+
+// Heap bytes held by a pointer based tree, including allocator overhead.
+static u64 expr_bytes (McExpr* e, u64* nnodes) {
+    if (!e || e->expr_type == MC_EXPR_TYPE_INVALID) {
+        return 0;
+    }
+
+    (*nnodes)++;
+    switch (e->expr_type) {
+        case MC_EXPR_TYPE_NUM :
+        case MC_EXPR_TYPE_ID :
+            return 0;
+        case MC_EXPR_TYPE_UN_MINUS :
+            return malloc_usable_size (e->un_minus.e) + expr_bytes (e->un_minus.e, nnodes);
+        case MC_EXPR_TYPE_TERN :
+            return malloc_usable_size (e->tern.c) + expr_bytes (e->tern.c, nnodes) +
+                   malloc_usable_size (e->tern.t) + expr_bytes (e->tern.t, nnodes) +
+                   malloc_usable_size (e->tern.f) + expr_bytes (e->tern.f, nnodes);
+        case MC_EXPR_TYPE_LIST : {
+            u64 n = malloc_usable_size (e->list.data);
+            VecForeach (&e->list, xpr, {
+                n += malloc_usable_size (xpr) + expr_bytes (xpr, nnodes);
+            });
+            return n;
+        }
+        default :
+            return malloc_usable_size (e->add.l) + expr_bytes (e->add.l, nnodes) +
+                   malloc_usable_size (e->add.r) + expr_bytes (e->add.r, nnodes);
+    }
+}
+
+
+static u64 ast_bytes (McAst* ast) {
+    return ast->nodes.capacity * sizeof (McAstNode) + ast->extra.capacity * sizeof (McAstId) +
+           ast->types.capacity * sizeof (McType) + ast->values.capacity * sizeof (u64) +
+           ast->names.capacity;
+}
+
+
+int main (void) {
+    srand (1337);
+
+    Str code = {0};
+    StrInit (&code);
+    for (u32 i = 0; i < NITEMS; i++) {
+        if (i) {
+            StrAppendf (&code, ", ");
+        }
+        gen_expr (&code, MAX_DEPTH);
+    }
+    StrPushBack (&code, 0);
+
+    McParser p = {0};
+    if (!McParserInitFromZStr (&p, code.data)) {
+        LOG_ERROR ("failed to init parser.");
+        return 1;
+    }
+
+    McExpr e = {0};
+    if (!McParseExpr (&e, &p) || e.expr_type != MC_EXPR_TYPE_LIST) {
+        LOG_ERROR ("failed to parse generated code.");
+        return 1;
+    }
+
+    McAst ast = {0};
+    McAstInit (&ast);
+    McAstId root = McAstAddExpr (&ast, &e);
+    if (root == MC_AST_NONE) {
+        LOG_ERROR ("failed to copy tree to AST store.");
+        return 1;
+    }
+
+    u64 nnodes    = 0;
+    u64 ptr_bytes = expr_bytes (&e, &nnodes) + sizeof (McExpr);
+    u64 idx_bytes = ast_bytes (&ast);
+
+    printf ("code       : %zu bytes, %llu nodes\n", code.length, nnodes);
+    printf (
+        "node size  : McExpr %zu bytes, McAstNode %zu bytes\n",
+        sizeof (McExpr),
+        sizeof (McAstNode)
+    );
+    printf (
+        "memory     : pointers %llu bytes (%.1f / node), indices %llu bytes (%.1f / node)\n",
+        ptr_bytes,
+        (f64)ptr_bytes / nnodes,
+        idx_bytes,
+        (f64)idx_bytes / nnodes
+    );
+
+    // evaluate every item of list, over and over
+    McAstNode* list    = McAstNodeAt (&ast, root);
+    f64        ptr_sum = 0;
+    f64        idx_sum = 0;
+    u64        ptr_ns  = (u64)-1;
+    u64        idx_ns  = (u64)-1;
+
+    for (u32 round = 0; round < NROUNDS; round++) {
+        u64 start = ClockMonotonicNs();
+        ptr_sum   = 0;
+        VecForeach (&e.list, xpr, { ptr_sum += McExprEval (xpr); });
+        u64 end = ClockMonotonicNs();
+        if (end - start < ptr_ns) {
+            ptr_ns = end - start;
+        }
+
+        start   = ClockMonotonicNs();
+        idx_sum = 0;
+        for (u32 i = 0; i < list->b; i++) {
+            idx_sum += McAstEval (&ast, VecAt (&ast.extra, list->a + i));
+        }
+        end = ClockMonotonicNs();
+        if (end - start < idx_ns) {
+            idx_ns = end - start;
+        }
+    }
+
+    printf (
+        "traversal  : pointers %.2f ns / node, indices %.2f ns / node (best of %d)\n",
+        (f64)ptr_ns / nnodes,
+        (f64)idx_ns / nnodes,
+        NROUNDS
+    );
+
+    if (ptr_sum != idx_sum) {
+        LOG_ERROR ("evaluation mismatch : %lf != %lf.", ptr_sum, idx_sum);
+        return 1;
+    }
+
+    McAstDeinit (&ast);
+    McExprDeinit (&e);
+    McParserDeinit (&p);
+    StrDeinit (&code);
+
+    return 0;
+}
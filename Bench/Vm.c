@@ -0,0 +1,409 @@
+/// file      : bench/vm.c
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Compare evaluation speed of recursive tree walk (McExprEval), stack
+/// machine (McBytecode), register machine (McRegCode) and native code
+/// (McJit), on many randomly generated expressions, each evaluated with a
+/// few different inputs, and of native code with same expression compiled
+/// by C compiler. Tree walk is timed once more after constant folding
+/// (McExprFold).
+
+#include <Misra/Mc/Parser/ASTNodeTypes.h>
+#include <Misra/Mc/Vm/Bytecode.h>
+#include <Misra/Mc/Vm/Jit.h>
+#include <Misra/Mc/Vm/Register.h>
+#include <Misra/Std/Clock.h>
+#include <Misra/Std/Container/Str.h>
+#include <Misra/Std/Log.h>
+
+// platform
+#include <stdlib.h>
+
+#define NITEMS    1024
+#define MAX_DEPTH 8
+#define NROUNDS   10
+#define NINPUTS   16
+
+static const char* const binary_ops[] =
+    {"+", "-", "*", "/", "<", "<=", "==", "!=", "&", "|", "^", ">>", "<<", "&&", "||"};
+
+#define NBINARY_OPS (sizeof (binary_ops) / sizeof (binary_ops[0]))
+
+static void gen_expr (Str* code, u32 depth) {
+    u32 r = rand();
+    if (!depth || r % 6 == 0) {
+        switch (r % 5) {
+            case 0 :
+                StrAppendf (code, "x");
+                break;
+            case 1 :
+                StrAppendf (code, "y");
+                break;
+            case 2 :
+                StrAppendf (code, "%u.5", r % 100);
+                break;
+            default :
+                StrAppendf (code, "%u", r % 100);
+                break;
+        }
+        return;
+    }
+
+    switch (r % 16) {
+        case 0 :
+            StrAppendf (code, "-");
+            gen_expr (code, depth - 1);
+            break;
+        case 1 :
+            StrAppendf (code, "(");
+            gen_expr (code, depth - 1);
+            StrAppendf (code, " < ");
+            gen_expr (code, depth - 1);
+            StrAppendf (code, " ? ");
+            gen_expr (code, depth - 1);
+            StrAppendf (code, " : ");
+            gen_expr (code, depth - 1);
+            StrAppendf (code, ")");
+            break;
+        case 2 :
+            StrAppendf (code, "((");
+            gen_expr (code, depth - 1);
+            StrAppendf (code, " >> %u) & %u)", r % 8, r % 255);
+            break;
+        default :
+            StrAppendf (code, "(");
+            gen_expr (code, depth - 1);
+            StrAppendf (code, " %s ", binary_ops[r % NBINARY_OPS]);
+            gen_expr (code, depth - 1);
+            StrAppendf (code, ")");
+            break;
+    }
+}
+
+
+static u64 count_nodes (McExpr* e) {
+    if (!e) {
+        return 0;
+    }
+
+    switch (e->expr_type) {
+        case MC_EXPR_TYPE_NUM :
+        case MC_EXPR_TYPE_ID :
+            return 1;
+        case MC_EXPR_TYPE_UN_MINUS :
+        case MC_EXPR_TYPE_IN_PARENS :
+            return 1 + count_nodes (e->un_minus.e);
+        case MC_EXPR_TYPE_TERN :
+            return 1 + count_nodes (e->tern.c) + count_nodes (e->tern.t) + count_nodes (e->tern.f);
+        default :
+            return 1 + count_nodes (e->add.l) + count_nodes (e->add.r);
+    }
+}
+
+
+// Expression compiled by C compiler, to compare native code with.
+#define C_EXPR_STR "x * x * 0.5 + y * 3 - (x < y ? x / y : y / x)"
+
+static __attribute__ ((noinline)) f64 c_expr (const f64* in) {
+    f64 x = in[0];
+    f64 y = in[1];
+    return x * x * 0.5 + y * 3 - (x < y ? x / y : y / x);
+}
+
+
+// Best time of NROUNDS evaluations of `C_EXPR_STR`, in ns per evaluation.
+static f64 time_c_expr (McJit* jit, bool native, f64* sum) {
+    f64 in[2]  = {0};
+    u64 x_idx  = native ? McJitFindInput (jit, "x") : 0;
+    u64 y_idx  = native ? McJitFindInput (jit, "y") : 1;
+    u64 best   = (u64)-1;
+    u32 nevals = 1 << 20;
+
+    for (u32 round = 0; round < NROUNDS; round++) {
+        u64 start = ClockMonotonicNs();
+        for (u32 idx = 0; idx < nevals; idx++) {
+            in[x_idx] = idx;
+            in[y_idx] = 1.5;
+            *sum     += native ? McJitEval (jit, in) : c_expr (in);
+        }
+        u64 end = ClockMonotonicNs();
+        if (end - start < best) {
+            best = end - start;
+        }
+    }
+
+    return (f64)best / nevals;
+}
+
+
+// Put value of "x" and "y" for given round into inputs of a compiled expression.
+static void set_inputs (f64* in, u64 x_idx, u64 y_idx, u32 round) {
+    if (x_idx != (u64)-1) {
+        in[x_idx] = round;
+    }
+    if (y_idx != (u64)-1) {
+        in[y_idx] = round * 0.25 + 1;
+    }
+}
+
+
+int main (void) {
+    srand (1337);
+
+    Str code = {0};
+    StrInit (&code);
+    for (u32 i = 0; i < NITEMS; i++) {
+        if (i) {
+            StrAppendf (&code, ", ");
+        }
+        gen_expr (&code, MAX_DEPTH);
+    }
+    StrPushBack (&code, 0);
+
+    McParser p = {0};
+    if (!McParserInitFromZStr (&p, code.data)) {
+        LOG_ERROR ("failed to init parser.");
+        return 1;
+    }
+
+    McExpr e = {0};
+    if (!McParseExpr (&e, &p) || e.expr_type != MC_EXPR_TYPE_LIST) {
+        LOG_ERROR ("failed to parse generated code.");
+        return 1;
+    }
+
+    // compile every item of list on it's own
+    u64         nitems = e.list.length;
+    McBytecode* bcs    = calloc (nitems, sizeof (McBytecode));
+    McRegCode*  rcs    = calloc (nitems, sizeof (McRegCode));
+    McJit*      jits   = calloc (nitems, sizeof (McJit));
+    if (!bcs || !rcs || !jits) {
+        LOG_ERROR ("failed to allocate compiled expressions.");
+        return 1;
+    }
+
+    u64 nnodes   = 0;
+    u64 bc_size  = 0;
+    u64 rc_size  = 0;
+    u64 jit_size = 0;
+    for (u64 idx = 0; idx < nitems; idx++) {
+        McExpr* xpr = VecAt (&e.list, idx);
+        if (!McBytecodeCompile (bcs + idx, xpr) || !McRegCodeCompile (rcs + idx, xpr) ||
+            !McJitCompile (jits + idx, xpr)) {
+            LOG_ERROR ("failed to compile item %llu.", idx);
+            return 1;
+        }
+        nnodes   += count_nodes (xpr);
+        bc_size  += bcs[idx].code.length;
+        rc_size  += rcs[idx].code.length;
+        jit_size += jits[idx].size;
+    }
+
+    printf ("code       : %zu bytes, %llu items, %llu nodes\n", code.length, nitems, nnodes);
+    printf (
+        "compiled   : bytecode %llu bytes, register %llu instructions (%llu bytes)\n",
+        bc_size,
+        rc_size,
+        rc_size * sizeof (McRegInsn)
+    );
+    printf ("native     : %llu bytes mapped%s\n", jit_size, jits->code ? "" : " (interpreted)");
+
+    // dynamic instruction counts over all inputs, checking on the way that all
+    // machines agree, which they must do exactly, NaNs included
+    McRegStats stats = {0};
+    f64        in[2] = {0};
+    for (u32 round = 0; round < NINPUTS; round++) {
+        for (u64 idx = 0; idx < nitems; idx++) {
+            McRegCode* rc = rcs + idx;
+            set_inputs (in, McRegCodeFindInput (rc, "x"), McRegCodeFindInput (rc, "y"), round);
+            f64 rv = McRegCodeEvalCounted (rc, in, &stats);
+
+            McBytecode* bc = bcs + idx;
+            set_inputs (in, McBytecodeFindInput (bc, "x"), McBytecodeFindInput (bc, "y"), round);
+            f64 bv = McBytecodeEval (bc, in);
+            f64 jv = McJitEval (jits + idx, in);
+            if ((rv != bv && (rv == rv || bv == bv)) || (rv != jv && (rv == rv || jv == jv))) {
+                LOG_ERROR ("evaluation mismatch in item %llu : %lf, %lf, %lf.", idx, bv, rv, jv);
+                return 1;
+            }
+        }
+    }
+    printf (
+        "dispatches : tree %.1f nodes, register %.1f instructions (%.1f%% super) per item\n",
+        (f64)nnodes / nitems,
+        (f64)stats.ninsns / (nitems * NINPUTS),
+        100.0 * stats.nsuper / stats.ninsns
+    );
+
+    // find inputs once, outside of timed loops
+    u64* bc_x = calloc (nitems * 4, sizeof (u64));
+    if (!bc_x) {
+        LOG_ERROR ("failed to allocate input indices.");
+        return 1;
+    }
+    u64* bc_y = bc_x + nitems;
+    u64* rc_x = bc_y + nitems;
+    u64* rc_y = rc_x + nitems;
+    for (u64 idx = 0; idx < nitems; idx++) {
+        bc_x[idx] = McBytecodeFindInput (bcs + idx, "x");
+        bc_y[idx] = McBytecodeFindInput (bcs + idx, "y");
+        rc_x[idx] = McRegCodeFindInput (rcs + idx, "x");
+        rc_y[idx] = McRegCodeFindInput (rcs + idx, "y");
+    }
+
+    f64 tree_sum = 0;
+    f64 bc_sum   = 0;
+    f64 rc_sum   = 0;
+    f64 jit_sum  = 0;
+    u64 tree_ns  = (u64)-1;
+    u64 bc_ns    = (u64)-1;
+    u64 rc_ns    = (u64)-1;
+    u64 jit_ns   = (u64)-1;
+
+    for (u32 round = 0; round < NROUNDS; round++) {
+        // tree walk has no inputs, identifiers are always 0
+        u64 start = ClockMonotonicNs();
+        tree_sum  = 0;
+        for (u32 input = 0; input < NINPUTS; input++) {
+            VecForeach (&e.list, xpr, { tree_sum += McExprEval (xpr); });
+        }
+        u64 end = ClockMonotonicNs();
+        if (end - start < tree_ns) {
+            tree_ns = end - start;
+        }
+
+        start  = ClockMonotonicNs();
+        bc_sum = 0;
+        for (u32 input = 0; input < NINPUTS; input++) {
+            for (u64 idx = 0; idx < nitems; idx++) {
+                set_inputs (in, bc_x[idx], bc_y[idx], input);
+                bc_sum += McBytecodeEval (bcs + idx, in);
+            }
+        }
+        end = ClockMonotonicNs();
+        if (end - start < bc_ns) {
+            bc_ns = end - start;
+        }
+
+        start  = ClockMonotonicNs();
+        rc_sum = 0;
+        for (u32 input = 0; input < NINPUTS; input++) {
+            for (u64 idx = 0; idx < nitems; idx++) {
+                set_inputs (in, rc_x[idx], rc_y[idx], input);
+                rc_sum += McRegCodeEval (rcs + idx, in);
+            }
+        }
+        end = ClockMonotonicNs();
+        if (end - start < rc_ns) {
+            rc_ns = end - start;
+        }
+
+        // native code takes inputs in same order as register code it's made from
+        start   = ClockMonotonicNs();
+        jit_sum = 0;
+        for (u32 input = 0; input < NINPUTS; input++) {
+            for (u64 idx = 0; idx < nitems; idx++) {
+                set_inputs (in, rc_x[idx], rc_y[idx], input);
+                jit_sum += McJitEval (jits + idx, in);
+            }
+        }
+        end = ClockMonotonicNs();
+        if (end - start < jit_ns) {
+            jit_ns = end - start;
+        }
+    }
+
+    u64 nevals = nitems * NINPUTS;
+    printf (
+        "evaluation : tree %.1f ns, bytecode %.1f ns, register %.1f ns, native %.1f ns per item "
+        "(best of %d)\n",
+        (f64)tree_ns / nevals,
+        (f64)bc_ns / nevals,
+        (f64)rc_ns / nevals,
+        (f64)jit_ns / nevals,
+        NROUNDS
+    );
+
+    // printed so that evaluations can't be optimized out
+    printf (
+        "sums       : tree %g, bytecode %g, register %g, native %g\n",
+        tree_sum,
+        bc_sum,
+        rc_sum,
+        jit_sum
+    );
+
+    // one small expression, against C compiler
+    McParser cp = {0};
+    McExpr   ce = {0};
+    McJit    cj = {0};
+    if (!McParserInitFromZStr (&cp, C_EXPR_STR) || !McParseExpr (&ce, &cp) ||
+        !McJitCompile (&cj, &ce)) {
+        LOG_ERROR ("failed to compile \"%s\".", C_EXPR_STR);
+        return 1;
+    }
+    f64 c_sum  = 0;
+    f64 cj_sum = 0;
+    f64 c_ns   = time_c_expr (&cj, false, &c_sum);
+    f64 cj_ns  = time_c_expr (&cj, true, &cj_sum);
+    printf (
+        "%s : C %.1f ns, native %.1f ns (sums %g, %g)\n",
+        C_EXPR_STR,
+        c_ns,
+        cj_ns,
+        c_sum,
+        cj_sum
+    );
+    McJitDeinit (&cj);
+    McExprDeinit (&ce);
+    McParserDeinit (&cp);
+
+    // same code folded as it's parsed, walked by tree evaluator again
+    McParser fp = {0};
+    McExpr   fe = {0};
+    if (!McParserInitFromZStr (&fp, code.data) || !McParserEnableFolding (&fp) ||
+        !McParseExpr (&fe, &fp)) {
+        LOG_ERROR ("failed to parse generated code with folding.");
+        return 1;
+    }
+    u64 fold_nodes = 0;
+    VecForeach (&fe.list, xpr, { fold_nodes += count_nodes (xpr); });
+
+    f64 fold_sum = 0;
+    u64 fold_ns  = (u64)-1;
+    for (u32 round = 0; round < NROUNDS; round++) {
+        u64 start = ClockMonotonicNs();
+        fold_sum  = 0;
+        for (u32 input = 0; input < NINPUTS; input++) {
+            VecForeach (&fe.list, xpr, { fold_sum += McExprEval (xpr); });
+        }
+        u64 end = ClockMonotonicNs();
+        if (end - start < fold_ns) {
+            fold_ns = end - start;
+        }
+    }
+    printf (
+        "folded     : %llu nodes, tree %.1f ns per item (sum %g)\n",
+        fold_nodes,
+        (f64)fold_ns / nevals,
+        fold_sum
+    );
+    McExprDeinit (&fe);
+    McParserDeinit (&fp);
+
+    for (u64 idx = 0; idx < nitems; idx++) {
+        McBytecodeDeinit (bcs + idx);
+        McRegCodeDeinit (rcs + idx);
+        McJitDeinit (jits + idx);
+    }
+    free (bc_x);
+    free (bcs);
+    free (rcs);
+    free (jits);
+    McExprDeinit (&e);
+    McParserDeinit (&p);
+    StrDeinit (&code);
+
+    return 0;
+}
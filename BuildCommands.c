@@ -6,7 +6,9 @@ SELF_START ({
         "misra_std",
         SOURCES (
             "Source/Misra/Std/Log.c",
+            "Source/Misra/Std/Clock.c",
             "Source/Misra/Std/File.c",
+            "Source/Misra/Std/Arena.c",
             "Source/Misra/Std/Container/Vec.c",
             "Source/Misra/Std/Container/Str.c"
         ),
@@ -14,10 +16,48 @@ SELF_START ({
         FLAGS ("-ggdb -fPIC -Og")
     );
 
+    // Perfect hash table of keywords, included by lexer
+    ADD_EXECUTABLE (
+        "gen_keyword_hash",
+        SOURCES ("Tools/GenKeywordHash.c"),
+        LIBRARIES ("misra_std"),
+        FLAGS ("-ggdb -fPIC -Og")
+    );
+
+    ADD_GENERATED_FILE (
+        BUILD_GEN_DIR "/Misra/Mc/Parser/KeywordTable.h",
+        "gen_keyword_hash",
+        SOURCES ("Source/Misra/Mc/Parser/Keywords.in")
+    );
+
+    // Powers of five for correctly rounded float literals
+    ADD_EXECUTABLE (
+        "gen_pow5_table",
+        SOURCES ("Tools/GenPow5Table.c"),
+        LIBRARIES ("misra_std"),
+        FLAGS ("-ggdb -fPIC -Og")
+    );
+
+    ADD_GENERATED_FILE (BUILD_GEN_DIR "/Misra/Mc/Parser/Pow5Table.h", "gen_pow5_table", NO_INPUTS);
+
     // Modern C Library
     ADD_LIBRARY (
         "misra_mc",
-        SOURCES ("Source/Misra/Mc/Parser/ASTNodeTypes.c"),
+        SOURCES (
+            "Source/Misra/Mc/Parser/Lexer.c",
+            "Source/Misra/Mc/Parser/LineIndex.c",
+            "Source/Misra/Mc/Parser/Literal.c",
+            "Source/Misra/Mc/Parser/ASTNodeTypes.c",
+            "Source/Misra/Mc/Parser/Ast.c",
+            "Source/Misra/Mc/Parser/Document.c",
+            "Source/Misra/Mc/Parser/Split.c",
+            "Source/Misra/Mc/Parser/Fold.c",
+            "Source/Misra/Mc/Parser/Value.c",
+            "Source/Misra/Mc/Vm/Bytecode.c",
+            "Source/Misra/Mc/Vm/Register.c",
+            "Source/Misra/Mc/Vm/Jit.c",
+            "Source/Misra/Mc/Driver.c"
+        ),
         LIBRARIES ("misra_std"),
         FLAGS ("-ggdb -fpic -Og")
     );
@@ -30,10 +70,61 @@ SELF_START ({
         FLAGS ("-ggdb -fPIC -Og")
     );
     
+    ADD_EXECUTABLE (
+        "log_decode",
+        SOURCES ("Tools/LogDecode.c"),
+        LIBRARIES ("misra_std"),
+        FLAGS ("-ggdb -fPIC -Og")
+    );
+
+    // Pointer vs index based AST, run by hand
+    ADD_EXECUTABLE (
+        "ast_bench",
+        SOURCES ("Bench/Ast.c"),
+        LIBRARIES ("misra_std", "misra_mc"),
+        FLAGS ("-ggdb -fPIC -Og")
+    );
+
+    // Tree walk vs bytecode vs register machine, run by hand
+    ADD_EXECUTABLE (
+        "vm_bench",
+        SOURCES ("Bench/Vm.c"),
+        LIBRARIES ("misra_std", "misra_mc"),
+        FLAGS ("-ggdb -fPIC -Og")
+    );
+
     ADD_EXECUTABLE (
         "expr_test",
         SOURCES ("Test/Expr.c"),
         LIBRARIES ("misra_std", "misra_mc"),
         FLAGS ("-ggdb -fPIC -Og")
     );
+
+    ADD_EXECUTABLE (
+        "file_test",
+        SOURCES ("Test/File.c"),
+        LIBRARIES ("misra_std"),
+        FLAGS ("-ggdb -fPIC -Og")
+    );
+
+    ADD_EXECUTABLE (
+        "clock_test",
+        SOURCES ("Test/Clock.c"),
+        LIBRARIES ("misra_std"),
+        FLAGS ("-ggdb -fPIC -Og")
+    );
+
+    ADD_EXECUTABLE (
+        "log_test",
+        SOURCES ("Test/Log.c"),
+        LIBRARIES ("misra_std"),
+        FLAGS ("-ggdb -fPIC -Og")
+    );
+
+    ADD_EXECUTABLE (
+        "watch_test",
+        SOURCES ("Test/Watch.c"),
+        NO_LIBRARIES,
+        FLAGS ("-ggdb -fPIC -Og")
+    );
 });
@@ -0,0 +1,74 @@
+/// file      : misra/mc/driver.h
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Front-end driver, to read, lex and parse many source files at once on a
+/// pool of worker threads.
+
+#ifndef MISRA_MODERN_C_DRIVER_H
+#define MISRA_MODERN_C_DRIVER_H
+
+#include <Misra/Types.h>
+
+/// Most worker threads `McDriverCheckFiles` ever uses.
+#define MC_DRIVER_MAX_THREADS 64
+
+///
+/// Result of front-end run over a single file.
+///
+typedef struct McFileResult {
+    /// Index of file in list of files given to driver.
+    u64 index;
+
+    /// Path of file, as given to driver.
+    const char* path;
+
+    /// Whether file was read, and every top level item in it is valid.
+    bool ok;
+
+    /// Number of bytes in file.
+    u64 nbytes;
+
+    /// Number of top level items, and how many of them are invalid.
+    u64 nitems;
+    u64 ninvalid;
+
+    /// Null-terminated description of first problem in file, NULL if `ok`.
+    const char* message;
+} McFileResult;
+
+///
+/// Called for every file, in same order as files were given, no matter in
+/// what order workers finish them. Always called on thread that called
+/// `McDriverCheckFiles`, so it needs no locking.
+///
+/// result[in]    : Result of file. Valid only till callback returns.
+/// user_data[in] : Same as given to `McDriverCheckFiles`.
+///
+typedef void (*McDriverReport) (const McFileResult* result, void* user_data);
+
+///
+/// Read, lex and parse given files, spread over a pool of worker threads.
+/// Each worker takes next unchecked file as soon as it's done with last one,
+/// so that a few large files don't hold up the rest. Results are reported
+/// as soon as all files before them are reported.
+///
+/// paths[in]     : Paths of files to check.
+/// npaths[in]    : Number of paths.
+/// nthreads[in]  : Number of worker threads. If 0, one per online CPU.
+///                 Never more than `MC_DRIVER_MAX_THREADS`.
+/// report[in]    : Callback to report result of each file to.
+/// user_data[in] : Passed on to `report` as is.
+///
+/// SUCCESS : Number of files that are not ok.
+/// FAILURE : (u64)-1, if driver itself failed. No file is reported then.
+///
+u64 McDriverCheckFiles (
+    const char* const* paths,
+    u64                npaths,
+    u32                nthreads,
+    McDriverReport     report,
+    void*              user_data
+);
+
+#endif // MISRA_MODERN_C_DRIVER_H
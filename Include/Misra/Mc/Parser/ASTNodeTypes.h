@@ -7,6 +7,9 @@
 #ifndef MISRA_MODERN_C_PARSER_AST_NODE_TYPES_H
 #define MISRA_MODERN_C_PARSER_AST_NODE_TYPES_H
 
+#include <Misra/Mc/Parser/Lexer.h>
+#include <Misra/Mc/Parser/LineIndex.h>
+#include <Misra/Std/Arena.h>
 #include <Misra/Std/Container/Str.h>
 #include <Misra/Types.h>
 
@@ -59,9 +62,139 @@ typedef struct McType {
     };
 } McType;
 
+///
+/// Streaming input state of a McParser.
+///
+/// When active, `McParser.code` is not the complete source but a fixed size
+/// window over it. More bytes are pulled from `fd` in chunks as the parser
+/// reads past the end of window, and already consumed bytes are dropped from
+/// the front of window with `McParserStreamCommit`.
+///
+typedef struct McParserStream {
+    /// Is this parser reading from a stream?
+    bool active;
+
+    /// Has the stream reached end of file?
+    bool eof;
+
+    /// File descriptor to pull chunks from.
+    int fd;
+
+    /// Offset of first byte of window in complete stream.
+    u64 base;
+
+    /// Maximum number of bytes window can hold.
+    u64 window_size;
+} McParserStream;
+
+typedef struct McParserMemoEntry McParserMemoEntry;
+
+///
+/// Packrat memoization state of a McParser.
+///
+/// When active, failures of expression rules and results of type rules are
+/// remembered by (rule, token index), so that no rule is ever tried twice at
+/// the same token, no matter how the parser backtracks. Successful
+/// expressions aren't remembered, because every AST node has exactly one
+/// owner and can't be handed out twice.
+///
+/// All entries live in a fixed size hash table allocated from `arena`, sized
+/// from a memory budget. When the table fills up, all entries are evicted at
+/// once and memoization starts over.
+///
+typedef struct McParserMemo {
+    /// Is packrat mode enabled?
+    bool active;
+
+    /// Storage for `slots`.
+    Arena arena;
+
+    /// Open addressing hash table of entries.
+    McParserMemoEntry* slots;
+
+    /// Number of slots in table, always a power of two.
+    u64 nslots;
+
+    /// Number of occupied slots.
+    u64 nentries;
+
+    /// Number of lookups answered from table.
+    u64 hits;
+
+    /// Number of lookups that had to run the rule.
+    u64 misses;
+
+    /// Number of times table was full and got cleared.
+    u64 evictions;
+} McParserMemo;
+
+///
+/// A problem found in code by a parser in error recovery mode.
+///
+typedef struct McDiagnostic {
+    /// Offset of first byte of offending token from start of code.
+    u64 offset;
+
+    /// 1-based line and column of offending token, 0 if not known.
+    u64 line;
+    u64 column;
+
+    /// Description of problem.
+    Str message;
+} McDiagnostic;
+
+typedef Vec (McDiagnostic) McDiagnosticVec;
+
+/// Default for most diagnostics a parser collects before it gives up.
+#define MC_PARSER_DEFAULT_MAX_DIAGNOSTICS 100
+
+///
+/// Error recovery (panic mode) state of a McParser.
+///
+/// When active, `McParseProgram` doesn't stop at first top level item it
+/// can't parse. It records a diagnostic, skips tokens up to next
+/// synchronisation token (a ";" or "}", which are skipped too, or a type
+/// name or qualifier starting next item), and goes on parsing. Skipped tokens
+/// are never looked at again, so recovery costs at most one pass over code.
+///
+typedef struct McParserRecovery {
+    /// Is error recovery enabled?
+    bool active;
+
+    /// All problems found, in order of their offset.
+    McDiagnosticVec diagnostics;
+
+    /// Parsing stops after this many diagnostics.
+    u64 max_diagnostics;
+
+    /// Number of tokens skipped to resynchronise.
+    u64 skipped;
+} McParserRecovery;
+
 typedef struct McParser {
-    Str         code;
-    const char* read_pos;
+    Str code;
+
+    /// Tokens of `code`, lexed lazily as parser reads ahead.
+    McLexer lexer;
+
+    /// Index of next token to be parsed in `lexer.tokens`.
+    u64 tok;
+
+    /// One past index of last token parser has looked at. Tells how far a
+    /// rule peeked ahead, to know what to parse again when tokens change.
+    u64 peek_end;
+
+    McParserStream stream;
+
+    McParserMemo memo;
+
+    McParserRecovery recovery;
+
+    /// Fold expressions as they are parsed, see `McParserEnableFolding`.
+    bool fold;
+
+    /// Line starts of code, scanned on first `McParserLocate`.
+    McLineIndex lines;
 } McParser;
 
 ///
@@ -98,6 +231,98 @@ McParser* McParserInitFromFile (McParser* p, const char* src_name);
 ///
 McParser* McParserInitFromZStr (McParser* p, const char* code);
 
+///
+/// Initialize a new Modern C Parser object to read code in chunks from given
+/// file descriptor (a file, a pipe, stdin, etc...) instead of loading
+/// complete source in memory at once.
+///
+/// Only `window_size` bytes are ever kept in memory. A single top level item
+/// (and the lookahead required to parse it) must fit in the window, otherwise
+/// parsing of that item fails. Peak memory usage is hence independent of
+/// total input size.
+///
+/// p[out]          : Reference to McParser object to be initialized.
+/// fd[in]          : File descriptor to read code from. Not closed by parser.
+/// window_size[in] : Max number of bytes of code to hold in memory at once.
+///                   If 0, then a default window size is used.
+///
+/// SUCCESS : `p`
+/// FAILURE : `NULL`
+///
+McParser* McParserInitFromFd (McParser* p, int fd, u64 window_size);
+
+///
+/// Enable packrat memoization mode (see `McParserMemo`) for given parser.
+/// This bounds parse time on adversarial input to linear, at the cost of a
+/// fixed amount of memory.
+///
+/// p[in,out]  : McParser object to enable memoization for.
+/// budget[in] : Max number of bytes memo table may use. If 0, then a default
+///              budget is used.
+///
+/// SUCCESS : `p`
+/// FAILURE : `NULL`
+///
+McParser* McParserEnableMemo (McParser* p, u64 budget);
+
+///
+/// Enable error recovery mode (see `McParserRecovery`) for given parser, so
+/// that a single run collects diagnostics for all errors in code.
+///
+/// p[in,out]           : McParser object to enable error recovery for.
+/// max_diagnostics[in] : Most diagnostics to collect before giving up. If 0,
+///                       then `MC_PARSER_DEFAULT_MAX_DIAGNOSTICS`.
+///
+/// SUCCESS : `p`
+/// FAILURE : `NULL`
+///
+McParser* McParserEnableRecovery (McParser* p, u64 max_diagnostics);
+
+///
+/// Enable constant folding (see `McExprFold`) of every expression
+/// `McParseExpr` returns, so that expressions evaluated many times don't
+/// compute their constant parts every time.
+///
+/// p[in,out] : McParser object to enable folding for.
+///
+/// SUCCESS : `p`
+/// FAILURE : `NULL`
+///
+McParser* McParserEnableFolding (McParser* p);
+
+///
+/// Drop all code before current read position from memory, making space
+/// for more input to be read in a streaming parser. This invalidates all
+/// pointers into parser code, so no rewind to a position before current read
+/// position must be possible after this call. It's safe to commit between two
+/// top level items.
+///
+/// For non-streaming parsers this is a no-op.
+///
+/// p[in,out] : McParser object to commit read position of.
+///
+/// SUCCESS : `p`
+/// FAILURE : `NULL`
+///
+McParser* McParserStreamCommit (McParser* p);
+
+///
+/// Get line and column of a byte of code, usually `McExpr.offset` of some
+/// expression, for diagnostics. Line starts are found on first call, and
+/// only for code that wasn't looked at by a previous call.
+///
+/// For streaming parsers, only bytes still in window can be located.
+///
+/// p[in,out]   : McParser object code was parsed with.
+/// offset[in]  : Offset of byte from start of code.
+/// line[out]   : 1-based line number.
+/// column[out] : 1-based column number, in bytes.
+///
+/// SUCCESS : true
+/// FAILURE : false, if offset is not in code.
+///
+bool McParserLocate (McParser* p, u64 offset, u64* line, u64* column);
+
 typedef enum McExprType {
     MC_EXPR_TYPE_INVALID = 0,
     MC_EXPR_TYPE_ADD,
@@ -172,6 +397,10 @@ typedef Vec (McExpr*) McExprVec;
 struct McExpr {
     McExprType expr_type;
 
+    /// Offset of first byte of expression from start of code, see `McParserLocate`.
+    /// Wraps around for streams longer than 4 GiB.
+    u32 offset;
+
     union {
         struct {
             McExpr* l;
@@ -201,10 +430,19 @@ struct McExpr {
 
         struct {
             bool is_int;
-            union {
-                u64 i;
-                f64 f;
-            };
+
+            /// Integer was written in hexadecimal, which C types differently.
+            bool is_hex;
+
+            /// Type of a value computed by `McExprFold`. Zero for literals, which
+            /// are typed from their value and radix.
+            McBasicType type;
+
+            /// Value, in `i` if `is_int` and in `f` otherwise. Evaluators have no
+            /// signed integers, so a folded integer that is negative is in `f` for
+            /// them, and keeps it's exact value in `i`.
+            u64 i;
+            f64 f;
         } num;
     };
 };
@@ -212,6 +450,9 @@ struct McExpr {
 ///
 /// Traverse the expression tree recursively and evaluate the value.
 ///
+/// Every value is a `f64`, so integers above 2^53 are rounded. See
+/// `McExprEvalValue` for evaluation with exact integers and C types.
+///
 /// expr[in] : Expression tree to be evaluated
 ///
 /// RETURN : evaluated value
@@ -258,6 +499,14 @@ typedef struct McProgram {
 /// Try to parse a program from the code string in `p`
 /// object.
 ///
+/// For streaming parsers, code is committed after every top level item,
+/// so on failure p is left at the point of failure instead of being
+/// restored.
+///
+/// In error recovery mode (see `McParserEnableRecovery`), parsing goes on
+/// past errors and p is left at end of code (or where too many errors were
+/// found), with all errors in `p->recovery.diagnostics`.
+///
 /// prog[out]   : AST generated after parsing is successful.
 /// p[in,out] : McParser object containing code to be parsed.
 ///
@@ -0,0 +1,123 @@
+/// file      : misra/mc/ast.h
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Compact, index based store for expression trees. All nodes of all trees
+/// live in one flat array and refer to their children by 32-bit index instead
+/// of by pointer. Everything that does not fit in a node (lists, third child
+/// of a ternary, cast types, number values and names) is kept out of line in
+/// separate arrays, so that every node has the same small size.
+
+#ifndef MISRA_MODERN_C_PARSER_AST_H
+#define MISRA_MODERN_C_PARSER_AST_H
+
+#include <Misra/Mc/Parser/ASTNodeTypes.h>
+#include <Misra/Std/Container/Str.h>
+#include <Misra/Std/Container/Vec.h>
+#include <Misra/Types.h>
+
+///
+/// Handle of a node in a McAst. Handles are indices into `McAst.nodes` and
+/// stay valid as the store grows.
+///
+typedef u32 McAstId;
+
+/// Handle of no node. Node at this index always exists and is invalid.
+#define MC_AST_NONE ((McAstId)0)
+
+///
+/// A single node. Meaning of `a` and `b` depends on `expr_type` :
+///
+/// - binary operators, assignments, call, subscript, member access :
+///   `a` and `b` are left and right children.
+/// - unary operators, postfix operators, parens, sizeof, alignof :
+///   `a` is the only child, `b` is unused.
+/// - cast : `a` is the child, `b` is index of type in `McAst.types`.
+/// - ternary : `a` is the condition, `McAst.extra[b]` and `McAst.extra[b + 1]`
+///   are true and false branches.
+/// - list : items are `McAst.extra[a]` to `McAst.extra[a + b - 1]`.
+/// - identifier : name is `b` bytes at offset `a` in `McAst.names`.
+/// - number : `a` is index of value in `McAst.values`, `b` is non-zero for integers.
+///   Values are bits of an `u64` for integers, and of an `f64` otherwise.
+///
+typedef struct McAstNode {
+    McExprType expr_type;
+
+    /// Same as `McExpr.offset`.
+    u32 offset;
+
+    u32 a;
+    u32 b;
+} McAstNode;
+
+typedef struct McAst {
+    /// All nodes, children always before their parent.
+    Vec (McAstNode) nodes;
+
+    /// Node handles of lists and ternaries.
+    Vec (McAstId) extra;
+
+    /// Types of casts.
+    Vec (McType) types;
+
+    /// Values of numbers.
+    Vec (u64) values;
+
+    /// Names of identifiers, one after another.
+    Str names;
+} McAst;
+
+///
+/// Initialize an empty AST store.
+///
+/// ast[out] : McAst object to be initialized.
+///
+/// SUCCESS : `ast`
+/// FAILURE : NULL
+///
+McAst* McAstInit (McAst* ast);
+
+///
+/// Deinitialize AST store, releasing all nodes of all trees in it.
+///
+/// ast[in,out] : McAst object to be de-initialized.
+///
+/// SUCCESS : `ast`
+/// FAILURE : NULL
+///
+McAst* McAstDeinit (McAst* ast);
+
+///
+/// Copy a pointer based expression tree into AST store. Given tree is left
+/// untouched, and can be deinitialized independently afterwards.
+///
+/// ast[in,out] : McAst object to add tree to.
+/// expr[in]    : Expression tree to copy.
+///
+/// SUCCESS : Handle of root node of copied tree.
+/// FAILURE : MC_AST_NONE, store unchanged.
+///
+McAstId McAstAddExpr (McAst* ast, McExpr* expr);
+
+///
+/// Get node with given handle.
+///
+/// ast[in] : McAst object containing node.
+/// id[in]  : Handle of node.
+///
+/// RETURN : Node, never NULL for handles returned by `McAstAddExpr`.
+///
+#define McAstNodeAt(ast, id) VecIter (&(ast)->nodes, (id))
+
+///
+/// Evaluate expression tree with given root, exactly like `McExprEval`
+/// evaluates the equivalent pointer based tree.
+///
+/// ast[in] : McAst object containing tree.
+/// id[in]  : Handle of root node of tree.
+///
+/// RETURN : evaluated value
+///
+f64 McAstEval (McAst* ast, McAstId id);
+
+#endif // MISRA_MODERN_C_PARSER_AST_H
@@ -0,0 +1,170 @@
+/// file      : misra/mc/document.h
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Editable source document, for editors and language servers. Document keeps
+/// tokens and top level items of it's code, and after every edit lexes and
+/// parses again only the part of code the edit could have changed.
+
+#ifndef MISRA_MODERN_C_PARSER_DOCUMENT_H
+#define MISRA_MODERN_C_PARSER_DOCUMENT_H
+
+#include <Misra/Mc/Parser/ASTNodeTypes.h>
+#include <Misra/Std/Container/Vec.h>
+#include <Misra/Types.h>
+
+/// Most threads `McDocumentInitParallel` ever uses.
+#define MC_DOCUMENT_MAX_THREADS 64
+
+/// Smallest slice `McDocumentInitParallel` cuts code into by default.
+#define MC_DOCUMENT_MIN_SLICE (64 * 1024)
+
+typedef enum McItemKind {
+    MC_ITEM_KIND_INVALID = 0,
+    MC_ITEM_KIND_TYPE,
+    MC_ITEM_KIND_EXPR,
+    MC_ITEM_KIND_MAX
+} McItemKind;
+
+///
+/// A top level item of a document, like `McParseProgram` reads them : a type
+/// or an expression, followed by an optional ";". Tokens that don't start a
+/// valid item are kept as invalid items of one token each.
+///
+typedef struct McItem {
+    McItemKind item_kind;
+
+    union {
+        McType type;
+        McExpr expr;
+    };
+
+    /// Index of first token of item.
+    u64 first_tok;
+
+    /// One past index of last token of item.
+    u64 end_tok;
+
+    /// One past index of last token parser looked at while parsing item.
+    /// Item must be parsed again if any token before this changes.
+    u64 peek_end;
+
+    /// Index of token an invalid item failed at: farthest one parser looked at.
+    u64 error_tok;
+
+    /// Offset of first byte of item in current code.
+    u64 offset;
+
+    /// Offset of first byte of item when it was parsed. Offsets stored in
+    /// AST nodes of item are relative to code at that time, see `McItemOffset`.
+    u64 parsed_offset;
+} McItem;
+
+typedef Vec (McItem) McItemVec;
+
+typedef struct McDocument {
+    /// Parser holding code and it's tokens.
+    McParser parser;
+
+    /// Top level items, in order.
+    McItemVec items;
+
+    /// Most tokens any item ever looked at past it's last token.
+    u64 lookahead;
+
+    /// Number of tokens lexed again by last edit.
+    u64 nrelexed;
+
+    /// Number of items parsed again by last edit.
+    u64 nreparsed;
+} McDocument;
+
+///
+/// Get offset in current code of document, of an offset stored in an AST
+/// node of given item (`McExpr.offset`).
+///
+/// item[in]        : Item node belongs to.
+/// node_offset[in] : Offset stored in node.
+///
+/// RETURN : Offset of same byte in current code.
+///
+#define McItemOffset(item, node_offset)                                                            \
+    ((item)->offset + (u32)((node_offset) - (u32)(item)->parsed_offset))
+
+///
+/// Initialize document with given code, and parse all of it.
+///
+/// doc[out] : McDocument object to be initialized.
+/// code[in] : Null-terminated code of document.
+///
+/// SUCCESS : `doc`
+/// FAILURE : NULL
+///
+McDocument* McDocumentInit (McDocument* doc, const char* code);
+
+///
+/// Initialize document with code read from file with given name, and parse
+/// all of it.
+///
+/// doc[out]     : McDocument object to be initialized.
+/// src_name[in] : Name of file to read code from.
+///
+/// SUCCESS : `doc`
+/// FAILURE : NULL
+///
+McDocument* McDocumentInitFromFile (McDocument* doc, const char* src_name);
+
+///
+/// Initialize document with given code, and parse it on multiple threads.
+///
+/// Code is first cut into slices at top level item boundaries (see
+/// `McSplitItems`). Slices are then lexed and parsed concurrently, each into
+/// a document of it's own, and merged in order. Resulting document is same
+/// as one from `McDocumentInit`, except that AST node offsets are relative
+/// to slice of their item (see `McItemOffset`).
+///
+/// doc[out]      : McDocument object to be initialized.
+/// code[in]      : Null-terminated code of document.
+/// nthreads[in]  : Number of threads to use, including calling thread. If 0,
+///                 one per online CPU. Never more than `MC_DOCUMENT_MAX_THREADS`.
+/// min_slice[in] : Minimum number of bytes per slice. If 0, a few slices per
+///                 thread, but no smaller than `MC_DOCUMENT_MIN_SLICE`.
+///
+/// SUCCESS : `doc`
+/// FAILURE : NULL
+///
+McDocument* McDocumentInitParallel (McDocument* doc, const char* code, u32 nthreads, u64 min_slice);
+
+///
+/// Deinitialize document, releasing code, tokens and all items.
+///
+/// doc[in,out] : McDocument object to be de-initialized.
+///
+/// SUCCESS : `doc`
+/// FAILURE : NULL
+///
+McDocument* McDocumentDeinit (McDocument* doc);
+
+///
+/// Replace `removed` bytes at `offset` in code of document by `length` bytes
+/// of `inserted` (eg: a keystroke, a paste or a delete), and update tokens
+/// and items to match.
+///
+/// Only tokens touching edited bytes are lexed again (see `McLexerEdit`).
+/// Parsing restarts at first item that looked at a changed token, and stops
+/// as soon as parser reaches an old item that starts after the edit. All
+/// items before and after that keep their AST.
+///
+/// doc[in,out]  : McDocument object to edit.
+/// offset[in]   : Offset of first byte to replace.
+/// removed[in]  : Number of bytes to remove.
+/// inserted[in] : Bytes to insert in their place. Can be NULL if `length` is 0.
+/// length[in]   : Number of bytes to insert.
+///
+/// SUCCESS : `doc`
+/// FAILURE : NULL, document must be deinitialized.
+///
+McDocument*
+    McDocumentEdit (McDocument* doc, u64 offset, u64 removed, const char* inserted, u64 length);
+
+#endif // MISRA_MODERN_C_PARSER_DOCUMENT_H
@@ -0,0 +1,43 @@
+/// file      : misra/mc/parser/fold.h
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Constant folding and algebraic simplification of expression trees.
+
+#ifndef MISRA_MODERN_C_PARSER_FOLD_H
+#define MISRA_MODERN_C_PARSER_FOLD_H
+
+#include <Misra/Mc/Parser/ASTNodeTypes.h>
+
+///
+/// Fold constant subtrees of an expression into `MC_EXPR_TYPE_NUM` nodes, in
+/// place, and simplify what remains with algebraic identities :
+///
+/// - `x * 1`, `x / 1`, `x - 0`, `x | 0`, `x ^ 0`, `x & ~0`, `x << 0`,
+///   `x >> 0` become `x`, and `x & 0`, `x % 1` become 0,
+/// - `- -x`, and `!!x` where `x` is already 0 or 1, become `x`,
+/// - `x / 2^n` becomes `x * 2^-n`, and `x % 2^n` becomes `x & (2^n - 1)`,
+/// - chains of `&`, `|` or `^` with constants are merged into one,
+/// - `&&`, `||` and `?:` with constant conditions pick their side.
+///
+/// Constant subtrees are folded with C types, as `McExprEvalValue` evaluates
+/// them, so integers stay exact and `1 / 2` is 0. Integer division by zero,
+/// and shift counts out of range, are left for run time. Constants that C
+/// gives no value (float operands of bitwise operators) and constants left by
+/// rewrites are typed as in `McBytecode` : `u64` for bitwise operators and
+/// "%", `i32` for logical operators, and `f64` for everything else. Folded
+/// constants keep their type in `num.type`. A rewrite is only done
+/// when it gives same value and type for every possible `x`, so `x + 0` is
+/// kept (it turns -0 into +0), and so are `x * 1` where `x` is a `u64`, and
+/// `x % 0`. Operands a rewrite drops must have no side effects. Casts of
+/// expressions that aren't constant are kept, with their operand folded, and
+/// operands of `sizeof` are never folded.
+///
+/// expr[in,out] : Expression to fold.
+///
+/// SUCCESS : `expr`
+/// FAILURE : NULL
+///
+McExpr* McExprFold (McExpr* expr);
+
+#endif // MISRA_MODERN_C_PARSER_FOLD_H
@@ -0,0 +1,43 @@
+/// file      : misra/mc/keywordhash.h
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Hash function of the keyword perfect hash table.
+///
+/// Keywords are listed in `Source/Misra/Mc/Parser/Keywords.in`. At build time
+/// `gen_keyword_hash` searches for a seed that makes this hash collision free
+/// over all keywords, and writes the table to `Build/gen`. Lexer then finds out
+/// whether an identifier is a keyword with one hash and one compare.
+
+#ifndef MISRA_MODERN_C_PARSER_KEYWORD_HASH_H
+#define MISRA_MODERN_C_PARSER_KEYWORD_HASH_H
+
+#include <string.h>
+
+// Misra
+#include <Misra/Types.h>
+
+///
+/// Hash a name into a slot of keyword table.
+///
+/// name[in]   : Name bytes, need not be null-terminated.
+/// length[in] : Number of bytes in name.
+/// seed[in]   : Seed found by generator.
+/// bits[in]   : Keyword table has `1 << bits` slots.
+///
+/// RETURN : Slot index in [0, 1 << bits).
+///
+static inline u32 McKeywordHash (const char* name, u32 length, u64 seed, u32 bits) {
+    // first and last (upto) 8 bytes, same bytes for short names
+    u64 head = 0;
+    u64 tail = 0;
+    u32 n    = length < 8 ? length : 8;
+    memcpy (&head, name, n);
+    memcpy (&tail, name + length - n, n);
+
+    u64 key = (head ^ (tail * 0x9e3779b97f4a7c15ULL)) + length;
+    key     = (key ^ (key >> 29)) * seed;
+    return (u32)(key >> (64 - bits));
+}
+
+#endif // MISRA_MODERN_C_PARSER_KEYWORD_HASH_H
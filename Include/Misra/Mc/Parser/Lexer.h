@@ -0,0 +1,265 @@
+/// file      : misra/mc/lexer.h
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Lexer for Modern C. Converts code into a compact array of tokens in a
+/// single linear pass, so that parser never has to look at (or skip over)
+/// the same bytes twice, no matter how much it backtracks.
+
+#ifndef MISRA_MODERN_C_PARSER_LEXER_H
+#define MISRA_MODERN_C_PARSER_LEXER_H
+
+#include <Misra/Std/Container/Str.h>
+#include <Misra/Std/Container/Vec.h>
+#include <Misra/Types.h>
+
+typedef enum McTokenKind {
+    MC_TOKEN_KIND_INVALID = 0,
+    MC_TOKEN_KIND_EOF,
+
+    // identifiers and literals
+    MC_TOKEN_KIND_ID,
+    MC_TOKEN_KIND_INT,
+    MC_TOKEN_KIND_FLT,
+    MC_TOKEN_KIND_HEX,
+
+    // keywords, see Source/Misra/Mc/Parser/Keywords.in
+    MC_TOKEN_KIND_SIZEOF,
+    MC_TOKEN_KIND_ALIGNOF,
+    MC_TOKEN_KIND_CONST,
+
+    // basic type names
+    MC_TOKEN_KIND_CHAR,
+    MC_TOKEN_KIND_U8,
+    MC_TOKEN_KIND_U16,
+    MC_TOKEN_KIND_U32,
+    MC_TOKEN_KIND_U64,
+    MC_TOKEN_KIND_I8,
+    MC_TOKEN_KIND_I16,
+    MC_TOKEN_KIND_I32,
+    MC_TOKEN_KIND_I64,
+    MC_TOKEN_KIND_F32,
+    MC_TOKEN_KIND_F64,
+
+    // punctuators
+    MC_TOKEN_KIND_PLUS,           // +
+    MC_TOKEN_KIND_PLUS_PLUS,      // ++
+    MC_TOKEN_KIND_PLUS_ASSIGN,    // +=
+    MC_TOKEN_KIND_MINUS,          // -
+    MC_TOKEN_KIND_MINUS_MINUS,    // --
+    MC_TOKEN_KIND_MINUS_ASSIGN,   // -=
+    MC_TOKEN_KIND_ARROW,          // ->
+    MC_TOKEN_KIND_STAR,           // *
+    MC_TOKEN_KIND_STAR_ASSIGN,    // *=
+    MC_TOKEN_KIND_SLASH,          // /
+    MC_TOKEN_KIND_SLASH_ASSIGN,   // /=
+    MC_TOKEN_KIND_PERCENT,        // %
+    MC_TOKEN_KIND_PERCENT_ASSIGN, // %=
+    MC_TOKEN_KIND_AMP,            // &
+    MC_TOKEN_KIND_AMP_AMP,        // &&
+    MC_TOKEN_KIND_AMP_ASSIGN,     // &=
+    MC_TOKEN_KIND_PIPE,           // |
+    MC_TOKEN_KIND_PIPE_PIPE,      // ||
+    MC_TOKEN_KIND_PIPE_ASSIGN,    // |=
+    MC_TOKEN_KIND_CARET,          // ^
+    MC_TOKEN_KIND_CARET_ASSIGN,   // ^=
+    MC_TOKEN_KIND_TILDE,          // ~
+    MC_TOKEN_KIND_BANG,           // !
+    MC_TOKEN_KIND_NE,             // !=
+    MC_TOKEN_KIND_ASSIGN,         // =
+    MC_TOKEN_KIND_EQ,             // ==
+    MC_TOKEN_KIND_LT,             // <
+    MC_TOKEN_KIND_LE,             // <=
+    MC_TOKEN_KIND_SHL,            // <<
+    MC_TOKEN_KIND_SHL_ASSIGN,     // <<=
+    MC_TOKEN_KIND_GT,             // >
+    MC_TOKEN_KIND_GE,             // >=
+    MC_TOKEN_KIND_SHR,            // >>
+    MC_TOKEN_KIND_SHR_ASSIGN,     // >>=
+    MC_TOKEN_KIND_QUESTION,       // ?
+    MC_TOKEN_KIND_COLON,          // :
+    MC_TOKEN_KIND_COMMA,          // ,
+    MC_TOKEN_KIND_DOT,            // .
+    MC_TOKEN_KIND_SEMICOLON,      // ;
+    MC_TOKEN_KIND_LPAREN,         // (
+    MC_TOKEN_KIND_RPAREN,         // )
+    MC_TOKEN_KIND_LBRACKET,       // [
+    MC_TOKEN_KIND_RBRACKET,       // ]
+    MC_TOKEN_KIND_LBRACE,         // {
+    MC_TOKEN_KIND_RBRACE,         // }
+
+    MC_TOKEN_KIND_MAX
+} McTokenKind;
+
+///
+/// A single token. Tokens don't own any memory, bytes of a token are always
+/// looked up from code the token was lexed from.
+///
+typedef struct McToken {
+    McTokenKind kind;
+
+    /// Offset of first byte of token in code.
+    u32 offset;
+
+    /// Number of bytes in token.
+    u32 length;
+
+    /// Interned name of identifiers, see `McLexerName`. 0 for everything else.
+    u32 value;
+} McToken;
+
+typedef Vec (McToken) McTokenVec;
+
+///
+/// Table of unique identifier names. Each name is stored once, and is
+/// referred to by it's index.
+///
+typedef struct McInterner {
+    /// All names, one after another, each followed by a null-terminator.
+    Str names;
+
+    /// Offset of each name in `names`.
+    Vec (u32) offsets;
+
+    /// Open addressing hash table. Each slot is index of name + 1, or 0 if empty.
+    Vec (u32) slots;
+} McInterner;
+
+typedef struct McLexer {
+    /// Tokens lexed so far.
+    McTokenVec tokens;
+
+    /// Offset of first byte not yet lexed.
+    u64 pos;
+
+    /// Names of all identifiers seen so far.
+    McInterner interner;
+} McLexer;
+
+///
+/// Initialize lexer.
+///
+/// lx[out] : Lexer to be initialized.
+///
+/// SUCCESS : `lx`
+/// FAILURE : NULL
+///
+McLexer* McLexerInit (McLexer* lx);
+
+///
+/// Deinitialize lexer, releasing all tokens and interned names.
+///
+/// lx[in,out] : Lexer to be de-initialized.
+///
+/// SUCCESS : `lx`
+/// FAILURE : NULL
+///
+McLexer* McLexerDeinit (McLexer* lx);
+
+///
+/// Lex tokens from `code`, starting from where last call stopped, and append
+/// them to `lx->tokens`.
+///
+/// When `eof` is false, more code may still follow `length`, so a token that
+/// touches end of code is not emitted. Lexing resumes from start of that
+/// token on next call, with more code. When `eof` is true, complete code is
+/// lexed and a `MC_TOKEN_KIND_EOF` token is appended after last token.
+///
+/// Keywords and basic type names get their own token kinds, and are never
+/// interned. Anything that cannot be lexed becomes a `MC_TOKEN_KIND_INVALID` token.
+/// Numbers immediately followed by identifier characters (eg: `134var`) are
+/// a single invalid token.
+///
+/// lx[in,out] : Lexer to append tokens to.
+/// code[in]   : Code to lex. Must be the same code as previous calls, only
+///              with more bytes appended at the end.
+/// length[in] : Number of bytes available in `code`.
+/// eof[in]    : Whether `length` is end of code.
+///
+/// SUCCESS : `lx`
+/// FAILURE : NULL
+///
+McLexer* McLexerRun (McLexer* lx, const char* code, u64 length, bool eof);
+
+///
+/// Tokens replaced by `McLexerEdit`.
+///
+typedef struct McTokenSplice {
+    /// Index of first replaced token.
+    u64 first;
+
+    /// Number of old tokens removed at `first`.
+    u64 nremoved;
+
+    /// Number of new tokens inserted at `first` in their place.
+    u64 ninserted;
+} McTokenSplice;
+
+///
+/// Update tokens of completely lexed code (last `McLexerRun` had `eof` set)
+/// after some bytes of code are replaced. Only tokens touching edited bytes
+/// are lexed again, from last token boundary before the edit up to first
+/// token after the edit that starts where an old token started. Offsets of
+/// tokens after that are moved by change in code length.
+///
+/// lx[in,out]   : Lexer to update.
+/// code[in]     : Code after edit.
+/// length[in]   : Number of bytes in code after edit.
+/// offset[in]   : Offset of first replaced byte.
+/// removed[in]  : Number of bytes removed at `offset`.
+/// inserted[in] : Number of bytes inserted at `offset` in their place.
+/// splice[out]  : Tokens that were replaced.
+///
+/// SUCCESS : `lx`
+/// FAILURE : NULL
+///
+McLexer* McLexerEdit (
+    McLexer*       lx,
+    const char*    code,
+    u64            length,
+    u64            offset,
+    u64            removed,
+    u64            inserted,
+    McTokenSplice* splice
+);
+
+///
+/// Forget first `ntokens` tokens, and first `nbytes` bytes of code they were
+/// lexed from. Offsets of remaining tokens are adjusted, so that they're
+/// relative to code with first `nbytes` bytes removed. Names not used by any
+/// remaining token are forgotten, so names of remaining tokens get new values.
+///
+/// lx[in,out]  : Lexer to drop tokens from.
+/// ntokens[in] : Number of tokens to drop from front.
+/// nbytes[in]  : Number of code bytes to drop from front. Must not be more
+///               than offset of first remaining token.
+///
+/// SUCCESS : `lx`
+/// FAILURE : NULL
+///
+McLexer* McLexerDrop (McLexer* lx, u64 ntokens, u64 nbytes);
+
+///
+/// Get index of given name in interner, adding it if it's not already there.
+///
+/// lx[in,out] : Lexer to intern name into.
+/// name[in]   : Name bytes, need not be null-terminated.
+/// length[in] : Number of bytes in name.
+///
+/// SUCCESS : Index of name.
+/// FAILURE : (u32)-1
+///
+u32 McLexerIntern (McLexer* lx, const char* name, u32 length);
+
+///
+/// Get interned name with given index.
+///
+/// lx[in]    : Lexer to lookup name in.
+/// value[in] : Index of name, usually `McToken.value` of an identifier.
+///
+/// SUCCESS : Null-terminated name. Valid till next `McLexerIntern` call.
+/// FAILURE : NULL
+///
+const char* McLexerName (McLexer* lx, u32 value);
+
+#endif // MISRA_MODERN_C_PARSER_LEXER_H
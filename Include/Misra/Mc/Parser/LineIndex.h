@@ -0,0 +1,94 @@
+/// file      : misra/mc/lineindex.h
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Table of line start offsets, to turn byte offsets of AST nodes into line
+/// and column numbers. Nothing is scanned until first lookup, so code that
+/// never reports a diagnostic never pays for it.
+
+#ifndef MISRA_MODERN_C_PARSER_LINE_INDEX_H
+#define MISRA_MODERN_C_PARSER_LINE_INDEX_H
+
+#include <Misra/Std/Container/Vec.h>
+#include <Misra/Types.h>
+
+///
+/// Line starts of a window of code. All offsets are absolute, counted from
+/// first byte of complete code, even if bytes before window are long gone.
+///
+typedef struct McLineIndex {
+    /// Offset of first byte of code window.
+    u64 base;
+
+    /// Number of bytes (from start of complete code) scanned for newlines.
+    u64 scanned;
+
+    /// 0-based line number of first line in `starts`.
+    u64 base_line;
+
+    /// Offset of first byte of each line, in increasing order. First entry is
+    /// start of line containing `base`, which may be before `base`.
+    Vec (u64) starts;
+} McLineIndex;
+
+///
+/// Initialize an empty line index. No memory is allocated till first scan.
+///
+/// li[out] : Line index to be initialized.
+///
+/// SUCCESS : `li`
+/// FAILURE : NULL
+///
+McLineIndex* McLineIndexInit (McLineIndex* li);
+
+///
+/// Deinitialize line index.
+///
+/// li[in,out] : Line index to be de-initialized.
+///
+/// SUCCESS : `li`
+/// FAILURE : NULL
+///
+McLineIndex* McLineIndexDeinit (McLineIndex* li);
+
+///
+/// Scan code window for newlines that weren't scanned yet. Bytes are scanned
+/// with vector instructions where available, and never more than once.
+///
+/// li[in,out] : Line index to update.
+/// code[in]   : Code window, first byte at absolute offset `li->base`.
+/// length[in] : Number of bytes in window.
+///
+/// SUCCESS : `li`
+/// FAILURE : NULL
+///
+McLineIndex* McLineIndexScan (McLineIndex* li, const char* code, u64 length);
+
+///
+/// Move start of window forward, when first `nbytes` bytes of code are
+/// dropped from memory. Dropped bytes are scanned first (if they weren't
+/// already), so that line numbers after them stay right.
+///
+/// li[in,out] : Line index to update.
+/// code[in]   : Code window, before dropping bytes.
+/// nbytes[in] : Number of bytes dropped from front of window.
+///
+/// SUCCESS : `li`
+/// FAILURE : NULL
+///
+McLineIndex* McLineIndexDrop (McLineIndex* li, const char* code, u64 nbytes);
+
+///
+/// Get line and column of a byte in scanned part of code window.
+///
+/// li[in]      : Line index to lookup in.
+/// offset[in]  : Absolute offset of byte.
+/// line[out]   : 1-based line number.
+/// column[out] : 1-based column number, in bytes.
+///
+/// SUCCESS : true
+/// FAILURE : false, if offset is before window or after scanned bytes.
+///
+bool McLineIndexLookup (McLineIndex* li, u64 offset, u64* line, u64* column);
+
+#endif // MISRA_MODERN_C_PARSER_LINE_INDEX_H
@@ -0,0 +1,53 @@
+/// file      : misra/mc/literal.h
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Conversion of numeric literal bytes (as found by lexer) to values.
+/// Digits are converted eight at a time, and floats are correctly rounded.
+
+#ifndef MISRA_MODERN_C_PARSER_LITERAL_H
+#define MISRA_MODERN_C_PARSER_LITERAL_H
+
+#include <Misra/Types.h>
+
+///
+/// Convert decimal digits to an unsigned 64-bit integer.
+///
+/// s[in]      : Digits, need not be null-terminated.
+/// length[in] : Number of digits.
+/// value[out] : Converted value.
+///
+/// SUCCESS : true, value set.
+/// FAILURE : false, if there are no digits, a non-digit, or if value does not fit in 64 bits.
+///
+bool McLiteralDecToU64 (const char* s, u32 length, u64* value);
+
+///
+/// Convert hexadecimal digits (without "0x" prefix) to an unsigned 64-bit integer.
+///
+/// s[in]      : Digits, upper or lower case, need not be null-terminated.
+/// length[in] : Number of digits.
+/// value[out] : Converted value.
+///
+/// SUCCESS : true, value set.
+/// FAILURE : false, if there are no digits, a non-digit, or if value does not fit in 64 bits.
+///
+bool McLiteralHexToU64 (const char* s, u32 length, u64* value);
+
+///
+/// Convert a decimal number of form `digits[.[digits]]` to nearest double,
+/// ties to even, exactly like a correctly rounding `strtod` would.
+///
+/// Most numbers are converted with a single 64x128-bit multiplication
+/// (Eisel-Lemire). Rare cases that are too close to call fall back to `strtod`.
+///
+/// s[in]      : Number, need not be null-terminated.
+/// length[in] : Number of bytes in number.
+/// value[out] : Converted value. Infinity if number is too large for a double.
+///
+/// SUCCESS : true, value set.
+/// FAILURE : false, if number is malformed.
+///
+bool McLiteralDecToF64 (const char* s, u32 length, f64* value);
+
+#endif // MISRA_MODERN_C_PARSER_LITERAL_H
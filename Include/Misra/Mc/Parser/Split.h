@@ -0,0 +1,34 @@
+/// file      : misra/mc/split.h
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Pre-scan of code for top level item boundaries, without lexing it. Code
+/// cut at these boundaries can be lexed and parsed slice by slice, in any
+/// order, and gives exactly same items as parsing it all at once.
+
+#ifndef MISRA_MODERN_C_PARSER_SPLIT_H
+#define MISRA_MODERN_C_PARSER_SPLIT_H
+
+#include <Misra/Std/Container/Vec.h>
+#include <Misra/Types.h>
+
+typedef Vec (u64) McCutVec;
+
+///
+/// Find places to cut code at. Only structural characters (brackets and ";")
+/// are looked at, found with vector instructions where available. Code is
+/// cut right after a ";" outside all brackets, when it ends an item, and no
+/// slice is shorter than `min_slice` bytes except the last one.
+///
+/// code[in]      : Code to scan.
+/// length[in]    : Number of bytes in code.
+/// min_slice[in] : Minimum number of bytes between two cuts.
+/// cuts[out]     : Offsets where slices start, in increasing order, appended
+///                 to. First one is always 0.
+///
+/// SUCCESS : `cuts`
+/// FAILURE : NULL
+///
+McCutVec* McSplitItems (const char* code, u64 length, u64 min_slice, McCutVec* cuts);
+
+#endif // MISRA_MODERN_C_PARSER_SPLIT_H
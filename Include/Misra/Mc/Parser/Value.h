@@ -0,0 +1,80 @@
+/// file      : misra/mc/parser/value.h
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Typed compile time evaluation of expressions, with C semantics.
+
+#ifndef MISRA_MODERN_C_PARSER_VALUE_H
+#define MISRA_MODERN_C_PARSER_VALUE_H
+
+#include <Misra/Mc/Parser/ASTNodeTypes.h>
+#include <Misra/Types.h>
+
+///
+/// Value of a constant expression, tagged with it's type.
+///
+/// Integers are kept in 64 bits no matter their width, sign extended if
+/// type is signed and zero extended otherwise, so that `u` and `i` read
+/// same value for every integer that fits in both. A `f32` is kept as the
+/// `f64` it converts to exactly.
+///
+typedef struct McValue {
+    /// Type of value, `type.nbits` is width of integer or float.
+    McBasicType type;
+
+    union {
+        u64 u;
+        i64 i;
+        f64 f;
+    };
+} McValue;
+
+///
+/// Evaluate a constant expression, exactly as C would on a 64-bit target,
+/// without ever converting integers to floating point and back.
+///
+/// - An integer literal is `i32` if it fits, else `i64` if it fits, else
+///   `u64`. Hexadecimal literals try `u32` after `i32`, and `u64` after
+///   `i64`, as in C. Float literals are `f64`.
+/// - Operands narrower than 32 bits are promoted to `i32`, and binary
+///   operators convert their operands to a common type first (usual
+///   arithmetic conversions).
+/// - Integer arithmetic wraps around in width of it's type, for signed
+///   types too, where C leaves overflow undefined. Division truncates
+///   towards zero.
+/// - Comparisons and logical operators give `i32`. `&&`, `||` and `?:` only
+///   evaluate operands they need.
+/// - `sizeof` gives size of it's operand's type as `u64`, without
+///   evaluating operand.
+///
+/// Evaluation fails on expressions that aren't constant (identifiers,
+/// assignments, calls, ...), on integer division by zero, on shift counts
+/// that are negative or not less than width of type, on float to integer
+/// casts of values that don't fit, and on operators C doesn't allow for
+/// given operand types (like "%" on floats). Casts to pointer types aren't
+/// supported.
+///
+/// Constants computed by `McExprFold` (or a parser with folding enabled) have
+/// the type they were folded to, see `McExprFold`.
+///
+/// value[out] : Value of expression.
+/// expr[in]   : Expression to evaluate.
+///
+/// SUCCESS : `value`
+/// FAILURE : NULL, value unchanged.
+///
+McValue* McExprEvalValue (McValue* value, McExpr* expr);
+
+///
+/// Same as `McExprEvalValue`, but doesn't log why an expression can't be
+/// evaluated, for callers that only evaluate whatever is constant.
+///
+/// value[out] : Value of expression.
+/// expr[in]   : Expression to evaluate.
+///
+/// SUCCESS : `value`
+/// FAILURE : NULL, value unchanged.
+///
+McValue* McExprTryEvalValue (McValue* value, McExpr* expr);
+
+#endif // MISRA_MODERN_C_PARSER_VALUE_H
@@ -0,0 +1,160 @@
+/// file      : misra/mc/vm/bytecode.h
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Bytecode compiler and stack machine for expressions. An expression is
+/// compiled once and can then be evaluated any number of times, with
+/// different values for identifiers in it, much faster than `McExprEval`
+/// walks the tree.
+
+#ifndef MISRA_MODERN_C_VM_BYTECODE_H
+#define MISRA_MODERN_C_VM_BYTECODE_H
+
+#include <Misra/Mc/Parser/ASTNodeTypes.h>
+#include <Misra/Std/Container/Str.h>
+#include <Misra/Std/Container/Vec.h>
+#include <Misra/Types.h>
+
+///
+/// Bytecode instructions. Every opcode is a single byte, followed by it's
+/// operands if any : 8 bytes of value for `PUSH_*`, 4 bytes of input index
+/// for `LOAD`, and 4 bytes of signed offset from end of instruction for
+/// jumps, all unaligned. `_I` instructions work on `u64`, `_F` ones on `f64`.
+///
+typedef enum McOpcode {
+    // return f64 top of stack
+    MC_OP_RET = 0,
+
+    // push operand, or input at index given by operand (an f64)
+    MC_OP_PUSH_I,
+    MC_OP_PUSH_F,
+    MC_OP_LOAD,
+
+    // conversions of top of stack, or of value below it (NOS), BOOL_ ones
+    // give u64 1 for non-zero and 0 for zero
+    MC_OP_I2F,
+    MC_OP_I2F_NOS,
+    MC_OP_F2I,
+    MC_OP_BOOL_I,
+    MC_OP_BOOL_F,
+
+    // f64 arithmetic, NOT_F gives u64 1 for zero and 0 for non-zero
+    MC_OP_ADD_F,
+    MC_OP_SUB_F,
+    MC_OP_MUL_F,
+    MC_OP_DIV_F,
+    MC_OP_NEG_F,
+    MC_OP_NOT_F,
+
+    // u64 arithmetic, NOT_I gives 1 for zero and 0 for non-zero
+    MC_OP_AND_I,
+    MC_OP_OR_I,
+    MC_OP_XOR_I,
+    MC_OP_MOD_I,
+    MC_OP_SHR_I,
+    MC_OP_SHL_I,
+    MC_OP_NOT_I,
+
+    // comparisons, all give u64 1 for true and 0 for false
+    MC_OP_LE_I,
+    MC_OP_GE_I,
+    MC_OP_LT_I,
+    MC_OP_GT_I,
+    MC_OP_EQ_I,
+    MC_OP_NE_I,
+    MC_OP_LE_F,
+    MC_OP_GE_F,
+    MC_OP_LT_F,
+    MC_OP_GT_F,
+    MC_OP_EQ_F,
+    MC_OP_NE_F,
+
+    // jumps, JZ pops u64 top of stack and jumps if it's zero, _KEEP ones
+    // jump with it kept on stack, or pop it and go on
+    MC_OP_JMP,
+    MC_OP_JZ,
+    MC_OP_JZ_KEEP,
+    MC_OP_JNZ_KEEP,
+
+    MC_OP_MAX
+} McOpcode;
+
+/// Deepest stack `McBytecodeEval` keeps on thread stack. Deeper programs use heap.
+#define MC_BYTECODE_LOCAL_STACK 64
+
+typedef Vec (u8) McCodeVec;
+typedef Vec (Str) McInputVec;
+
+///
+/// An expression compiled to bytecode.
+///
+/// Values are kept as `u64` where `McExprEval` casts them to `u64` anyway
+/// (bitwise operators, shifts, "%") and for results of comparisons and
+/// logical operators, and as `f64` everywhere else. Conversions are compiled
+/// in only where a value crosses from one to the other, so results are same
+/// as of `McExprEval`, except for integer results above 2^53, which bytecode
+/// keeps exact where `McExprEval` rounds them to nearest `f64`.
+///
+typedef struct McBytecode {
+    /// Instructions, ending with `MC_OP_RET`.
+    McCodeVec code;
+
+    /// Names of distinct identifiers in expression, in order of first use.
+    /// Index of a name is index of it's value in inputs to `McBytecodeEval`.
+    McInputVec inputs;
+
+    /// Most values on stack at any point of evaluation.
+    u64 max_depth;
+} McBytecode;
+
+///
+/// Compile given expression to bytecode. Expression is not needed anymore
+/// after this, and may be changed or destroyed.
+///
+/// Operators that have no value (assignments, calls, member access, ...)
+/// evaluate to 0, as with `McExprEval`.
+///
+/// bc[out]   : Bytecode object to be initialized.
+/// expr[in]  : Expression to compile.
+///
+/// SUCCESS : `bc`
+/// FAILURE : NULL
+///
+McBytecode* McBytecodeCompile (McBytecode* bc, McExpr* expr);
+
+///
+/// De-initialize bytecode object.
+///
+/// bc[in,out] : Bytecode to be de-initialized.
+///
+/// SUCCESS : `bc`
+/// FAILURE : NULL
+///
+McBytecode* McBytecodeDeinit (McBytecode* bc);
+
+///
+/// Find index of an identifier in inputs of compiled expression.
+///
+/// bc[in]   : Compiled expression.
+/// name[in] : Null-terminated name of identifier.
+///
+/// SUCCESS : Index of identifier's value in inputs to `McBytecodeEval`.
+/// FAILURE : (u64)-1, if expression has no such identifier.
+///
+u64 McBytecodeFindInput (const McBytecode* bc, const char* name);
+
+///
+/// Evaluate compiled expression. Dispatch is threaded through a table of
+/// label addresses where compiler supports it, so that every instruction
+/// jumps to next one from a place of it's own, which branch predictors
+/// track much better than one shared switch.
+///
+/// bc[in]     : Compiled expression.
+/// inputs[in] : Values of identifiers, `bc->inputs.length` of them. May be
+///              NULL if there are none.
+///
+/// RETURN : value of expression
+///
+f64 McBytecodeEval (const McBytecode* bc, const f64* inputs);
+
+#endif // MISRA_MODERN_C_VM_BYTECODE_H
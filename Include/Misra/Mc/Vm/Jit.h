@@ -0,0 +1,84 @@
+/// file      : misra/mc/vm/jit.h
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Native code compiler for expressions. Register code from Register.h is
+/// translated to x86-64 machine code, one instruction after another, into
+/// memory that is never writable and executable at same time. On other
+/// architectures the register machine is used instead, so callers don't
+/// need to care where they run.
+
+#ifndef MISRA_MODERN_C_VM_JIT_H
+#define MISRA_MODERN_C_VM_JIT_H
+
+#include <Misra/Mc/Parser/ASTNodeTypes.h>
+#include <Misra/Mc/Vm/Register.h>
+#include <Misra/Types.h>
+
+///
+/// An expression compiled to native code.
+///
+/// Values are typed same as in `McBytecode`, `f64` ones live in SSE2
+/// registers and `u64` ones in general purpose registers, and results are
+/// exactly those of `McRegCodeEval`.
+///
+typedef struct McJit {
+    /// Register code native code was translated from, used for inputs, and
+    /// to evaluate expression where there is no native code.
+    McRegCode rc;
+
+    /// Executable memory holding native code, NULL if there is none.
+    void* code;
+
+    /// Size of `code` in bytes, a multiple of page size.
+    u64 size;
+} McJit;
+
+///
+/// Compile given expression to native code. Expression is not needed
+/// anymore after this, and may be changed or destroyed.
+///
+/// If target is not x86-64, or system refuses executable memory, no native
+/// code is generated and `McJitEval` interprets register code instead.
+///
+/// jit[out] : Object to be initialized.
+/// expr[in] : Expression to compile.
+///
+/// SUCCESS : `jit`
+/// FAILURE : NULL
+///
+McJit* McJitCompile (McJit* jit, McExpr* expr);
+
+///
+/// De-initialize compiled expression, and unmap it's native code.
+///
+/// jit[in,out] : Compiled expression to be de-initialized.
+///
+/// SUCCESS : `jit`
+/// FAILURE : NULL
+///
+McJit* McJitDeinit (McJit* jit);
+
+///
+/// Find index of an identifier in inputs of compiled expression.
+///
+/// jit[in]  : Compiled expression.
+/// name[in] : Null-terminated name of identifier.
+///
+/// SUCCESS : Index of identifier's value in inputs to `McJitEval`.
+/// FAILURE : (u64)-1, if expression has no such identifier.
+///
+u64 McJitFindInput (const McJit* jit, const char* name);
+
+///
+/// Evaluate compiled expression.
+///
+/// jit[in]    : Compiled expression.
+/// inputs[in] : Values of identifiers, `jit->rc.inputs.length` of them. May
+///              be NULL if there are none.
+///
+/// RETURN : value of expression
+///
+f64 McJitEval (const McJit* jit, const f64* inputs);
+
+#endif // MISRA_MODERN_C_VM_JIT_H
@@ -0,0 +1,242 @@
+/// file      : misra/mc/vm/register.h
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Register machine for expressions. Compared to the stack machine in
+/// Bytecode.h, operands are named directly instead of being pushed, and
+/// frequent pairs of operations are fused into superinstructions, so the
+/// deep binary trees parser produces take far fewer dispatches.
+
+#ifndef MISRA_MODERN_C_VM_REGISTER_H
+#define MISRA_MODERN_C_VM_REGISTER_H
+
+#include <Misra/Mc/Parser/ASTNodeTypes.h>
+#include <Misra/Mc/Vm/Bytecode.h>
+#include <Misra/Std/Container/Vec.h>
+#include <Misra/Types.h>
+
+///
+/// Register machine instructions. `d` is destination register, `a` and `b`
+/// source registers. `_K` instructions take a constant from pool at index
+/// `b` instead of register `b`. `_I` ones work on `u64`, `_F` ones on `f64`.
+///
+typedef enum McRegOp {
+    // return register `a`, converted to f64
+    MC_REG_OP_RET_F = 0,
+    MC_REG_OP_RET_I,
+
+    // d = a, d = constant, and conversions, BOOL_ ones give u64 1 for
+    // non-zero and 0 for zero, NOT_ ones the other way around
+    MC_REG_OP_MOV,
+    MC_REG_OP_MOV_K,
+    MC_REG_OP_I2F,
+    MC_REG_OP_F2I,
+    MC_REG_OP_BOOL_I,
+    MC_REG_OP_BOOL_F,
+    MC_REG_OP_NEG_F,
+    MC_REG_OP_NOT_I,
+    MC_REG_OP_NOT_F,
+
+    // d = a op b, comparisons give u64 1 for true and 0 for false
+    MC_REG_OP_ADD_F,
+    MC_REG_OP_SUB_F,
+    MC_REG_OP_MUL_F,
+    MC_REG_OP_DIV_F,
+    MC_REG_OP_AND_I,
+    MC_REG_OP_OR_I,
+    MC_REG_OP_XOR_I,
+    MC_REG_OP_MOD_I,
+    MC_REG_OP_SHR_I,
+    MC_REG_OP_SHL_I,
+    MC_REG_OP_LE_I,
+    MC_REG_OP_GE_I,
+    MC_REG_OP_LT_I,
+    MC_REG_OP_GT_I,
+    MC_REG_OP_EQ_I,
+    MC_REG_OP_NE_I,
+    MC_REG_OP_LE_F,
+    MC_REG_OP_GE_F,
+    MC_REG_OP_LT_F,
+    MC_REG_OP_GT_F,
+    MC_REG_OP_EQ_F,
+    MC_REG_OP_NE_F,
+
+    // jump to instruction `target` always, or if register `a` is (not) zero
+    MC_REG_OP_JMP,
+    MC_REG_OP_JZ_I,
+    MC_REG_OP_JZ_F,
+    MC_REG_OP_JNZ_I,
+    MC_REG_OP_JNZ_F,
+
+    // superinstructions from here on : d = a op constant, in same order as above
+    MC_REG_OP_ADD_FK,
+    MC_REG_OP_SUB_FK,
+    MC_REG_OP_MUL_FK,
+    MC_REG_OP_DIV_FK,
+    MC_REG_OP_AND_IK,
+    MC_REG_OP_OR_IK,
+    MC_REG_OP_XOR_IK,
+    MC_REG_OP_MOD_IK,
+    MC_REG_OP_SHR_IK,
+    MC_REG_OP_SHL_IK,
+    MC_REG_OP_LE_IK,
+    MC_REG_OP_GE_IK,
+    MC_REG_OP_LT_IK,
+    MC_REG_OP_GT_IK,
+    MC_REG_OP_EQ_IK,
+    MC_REG_OP_NE_IK,
+    MC_REG_OP_LE_FK,
+    MC_REG_OP_GE_FK,
+    MC_REG_OP_LT_FK,
+    MC_REG_OP_GT_FK,
+    MC_REG_OP_EQ_FK,
+    MC_REG_OP_NE_FK,
+
+    // d = constant op a
+    MC_REG_OP_RSUB_FK,
+    MC_REG_OP_RDIV_FK,
+
+    // d = (a shift `target`) & constant
+    MC_REG_OP_SHR_AND_IK,
+    MC_REG_OP_SHL_AND_IK,
+
+    // jump to `target` if comparison of a and b (or constant) is false
+    MC_REG_OP_JF_LE_I,
+    MC_REG_OP_JF_GE_I,
+    MC_REG_OP_JF_LT_I,
+    MC_REG_OP_JF_GT_I,
+    MC_REG_OP_JF_EQ_I,
+    MC_REG_OP_JF_NE_I,
+    MC_REG_OP_JF_LE_F,
+    MC_REG_OP_JF_GE_F,
+    MC_REG_OP_JF_LT_F,
+    MC_REG_OP_JF_GT_F,
+    MC_REG_OP_JF_EQ_F,
+    MC_REG_OP_JF_NE_F,
+    MC_REG_OP_JF_LE_IK,
+    MC_REG_OP_JF_GE_IK,
+    MC_REG_OP_JF_LT_IK,
+    MC_REG_OP_JF_GT_IK,
+    MC_REG_OP_JF_EQ_IK,
+    MC_REG_OP_JF_NE_IK,
+    MC_REG_OP_JF_LE_FK,
+    MC_REG_OP_JF_GE_FK,
+    MC_REG_OP_JF_LT_FK,
+    MC_REG_OP_JF_GT_FK,
+    MC_REG_OP_JF_EQ_FK,
+    MC_REG_OP_JF_NE_FK,
+
+    MC_REG_OP_MAX
+} McRegOp;
+
+/// First superinstruction, all opcodes after it are superinstructions too.
+#define MC_REG_OP_FIRST_SUPER MC_REG_OP_ADD_FK
+
+/// Most registers `McRegCodeEval` keeps on thread stack. Larger programs use heap.
+#define MC_REG_LOCAL_REGS 128
+
+typedef struct McRegInsn {
+    u16 op;
+    u16 d;
+    u16 a;
+    u16 b;
+
+    /// Index of instruction to jump to, or shift amount of `SH*_AND_IK`.
+    u32 target;
+} McRegInsn;
+
+typedef Vec (McRegInsn) McRegInsnVec;
+typedef Vec (u64) McRegConstVec;
+
+///
+/// An expression compiled for the register machine.
+///
+/// Registers hold inputs first, in order of `inputs`, and then temporaries.
+/// A subexpression at depth `n` of tree keeps it's value in `n`-th
+/// temporary, so registers needed grow with depth of tree, not it's size.
+/// Values are typed same as in `McBytecode`, and results are exactly those
+/// of `McBytecodeEval`.
+///
+typedef struct McRegCode {
+    /// Instructions, ending with a `MC_REG_OP_RET_*`.
+    McRegInsnVec code;
+
+    /// Bit patterns of constants used by `_K` instructions.
+    McRegConstVec consts;
+
+    /// Names of identifiers, same as `McBytecode.inputs`.
+    McInputVec inputs;
+
+    /// Number of registers, including inputs.
+    u64 nregs;
+} McRegCode;
+
+///
+/// Dynamic instruction counts of evaluations, see `McRegCodeEvalCounted`.
+///
+typedef struct McRegStats {
+    /// Number of instructions executed.
+    u64 ninsns;
+
+    /// How many of them were superinstructions.
+    u64 nsuper;
+} McRegStats;
+
+///
+/// Compile given expression for register machine. Expression is not needed
+/// anymore after this, and may be changed or destroyed.
+///
+/// rc[out]  : Register code object to be initialized.
+/// expr[in] : Expression to compile.
+///
+/// SUCCESS : `rc`
+/// FAILURE : NULL, also if expression needs more than 65536 registers or
+///           constants.
+///
+McRegCode* McRegCodeCompile (McRegCode* rc, McExpr* expr);
+
+///
+/// De-initialize register code object.
+///
+/// rc[in,out] : Register code to be de-initialized.
+///
+/// SUCCESS : `rc`
+/// FAILURE : NULL
+///
+McRegCode* McRegCodeDeinit (McRegCode* rc);
+
+///
+/// Find index of an identifier in inputs of compiled expression.
+///
+/// rc[in]   : Compiled expression.
+/// name[in] : Null-terminated name of identifier.
+///
+/// SUCCESS : Index of identifier's value in inputs to `McRegCodeEval`.
+/// FAILURE : (u64)-1, if expression has no such identifier.
+///
+u64 McRegCodeFindInput (const McRegCode* rc, const char* name);
+
+///
+/// Evaluate compiled expression, with threaded dispatch where compiler
+/// supports it (see `McBytecodeEval`).
+///
+/// rc[in]     : Compiled expression.
+/// inputs[in] : Values of identifiers, `rc->inputs.length` of them. May be
+///              NULL if there are none.
+///
+/// RETURN : value of expression
+///
+f64 McRegCodeEval (const McRegCode* rc, const f64* inputs);
+
+///
+/// Same as `McRegCodeEval`, but also count instructions executed.
+///
+/// rc[in]        : Compiled expression.
+/// inputs[in]    : Values of identifiers.
+/// stats[in,out] : Counts of this evaluation are added to it.
+///
+/// RETURN : value of expression
+///
+f64 McRegCodeEvalCounted (const McRegCode* rc, const f64* inputs, McRegStats* stats);
+
+#endif // MISRA_MODERN_C_VM_REGISTER_H
@@ -0,0 +1,128 @@
+/// file      : misra/std/arena.h
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, All rights reserved.
+///
+/// Arena (bump) allocator. Allocations are carved out of large blocks and are
+/// never freed individually. Memory is given back all at once with
+/// `ArenaReset`/`ArenaDeinit`, or back to a previously taken mark with
+/// `ArenaRestore`.
+
+#ifndef MISRA_STD_ARENA_H
+#define MISRA_STD_ARENA_H
+
+#include <stddef.h>
+
+// Misra
+#include <Misra/Types.h>
+
+typedef struct ArenaBlock ArenaBlock;
+
+struct ArenaBlock {
+    /// Previously allocated block.
+    ArenaBlock *next;
+
+    /// Number of usable bytes in this block.
+    size_t size;
+
+    /// Number of bytes already handed out from this block.
+    size_t used;
+
+    /// Block memory.
+    u8 data[];
+};
+
+typedef struct Arena {
+    /// Block allocations are currently made from. Older blocks are chained
+    /// after this one.
+    ArenaBlock *blocks;
+
+    /// Blocks given back by `ArenaReset`/`ArenaRestore`, kept for reuse.
+    ArenaBlock *free_blocks;
+
+    /// Minimum size of each new block.
+    size_t block_size;
+} Arena;
+
+///
+/// A position in arena that can be restored back to, releasing everything
+/// allocated after the mark was taken.
+///
+typedef struct ArenaMark {
+    ArenaBlock *block;
+    size_t      used;
+} ArenaMark;
+
+///
+/// Initialize arena. No memory is allocated until first allocation.
+///
+/// arena[out]     : Arena to be initialized.
+/// block_size[in] : Minimum size of each memory block. If 0, then a default
+///                  block size is used.
+///
+/// SUCCESS : `arena`
+/// FAILURE : NULL
+///
+Arena *ArenaInit (Arena *arena, size_t block_size);
+
+///
+/// Release all memory held by arena.
+///
+/// arena[in,out] : Arena to be de-initialized.
+///
+/// SUCCESS : `arena`
+/// FAILURE : NULL
+///
+Arena *ArenaDeinit (Arena *arena);
+
+///
+/// Allocate memory from arena. Returned memory is NOT zeroed.
+///
+/// arena[in,out] : Arena to allocate from.
+/// size[in]      : Number of bytes to allocate.
+/// align[in]     : Alignment of returned memory. Must be a power of two.
+///
+/// SUCCESS : Pointer to allocated memory.
+/// FAILURE : NULL
+///
+void *ArenaAlloc (Arena *arena, size_t size, size_t align);
+
+///
+/// Allocate zeroed memory for `n` objects of type `T` from arena.
+///
+#define ArenaNew(arena, T, n) ((T *)arena_alloc_zero ((arena), sizeof (T) * (n), _Alignof (T)))
+
+///
+/// Get current position of arena, to `ArenaRestore` back to later.
+///
+/// arena[in] : Arena to take mark of.
+///
+/// RETURN : Mark of current arena position.
+///
+ArenaMark ArenaGetMark (Arena *arena);
+
+///
+/// Release everything allocated after given mark was taken.
+/// Released blocks are kept around for reuse.
+///
+/// arena[in,out] : Arena to restore.
+/// mark[in]      : Mark previously taken with `ArenaGetMark` on same arena.
+///
+/// SUCCESS : `arena`
+/// FAILURE : NULL
+///
+Arena *ArenaRestore (Arena *arena, ArenaMark mark);
+
+///
+/// Release everything allocated from arena so far.
+/// Released blocks are kept around for reuse.
+///
+/// arena[in,out] : Arena to reset.
+///
+/// SUCCESS : `arena`
+/// FAILURE : NULL
+///
+#define ArenaReset(arena) ArenaRestore ((arena), (ArenaMark) {0})
+
+void *arena_alloc_zero (Arena *arena, size_t size, size_t align);
+
+#endif // MISRA_STD_ARENA_H
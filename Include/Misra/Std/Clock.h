@@ -0,0 +1,78 @@
+/// file      : misra/std/clock.h
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, All rights reserved.
+///
+/// Cheap timestamps for logging and tracing.
+///
+/// Coarse clocks are updated once every timer tick (a few ms) but are just a
+/// memory read. Precise clocks are backed by vDSO. `ClockFastNs` uses the CPU
+/// timestamp counter directly, when it runs at constant rate.
+
+#ifndef MISRA_STD_CLOCK_H
+#define MISRA_STD_CLOCK_H
+
+// Misra
+#include <Misra/Types.h>
+
+///
+/// Nanoseconds since an arbitrary point, never goes backwards.
+///
+u64 ClockMonotonicNs (void);
+
+///
+/// Same as `ClockMonotonicNs`, but with timer tick resolution (usually 1-4 ms).
+/// Cheapest clock available. Same as `ClockMonotonicNs` where there's no coarse clock.
+///
+u64 ClockMonotonicCoarseNs (void);
+
+///
+/// Same as `ClockMonotonicNs`, but not affected by NTP frequency adjustments.
+/// Use this to measure short intervals precisely. Same as `ClockMonotonicNs`
+/// where there's no raw clock.
+///
+u64 ClockMonotonicRawNs (void);
+
+///
+/// Nanoseconds since Unix epoch. Can jump if system time is changed.
+///
+u64 ClockRealtimeNs (void);
+
+///
+/// Same as `ClockRealtimeNs`, but with timer tick resolution, where available.
+///
+u64 ClockRealtimeCoarseNs (void);
+
+///
+/// Raw CPU timestamp counter (rdtsc) on x86-64, `ClockMonotonicRawNs` elsewhere.
+/// Convert to nanoseconds using `ClockTicksToNs`.
+///
+u64 ClockTicks (void);
+
+///
+/// Convert a difference of two `ClockTicks` values to nanoseconds.
+/// Timestamp counter is calibrated against `ClockMonotonicRawNs` on first use.
+///
+/// ticks[in] : Number of ticks.
+///
+/// RETURN : Number of nanoseconds.
+///
+u64 ClockTicksToNs (u64 ticks);
+
+///
+/// Fastest precise monotonic clock in nanoseconds. Uses timestamp counter if it is
+/// invariant (constant rate, synchronized across cores), otherwise same as
+/// `ClockMonotonicNs`. Only differences between two values are meaningful.
+///
+u64 ClockFastNs (void);
+
+///
+/// Given time as local time "YYYY-MM-DD HH:MM:SS". Formatted string is cached per thread,
+/// and formatted again only when second changes, so it's cheap to call in a loop.
+///
+/// realtime_ns[in] : Nanoseconds since Unix epoch, eg: from `ClockRealtimeCoarseNs`.
+///
+/// RETURN : Pointer to thread local string. Valid till next call from same thread.
+///
+const char *ClockWallTimeStr (u64 realtime_ns);
+
+#endif // MISRA_STD_CLOCK_H
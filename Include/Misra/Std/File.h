@@ -12,6 +12,7 @@
 
 // ct
 #include <Misra/Std/Container/Str.h>
+#include <Misra/Types.h>
 
 typedef enum {
     DIR_ENTRY_TYPE_UNKNOWN,
@@ -57,8 +58,144 @@ typedef Vec (DirEntry) DirContents;
 ///
 DirContents *ReadDirContents (DirContents *dir, const char *path);
 
+typedef struct WalkDirEntry {
+    /// Type of entry. Symbolic links are reported as links and never followed.
+    DirEntryType type;
+
+    /// Depth of entry, entries directly inside walk root are at depth 0.
+    u32 depth;
+
+    /// Descriptor of directory containing this entry, for use with `*at()` calls.
+    int dir_fd;
+
+    /// Null-terminated entry name.
+    const char *name;
+    size_t      name_len;
+
+    /// Null-terminated path of entry, starting with walk root.
+    const char *path;
+    size_t      path_len;
+} WalkDirEntry;
+
+///
+/// Decide whether an entry must be visited (and descended into, if it's
+/// a directory) or skipped.
+///
+/// entry[in]     : Entry to be tested. Valid only for duration of call.
+/// user_data[in] : User data passed to `WalkDir`.
+///
+/// RETURN : true to visit entry, false to skip it.
+///
+typedef bool (*WalkDirFilter) (const WalkDirEntry *entry, void *user_data);
+
+///
+/// Visit an entry accepted by filter.
+///
+/// entry[in]     : Entry being visited. Valid only for duration of call.
+/// user_data[in] : User data passed to `WalkDir`.
+///
+/// RETURN : true to continue walk, false to stop it as soon as possible.
+///
+typedef bool (*WalkDirVisitor) (const WalkDirEntry *entry, void *user_data);
+
+///
+/// Recursively walk a directory tree.
+///
+/// Directory entries are read in large batches (getdents64 on Linux) and
+/// no memory is allocated per entry, so entries rejected by `filter` cost
+/// nothing but the filter call. Directories are opened relative to their
+/// parent directory descriptor, with or without threads, so a directory
+/// replaced by a symbolic link during walk is not followed.
+///
+/// With `nthreads` > 1, subdirectories are distributed across that many
+/// worker threads. Order of visits is then unspecified and `filter` and
+/// `visit` must be thread-safe.
+///
+/// root[in]      : Path of directory to walk.
+/// filter[in]    : Optional filter, all entries are visited if NULL.
+/// visit[in]     : Visitor called for each accepted entry.
+/// user_data[in] : Passed as is to filter and visitor.
+/// nthreads[in]  : Number of threads to walk with. 0 or 1 means walk on calling thread.
+///
+/// SUCCESS : true, complete tree walked or visitor stopped the walk.
+/// FAILURE : false, root can't be opened, a directory can't be read, or path of an
+///           entry doesn't fit in `PATH_MAX`. Rest of tree is still walked.
+///
+bool WalkDir (
+    const char    *root,
+    WalkDirFilter  filter,
+    WalkDirVisitor visit,
+    void          *user_data,
+    u32            nthreads
+);
+
+///
+/// Metadata of a file, as stored in process-wide file info cache.
+///
+typedef struct FileInfo {
+    int64_t size;
+    int64_t mtime_ns;
+    int64_t ctime_ns;
+    u64     inode;
+    u64     device;
+
+    /// Hash of file contents. Valid only if `has_hash` is set.
+    u64  hash;
+    bool has_hash;
+} FileInfo;
+
+typedef enum FileInfoFlags {
+    /// Always `stat` the file and compare mtime, ctime, inode and size with
+    /// cached info. Content hash is dropped if any of these changed.
+    FILE_INFO_VALIDATE = 0,
+
+    /// Return cached info of an existing file without any syscall, if it was
+    /// looked up in current cache generation.
+    FILE_INFO_CACHED = 1 << 0,
+
+    /// Same as `FILE_INFO_CACHED`, for files that were missing as well.
+    FILE_INFO_CACHE_MISSING = 1 << 1,
+
+    /// Compute hash of file contents if not already known.
+    FILE_INFO_HASH = 1 << 2,
+} FileInfoFlags;
+
+///
+/// Get metadata of file through process-wide file info cache.
+///
+/// By default file is always `stat`ed, and cache only keeps content hash of
+/// unchanged files. With `FILE_INFO_CACHED`, entries looked up in current
+/// cache generation are returned without any syscall, and so may be stale
+/// until `FileInfoCacheBump`. Missing files are only trusted from cache with
+/// `FILE_INFO_CACHE_MISSING`, in which case `errno` is same as when file was
+/// looked up. Safe to be called from multiple threads at once.
+///
+/// path[in]  : Name/path of file.
+/// info[out] : File metadata is stored here.
+/// flags[in] : Combination of `FileInfoFlags`.
+///
+/// SUCCESS : true
+/// FAILURE : false, file does not exist or can't be read.
+///
+bool GetFileInfo (const char *path, FileInfo *info, FileInfoFlags flags);
+
+///
+/// Start a new file info cache generation. All cached entries are
+/// revalidated with a `stat` on their next lookup, even with
+/// `FILE_INFO_CACHED`.
+///
+/// RETURN : New generation number.
+///
+u64 FileInfoCacheBump (void);
+
+///
+/// Remove all entries from file info cache and release it's memory.
+///
+void FileInfoCacheClear (void);
+
 ///
 /// Get size of file without opening it.
+/// File is always `stat`ed, file info cache is not used.
 ///
 /// filename[in] : Name/path of file.
 ///
@@ -8,27 +8,147 @@
 #define MISRA_STD_LOG_H
 
 #include <errno.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <string.h>
 
 // Misra
 #include <Misra/Types.h>
 
-#define LOG_FATAL(fmt, ...)                                                                        \
-    LogWrite (LOG_MESSAGE_TYPE_FATAL, __FUNCTION__, __LINE__, fmt, #__VA_ARGS__)
+///
+/// Log levels. Messages of a level above `LOG_LEVEL` are compiled out completely.
+///
+#define LOG_LEVEL_NONE  -1
+#define LOG_LEVEL_FATAL 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_INFO  2
 
-#define LOG_ERROR(fmt, ...)                                                                        \
-    LogWrite (LOG_MESSAGE_TYPE_ERROR, __FUNCTION__, __LINE__, fmt, #__VA_ARGS__)
+///
+/// Minimum level of messages that will be compiled in. Define it before including
+/// this header or pass it on command line (eg: `-DLOG_LEVEL=LOG_LEVEL_FATAL`) for
+/// release builds, so that disabled log sites cost nothing. Format strings and
+/// arguments of disabled sites are still type checked, but never evaluated.
+///
+#ifndef LOG_LEVEL
+#    define LOG_LEVEL LOG_LEVEL_INFO
+#endif
 
-#define LOG_INFO(fmt, ...)                                                                         \
-    LogWrite (LOG_MESSAGE_TYPE_INFO, __FUNCTION__, __LINE__, fmt, #__VA_ARGS__)
+///
+/// Each log site writes at most `LOG_RATE_LIMIT_BURST` messages every
+/// `LOG_RATE_LIMIT_WINDOW_MS`. Rest are counted and reported as a single
+/// "message repeated N times" line. FATAL messages are never suppressed.
+/// Define `LOG_RATE_LIMIT_BURST` as 0 to disable rate limiting.
+///
+#ifndef LOG_RATE_LIMIT_BURST
+#    define LOG_RATE_LIMIT_BURST 10
+#endif
+
+#ifndef LOG_RATE_LIMIT_WINDOW_MS
+#    define LOG_RATE_LIMIT_WINDOW_MS 1000
+#endif
 
 typedef enum {
-    LOG_MESSAGE_TYPE_FATAL,
-    LOG_MESSAGE_TYPE_ERROR,
-    LOG_MESSAGE_TYPE_INFO
+    LOG_MESSAGE_TYPE_FATAL = LOG_LEVEL_FATAL,
+    LOG_MESSAGE_TYPE_ERROR = LOG_LEVEL_ERROR,
+    LOG_MESSAGE_TYPE_INFO  = LOG_LEVEL_INFO
 } LogMessageType;
 
+///
+/// Static information about a single `LOG_*` call site. Only the arguments are
+/// recorded for each message, everything else is looked up from it's site.
+///
+typedef struct LogSite LogSite;
+
+struct LogSite {
+    LogMessageType type;
+    const char    *tag;
+    const char    *file;
+    int            line;
+    const char    *format;
+
+    /// Id of site in binary log, assigned when site is first written there.
+    u32 id;
+    u32 generation;
+
+    /// Rate limiting : messages in current window, when window ends, and
+    /// messages suppressed so far.
+    _Atomic u32 count;
+    _Atomic u64 window_end_ns;
+    _Atomic u64 suppressed;
+
+    /// Rate limited sites are linked together, so their suppressed counts can be reported.
+    _Atomic bool limited;
+    LogSite     *next_limited;
+    u64          last_report_ns;
+};
+
+///
+/// Slow path of `LogSiteAllow`, taken once a site has used up it's burst.
+/// Starts a new window when current one is over, otherwise counts message
+/// as suppressed.
+///
+/// site[in,out] : Call site to be checked.
+///
+/// RETURN : true if message must be suppressed, false otherwise.
+///
+bool LogSiteRateLimited (LogSite *site);
+
+///
+/// Decide whether a message from given site must be written or suppressed.
+/// Fast path is a single atomic increment, clock is read only after a site
+/// has already written `LOG_RATE_LIMIT_BURST` messages.
+///
+static inline bool LogSiteAllow (LogSite *site) {
+    if (!LOG_RATE_LIMIT_BURST || site->type == LOG_MESSAGE_TYPE_FATAL ||
+        atomic_fetch_add_explicit (&site->count, 1, memory_order_relaxed) < LOG_RATE_LIMIT_BURST) {
+        return true;
+    }
+
+    return !LogSiteRateLimited (site);
+}
+
+#define LOG_FIRST_ARG(...)       LOG_FIRST_ARG_IMPL (__VA_ARGS__, ~)
+#define LOG_FIRST_ARG_IMPL(x, ...) x
+
+#define LOG_SITE_WRITE(msg_type, ...)                                                              \
+    do {                                                                                           \
+        static LogSite log_site = {                                                                \
+            .type   = msg_type,                                                                    \
+            .tag    = __FUNCTION__,                                                                \
+            .file   = __FILE__,                                                                    \
+            .line   = __LINE__,                                                                    \
+            .format = LOG_FIRST_ARG (__VA_ARGS__)                                                  \
+        };                                                                                         \
+        if (LogSiteAllow (&log_site)) {                                                            \
+            LogWrite (&log_site, __VA_ARGS__);                                                     \
+        }                                                                                          \
+    } while (0)
+
+#define LOG_SITE_DISABLED(...)                                                                     \
+    do {                                                                                           \
+        if (0) {                                                                                   \
+            LogWrite (NULL, __VA_ARGS__);                                                          \
+        }                                                                                          \
+    } while (0)
+
+#if LOG_LEVEL >= LOG_LEVEL_FATAL
+#    define LOG_FATAL(...) LOG_SITE_WRITE (LOG_MESSAGE_TYPE_FATAL, __VA_ARGS__)
+#else
+#    define LOG_FATAL(...) LOG_SITE_DISABLED (__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#    define LOG_ERROR(...) LOG_SITE_WRITE (LOG_MESSAGE_TYPE_ERROR, __VA_ARGS__)
+#else
+#    define LOG_ERROR(...) LOG_SITE_DISABLED (__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#    define LOG_INFO(...) LOG_SITE_WRITE (LOG_MESSAGE_TYPE_INFO, __VA_ARGS__)
+#else
+#    define LOG_INFO(...) LOG_SITE_DISABLED (__VA_ARGS__)
+#endif
+
 ///
 /// Initialize logging engine.
 ///
@@ -38,18 +158,56 @@ typedef enum {
 void LogInit (bool redirect);
 
 ///
-/// Shutdown logging engine.
+/// Shutdown logging engine. All pending messages are written out.
 ///
 void LogDeinit();
 
 ///
-/// Generate the log message
+/// Write out all pending log messages of all threads, and wait till done.
+/// Messages are written asynchronously by a background thread, so call this
+/// when logs must be visible before continuing (eg: before a crash).
+/// Pending messages are automatically flushed at exit.
+///
+void LogFlush();
+
+///
+/// Write all log messages to given file in compact binary format, instead of text.
+/// Each message is stored as it's site id and raw arguments. Information about each
+/// site (format string, function, line, ...) is stored only once, before it's first
+/// message. Use `LogDecode` (or `log_decode` tool) to convert it to text later.
+///
+/// path[in] : Path of binary log file, created or overwritten.
+///
+/// SUCCESS : true
+/// FAILURE : false
+///
+bool LogInitBinary (const char *path);
+
+///
+/// Convert a binary log created after `LogInitBinary` to text.
+///
+/// in_fd[in]  : File descriptor to read binary log from.
+/// out_fd[in] : File descriptor to write text log to.
+///
+/// SUCCESS : true
+/// FAILURE : false, input is not a valid binary log.
+///
+bool LogDecode (int in_fd, int out_fd);
+
+///
+/// Generate the log message. This only copies arguments into a per-thread buffer,
+/// without taking any locks. Message is formatted and written later by a
+/// background thread. If buffer is full, message is dropped and a count of dropped
+/// messages is reported instead. FATAL messages are flushed before returning.
+///
+/// Use `LOG_*` macros instead of calling this directly, they create the call site.
+/// Since formatting is deferred, `format` must be same as `site->format`, this is
+/// asserted unless `NDEBUG` is defined. String arguments are copied and may be temporary.
 ///
-/// type[in]   : Log message type (info, error, fatal)
-/// tag[in]    : Log message idenfifier, something like file, function, name etc...
-/// line[in]   : Line number at which this log was generated.
+/// site[in]   : Call site this message is generated from.
 /// format[in] : Format string and following variadic arguments
 ///
-void LogWrite (LogMessageType type, const char *tag, int line, const char *format, ...);
+void LogWrite (const LogSite *site, const char *format, ...)
+    __attribute__ ((format (printf, 2, 3)));
 
 #endif // MISRA_STD_LOG_H
@@ -0,0 +1,450 @@
+/// file      : misra/std/watch.h
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, All rights reserved.
+///
+/// Watch directories for file changes (inotify based).
+///
+/// Header only, so that Vidyut can use it to implement `--watch` before
+/// misra_std is built. For the same reason nothing here logs, failures are
+/// reported through return value and `errno`.
+///
+/// inotify is Linux only. Everywhere else the watcher can't be initialized,
+/// and every function fails with `errno` set to `ENOSYS`.
+
+#ifndef MISRA_STD_WATCH_H
+#define MISRA_STD_WATCH_H
+
+// platform
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Vidyut uses <stdbool.h>, which cannot be mixed with bool of Misra/Types.h
+#ifdef __bool_true_false_are_defined
+typedef unsigned int u32;
+typedef signed int   i32;
+#else
+#    include "../Types.h"
+#endif
+
+///
+/// Paths of changed files reported by `WatcherWait`, sorted.
+/// Every path is present only once, no matter how many events it got.
+///
+typedef struct WatchChanges {
+    char  **paths;
+    size_t  length;
+    size_t  capacity;
+
+    /// Kernel dropped events, anything might have changed. Every watched
+    /// directory is reported as changed in `paths`.
+    bool overflow;
+} WatchChanges;
+
+typedef struct Watcher {
+    /// inotify instance, -1 when not initialized.
+    int fd;
+
+    /// After a change, wait till no more changes come in for this long,
+    /// before reporting changes.
+    u32 debounce_ms;
+
+    /// Paths of watched directories, indexed by watch descriptor.
+    /// NULL for descriptors not in use.
+    char **dirs;
+
+    /// Directories that are watched recursively, indexed by watch descriptor.
+    /// New subdirectories created inside these are watched automatically.
+    bool *recursive;
+
+    /// Number of entries in `dirs` and `recursive`.
+    size_t length;
+} Watcher;
+
+///
+/// Release paths held by `changes`, leaving it empty.
+///
+/// changes[in,out] : Changes to be de-initialized.
+///
+static inline void WatchChangesDeinit (WatchChanges *changes) {
+    if (!changes) {
+        return;
+    }
+
+    for (size_t i = 0; i < changes->length; i++) {
+        free (changes->paths[i]);
+    }
+    free (changes->paths);
+    memset (changes, 0, sizeof (WatchChanges));
+}
+
+///
+/// Stop watching and release all resources.
+///
+/// w[in,out] : Watcher to be de-initialized.
+///
+/// SUCCESS : `w`
+/// FAILURE : NULL
+///
+static inline Watcher *WatcherDeinit (Watcher *w) {
+    if (!w) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    if (w->fd >= 0) {
+        close (w->fd);
+    }
+
+    for (size_t i = 0; i < w->length; i++) {
+        free (w->dirs[i]);
+    }
+    free (w->dirs);
+    free (w->recursive);
+
+    memset (w, 0, sizeof (Watcher));
+    w->fd = -1;
+
+    return w;
+}
+
+#ifdef __linux__
+
+#    include <dirent.h>
+#    include <poll.h>
+#    include <sys/inotify.h>
+#    include <sys/stat.h>
+
+#    define WATCHER_MASK                                                                           \
+        (IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF)
+
+///
+/// Initialize a new watcher.
+///
+/// w[out]          : Watcher to be initialized.
+/// debounce_ms[in] : Quiet period to wait for after a change, before reporting it.
+///
+/// SUCCESS : `w`
+/// FAILURE : NULL, `errno` tells why.
+///
+static inline Watcher *WatcherInit (Watcher *w, u32 debounce_ms) {
+    if (!w) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    memset (w, 0, sizeof (Watcher));
+    w->debounce_ms = debounce_ms;
+
+    w->fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+    if (w->fd < 0) {
+        return NULL;
+    }
+
+    return w;
+}
+
+// Take ownership of `path` and add it to changes.
+static inline bool watch_changes_push (WatchChanges *changes, char *path) {
+    if (!path) {
+        return false;
+    }
+
+    if (changes->length == changes->capacity) {
+        size_t capacity = changes->capacity ? changes->capacity * 2 : 16;
+        char **paths    = realloc (changes->paths, capacity * sizeof (char *));
+        if (!paths) {
+            free (path);
+            return false;
+        }
+        changes->paths    = paths;
+        changes->capacity = capacity;
+    }
+
+    changes->paths[changes->length++] = path;
+    return true;
+}
+
+// Join directory and name into a newly allocated path.
+static inline char *watcher_join_path (const char *dir, const char *name) {
+    size_t size = strlen (dir) + strlen (name) + 2;
+    char  *path = malloc (size);
+    if (path) {
+        snprintf (path, size, "%s/%s", dir, name);
+    }
+    return path;
+}
+
+static inline bool watcher_add_one (Watcher *w, const char *path, bool recursive) {
+    int wd = inotify_add_watch (w->fd, path, WATCHER_MASK | IN_ONLYDIR);
+    if (wd < 0) {
+        return false;
+    }
+
+    // watch descriptors are small integers, use them directly as index
+    if ((size_t)wd >= w->length) {
+        char **dirs = realloc (w->dirs, (wd + 1) * sizeof (char *));
+        if (dirs) {
+            w->dirs = dirs;
+        }
+
+        bool *recursive = realloc (w->recursive, (wd + 1) * sizeof (bool));
+        if (recursive) {
+            w->recursive = recursive;
+        }
+
+        // extra capacity left by a partial failure is harmless, `length` isn't updated
+        if (!dirs || !recursive) {
+            inotify_rm_watch (w->fd, wd);
+            errno = ENOMEM;
+            return false;
+        }
+
+        memset (w->dirs + w->length, 0, (wd + 1 - w->length) * sizeof (char *));
+        memset (w->recursive + w->length, 0, (wd + 1 - w->length) * sizeof (bool));
+        w->length = wd + 1;
+    }
+
+    // same directory watched again gets same descriptor, keep spelling used first
+    if (!w->dirs[wd]) {
+        w->dirs[wd] = strdup (path);
+        if (!w->dirs[wd]) {
+            inotify_rm_watch (w->fd, wd);
+            errno = ENOMEM;
+            return false;
+        }
+    }
+    w->recursive[wd] = w->recursive[wd] || recursive;
+
+    return true;
+}
+
+// Watch every directory below `path`. Walk continues past failures, but reports them.
+static inline bool watcher_add_tree (Watcher *w, const char *path) {
+    DIR *dir = opendir (path);
+    if (!dir) {
+        return false;
+    }
+
+    bool           ok = true;
+    struct dirent *entry;
+    while ((entry = readdir (dir))) {
+        if (!strcmp (entry->d_name, ".") || !strcmp (entry->d_name, "..")) {
+            continue;
+        }
+
+        char *child = watcher_join_path (path, entry->d_name);
+        if (!child) {
+            ok = false;
+            break;
+        }
+
+        struct stat st;
+        bool        is_dir = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN && !lstat (child, &st)) {
+            is_dir = S_ISDIR (st.st_mode);
+        }
+
+        if (is_dir) {
+            ok = watcher_add_one (w, child, true) && ok;
+            ok = watcher_add_tree (w, child) && ok;
+        }
+        free (child);
+    }
+
+    closedir (dir);
+    return ok;
+}
+
+///
+/// Start watching given directory for changes in files directly inside it,
+/// or anywhere inside it's tree if `recursive` is set.
+///
+/// w[in,out]     : Watcher to add directory to.
+/// path[in]      : Path of directory to watch. Reported paths start with it.
+/// recursive[in] : Whether or not to watch all subdirectories as well.
+///
+/// SUCCESS : true
+/// FAILURE : false, `errno` tells why. Some subdirectories may still be watched.
+///
+static inline bool WatcherAddDir (Watcher *w, const char *path, bool recursive) {
+    if (!w || !path || w->fd < 0) {
+        errno = EINVAL;
+        return false;
+    }
+
+    if (!watcher_add_one (w, path, recursive)) {
+        return false;
+    }
+
+    if (recursive) {
+        return watcher_add_tree (w, path);
+    }
+
+    return true;
+}
+
+// Read all pending events and append changed paths.
+static inline bool watcher_read_events (Watcher *w, WatchChanges *changes) {
+    char buf[16 * 1024] __attribute__ ((aligned (__alignof__ (struct inotify_event))));
+
+    while (true) {
+        ssize_t len = read (w->fd, buf, sizeof (buf));
+        if (len < 0) {
+            if (errno == EAGAIN) {
+                return true;
+            } else if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        for (char *iter = buf; iter < buf + len;) {
+            struct inotify_event *ev  = (struct inotify_event *)iter;
+            iter                     += sizeof (struct inotify_event) + ev->len;
+
+            // kernel dropped events, everything might have changed
+            if (ev->mask & IN_Q_OVERFLOW) {
+                changes->overflow = true;
+                for (size_t i = 0; i < w->length; i++) {
+                    if (w->dirs[i] && !watch_changes_push (changes, strdup (w->dirs[i]))) {
+                        return false;
+                    }
+                }
+                continue;
+            }
+
+            if (ev->wd < 0 || (size_t)ev->wd >= w->length || !w->dirs[ev->wd]) {
+                continue;
+            }
+
+            // watch was removed because directory is gone
+            if (ev->mask & IN_IGNORED) {
+                free (w->dirs[ev->wd]);
+                w->dirs[ev->wd] = NULL;
+                continue;
+            }
+
+            const char *dir    = w->dirs[ev->wd];
+            char       *change = ev->len ? watcher_join_path (dir, ev->name) : strdup (dir);
+            if (!change) {
+                return false;
+            }
+
+            // start watching new subdirectories of recursively watched dirs
+            if ((ev->mask & IN_ISDIR) && (ev->mask & (IN_CREATE | IN_MOVED_TO)) &&
+                w->recursive[ev->wd]) {
+                WatcherAddDir (w, change, true);
+            }
+
+            if (!watch_changes_push (changes, change)) {
+                return false;
+            }
+        }
+    }
+}
+
+static inline int watcher_compare_paths (const void *first, const void *second) {
+    return strcmp (*(char *const *)first, *(char *const *)second);
+}
+
+///
+/// Wait for changes in watched directories. After first change, more changes
+/// are collected till none arrive for `debounce_ms` milliseconds, so a burst
+/// of writes (eg: a `git checkout`) is reported as one set of changes.
+///
+/// w[in,out]      : Watcher to wait on.
+/// changes[out]   : Changed paths are stored here. Must be zero initialized, or hold
+///                  result of a previous wait, which is released first.
+/// timeout_ms[in] : Max time to wait for first change. Negative means wait forever.
+///
+/// SUCCESS : true, `changes` contains atleast one path.
+/// FAILURE : false, timed out (`errno` is `ETIMEDOUT`) or an error occured.
+///
+static inline bool WatcherWait (Watcher *w, WatchChanges *changes, i32 timeout_ms) {
+    if (!w || !changes || w->fd < 0) {
+        errno = EINVAL;
+        return false;
+    }
+
+    WatchChangesDeinit (changes);
+
+    struct pollfd pfd     = {.fd = w->fd, .events = POLLIN};
+    i32           timeout = timeout_ms;
+
+    // wait for first change, then keep collecting till things settle down
+    while (true) {
+        int ret = poll (&pfd, 1, timeout);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        if (!ret) {
+            break;
+        }
+
+        if (!watcher_read_events (w, changes)) {
+            return false;
+        }
+
+        if (changes->length) {
+            timeout = w->debounce_ms;
+        }
+    }
+
+    if (!changes->length) {
+        errno = ETIMEDOUT;
+        return false;
+    }
+
+    // coalesce multiple events on same path
+    qsort (changes->paths, changes->length, sizeof (char *), watcher_compare_paths);
+    size_t nunique = 1;
+    for (size_t i = 1; i < changes->length; i++) {
+        if (!strcmp (changes->paths[nunique - 1], changes->paths[i])) {
+            free (changes->paths[i]);
+        } else {
+            changes->paths[nunique++] = changes->paths[i];
+        }
+    }
+    changes->length = nunique;
+
+    return true;
+}
+
+#else
+
+static inline Watcher *WatcherInit (Watcher *w, u32 debounce_ms) {
+    (void)debounce_ms;
+    if (w) {
+        memset (w, 0, sizeof (Watcher));
+        w->fd = -1;
+    }
+    errno = w ? ENOSYS : EINVAL;
+    return NULL;
+}
+
+static inline bool WatcherAddDir (Watcher *w, const char *path, bool recursive) {
+    (void)w;
+    (void)path;
+    (void)recursive;
+    errno = ENOSYS;
+    return false;
+}
+
+static inline bool WatcherWait (Watcher *w, WatchChanges *changes, i32 timeout_ms) {
+    (void)w;
+    (void)timeout_ms;
+    WatchChangesDeinit (changes);
+    errno = ENOSYS;
+    return false;
+}
+
+#endif // __linux__
+
+#endif // MISRA_STD_WATCH_H
@@ -1,25 +1,172 @@
+#include <Misra/Mc/Driver.h>
 #include <Misra/Mc/Parser/ASTNodeTypes.h>
+#include <Misra/Std/Container/Str.h>
+#include <Misra/Std/File.h>
 #include <Misra/Std/Log.h>
 
-int main (int argc, char** argv) {
-    if (argc < 2) {
-        fprintf (stderr, "usage: mcc <src>\n");
-        return 1;
+// platform
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// response files may name other response files, but only this deep
+#define MAX_RESPONSE_DEPTH 8
+
+typedef Vec (const char*) PathVec;
+typedef Vec (Str) StrVec;
+
+static void usage (void) {
+    fprintf (stderr, "usage: mcc [--binary-log <log>] [-j <threads>] <src|@rsp>...\n");
+    fprintf (stderr, "       mcc [--binary-log <log>] -      (read source from stdin)\n");
+    fprintf (stderr, "\n");
+    fprintf (stderr, "  @rsp : read more inputs from file rsp, separated by whitespace\n");
+    fprintf (stderr, "  -j   : number of files checked at once, all CPUs by default\n");
+}
+
+
+static bool add_input (PathVec* paths, StrVec* rsps, const char* arg, u32 depth);
+
+// Add every whitespace separated word of a response file as an input.
+// Words point into file contents, which are kept in `rsps` till exit.
+static bool add_response_file (PathVec* paths, StrVec* rsps, const char* name, u32 depth) {
+    if (depth >= MAX_RESPONSE_DEPTH) {
+        LOG_ERROR ("response files nested too deep at \"%s\".", name);
+        return false;
+    }
+
+    Str rsp = {0};
+    StrInit (&rsp);
+    if (!ReadCompleteFile (name, (void**)&rsp.data, &rsp.length, &rsp.capacity)) {
+        LOG_ERROR ("failed to read response file \"%s\".", name);
+        StrDeinit (&rsp);
+        return false;
+    }
+    if (!VecPushBack (rsps, &rsp)) {
+        LOG_ERROR ("failed to keep response file.");
+        StrDeinit (&rsp);
+        return false;
     }
 
-    const char* src_name = argv[1];
+    // contents are null-terminated, words are cut in place
+    char* s = VecLast (rsps).data;
+    while (*s) {
+        while (*s && strchr (" \t\r\n\f\v", *s)) {
+            *s++ = 0;
+        }
+        if (!*s) {
+            break;
+        }
+
+        const char* word = s;
+        while (*s && !strchr (" \t\r\n\f\v", *s)) {
+            s++;
+        }
+        if (*s) {
+            *s++ = 0;
+        }
+
+        if (!add_input (paths, rsps, word, depth + 1)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+static bool add_input (PathVec* paths, StrVec* rsps, const char* arg, u32 depth) {
+    if (arg[0] == '@') {
+        return add_response_file (paths, rsps, arg + 1, depth);
+    }
+
+    if (!VecPushBack (paths, &arg)) {
+        LOG_ERROR ("failed to add input.");
+        return false;
+    }
+    return true;
+}
+
+
+static void report_file (const McFileResult* r, void* user_data) {
+    (void)user_data;
 
+    if (r->ok) {
+        printf ("%s : ok, %llu items\n", r->path, r->nitems);
+    } else {
+        printf ("%s : error : %s\n", r->path, r->message);
+    }
+}
+
+
+// parse source from stdin, without ever holding complete source in memory
+static int run_stdin (void) {
     McParser parser = {0};
-    if (!McParserInitFromFile (&parser, src_name)) {
+    if (!McParserInitFromFd (&parser, STDIN_FILENO, 0)) {
         LOG_ERROR ("failed to init parser.");
         return 1;
     }
 
+    // report every error, not just first one
+    McParserEnableRecovery (&parser, 0);
+
     McProgram program = {};
 
-    printf ("program = %b\n", McParseProgram (&program, &parser));
+    bool ok = McParseProgram (&program, &parser);
+    VecForeachPtr (&parser.recovery.diagnostics, d, {
+        printf ("%llu:%llu : %.*s\n", d->line, d->column, (int)d->message.length, d->message.data);
+    });
+    printf ("program = %b\n", ok);
 
     McParserDeinit (&parser);
 
-    return 0;
+    return ok ? 0 : 1;
+}
+
+
+int main (int argc, char** argv) {
+    // write logs in compact binary format, decode with log_decode
+    if (argc > 2 && !strcmp (argv[1], "--binary-log")) {
+        if (!LogInitBinary (argv[2])) {
+            return 1;
+        }
+        argc -= 2;
+        argv += 2;
+    }
+
+    u32 nthreads = 0;
+    if (argc > 2 && !strcmp (argv[1], "-j")) {
+        nthreads = strtoul (argv[2], NULL, 10);
+        argc    -= 2;
+        argv    += 2;
+    }
+
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+
+    if (argc == 2 && !strcmp (argv[1], "-")) {
+        return run_stdin();
+    }
+
+    PathVec paths = {0};
+    StrVec  rsps  = {0};
+    VecInit (&paths, NULL, NULL);
+    VecInit (&rsps, NULL, NULL);
+
+    int status = 0;
+    for (int idx = 1; idx < argc && !status; idx++) {
+        status = !add_input (&paths, &rsps, argv[idx], 0);
+    }
+
+    if (!status) {
+        u64 nfailed = McDriverCheckFiles (paths.data, paths.length, nthreads, report_file, NULL);
+        status      = nfailed != 0;
+    }
+
+    VecForeachPtr (&rsps, rsp, { StrDeinit (rsp); });
+    VecDeinit (&rsps);
+    VecDeinit (&paths);
+
+    return status;
 }
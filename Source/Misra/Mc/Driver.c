@@ -0,0 +1,240 @@
+/// file      : misra/mc/driver.c
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Multi-file front-end driver.
+
+#include <Misra/Mc/Driver.h>
+#include <Misra/Mc/Parser/Document.h>
+#include <Misra/Std/Arena.h>
+#include <Misra/Std/Container/Vec.h>
+#include <Misra/Std/Log.h>
+
+// platform
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// most bytes of a token quoted in a message
+#define MESSAGE_MAX_TOKEN 32
+
+typedef struct DriverWork {
+    const char* const* paths;
+    u64                npaths;
+
+    /// Result of each file, and whether it's complete.
+    Vec (McFileResult) results;
+    Vec (bool) done;
+
+    /// Index of next file no worker has picked yet.
+    u64 next;
+
+    /// Index of next file to report.
+    u64 reported;
+
+    /// Protects `done` and `reported`.
+    pthread_mutex_t lock;
+
+    /// Signalled when file at `reported` is done.
+    pthread_cond_t cond;
+} DriverWork;
+
+typedef struct DriverWorker {
+    DriverWork* work;
+
+    /// Messages of files checked by this worker. They must outlive worker's
+    /// documents till they're reported, and are all released at once.
+    Arena arena;
+
+    pthread_t thread;
+} DriverWorker;
+
+// Format a message into arena.
+static const char* arena_printf (Arena* arena, const char* fmt, ...) {
+    va_list args;
+
+    va_start (args, fmt);
+    int n = vsnprintf (NULL, 0, fmt, args);
+    va_end (args);
+    if (n < 0) {
+        return NULL;
+    }
+
+    char* msg = ArenaAlloc (arena, n + 1, 1);
+    if (!msg) {
+        return NULL;
+    }
+
+    va_start (args, fmt);
+    vsnprintf (msg, n + 1, fmt, args);
+    va_end (args);
+
+    return msg;
+}
+
+
+// Read, lex and parse a single file.
+static void check_file (McFileResult* r, Arena* arena) {
+    McDocument doc = {0};
+    if (!McDocumentInitFromFile (&doc, r->path)) {
+        r->message = "failed to read file";
+        return;
+    }
+
+    r->nbytes = doc.parser.code.length;
+    r->nitems = doc.items.length;
+
+    for (u64 idx = 0; idx < doc.items.length; idx++) {
+        McItem* item = VecIter (&doc.items, idx);
+        if (item->item_kind != MC_ITEM_KIND_INVALID || r->ninvalid++) {
+            continue;
+        }
+
+        // report where parser got stuck, not where item starts
+        McToken* tok    = VecIter (&doc.parser.lexer.tokens, item->error_tok);
+        u64      line   = 0;
+        u64      column = 0;
+        McParserLocate (&doc.parser, tok->offset, &line, &column);
+        if (tok->kind == MC_TOKEN_KIND_EOF) {
+            r->message = arena_printf (arena, "%llu:%llu : unexpected end of code", line, column);
+        } else {
+            r->message = arena_printf (
+                arena,
+                "%llu:%llu : unexpected \"%.*s\"",
+                line,
+                column,
+                (int)(tok->length < MESSAGE_MAX_TOKEN ? tok->length : MESSAGE_MAX_TOKEN),
+                doc.parser.code.data + tok->offset
+            );
+        }
+        if (!r->message) {
+            r->message = "invalid item";
+        }
+    }
+
+    r->ok = !r->ninvalid;
+    McDocumentDeinit (&doc);
+}
+
+
+// Check file at given index, and mark it done.
+static void run_file (DriverWork* work, Arena* arena, u64 idx) {
+    check_file (VecIter (&work->results, idx), arena);
+
+    pthread_mutex_lock (&work->lock);
+    VecAt (&work->done, idx) = true;
+    if (idx == work->reported) {
+        pthread_cond_signal (&work->cond);
+    }
+    pthread_mutex_unlock (&work->lock);
+}
+
+
+static void* worker_main (void* arg) {
+    DriverWorker* w = arg;
+
+    u64 idx;
+    while ((idx = __atomic_fetch_add (&w->work->next, 1, __ATOMIC_RELAXED)) < w->work->npaths) {
+        run_file (w->work, &w->arena, idx);
+    }
+
+    return NULL;
+}
+
+
+u64 McDriverCheckFiles (
+    const char* const* paths,
+    u64                npaths,
+    u32                nthreads,
+    McDriverReport     report,
+    void*              user_data
+) {
+    if ((!paths && npaths) || !report) {
+        LOG_ERROR ("invalid arguments.");
+        return (u64)-1;
+    }
+
+    if (!nthreads) {
+        long ncpu = sysconf (_SC_NPROCESSORS_ONLN);
+        nthreads  = ncpu > 0 ? ncpu : 1;
+    }
+    if (nthreads > MC_DRIVER_MAX_THREADS) {
+        nthreads = MC_DRIVER_MAX_THREADS;
+    }
+
+    DriverWork work = {.paths = paths, .npaths = npaths};
+    VecInit (&work.results, NULL, NULL);
+    VecInit (&work.done, NULL, NULL);
+    if (npaths && (!VecResize (&work.results, npaths) || !VecResize (&work.done, npaths))) {
+        LOG_ERROR ("failed to allocate results.");
+        VecDeinit (&work.results);
+        VecDeinit (&work.done);
+        return (u64)-1;
+    }
+    for (u64 idx = 0; idx < npaths; idx++) {
+        VecAt (&work.results, idx) = (McFileResult) {.index = idx, .path = paths[idx]};
+        VecAt (&work.done, idx)    = false;
+    }
+    pthread_mutex_init (&work.lock, NULL);
+    pthread_cond_init (&work.cond, NULL);
+
+    // first worker is this thread, it also reports results
+    DriverWorker workers[MC_DRIVER_MAX_THREADS];
+    u32          nstarted = 1;
+    workers[0].work       = &work;
+    ArenaInit (&workers[0].arena, 0);
+    while (nstarted < nthreads && nstarted < npaths) {
+        DriverWorker* w = &workers[nstarted];
+        w->work         = &work;
+        ArenaInit (&w->arena, 0);
+        if (pthread_create (&w->thread, NULL, worker_main, w)) {
+            ArenaDeinit (&w->arena);
+            break;
+        }
+        nstarted++;
+    }
+
+    // report files in order as they get done, and check files in between
+    u64 nfailed = 0;
+    pthread_mutex_lock (&work.lock);
+    while (work.reported < npaths) {
+        if (VecAt (&work.done, work.reported)) {
+            McFileResult* r = VecIter (&work.results, work.reported);
+            pthread_mutex_unlock (&work.lock);
+
+            nfailed += !r->ok;
+            report (r, user_data);
+
+            pthread_mutex_lock (&work.lock);
+            work.reported++;
+            continue;
+        }
+
+        u64 idx = __atomic_fetch_add (&work.next, 1, __ATOMIC_RELAXED);
+        if (idx < npaths) {
+            pthread_mutex_unlock (&work.lock);
+            run_file (&work, &workers[0].arena, idx);
+            pthread_mutex_lock (&work.lock);
+            continue;
+        }
+
+        pthread_cond_wait (&work.cond, &work.lock);
+    }
+    pthread_mutex_unlock (&work.lock);
+
+    for (u32 idx = 1; idx < nstarted; idx++) {
+        pthread_join (workers[idx].thread, NULL);
+    }
+    for (u32 idx = 0; idx < nstarted; idx++) {
+        ArenaDeinit (&workers[idx].arena);
+    }
+
+    pthread_cond_destroy (&work.cond);
+    pthread_mutex_destroy (&work.lock);
+    VecDeinit (&work.results);
+    VecDeinit (&work.done);
+
+    return nfailed;
+}
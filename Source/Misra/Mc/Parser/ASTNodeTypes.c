@@ -5,10 +5,17 @@
 /// Method definitions to interact with Mc AST node types.
 
 #include <Misra/Mc/Parser/ASTNodeTypes.h>
+#include <Misra/Mc/Parser/Fold.h>
+#include <Misra/Mc/Parser/Literal.h>
 #include <Misra/Std/Container/Str.h>
 #include <Misra/Std/File.h>
 #include <Misra/Std/Log.h>
 
+// platform
+#include <stdarg.h>
+#include <stdio.h>
+#include <unistd.h>
+
 #define IS_DIGIT(c) ('0' <= (c) && (c) <= '9')
 #define IS_UPPER(c) ('A' <= (c) && (c) <= 'Z')
 #define IS_LOWER(c) ('a' <= (c) && (c) <= 'z')
@@ -17,6 +24,12 @@
 #define TO_LOWER(c) (IS_UPPER (c) ? 'a' + ((c) - 'A') : (c))
 #define TO_UPPER(c) (IS_LOWER (c) ? 'a' + ((c) - 'A') : (c))
 
+// window size used by streaming parsers when none is provided
+#define MC_PARSER_STREAM_DEFAULT_WINDOW_SIZE (64 * 1024)
+
+// max number of bytes pulled from stream in one read
+#define MC_PARSER_STREAM_CHUNK_SIZE (4 * 1024)
+
 static inline McType* type_deinit (McType* t) {
     if (!t) {
         LOG_ERROR ("invalid arguments.");
@@ -29,14 +42,7 @@ static inline McType* type_deinit (McType* t) {
 }
 
 
-static inline bool parse_type (McType* t, McParser* p) {
-    if (!t || !p) {
-        LOG_ERROR ("invalid arguments.");
-        return false;
-    }
-
-    return false;
-}
+static inline bool parse_type (McType* t, McParser* p);
 
 McExpr* McExprDeinit (McExpr* e) {
     if (!e) {
@@ -223,127 +229,206 @@ McType* basic_type_init (
 
 
 ///
-/// Check whether there's enough space to read N bytes.
-///
-/// The read is bi-directional, meaning negative value for `n`
-/// means a read attempt backwards, and a positive value for `n`
-/// means a read attempt forwards.
+/// Pull one more chunk of code from stream into parser window.
 ///
-/// Backward reading means reading from current read position towards
-/// the beginning of string. On the other hand, forward reading is
-/// reading from current position towards the string end.
+/// Window is never reallocated here, because lexer tokens refer to code
+/// by offsets into it and callers up the stack may rewind to any of them.
+/// When the window is full, the only way to make more space is
+/// `McParserStreamCommit`.
 ///
-///      backwards reading (-ve)
-///     ;-----------<<----------;
-///     v                       ^
-/// ;-------;----------------;-----; ... ------;-----;
-/// | begin | .............. | cur | ......... | end |
-/// ;-------;----------------;-----; ... ------;-----;
-///                             v                  ^
-///                             ;-------->>--------;
-///                              forward read (+ve)
+/// p[in,out] : Streaming McParser object to fill.
 ///
-/// p[in] : McParser object to check space into.
-/// n[in]   : Number of bytes to check for.
+/// SUCCESS : true, more code available in window.
+/// FAILURE : false, stream ended or window is full.
 ///
-/// SUCCESS : true
-/// FAILURE : false
-///
-static inline bool parser_can_read_n (const McParser* p, i64 n) {
-    if (!p) {
+static bool parser_stream_fill (McParser* p) {
+    if (!p || !p->stream.active) {
         LOG_ERROR ("invalid arguments.");
         return false;
     }
 
-    // empty string matches to true always
-    if (!n) {
-        return true;
-    }
+    while (!p->stream.eof) {
+        u64 space = p->stream.window_size - p->code.length;
+        if (!space) {
+            LOG_ERROR ("stream window exhausted, top level item does not fit in window.");
+            return false;
+        }
+
+        if (space > MC_PARSER_STREAM_CHUNK_SIZE) {
+            space = MC_PARSER_STREAM_CHUNK_SIZE;
+        }
+
+        ssize_t nread = read (p->stream.fd, p->code.data + p->code.length, space);
+        if (nread < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            LOG_ERROR ("read() failed : %s.", strerror (errno));
+            p->stream.eof = true;
+            return false;
+        }
+
+        if (!nread) {
+            p->stream.eof = true;
+            return false;
+        }
 
-    // bounds check
-    if ((p->read_pos + n) >= p->code.data && (p->read_pos + n) <= (p->code.data + p->code.length)) {
+        p->code.length               += nread;
+        p->code.data[p->code.length]  = 0;
         return true;
     }
 
     return false;
 }
 
+// returned when code cannot be lexed any further because of an error
+static const McToken invalid_token = {.kind = MC_TOKEN_KIND_INVALID};
+
 ///
-/// If it's possible to read `n` characters in forward or backward
-/// direction, then move read position by that many characters in
-/// either direction.
+/// Get token at given index, lexing more code (and pulling more code from
+/// stream for streaming parsers) if it's not lexed yet. Code is lexed only
+/// once, no matter how many times parser rewinds and looks at a token again.
 ///
-/// p[in,out] : McParser to move read position into.
-/// n[in]     : Number of bytes (+ve or -ve) to move cursor by.
+/// Returned pointer is valid only till next call, because lexing more code
+/// can reallocate token array.
 ///
-/// SUCCESS : p, read position in p moved by n in either direction.
-/// FAILURE : NULL, p unchanged
+/// p[in,out] : McParser object to get token from.
+/// idx[in]   : Index of token in lexer.
 ///
-static inline McParser* parser_move_by_n (McParser* p, i64 n) {
-    if (!p) {
-        LOG_ERROR ("invalid arguments.");
-        return false;
+/// SUCCESS : Token at given index, or `MC_TOKEN_KIND_EOF` token if index is past end of code.
+/// FAILURE : A `MC_TOKEN_KIND_INVALID` token.
+///
+static const McToken* parser_token_at (McParser* p, u64 idx) {
+    McTokenVec* tokens = &p->lexer.tokens;
+
+    if (idx >= p->peek_end) {
+        p->peek_end = idx + 1;
     }
 
-    if (parser_can_read_n (p, n)) {
-        p->read_pos += n;
+    while (idx >= tokens->length) {
+        if (tokens->length && VecLast (tokens).kind == MC_TOKEN_KIND_EOF) {
+            return &VecLast (tokens);
+        }
+
+        bool eof     = !p->stream.active || p->stream.eof;
+        u64  ntokens = tokens->length;
+        if (!McLexerRun (&p->lexer, p->code.data, p->code.length, eof)) {
+            return &invalid_token;
+        }
+
+        // all code in window is lexed, need more
+        if (tokens->length == ntokens && !eof && !parser_stream_fill (p) && !p->stream.eof) {
+            return &invalid_token;
+        }
     }
 
-    return false;
+    return VecIter (tokens, idx);
 }
 
 ///
-/// Try to read a single character at current read position. If match
-/// is success then advance by one position and return true, otherwise
-/// don't make any changes to read position and return false.
+/// Get kind of token at current parser position, without consuming it.
 ///
-/// p[in,out] : McParser object to try reading from.
-/// c[in]     : A character to match to.
+/// p[in,out] : McParser object to peek into.
 ///
-/// SUCCESS : true, read position in p is advanced by 1
-/// FAILURE : false, p is unchanged
+/// RETURN : Kind of current token.
 ///
-bool McParserReadChar (McParser* p, i8 c) {
-    if (!p) {
-        LOG_ERROR ("invalid arguments");
-        return false;
-    }
+static inline McTokenKind parser_peek (McParser* p) {
+    return parser_token_at (p, p->tok)->kind;
+}
 
-    if (parser_can_read_n (p, 1) && (p->read_pos[0] == c)) {
-        p->read_pos++;
-        return true;
-    }
+///
+/// Get offset of token at given index from start of code, to be stored in
+/// AST nodes starting at that token.
+///
+/// p[in,out] : McParser object token belongs to.
+/// idx[in]   : Index of token in lexer.
+///
+/// RETURN : Offset of token, wrapped to 32 bits.
+///
+static inline u32 parser_offset (McParser* p, u64 idx) {
+    return (u32)(p->stream.base + parser_token_at (p, idx)->offset);
+}
 
-    return false;
+///
+/// Get location of given token to report in a diagnostic.
+///
+/// p[in,out]   : McParser object token belongs to.
+/// tok[in]     : Token to locate.
+/// line[out]   : Line number, or 0 if not known.
+/// column[out] : Column number, or 0 if not known.
+///
+static inline void parser_token_loc (McParser* p, const McToken* tok, u64* line, u64* column) {
+    if (!McParserLocate (p, p->stream.base + tok->offset, line, column)) {
+        *line   = 0;
+        *column = 0;
+    }
 }
 
 ///
-/// Try to read a character array of given length at current read position
-/// in McParser object. If such array exists, then advance by given length
-/// of character array to read past that next time, and return true, otherwise
-/// return false indicating that the provided array does not exist at
-/// current read position.
+/// Record a diagnostic about given token, if parser is in error recovery
+/// mode. Diagnostics are kept in order of offset, so one at or before last
+/// recorded one is dropped : it's either same error found again after
+/// backtracking, or a vaguer report of an error already described.
 ///
-/// p[in,out] : McParser object to try reading from.
-/// zs[in]    : A character array to match to.
-/// n[in]     : Size of character array in bytes.
+/// p[in,out] : McParser object token belongs to.
+/// tok[in]   : Offending token.
+/// fmt[in]   : printf style format of message, followed by it's arguments.
 ///
-/// SUCCESS : true, read pos in p is advanced by n
-/// FAILURE : false, p is unchanged
+/// SUCCESS : true
+/// FAILURE : false, if diagnostic couldn't be recorded.
 ///
-bool McParserReadCStr (McParser* p, const char* cs, u64 n) {
-    if (!p || !cs) {
-        LOG_ERROR ("invalid arguments.");
-        return false;
+static bool parser_diagnose (McParser* p, const McToken* tok, const char* fmt, ...) {
+    McDiagnosticVec* diags = &p->recovery.diagnostics;
+    if (!p->recovery.active) {
+        return true;
     }
 
-    // matching empty string is always true
-    if (!n) {
+    u64 offset = p->stream.base + tok->offset;
+    if (diags->length && offset <= VecLast (diags).offset) {
         return true;
     }
 
-    if (parser_can_read_n (p, n) && !strncmp (p->read_pos, cs, n)) {
-        p->read_pos += n;
+    McDiagnostic d = {.offset = offset};
+    parser_token_loc (p, tok, &d.line, &d.column);
+    StrInit (&d.message);
+
+    va_list args;
+    va_start (args, fmt);
+    int n = vsnprintf (NULL, 0, fmt, args);
+    va_end (args);
+    if (n < 0 || !StrResize (&d.message, n + 1)) {
+        LOG_ERROR ("failed to format diagnostic.");
+        StrDeinit (&d.message);
+        return false;
+    }
+    va_start (args, fmt);
+    vsnprintf (d.message.data, n + 1, fmt, args);
+    va_end (args);
+    d.message.length = n;
+
+    if (!VecPushBack (diags, &d)) {
+        LOG_ERROR ("failed to add diagnostic.");
+        StrDeinit (&d.message);
+        return false;
+    }
+
+    return true;
+}
+
+
+///
+/// Consume current token if it's of given kind.
+///
+/// p[in,out] : McParser object to read token from.
+/// kind[in]  : Kind of token to match.
+///
+/// SUCCESS : true, current token is consumed.
+/// FAILURE : false, p unchanged.
+///
+static inline bool parser_accept (McParser* p, McTokenKind kind) {
+    if (parser_peek (p) == kind) {
+        p->tok++;
         return true;
     }
 
@@ -351,93 +436,173 @@ bool McParserReadCStr (McParser* p, const char* cs, u64 n) {
 }
 
 ///
-/// Try to read a zero-terminated string at current read position
-/// in McParser object. If such string exists, then advance by length
-/// of string to read past that next time, and return true, otherwise
-/// return false indicating that the provided string does not exist at
-/// current read position.
+/// Consume current token if it's of given kind, and get a copy of it.
 ///
-/// p[in,out] : McParser object to try reading from.
-/// zs[in]    : Zero-terminated string to match to.
+/// p[in,out] : McParser object to read token from.
+/// kind[in]  : Kind of token to match.
+/// tok[out]  : Copy of consumed token.
 ///
-/// SUCCESS : true, read pos in p is advanced by strlen(zs)
-/// FAILURE : false, p is unchanged
+/// SUCCESS : true, current token is consumed.
+/// FAILURE : false, p unchanged.
 ///
-bool McParserReadZStr (McParser* p, const char* zs) {
-    if (!p || !zs) {
-        LOG_ERROR ("invalid arguments.");
-        return false;
+static inline bool parser_accept_token (McParser* p, McTokenKind kind, McToken* tok) {
+    const McToken* cur = parser_token_at (p, p->tok);
+    if (cur->kind == kind) {
+        *tok = *cur;
+        p->tok++;
+        return true;
+    }
+
+    return false;
+}
+
+// memo budget used when none is provided
+#define MC_PARSER_MEMO_DEFAULT_BUDGET (1024 * 1024)
+
+// Rules remembered in packrat mode. Binary expression rule is remembered
+// separately for each minimum precedence, starting at MEMO_RULE_BINARY.
+typedef enum MemoRule {
+    MEMO_RULE_NONE = 0, // marks an empty slot
+    MEMO_RULE_TYPE,
+    MEMO_RULE_EXPR_LIST,
+    MEMO_RULE_EXPR_UNARY,
+    MEMO_RULE_EXPR_BINARY,
+} MemoRule;
+
+struct McParserMemoEntry {
+    /// Token index rule was tried at.
+    u64 tok;
+
+    /// Token index right after parsed rule, if rule matched.
+    u64 end_tok;
+
+    /// Rule that was tried, MEMO_RULE_NONE if slot is empty.
+    u32 rule;
+
+    /// Did rule match?
+    bool ok;
+
+    /// Parsed type, for MEMO_RULE_TYPE.
+    McType type;
+};
+
+// Forget everything remembered so far.
+static inline void memo_clear (McParserMemo* m) {
+    if (m->nentries) {
+        memset (m->slots, 0, m->nslots * sizeof (McParserMemoEntry));
+        m->nentries = 0;
+    }
+}
+
+
+static inline McParserMemoEntry* memo_slot (McParserMemo* m, u32 rule, u64 tok) {
+    u64 mask = m->nslots - 1;
+    u64 i    = ((tok * 0x9e3779b97f4a7c15ULL) ^ rule) & mask;
+
+    // table is never more than half full, so there's always an empty slot
+    while (m->slots[i].rule && (m->slots[i].rule != rule || m->slots[i].tok != tok)) {
+        i = (i + 1) & mask;
     }
 
-    return McParserReadCStr (p, zs, strlen (zs));
+    return &m->slots[i];
 }
 
+
 ///
-/// Read a single character without advancing the read position.
-/// Using this in conjunction with `McParserMoveBy`, a matching function
-/// can match a character optionally and advance to any position depending
-/// on that.
+/// Lookup result of trying `rule` at current parser position.
 ///
-/// p[in] : McParser object to peek character from.
+/// p[in,out] : McParser object to lookup memo of.
+/// rule[in]  : Rule to lookup.
 ///
-/// SUCCESS : Character (>=0) at current read position.
-/// FAILURE : -1.
+/// SUCCESS : Remembered entry.
+/// FAILURE : NULL, if rule was never tried here or memoization is disabled.
 ///
-static inline char parser_peek (const McParser* p) {
-    if (!p) {
-        LOG_ERROR ("invalid arguments");
-        return -1;
+static inline McParserMemoEntry* memo_recall (McParser* p, u32 rule) {
+    McParserMemo* m = &p->memo;
+    if (!m->active) {
+        return NULL;
     }
 
-    if (parser_can_read_n (p, 1)) {
-        return p->read_pos[0];
+    McParserMemoEntry* e = memo_slot (m, rule, p->tok);
+    if (!e->rule) {
+        m->misses++;
+        return NULL;
     }
 
-    return -1;
+    m->hits++;
+    return e;
 }
 
-static inline void parser_skip_ws (McParser* p) {
-    if (!p) {
-        LOG_ERROR ("invalid arguments.");
-        return;
+
+///
+/// Remember result of trying `rule` at `tok`, clearing the table first if it's full.
+///
+/// p[in,out]   : McParser object to update memo of.
+/// rule[in]    : Rule that was tried.
+/// tok[in]     : Token index rule was tried at.
+/// ok[in]      : Did rule match?
+/// end_tok[in] : Token index right after match.
+///
+/// RETURN : Remembered entry, or NULL if memoization is disabled.
+///
+static inline McParserMemoEntry* memo_store (McParser* p, u32 rule, u64 tok, bool ok, u64 end_tok) {
+    McParserMemo* m = &p->memo;
+    if (!m->active) {
+        return NULL;
+    }
+
+    if (m->nentries >= m->nslots / 2) {
+        memo_clear (m);
+        m->evictions++;
     }
 
-    while (strchr (" \t\r\n\b\f", parser_peek (p))) {
-        p->read_pos++;
+    McParserMemoEntry* e = memo_slot (m, rule, tok);
+    if (!e->rule) {
+        m->nentries++;
     }
+
+    e->rule    = rule;
+    e->tok     = tok;
+    e->ok      = ok;
+    e->end_tok = end_tok;
+
+    return e;
 }
 
+
 static inline bool parse_int (u64* si, McParser* p) {
     if (!si || !p) {
         LOG_ERROR ("invalid arguments");
         return false;
     }
 
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
-
-    // parse integer
-    u64  val = 0;
-    char c   = parser_peek (p);
-    while (IS_DIGIT (c)) {
-        val = val * 10 + (parser_peek (p) - '0');
-
-        p->read_pos++;
-        c = parser_peek (p);
-    }
-
-    c = parser_peek (p);
-    if (IS_ALPHA (c) || c == '.') {
-        p->read_pos = start_pos;
+    McToken tok = {0};
+    if (!parser_accept_token (p, MC_TOKEN_KIND_INT, &tok)) {
         return false;
     }
 
-    if (start_pos != p->read_pos) {
-        *si = val;
-        return true;
-    } else {
+    if (!McLiteralDecToU64 (p->code.data + tok.offset, tok.length, si)) {
+        u64 line = 0, column = 0;
+        parser_token_loc (p, &tok, &line, &column);
+        LOG_ERROR (
+            "%llu:%llu : integer literal \"%.*s\" is too large.",
+            line,
+            column,
+            (int)tok.length,
+            p->code.data + tok.offset
+        );
+        parser_diagnose (
+            p,
+            &tok,
+            "integer literal \"%.*s\" is too large",
+            (int)tok.length,
+            p->code.data + tok.offset
+        );
+        p->tok--;
         return false;
     }
+
+    return true;
 }
 
 
@@ -447,50 +612,28 @@ static inline bool parse_flt (f64* f, McParser* p) {
         return false;
     }
 
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
-
-    // parse integer
-    f64  val = 0;
-    char c   = parser_peek (p);
-    while (IS_DIGIT (c)) {
-        val = val * 10 + (parser_peek (p) - '0');
-
-        p->read_pos++;
-        c = parser_peek (p);
-    }
-
-    if (parser_peek (p) == '.') {
-        p->read_pos++;
-    }
-
-    f64 pow = 10;
-    f64 dec = 0;
-
-    while (IS_DIGIT (c)) {
-        dec = dec + (parser_peek (p) - '0') / pow;
-        pow = pow * 10;
-
-        p->read_pos++;
-        c = parser_peek (p);
+    McToken tok = {0};
+    if (!parser_accept_token (p, MC_TOKEN_KIND_FLT, &tok)) {
+        return false;
     }
 
-    if (parser_peek (p) == 'f') {
-        p->read_pos++;
+    // 'f' suffix doesn't change value
+    const char* s      = p->code.data + tok.offset;
+    u32         length = tok.length;
+    if (s[length - 1] == 'f') {
+        length--;
     }
 
-    if (IS_ALPHA (parser_peek (p))) {
-        p->read_pos = start_pos;
+    if (!McLiteralDecToF64 (s, length, f)) {
+        u64 line = 0, column = 0;
+        parser_token_loc (p, &tok, &line, &column);
+        LOG_ERROR ("%llu:%llu : invalid float literal \"%.*s\".", line, column, (int)tok.length, s);
+        parser_diagnose (p, &tok, "invalid float literal \"%.*s\"", (int)tok.length, s);
+        p->tok--;
         return false;
     }
 
-    if (start_pos != p->read_pos) {
-        val = val + dec;
-        *f  = val;
-        return true;
-    } else {
-        return false;
-    }
+    return true;
 }
 
 
@@ -500,1254 +643,1019 @@ static inline bool parse_hex (u64* hx, McParser* p) {
         return false;
     }
 
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
+    McToken tok = {0};
+    if (!parser_accept_token (p, MC_TOKEN_KIND_HEX, &tok)) {
+        return false;
+    }
 
-    if (parser_can_read_n (p, 2) && !strncmp (p->read_pos, "0x", 2)) {
-        p->read_pos += 2;
-    } else {
-        p->read_pos = start_pos;
+    // skip "0x"
+    if (!McLiteralHexToU64 (p->code.data + tok.offset + 2, tok.length - 2, hx)) {
+        u64 line = 0, column = 0;
+        parser_token_loc (p, &tok, &line, &column);
+        LOG_ERROR (
+            "%llu:%llu : hex literal \"%.*s\" is too large.",
+            line,
+            column,
+            (int)tok.length,
+            p->code.data + tok.offset
+        );
+        parser_diagnose (
+            p,
+            &tok,
+            "hex literal \"%.*s\" is too large",
+            (int)tok.length,
+            p->code.data + tok.offset
+        );
+        p->tok--;
         return false;
     }
 
-    u64 val = 0;
+    return true;
+}
 
-    char c = parser_peek (p);
-    while (strchr ("0123456789abcdefABCDEF", c)) {
-        c         = TO_LOWER (c);
-        char* hxs = "0123456789abcdef";
-        val       = val * 16 + strchr (hxs, c) - hxs;
 
-        p->read_pos++;
-        c = parser_peek (p);
+// basic type named by each type name token, indexed by token kind
+static const struct {
+    McBasicTypeKind kind;
+    bool            is_unsigned;
+    u8              nbits;
+} basic_types[MC_TOKEN_KIND_MAX] = {
+    [MC_TOKEN_KIND_CHAR] = {MC_BASIC_TYPE_KIND_INTEGER, false, 8},
+    [MC_TOKEN_KIND_U8]   = {MC_BASIC_TYPE_KIND_INTEGER,  true, 8},
+    [MC_TOKEN_KIND_U16]  = {MC_BASIC_TYPE_KIND_INTEGER,  true, 16},
+    [MC_TOKEN_KIND_U32]  = {MC_BASIC_TYPE_KIND_INTEGER,  true, 32},
+    [MC_TOKEN_KIND_U64]  = {MC_BASIC_TYPE_KIND_INTEGER,  true, 64},
+    [MC_TOKEN_KIND_I8]   = {MC_BASIC_TYPE_KIND_INTEGER, false, 8},
+    [MC_TOKEN_KIND_I16]  = {MC_BASIC_TYPE_KIND_INTEGER, false, 16},
+    [MC_TOKEN_KIND_I32]  = {MC_BASIC_TYPE_KIND_INTEGER, false, 32},
+    [MC_TOKEN_KIND_I64]  = {MC_BASIC_TYPE_KIND_INTEGER, false, 64},
+    [MC_TOKEN_KIND_F32]  = {  MC_BASIC_TYPE_KIND_FLOAT, false, 32},
+    [MC_TOKEN_KIND_F64]  = {  MC_BASIC_TYPE_KIND_FLOAT, false, 64},
+};
+
+static inline bool parse_basic_type (McType* t, McParser* p, McTypeMod type_mod) {
+    if (!t || !p) {
+        LOG_ERROR ("invalid arguments.");
+        return false;
+    }
+
+    McTokenKind kind = parser_peek (p);
+    if (basic_types[kind].kind == MC_BASIC_TYPE_KIND_INVALID) {
+        return false;
     }
 
-    if (start_pos != p->read_pos) {
-        *hx = val;
+    if (basic_type_init (
+            t,
+            basic_types[kind].kind,
+            type_mod,
+            basic_types[kind].is_unsigned,
+            basic_types[kind].nbits
+        )) {
+        p->tok++;
         return true;
-    } else {
-        return false;
     }
+
+    return false;
 }
 
 
-static inline bool parse_basic_type (McType* t, McParser* p) {
+// <type> ::= [ "const" ] <all_type> [ "*" ]
+static inline bool parse_type (McType* t, McParser* p) {
     if (!t || !p) {
         LOG_ERROR ("invalid arguments.");
         return false;
     }
 
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
-
-    bool            is_unsigned = false;
-    McBasicTypeKind bt_kind     = MC_BASIC_TYPE_KIND_INVALID;
-    switch (parser_peek (p)) {
-        case 'u' : {
-            p->read_pos++;
-            bt_kind     = MC_BASIC_TYPE_KIND_INTEGER;
-            is_unsigned = true;
-            break;
-        }
-        case 'i' : {
-            p->read_pos++;
-            bt_kind     = MC_BASIC_TYPE_KIND_INTEGER;
-            is_unsigned = false;
-            break;
-        }
-        case 'f' : {
-            p->read_pos++;
-            bt_kind = MC_BASIC_TYPE_KIND_FLOAT;
-            break;
-        }
-        default : {
-            return false;
+    McParserMemoEntry* m = memo_recall (p, MEMO_RULE_TYPE);
+    if (m) {
+        if (m->ok) {
+            *t     = m->type;
+            p->tok = m->end_tok;
         }
+        return m->ok;
     }
 
-    if (bt_kind) {
-        u64 nbits = 0;
-        if (parse_int (&nbits, p)) {
-            if (basic_type_init (t, bt_kind, MC_TYPE_MOD_NONE, is_unsigned, nbits)) {
-                return true;
-            }
-        }
+    u64       start_tok = p->tok;
+    McTypeMod type_mod  = MC_TYPE_MOD_NONE;
+
+    if (parser_accept (p, MC_TOKEN_KIND_CONST)) {
+        type_mod |= MC_TYPE_MOD_CONST;
     }
 
-    p->read_pos = start_pos;
-    return false;
+    if (!parse_basic_type (t, p, type_mod)) {
+        p->tok = start_tok;
+        memo_store (p, MEMO_RULE_TYPE, start_tok, false, start_tok);
+        return false;
+    }
+
+    if (parser_accept (p, MC_TOKEN_KIND_STAR)) {
+        t->basic_type.type_mod |= MC_TYPE_MOD_POINTER;
+    }
+
+    if ((m = memo_store (p, MEMO_RULE_TYPE, start_tok, true, p->tok))) {
+        m->type = *t;
+    }
+
+    return true;
 }
 
 
-static inline bool parse_id (Str* id, McParser* p) {
-    if (!id || !p) {
+bool McParseType (McType* type, McParser* p) {
+    if (!type || !p) {
         LOG_ERROR ("invalid arguments.");
         return false;
     }
 
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
+    return parse_type (type, p);
+}
 
-    char c = parser_peek (p);
 
-    StrInit (id);
-    while (c == '_' || IS_ALPHA (c) || (id->length && IS_DIGIT (c))) {
-        StrPushBack (id, c);
-        p->read_pos++;
-        c = parser_peek (p);
+static inline bool parse_id (Str* id, McParser* p) {
+    if (!id || !p) {
+        LOG_ERROR ("invalid arguments.");
+        return false;
     }
 
-    if (!id->length) {
+    McToken tok = {0};
+    if (!parser_accept_token (p, MC_TOKEN_KIND_ID, &tok)) {
         return false;
     }
 
+    StrInitFromZStr (id, McLexerName (&p->lexer, tok.value));
     return true;
 }
 
 static inline bool parse_expr_list (McExpr* e, McParser* p);
 
+///
+/// Turn already parsed expression `e` into left operand of a binary
+/// expression of given type.
+///
+/// e[in,out] : Left operand, becomes the binary expression.
+/// et[in]    : Type of binary expression.
+///
+/// RETURN : Empty right operand of `e`, to be parsed by caller.
+///
+static inline McExpr* binary_expr_init (McExpr* e, McExprType et) {
+    McExpr* l = NEW (McExpr);
+    McExpr* r = NEW (McExpr);
+
+    *l           = *e;
+    e->expr_type = et;
+    e->add.l     = l;
+    e->add.r     = r;
+
+    return r;
+}
+
+
 static inline bool parse_expr_term (McExpr* e, McParser* p) {
     if (!e || !p) {
         LOG_ERROR ("invalid arguments.");
         return false;
     }
 
+    u32 offset = parser_offset (p, p->tok);
+
     if (parse_id (&e->id, p)) {
         e->expr_type = MC_EXPR_TYPE_ID;
-        return true;
     } else if ((e->num.is_int = parse_hex (&e->num.i, p))) {
-        e->expr_type = MC_EXPR_TYPE_NUM;
-        return true;
+        e->expr_type  = MC_EXPR_TYPE_NUM;
+        e->num.is_hex = true;
+        e->num.type   = (McBasicType) {0};
     } else if ((e->num.is_int = parse_int (&e->num.i, p))) {
-        e->expr_type = MC_EXPR_TYPE_NUM;
-        return true;
+        e->expr_type  = MC_EXPR_TYPE_NUM;
+        e->num.is_hex = false;
+        e->num.type   = (McBasicType) {0};
     } else if (!(e->num.is_int = !parse_flt (&e->num.f, p))) {
-        e->expr_type = MC_EXPR_TYPE_NUM;
-        return true;
-    }
-
-    return false;
-}
-
-
-static inline bool parse_expr14 (McExpr* e, McParser* p) {
-    if (!e || !p) {
-        LOG_ERROR ("invalid arguments.");
+        e->expr_type  = MC_EXPR_TYPE_NUM;
+        e->num.is_hex = false;
+        e->num.type   = (McBasicType) {0};
+    } else {
         return false;
     }
 
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
-
-    if (parser_peek (p) == '(') {
-        p->read_pos++;
-        parser_skip_ws (p);
-
-        if (parse_expr14 (e, p)) {
-            parser_skip_ws (p);
-
-            if (parser_peek (p) == ')') {
-                p->read_pos++;
-                return true;
-            }
+    e->offset = offset;
+    return true;
+}
 
-            p->read_pos = start_pos;
-            memset (e, 0, sizeof (McExpr));
-            return false;
-        }
 
-        // fall through
-    }
+///
+/// Parse rest of a parenthesized expression list, after "(" is already consumed.
+///
+/// e[out]    : IN_PARENS expression on success.
+/// p[in,out] : McParser object to parse from.
+///
+/// SUCCESS : true, ")" is consumed.
+/// FAILURE : false, e unchanged, p left where parsing failed.
+///
+static inline bool parse_expr_in_parens (McExpr* e, McParser* p) {
+    McExpr* xpr = NEW (McExpr);
 
-    if (parse_expr_term (e, p)) {
+    if (parse_expr_list (xpr, p) && parser_accept (p, MC_TOKEN_KIND_RPAREN)) {
+        e->expr_type   = MC_EXPR_TYPE_IN_PARENS;
+        e->in_parens.e = xpr;
         return true;
     }
 
-    p->read_pos = start_pos;
+    McExprDeinit (xpr);
+    FREE (xpr);
     return false;
 }
 
 
-static inline bool parse_expr13 (McExpr* e, McParser* p) {
+// expr14 in Docs/Grammar.md
+static inline bool parse_expr_primary (McExpr* e, McParser* p) {
     if (!e || !p) {
         LOG_ERROR ("invalid arguments.");
         return false;
     }
 
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
-
-    // (type) { expr_list }
-    if (parser_peek (p) == '(') {
-        p->read_pos++;
-        parser_skip_ws (p);
-
-        if (parse_type (&e->cast.type, p)) {
-            if (parser_peek (p) == ')') {
-                p->read_pos++;
-                parser_skip_ws (p);
-
-                if (parser_peek (p) == '{') {
-                    p->read_pos++;
-                    parser_skip_ws (p);
+    u64 start_tok = p->tok;
 
-                    McExpr* xpr = NEW (McExpr);
-                    if (parse_expr_list (xpr, p)) {
-                        if (parser_peek (p) == '}') {
-                            p->read_pos++;
-
-                            e->expr_type = MC_EXPR_TYPE_CAST;
-                            e->cast.e    = xpr;
-                            return true;
-                        }
-
-                        p->read_pos = start_pos;
-                        McExprDeinit (xpr);
-                        FREE (xpr);
-                        memset (e, 0, sizeof (McExpr));
-                        return false;
-                    }
-
-                    // fall through
-                }
-                // fall through
-            }
-            // fall through
+    if (parser_accept (p, MC_TOKEN_KIND_LPAREN)) {
+        if (parse_expr_in_parens (e, p)) {
+            e->offset = parser_offset (p, start_tok);
+            return true;
         }
 
-        p->read_pos = start_pos;
-        memset (e, 0, sizeof (McExpr));
+        p->tok = start_tok;
         return false;
     }
 
-    // suffixed expressions
-    if (parse_expr14 (e, p)) {
-        McExprType et = MC_EXPR_TYPE_INVALID;
+    return parse_expr_term (e, p);
+}
 
-        // expr ++
-        // expr --
-        if (parser_can_read_n (p, 2) && !strncmp (p->read_pos, "++", 2)) {
-            p->read_pos += 2;
-            et           = MC_EXPR_TYPE_INC_SFX;
-        } else if (parser_can_read_n (p, 2) && !strncmp (p->read_pos, "--", 2)) {
-            p->read_pos += 2;
-            et           = MC_EXPR_TYPE_DEC_SFX;
-        }
 
-        if (et) {
-            parser_skip_ws (p);
+///
+/// Apply postfix operators (expr13 in Docs/Grammar.md) to an already parsed
+/// operand `e`, as long as there are any.
+///
+/// e[in,out]     : Parsed operand, becomes the postfix expression on success.
+/// p[in,out]     : McParser object to parse from.
+/// start_tok[in] : Token to rewind parser to on failure.
+///
+/// SUCCESS : true, e is the postfix expression.
+/// FAILURE : false, e is invalidated, p rewound to `start_tok`.
+///
+static inline bool parse_expr_postfix (McExpr* e, McParser* p, u64 start_tok) {
+    // suffixes can be chained, eg: a.b[1](x)++
+    while (true) {
+        McExprType  et    = MC_EXPR_TYPE_INVALID;
+        McTokenKind close = MC_TOKEN_KIND_INVALID;
+
+        switch (parser_peek (p)) {
+            case MC_TOKEN_KIND_PLUS_PLUS :
+                et = MC_EXPR_TYPE_INC_SFX;
+                break;
+            case MC_TOKEN_KIND_MINUS_MINUS :
+                et = MC_EXPR_TYPE_DEC_SFX;
+                break;
+            case MC_TOKEN_KIND_DOT :
+                et = MC_EXPR_TYPE_ACCESS;
+                break;
+            case MC_TOKEN_KIND_ARROW :
+                et = MC_EXPR_TYPE_PTR_ACCESS;
+                break;
+            case MC_TOKEN_KIND_LPAREN :
+                et    = MC_EXPR_TYPE_CALL;
+                close = MC_TOKEN_KIND_RPAREN;
+                break;
+            case MC_TOKEN_KIND_LBRACKET :
+                et    = MC_EXPR_TYPE_ARR_SUBSCRIPT;
+                close = MC_TOKEN_KIND_RBRACKET;
+                break;
+            default :
+                return true;
+        }
+        p->tok++;
 
+        // expr ++
+        // expr --
+        if (et == MC_EXPR_TYPE_INC_SFX || et == MC_EXPR_TYPE_DEC_SFX) {
             McExpr* xpr  = NEW (McExpr);
             *xpr         = *e;
             e->expr_type = et;
-            e->inc_pfx.e = xpr;
-
-            return true;
+            e->inc_sfx.e = xpr;
+            continue;
         }
 
+        McExpr* r = binary_expr_init (e, et);
+
         // expr . expr (member access)
         // expr -> expr (member access through pointer)
-        if (parser_peek (p) == '.') {
-            p->read_pos++;
-            et = MC_EXPR_TYPE_ACCESS;
-        } else if (parser_can_read_n (p, 2) && !strncmp (p->read_pos, "->", 2)) {
-            p->read_pos += 2;
-            et           = MC_EXPR_TYPE_PTR_ACCESS;
+        // expr ( expr_list ) (function call)
+        // expr [ expr_list ] (array subscript)
+        // a call without arguments has an invalid expression as it's argument
+        if (close ? (et == MC_EXPR_TYPE_CALL && parser_accept (p, close)) ||
+                        (parse_expr_list (r, p) && parser_accept (p, close)) :
+                    parse_expr_primary (r, p)) {
+            continue;
         }
 
-        if (et) {
-            parser_skip_ws (p);
+        p->tok = start_tok;
+        McExprDeinit (e);
+        return false;
+    }
+}
 
-            McExpr* r = NEW (McExpr);
 
-            if (parse_expr14 (r, p)) {
-                McExpr* l = NEW (McExpr);
-                *l        = *e;
+static inline bool parse_expr_unary (McExpr* e, McParser* p);
 
-                e->expr_type = et;
-                e->access.l  = l;
-                e->access.r  = r;
+// expr12 in Docs/Grammar.md
+static inline bool parse_expr_unary_nomemo (McExpr* e, McParser* p) {
+    if (!e || !p) {
+        LOG_ERROR ("invalid arguments.");
+        return false;
+    }
 
-                return true;
-            }
-
-            McExprDeinit (r);
-            FREE (r);
-            memset (e, 0, sizeof (McExpr));
-            return false;
-        }
-
-        // expr14  ( expr14 ) (function call)
-        // expr14  [ expr14 ] (array subscript)
-        if (parser_peek (p) == '(') {
-            p->read_pos++;
-            parser_skip_ws (p);
-
-            McExpr* r = NEW (McExpr);
-            if (parse_expr14 (r, p)) {
-                if (parser_peek (p) == ')') {
-                    p->read_pos++;
-
-                    McExpr* l = NEW (McExpr);
-                    *l        = *e;
-
-                    e->expr_type = MC_EXPR_TYPE_CALL;
-                    e->call.l    = l;
-                    e->call.r    = r;
-
-                    return true;
-                }
-
-                // fall through
-            }
-
-            p->read_pos = start_pos;
-            McExprDeinit (r);
-            FREE (r);
-            memset (e, 0, sizeof (McExpr));
-            return false;
-        } else if (parser_peek (p) == '[') {
-            p->read_pos++;
-            parser_skip_ws (p);
-
-            McExpr* r = NEW (McExpr);
-            if (parse_expr14 (r, p)) {
-                if (parser_peek (p) == ']') {
-                    p->read_pos++;
-
-                    McExpr* l = NEW (McExpr);
-                    *l        = *e;
-
-                    e->expr_type       = MC_EXPR_TYPE_ARR_SUBSCRIPT;
-                    e->arr_subscript.l = l;
-                    e->arr_subscript.r = r;
-
-                    return true;
-                }
-
-                // fall through
-            }
-
-            p->read_pos = start_pos;
-            McExprDeinit (r);
-            FREE (r);
-            memset (e, 0, sizeof (McExpr));
-            return false;
-        }
-
-        return true;
-    }
-
-    return false;
-}
-
-
-static inline bool parse_expr12 (McExpr* e, McParser* p) {
-    if (!e || !p) {
-        LOG_ERROR ("invalid arguments.");
-        return false;
-    }
-
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
+    u64 start_tok = p->tok;
 
     McExprType et = MC_EXPR_TYPE_INVALID;
-
-    // it's important to try parsing "++" and "--" before "+" or "-"
-    if (parser_can_read_n (p, 2) && !strncmp (p->read_pos, "++", 2)) {
-        p->read_pos += 2;
-        et           = MC_EXPR_TYPE_INC_PFX;
-    } else if (parser_can_read_n (p, 2) && !strncmp (p->read_pos, "--", 2)) {
-        p->read_pos += 2;
-        et           = MC_EXPR_TYPE_DEC_PFX;
-    } else if (parser_peek (p) == '+') {
-        p->read_pos++;
-        et = MC_EXPR_TYPE_UN_PLUS;
-    } else if (parser_peek (p) == '-') {
-        p->read_pos++;
-        et = MC_EXPR_TYPE_UN_MINUS;
-    } else if (parser_peek (p) == '!') {
-        p->read_pos++;
-        et = MC_EXPR_TYPE_LOG_NOT;
-    } else if (parser_peek (p) == '~') {
-        p->read_pos++;
-        et = MC_EXPR_TYPE_NOT;
-    } else if (parser_can_read_n (p, 2) && !strncmp (p->read_pos, "sizeof", 6)) {
-        p->read_pos += 6;
-        et           = MC_EXPR_TYPE_SIZE_OF;
-    } else if (parser_can_read_n (p, 2) && !strncmp (p->read_pos, "_Alignof", 8)) {
-        p->read_pos += 8;
-        et           = MC_EXPR_TYPE_ALIGN_OF;
+    switch (parser_peek (p)) {
+        case MC_TOKEN_KIND_PLUS_PLUS :
+            et = MC_EXPR_TYPE_INC_PFX;
+            break;
+        case MC_TOKEN_KIND_MINUS_MINUS :
+            et = MC_EXPR_TYPE_DEC_PFX;
+            break;
+        case MC_TOKEN_KIND_PLUS :
+            et = MC_EXPR_TYPE_UN_PLUS;
+            break;
+        case MC_TOKEN_KIND_MINUS :
+            et = MC_EXPR_TYPE_UN_MINUS;
+            break;
+        case MC_TOKEN_KIND_BANG :
+            et = MC_EXPR_TYPE_LOG_NOT;
+            break;
+        case MC_TOKEN_KIND_TILDE :
+            et = MC_EXPR_TYPE_NOT;
+            break;
+        case MC_TOKEN_KIND_STAR :
+            et = MC_EXPR_TYPE_DEREF;
+            break;
+        case MC_TOKEN_KIND_AMP :
+            et = MC_EXPR_TYPE_ADDR;
+            break;
+        case MC_TOKEN_KIND_SIZEOF :
+            et = MC_EXPR_TYPE_SIZE_OF;
+            break;
+        case MC_TOKEN_KIND_ALIGNOF :
+            et = MC_EXPR_TYPE_ALIGN_OF;
+            break;
+        default :
+            break;
     }
 
     if (et) {
-        parser_skip_ws (p);
+        p->tok++;
 
         McExpr* xpr = NEW (McExpr);
 
         e->expr_type = et;
+        e->offset    = parser_offset (p, start_tok);
         e->inc_pfx.e = xpr;
 
-        if (parse_expr12 (xpr, p)) {
+        if (parse_expr_unary (xpr, p)) {
             return true;
         }
 
-        p->read_pos = start_pos;
+        p->tok = start_tok;
         McExprDeinit (xpr);
         FREE (xpr);
         memset (e, 0, sizeof (McExpr));
         return false;
     }
 
-    // (type) expr type cast
-    if (parser_peek (p) == '(') {
-        p->read_pos++;
-        parser_skip_ws (p);
+    if (!parser_accept (p, MC_TOKEN_KIND_LPAREN)) {
+        if (!parse_expr_term (e, p)) {
+            return false;
+        }
+        return parse_expr_postfix (e, p, start_tok);
+    }
 
-        if (parse_type (&e->cast.type, p)) {
-            if (parser_peek (p) == ')') {
-                p->read_pos++;
-                parser_skip_ws (p);
+    // a type name right after "(" can only be a cast or a compound literal,
+    // so whatever follows "(" is looked at exactly once
+    McType type = {0};
+    if (!parse_type (&type, p)) {
+        // ( expr_list )
+        if (!parse_expr_in_parens (e, p)) {
+            p->tok = start_tok;
+            return false;
+        }
+        e->offset = parser_offset (p, start_tok);
+        return parse_expr_postfix (e, p, start_tok);
+    }
 
-                McExpr* xpr = NEW (McExpr);
-                if (parse_expr12 (xpr, p)) {
-                    e->expr_type = MC_EXPR_TYPE_CAST;
-                    e->cast.e    = xpr;
-                    return true;
-                }
+    if (parser_accept (p, MC_TOKEN_KIND_RPAREN)) {
+        McExpr* xpr = NEW (McExpr);
 
-                p->read_pos = start_pos;
-                McExprDeinit (xpr);
-                FREE (xpr);
-                memset (e, 0, sizeof (McExpr));
-                return false;
+        // (type) { expr_list }
+        if (parser_accept (p, MC_TOKEN_KIND_LBRACE)) {
+            if (parse_expr_list (xpr, p) && parser_accept (p, MC_TOKEN_KIND_RBRACE)) {
+                e->expr_type = MC_EXPR_TYPE_CAST;
+                e->offset    = parser_offset (p, start_tok);
+                e->cast.type = type;
+                e->cast.e    = xpr;
+                return parse_expr_postfix (e, p, start_tok);
             }
-
-            // fall through
         }
 
-        p->read_pos = start_pos;
-        memset (e, 0, sizeof (McExpr));
-        return false;
-    }
+        // (type) expr
+        else if (parse_expr_unary (xpr, p)) {
+            e->expr_type = MC_EXPR_TYPE_CAST;
+            e->offset    = parser_offset (p, start_tok);
+            e->cast.type = type;
+            e->cast.e    = xpr;
+            return true;
+        }
 
-    if (parse_expr13 (e, p)) {
-        return true;
+        McExprDeinit (xpr);
+        FREE (xpr);
     }
 
+    type_deinit (&type);
+    p->tok = start_tok;
     return false;
 }
 
 
-static inline bool parse_expr11 (McExpr* e, McParser* p) {
-    if (!e || !p) {
-        LOG_ERROR ("invalid arguments.");
+// expression rules only ever remember failures, see McParserMemo
+static inline bool parse_expr_unary (McExpr* e, McParser* p) {
+    if (memo_recall (p, MEMO_RULE_EXPR_UNARY)) {
         return false;
     }
 
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
-
-    if (parse_expr12 (e, p)) {
-        parser_skip_ws (p);
-
-        McExprType et = MC_EXPR_TYPE_INVALID;
-        if (parser_peek (p) == '*') {
-            et = MC_EXPR_TYPE_MUL;
-        } else if (parser_peek (p) == '/') {
-            et = MC_EXPR_TYPE_DIV;
-        } else if (parser_peek (p) == '%') {
-            et = MC_EXPR_TYPE_MOD;
-        }
-
-        if (et) {
-            p->read_pos++;
-            parser_skip_ws (p);
-
-            McExpr* l = NEW (McExpr);
-            McExpr* r = NEW (McExpr);
-
-            *l           = *e;
-            e->expr_type = et;
-            e->mul.l     = l;
-            e->mul.r     = r;
-
-            if (parse_expr11 (r, p)) {
-                return true;
-            }
-
-            p->read_pos = start_pos;
-            McExprDeinit (l);
-            FREE (l);
-            McExprDeinit (r);
-            FREE (r);
-            memset (e, 0, sizeof (McExpr));
-            return false;
-        }
-
+    u64 start_tok = p->tok;
+    if (parse_expr_unary_nomemo (e, p)) {
         return true;
     }
 
+    memo_store (p, MEMO_RULE_EXPR_UNARY, start_tok, false, start_tok);
     return false;
 }
 
 
-static inline bool parse_expr10 (McExpr* e, McParser* p) {
+// How tightly a binary operator binds it's operands, from loosest to tightest.
+// Each level is one of expr0 to expr11 in Docs/Grammar.md.
+typedef enum ExprPrec {
+    EXPR_PREC_NONE = 0,
+    EXPR_PREC_ASSIGN,  // expr0
+    EXPR_PREC_TERN,    // expr1
+    EXPR_PREC_LOG_OR,  // expr2
+    EXPR_PREC_LOG_AND, // expr3
+    EXPR_PREC_OR,      // expr4
+    EXPR_PREC_XOR,     // expr5
+    EXPR_PREC_AND,     // expr6
+    EXPR_PREC_EQ,      // expr7
+    EXPR_PREC_REL,     // expr8
+    EXPR_PREC_SHIFT,   // expr9
+    EXPR_PREC_ADD,     // expr10
+    EXPR_PREC_MUL,     // expr11
+} ExprPrec;
+
+// Binary operator table, indexed by token kind. Tokens that are not binary
+// operators have EXPR_PREC_NONE.
+static const struct {
+    ExprPrec   prec;
+    McExprType expr_type;
+} binary_ops[MC_TOKEN_KIND_MAX] = {
+    [MC_TOKEN_KIND_ASSIGN]         = { EXPR_PREC_ASSIGN,     MC_EXPR_TYPE_ASSIGN},
+    [MC_TOKEN_KIND_PLUS_ASSIGN]    = { EXPR_PREC_ASSIGN, MC_EXPR_TYPE_ADD_ASSIGN},
+    [MC_TOKEN_KIND_MINUS_ASSIGN]   = { EXPR_PREC_ASSIGN, MC_EXPR_TYPE_SUB_ASSIGN},
+    [MC_TOKEN_KIND_STAR_ASSIGN]    = { EXPR_PREC_ASSIGN, MC_EXPR_TYPE_MUL_ASSIGN},
+    [MC_TOKEN_KIND_SLASH_ASSIGN]   = { EXPR_PREC_ASSIGN, MC_EXPR_TYPE_DIV_ASSIGN},
+    [MC_TOKEN_KIND_PERCENT_ASSIGN] = { EXPR_PREC_ASSIGN, MC_EXPR_TYPE_MOD_ASSIGN},
+    [MC_TOKEN_KIND_AMP_ASSIGN]     = { EXPR_PREC_ASSIGN, MC_EXPR_TYPE_AND_ASSIGN},
+    [MC_TOKEN_KIND_PIPE_ASSIGN]    = { EXPR_PREC_ASSIGN,  MC_EXPR_TYPE_OR_ASSIGN},
+    [MC_TOKEN_KIND_CARET_ASSIGN]   = { EXPR_PREC_ASSIGN, MC_EXPR_TYPE_XOR_ASSIGN},
+    [MC_TOKEN_KIND_SHR_ASSIGN]     = { EXPR_PREC_ASSIGN, MC_EXPR_TYPE_SHR_ASSIGN},
+    [MC_TOKEN_KIND_SHL_ASSIGN]     = { EXPR_PREC_ASSIGN, MC_EXPR_TYPE_SHL_ASSIGN},
+    [MC_TOKEN_KIND_QUESTION]       = {   EXPR_PREC_TERN,       MC_EXPR_TYPE_TERN},
+    [MC_TOKEN_KIND_PIPE_PIPE]      = { EXPR_PREC_LOG_OR,     MC_EXPR_TYPE_LOG_OR},
+    [MC_TOKEN_KIND_AMP_AMP]        = {EXPR_PREC_LOG_AND,    MC_EXPR_TYPE_LOG_AND},
+    [MC_TOKEN_KIND_PIPE]           = {     EXPR_PREC_OR,         MC_EXPR_TYPE_OR},
+    [MC_TOKEN_KIND_CARET]          = {    EXPR_PREC_XOR,        MC_EXPR_TYPE_XOR},
+    [MC_TOKEN_KIND_AMP]            = {    EXPR_PREC_AND,        MC_EXPR_TYPE_AND},
+    [MC_TOKEN_KIND_EQ]             = {     EXPR_PREC_EQ,         MC_EXPR_TYPE_EQ},
+    [MC_TOKEN_KIND_NE]             = {     EXPR_PREC_EQ,         MC_EXPR_TYPE_NE},
+    [MC_TOKEN_KIND_LT]             = {    EXPR_PREC_REL,         MC_EXPR_TYPE_LT},
+    [MC_TOKEN_KIND_GT]             = {    EXPR_PREC_REL,         MC_EXPR_TYPE_GT},
+    [MC_TOKEN_KIND_LE]             = {    EXPR_PREC_REL,         MC_EXPR_TYPE_LE},
+    [MC_TOKEN_KIND_GE]             = {    EXPR_PREC_REL,         MC_EXPR_TYPE_GE},
+    [MC_TOKEN_KIND_SHL]            = {  EXPR_PREC_SHIFT,        MC_EXPR_TYPE_SHL},
+    [MC_TOKEN_KIND_SHR]            = {  EXPR_PREC_SHIFT,        MC_EXPR_TYPE_SHR},
+    [MC_TOKEN_KIND_PLUS]           = {    EXPR_PREC_ADD,        MC_EXPR_TYPE_ADD},
+    [MC_TOKEN_KIND_MINUS]          = {    EXPR_PREC_ADD,        MC_EXPR_TYPE_SUB},
+    [MC_TOKEN_KIND_STAR]           = {    EXPR_PREC_MUL,        MC_EXPR_TYPE_MUL},
+    [MC_TOKEN_KIND_SLASH]          = {    EXPR_PREC_MUL,        MC_EXPR_TYPE_DIV},
+    [MC_TOKEN_KIND_PERCENT]        = {    EXPR_PREC_MUL,        MC_EXPR_TYPE_MOD},
+};
+
+static inline bool parse_expr_binary (McExpr* e, McParser* p, ExprPrec min_prec);
+
+///
+/// Parse an expression made of binary operators that bind at least as
+/// tightly as `min_prec`, by precedence climbing. Every operand is parsed
+/// exactly once, and recursion depth only grows with nesting of operators,
+/// not with number of precedence levels.
+///
+/// All binary operators are right associative (see Docs/Grammar.md), so
+/// right operand of an operator takes every following operator of same or
+/// tighter precedence.
+///
+/// e[out]       : Parsed expression.
+/// p[in,out]    : McParser object to parse from.
+/// min_prec[in] : Loosest operator allowed in expression.
+///
+/// SUCCESS : true, e is parsed expression.
+/// FAILURE : false, e is invalidated, p unchanged.
+///
+static inline bool parse_expr_binary_nomemo (McExpr* e, McParser* p, ExprPrec min_prec) {
     if (!e || !p) {
         LOG_ERROR ("invalid arguments.");
         return false;
     }
 
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
-
-    if (parse_expr11 (e, p)) {
-        parser_skip_ws (p);
+    u64 start_tok = p->tok;
 
-        McExprType et = MC_EXPR_TYPE_INVALID;
-        if (parser_peek (p) == '+') {
-            p->read_pos++;
+    if (!parse_expr_unary (e, p)) {
+        return false;
+    }
 
-            // avoid "++" here, pass it down to expr11
-            if (parser_peek (p) == '+') {
-                p->read_pos = start_pos;
-                McExprDeinit (e);
-                return parse_expr11 (e, p);
-            } else {
-                et = MC_EXPR_TYPE_ADD;
-            }
-        } else if (parser_peek (p) == '-') {
-            p->read_pos++;
-
-            // avoid "--" here, pass it down to expr11
-            if (parser_peek (p) == '-') {
-                p->read_pos = start_pos;
-                McExprDeinit (e);
-                return parse_expr11 (e, p);
-            } else {
-                et = MC_EXPR_TYPE_SUB;
-            }
+    while (true) {
+        McTokenKind kind = parser_peek (p);
+        ExprPrec    prec = binary_ops[kind].prec;
+        McExprType  et   = binary_ops[kind].expr_type;
+        if (!prec || prec < min_prec) {
+            return true;
         }
+        p->tok++;
 
-        if (et) {
-            parser_skip_ws (p);
-
-            McExpr* l = NEW (McExpr);
-            McExpr* r = NEW (McExpr);
+        // expr2 ? expr1 : expr1
+        if (et == MC_EXPR_TYPE_TERN) {
+            McExpr* c = NEW (McExpr);
+            McExpr* t = NEW (McExpr);
+            McExpr* f = NEW (McExpr);
 
-            *l           = *e;
-            e->expr_type = et;
-            e->add.l     = l;
-            e->add.r     = r;
+            // we just realized this expression is a ternary operator expr
+            *c           = *e;
+            e->expr_type = MC_EXPR_TYPE_TERN;
+            e->tern.c    = c;
+            e->tern.t    = t;
+            e->tern.f    = f;
 
-            if (parse_expr10 (r, p)) {
-                return true;
+            if (parse_expr_binary (t, p, EXPR_PREC_TERN) &&
+                parser_accept (p, MC_TOKEN_KIND_COLON) &&
+                parse_expr_binary (f, p, EXPR_PREC_TERN)) {
+                continue;
             }
 
-            p->read_pos = start_pos;
-            McExprDeinit (l);
-            FREE (l);
-            McExprDeinit (r);
-            FREE (r);
-            memset (e, 0, sizeof (McExpr));
+            // we expected "expr1 : expr1", but didn't get one
+            p->tok = start_tok;
+            McExprDeinit (e);
             return false;
         }
 
-        return true;
-    }
-
-    return false;
-}
-
-
-static inline bool parse_expr9 (McExpr* e, McParser* p) {
-    if (!e || !p) {
-        LOG_ERROR ("invalid arguments.");
-        return false;
-    }
-
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
-
-    if (parse_expr10 (e, p)) {
-        parser_skip_ws (p);
-
-        McExprType et = MC_EXPR_TYPE_INVALID;
-        if (parser_can_read_n (p, 2) && !strncmp (p->read_pos, "<<", 2)) {
-            et = MC_EXPR_TYPE_SHL;
-        } else if (parser_can_read_n (p, 2) && !strncmp (p->read_pos, ">>", 2)) {
-            et = MC_EXPR_TYPE_SHR;
-        }
-
-        if (et) {
-            p->read_pos += 2;
-            parser_skip_ws (p);
-
-            McExpr* l = NEW (McExpr);
-            McExpr* r = NEW (McExpr);
-
-            *l           = *e;
-            e->expr_type = et;
-            e->shl.l     = l;
-            e->shl.r     = r;
-
-            if (parse_expr9 (r, p)) {
-                return true;
-            }
+        // multiple assignments are allowed at the same time,
+        // but compound assignments can't be chained
+        bool     is_compound = prec == EXPR_PREC_ASSIGN && et != MC_EXPR_TYPE_ASSIGN;
+        ExprPrec rhs_prec    = is_compound ? EXPR_PREC_TERN : prec;
 
-            p->read_pos = start_pos;
-            McExprDeinit (l);
-            FREE (l);
-            McExprDeinit (r);
-            FREE (r);
-            memset (e, 0, sizeof (McExpr));
+        if (!parse_expr_binary (binary_expr_init (e, et), p, rhs_prec)) {
+            p->tok = start_tok;
+            McExprDeinit (e);
             return false;
         }
 
-        return true;
+        // "=" already took everything after it, and nothing may follow a
+        // compound assignment
+        if (prec == EXPR_PREC_ASSIGN) {
+            return true;
+        }
     }
-
-    return false;
 }
 
 
-static inline bool parse_expr8 (McExpr* e, McParser* p) {
-    if (!e || !p) {
-        LOG_ERROR ("invalid arguments.");
+static inline bool parse_expr_binary (McExpr* e, McParser* p, ExprPrec min_prec) {
+    if (memo_recall (p, MEMO_RULE_EXPR_BINARY + min_prec)) {
         return false;
     }
 
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
-
-    if (parse_expr9 (e, p)) {
-        parser_skip_ws (p);
-
-        McExprType et = MC_EXPR_TYPE_INVALID;
-        if (parser_peek (p) == '<') {
-            p->read_pos++;
-            et = MC_EXPR_TYPE_LT;
-        } else if (parser_peek (p) == '>') {
-            p->read_pos++;
-            et = MC_EXPR_TYPE_GT;
-        } else if (parser_can_read_n (p, 2) && !strncmp (p->read_pos, "<=", 2)) {
-            p->read_pos += 2;
-            et           = MC_EXPR_TYPE_LE;
-        } else if (parser_can_read_n (p, 2) && !strncmp (p->read_pos, ">=", 2)) {
-            p->read_pos += 2;
-            et           = MC_EXPR_TYPE_GT;
-        }
-        parser_skip_ws (p);
-
-        if (et) {
-            McExpr* l = NEW (McExpr);
-            McExpr* r = NEW (McExpr);
-
-            *l           = *e;
-            e->expr_type = et;
-            e->le.l      = l;
-            e->le.r      = r;
-
-            if (parse_expr8 (r, p)) {
-                return true;
-            }
-
-            p->read_pos = start_pos;
-            McExprDeinit (l);
-            FREE (l);
-            McExprDeinit (r);
-            FREE (r);
-            memset (e, 0, sizeof (McExpr));
-            return false;
-        }
-
+    u64 start_tok = p->tok;
+    if (parse_expr_binary_nomemo (e, p, min_prec)) {
         return true;
     }
 
+    memo_store (p, MEMO_RULE_EXPR_BINARY + min_prec, start_tok, false, start_tok);
     return false;
 }
 
 
-static inline bool parse_expr7 (McExpr* e, McParser* p) {
+bool McParseExpr (McExpr* e, McParser* p) {
     if (!e || !p) {
         LOG_ERROR ("invalid arguments.");
         return false;
     }
 
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
-
-    if (parse_expr8 (e, p)) {
-        parser_skip_ws (p);
-
-        McExprType et = MC_EXPR_TYPE_INVALID;
-        if (parser_can_read_n (p, 2) && !strncmp (p->read_pos, "==", 2)) {
-            et = MC_EXPR_TYPE_EQ;
-        } else if (parser_can_read_n (p, 2) && !strncmp (p->read_pos, "!=", 2)) {
-            et = MC_EXPR_TYPE_NE;
-        }
-
-        if (et) {
-            p->read_pos += 2;
-            parser_skip_ws (p);
-
-            McExpr* l = NEW (McExpr);
-            McExpr* r = NEW (McExpr);
-
-            *l           = *e;
-            e->expr_type = et;
-            e->eq.l      = l;
-            e->eq.r      = r;
-
-            if (parse_expr7 (r, p)) {
-                return true;
-            }
-
-            p->read_pos = start_pos;
-            McExprDeinit (l);
-            FREE (l);
-            McExprDeinit (r);
-            FREE (r);
-            memset (e, 0, sizeof (McExpr));
-            return false;
-        }
-
-        return true;
+    if (!parse_expr_list (e, p)) {
+        return false;
     }
-
-    return false;
+    if (p->fold) {
+        McExprFold (e);
+    }
+    return true;
 }
 
 
-static inline bool parse_expr6 (McExpr* e, McParser* p) {
+static inline bool parse_expr_list_nomemo (McExpr* e, McParser* p) {
     if (!e || !p) {
         LOG_ERROR ("invalid arguments.");
         return false;
     }
 
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
-
-    if (parse_expr7 (e, p)) {
-        parser_skip_ws (p);
+    if (!parse_expr_binary (e, p, EXPR_PREC_ASSIGN)) {
+        return false;
+    }
 
-        if (parser_peek (p) == '&') {
-            p->read_pos += 1;
-            parser_skip_ws (p);
+    if (parser_peek (p) != MC_TOKEN_KIND_COMMA) {
+        return true;
+    }
 
-            McExpr* l = NEW (McExpr);
-            McExpr* r = NEW (McExpr);
+    // if we get a comma, then this is actually a list expression
+    McExprVec list = {0};
+    VecInit (&list, NULL, NULL);
 
-            *l           = *e;
-            e->expr_type = MC_EXPR_TYPE_AND;
-            e->log_and.l = l;
-            e->log_and.r = r;
+    McExpr* xpr = NEW (McExpr);
+    *xpr        = *e;
+    VecPushBack (&list, &xpr);
 
-            if (parse_expr6 (r, p)) {
-                return true;
-            }
+    while (true) {
+        u64 comma_tok = p->tok;
+        if (!parser_accept (p, MC_TOKEN_KIND_COMMA)) {
+            break;
+        }
 
-            p->read_pos = start_pos;
-            McExprDeinit (l);
-            FREE (l);
-            McExprDeinit (r);
-            FREE (r);
-            memset (e, 0, sizeof (McExpr));
-            return false;
+        xpr = NEW (McExpr);
+        if (!parse_expr_binary (xpr, p, EXPR_PREC_ASSIGN)) {
+            // trailing comma is not part of list
+            p->tok = comma_tok;
+            FREE (xpr);
+            break;
         }
 
-        return true;
+        VecPushBack (&list, &xpr);
     }
 
-    return false;
+    // then change current expr's type to list
+    e->expr_type = MC_EXPR_TYPE_LIST;
+    e->list      = list;
+
+    return true;
 }
 
 
-static inline bool parse_expr5 (McExpr* e, McParser* p) {
-    if (!e || !p) {
-        LOG_ERROR ("invalid arguments.");
+static inline bool parse_expr_list (McExpr* e, McParser* p) {
+    if (memo_recall (p, MEMO_RULE_EXPR_LIST)) {
         return false;
     }
 
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
-
-    if (parse_expr6 (e, p)) {
-        parser_skip_ws (p);
-
-        if (parser_peek (p) == '^') {
-            p->read_pos += 1;
-            parser_skip_ws (p);
-
-            McExpr* l = NEW (McExpr);
-            McExpr* r = NEW (McExpr);
-
-            *l           = *e;
-            e->expr_type = MC_EXPR_TYPE_XOR;
-            e->xor.l     = l;
-            e->xor.r     = r;
-
-            if (parse_expr5 (r, p)) {
-                return true;
-            }
-
-            p->read_pos = start_pos;
-            McExprDeinit (l);
-            FREE (l);
-            McExprDeinit (r);
-            FREE (r);
-            memset (e, 0, sizeof (McExpr));
-            return false;
-        }
-
+    u64 start_tok = p->tok;
+    if (parse_expr_list_nomemo (e, p)) {
         return true;
     }
 
+    memo_store (p, MEMO_RULE_EXPR_LIST, start_tok, false, start_tok);
     return false;
 }
 
 
-static inline bool parse_expr4 (McExpr* e, McParser* p) {
-    if (!e || !p) {
-        LOG_ERROR ("invalid arguments.");
-        return false;
-    }
-
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
-
-    if (parse_expr5 (e, p)) {
-        parser_skip_ws (p);
+// Whether a top level item can start at token of given kind, for sure.
+static inline bool is_type_start (McTokenKind kind) {
+    return kind == MC_TOKEN_KIND_CONST || (kind >= MC_TOKEN_KIND_CHAR && kind <= MC_TOKEN_KIND_F64);
+}
 
-        if (parser_peek (p) == '|') {
-            p->read_pos += 1;
-            parser_skip_ws (p);
 
-            McExpr* l = NEW (McExpr);
-            McExpr* r = NEW (McExpr);
+///
+/// Report top level item at current token that failed to parse, and skip
+/// tokens up to next synchronisation token (see `McParserRecovery`).
+///
+/// p[in,out] : McParser object in error recovery mode.
+///
+/// SUCCESS : true, p at a ";" or at start of next item.
+/// FAILURE : false, if there are too many errors to go on.
+///
+static bool parser_recover (McParser* p) {
+    McParserRecovery* r = &p->recovery;
 
-            *l           = *e;
-            e->expr_type = MC_EXPR_TYPE_OR;
-            e->or.l      = l;
-            e->or.r      = r;
+    // farthest token parser got to is most likely where the error is
+    u64            bad = p->peek_end > p->tok ? p->peek_end - 1 : p->tok;
+    const McToken* tok = parser_token_at (p, bad);
 
-            if (parse_expr4 (r, p)) {
-                return true;
-            }
+    bool ok;
+    if (tok->kind == MC_TOKEN_KIND_EOF) {
+        ok = parser_diagnose (p, tok, "unexpected end of code");
+    } else {
+        ok = parser_diagnose (
+            p,
+            tok,
+            "unexpected \"%.*s\"",
+            (int)tok->length,
+            p->code.data + tok->offset
+        );
+    }
+    if (!ok || r->diagnostics.length >= r->max_diagnostics) {
+        return false;
+    }
 
-            p->read_pos = start_pos;
-            McExprDeinit (l);
-            FREE (l);
-            McExprDeinit (r);
-            FREE (r);
-            memset (e, 0, sizeof (McExpr));
-            return false;
+    // skip at least one token, so that every recovery makes progress, but
+    // leave a ";" to be taken as end of item
+    McTokenKind kind = parser_peek (p);
+    while (kind != MC_TOKEN_KIND_EOF) {
+        p->tok++;
+        r->skipped++;
+        if (kind == MC_TOKEN_KIND_RBRACE) {
+            break;
         }
 
-        return true;
+        kind = parser_peek (p);
+        if (kind == MC_TOKEN_KIND_SEMICOLON || is_type_start (kind)) {
+            break;
+        }
     }
 
-    return false;
+    return true;
 }
 
 
-static inline bool parse_expr3 (McExpr* e, McParser* p) {
-    if (!e || !p) {
+bool McParseProgram (McProgram* prog, McParser* p) {
+    if (!prog || !p) {
         LOG_ERROR ("invalid arguments.");
         return false;
     }
 
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
-
-    if (parse_expr4 (e, p)) {
-        parser_skip_ws (p);
-
-        if (parser_can_read_n (p, 2) && !strncmp (p->read_pos, "&&", 2)) {
-            p->read_pos += 2;
-            parser_skip_ws (p);
+    u64 start_tok = p->tok;
 
-            McExpr* l = NEW (McExpr);
-            McExpr* r = NEW (McExpr);
+    while (parser_peek (p) != MC_TOKEN_KIND_EOF) {
+        McType type = {0};
+        McExpr e    = {0};
+        p->peek_end = p->tok;
+        if (parse_type (&type, p)) {
+            puts ("type");
+        } else if (McParseExpr (&e, p)) {
+            printf ("expr value : %lf\n", McExprEval (&e));
+            McExprDeinit (&e);
+        } else if (!p->recovery.active || !parser_recover (p)) {
+            break;
+        }
 
-            *l           = *e;
-            e->expr_type = MC_EXPR_TYPE_LOG_AND;
-            e->log_and.l = l;
-            e->log_and.r = r;
+        parser_accept (p, MC_TOKEN_KIND_SEMICOLON);
 
-            if (parse_expr3 (r, p)) {
-                return true;
-            }
+        // nothing before this point will ever be looked at again
+        McParserStreamCommit (p);
+    }
 
-            p->read_pos = start_pos;
-            McExprDeinit (l);
-            FREE (l);
-            McExprDeinit (r);
-            FREE (r);
-            memset (e, 0, sizeof (McExpr));
-            return false;
+    if (parser_peek (p) != MC_TOKEN_KIND_EOF) {
+        if (!p->stream.active && !p->recovery.active) {
+            p->tok = start_tok;
         }
-
-        // direct pass to expr2
-        return true;
+        return false;
     }
 
-    return false;
+    return !p->recovery.diagnostics.length;
 }
 
-
-static inline bool parse_expr2 (McExpr* e, McParser* p) {
-    if (!e || !p) {
+McParser* McParserDeinit (McParser* p) {
+    if (!p) {
         LOG_ERROR ("invalid arguments.");
-        return false;
+        return NULL;
     }
 
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
-
-    if (parse_expr3 (e, p)) {
-        parser_skip_ws (p);
+    StrDeinit (&p->code);
+    McLexerDeinit (&p->lexer);
+    McLineIndexDeinit (&p->lines);
+    if (p->memo.active) {
+        ArenaDeinit (&p->memo.arena);
+    }
+    if (p->recovery.active) {
+        VecForeachPtr (&p->recovery.diagnostics, d, { StrDeinit (&d->message); });
+        VecDeinit (&p->recovery.diagnostics);
+    }
+    memset (p, 0, sizeof (McParser));
 
-        if (parser_can_read_n (p, 2) && !strncmp (p->read_pos, "||", 2)) {
-            p->read_pos += 2;
-            parser_skip_ws (p);
+    return p;
+}
 
-            McExpr* l = NEW (McExpr);
-            McExpr* r = NEW (McExpr);
 
-            *l           = *e;
-            e->expr_type = MC_EXPR_TYPE_LOG_OR;
-            e->log_or.l  = l;
-            e->log_or.r  = r;
+McParser* McParserInitFromFile (McParser* p, const char* src_name) {
+    if (!p || !src_name) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
 
-            if (parse_expr2 (r, p)) {
-                return true;
-            }
+    memset (p, 0, sizeof (McParser));
 
-            p->read_pos = start_pos;
-            McExprDeinit (l);
-            FREE (l);
-            McExprDeinit (r);
-            FREE (r);
-            memset (e, 0, sizeof (McExpr));
-            return false;
-        }
+    if (!ReadCompleteFile (src_name, (void**)&p->code.data, &p->code.length, &p->code.capacity)) {
+        LOG_ERROR ("failed to read complete file \"%s\".", src_name);
+        McParserDeinit (p);
+        return NULL;
+    }
 
-        // direct pass to expr2
-        return true;
+    if (!McLexerInit (&p->lexer)) {
+        LOG_ERROR ("failed to init lexer.");
+        McParserDeinit (p);
+        return NULL;
     }
 
-    return false;
+    McLineIndexInit (&p->lines);
+
+    return p;
 }
 
 
-static inline bool parse_expr1 (McExpr* e, McParser* p) {
-    if (!e || !p) {
+McParser* McParserInitFromZStr (McParser* p, const char* code) {
+    if (!p || !code) {
         LOG_ERROR ("invalid arguments.");
-        return false;
+        return NULL;
     }
 
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
-
-    if (parse_expr2 (e, p)) {
-        parser_skip_ws (p);
-
-        if (parser_peek (p) == '?') {
-            p->read_pos++;
-            parser_skip_ws (p);
-
-            McExpr* c = NEW (McExpr);
-            McExpr* t = NEW (McExpr);
-            McExpr* f = NEW (McExpr);
-
-            // we just realized this expression is a ternary operator expr
-            *c           = *e;
-            e->expr_type = MC_EXPR_TYPE_TERN;
-            e->tern.c    = c;
-            e->tern.t    = t;
-            e->tern.f    = f;
-
-            if (parse_expr1 (t, p)) {
-                parser_skip_ws (p);
-
-                if (parser_peek (p) == ':') {
-                    p->read_pos++;
-                    parser_skip_ws (p);
-
-                    if (parse_expr1 (f, p)) {
-                        return true;
-                    }
-
-                    // we expected an expr1, but didn't get one
-                    p->read_pos = start_pos;
-                    McExprDeinit (c);
-                    FREE (c);
-                    McExprDeinit (t);
-                    FREE (t);
-                    McExprDeinit (f);
-                    FREE (f);
-                    memset (e, 0, sizeof (McExpr));
-                    return false;
-                }
-
-                // fall through
-            }
+    memset (p, 0, sizeof (McParser));
 
-            // we expected an expr1, but didn't get one
-            p->read_pos = start_pos;
-            McExprDeinit (c);
-            FREE (c);
-            McExprDeinit (t);
-            FREE (t);
-            McExprDeinit (f);
-            FREE (f);
-            memset (e, 0, sizeof (McExpr));
-            return false;
-        }
+    StrInitFromZStr (&p->code, code);
 
-        // direct pass to expr2
-        return true;
+    if (!McLexerInit (&p->lexer)) {
+        LOG_ERROR ("failed to init lexer.");
+        McParserDeinit (p);
+        return NULL;
     }
 
-    return false;
+    McLineIndexInit (&p->lines);
+
+    return p;
 }
 
 
-static inline bool parse_expr0 (McExpr* e, McParser* p) {
-    if (!e || !p) {
+McParser* McParserInitFromFd (McParser* p, int fd, u64 window_size) {
+    if (!p || fd < 0) {
         LOG_ERROR ("invalid arguments.");
-        return false;
+        return NULL;
     }
 
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
-
-    if (parse_expr1 (e, p)) {
-        parser_skip_ws (p);
-
-        // try to parse assignment expression separately,
-        // because we allow multiple assignments
-        if (parser_peek (p) == '=') {
-            p->read_pos += 1;
-            parser_skip_ws (p);
-
-            McExpr* l = NEW (McExpr);
-            McExpr* r = NEW (McExpr);
+    memset (p, 0, sizeof (McParser));
 
-            *l           = *e;
-            e->expr_type = MC_EXPR_TYPE_OR;
-            e->assign.l  = l;
-            e->assign.r  = r;
+    if (!window_size) {
+        window_size = MC_PARSER_STREAM_DEFAULT_WINDOW_SIZE;
+    }
 
-            if (parse_expr4 (r, p)) {
-                return true;
-            }
+    // window is allocated once and never grows,
+    // one extra byte for null-termination
+    StrInit (&p->code);
+    if (!StrReserve (&p->code, window_size + 1)) {
+        LOG_ERROR ("failed to allocate stream window.");
+        McParserDeinit (p);
+        return NULL;
+    }
 
-            p->read_pos = start_pos;
-            McExprDeinit (l);
-            FREE (l);
-            McExprDeinit (r);
-            FREE (r);
-            memset (e, 0, sizeof (McExpr));
-            return false;
-        }
+    if (!McLexerInit (&p->lexer)) {
+        LOG_ERROR ("failed to init lexer.");
+        McParserDeinit (p);
+        return NULL;
+    }
 
-        // fall through to parse other operators at expr0 level
-
-        // Operands corresponding to expression type
-        struct {
-            const char* opnd;
-            u8          opnd_len;
-            McExprType  expr_type;
-        } opnd_type[] = {
-            { "+=", 2, MC_EXPR_TYPE_ADD_ASSIGN},
-            { "-=", 2, MC_EXPR_TYPE_SUB_ASSIGN},
-            { "*=", 2, MC_EXPR_TYPE_MUL_ASSIGN},
-            { "/=", 2, MC_EXPR_TYPE_DIV_ASSIGN},
-            { "%=", 2, MC_EXPR_TYPE_MOD_ASSIGN},
-            { "&=", 2, MC_EXPR_TYPE_AND_ASSIGN},
-            { "|=", 2,  MC_EXPR_TYPE_OR_ASSIGN},
-            { "^=", 2, MC_EXPR_TYPE_XOR_ASSIGN},
-            {">>=", 3, MC_EXPR_TYPE_SHR_ASSIGN},
-            {"<<=", 3, MC_EXPR_TYPE_SHL_ASSIGN},
-        };
-        u64 nopnds = sizeof (opnd_type) / sizeof (opnd_type[0]);
-
-        McExpr* r = NEW (McExpr);
-
-        // Go through each operand and create the corresponding
-        // expression by parsing another right expression
-        for (u64 o = 0; o < nopnds; o++) {
-            if (parser_can_read_n (p, opnd_type[o].opnd_len) &&
-                !strncmp (p->read_pos, opnd_type[o].opnd, opnd_type[o].opnd_len)) {
-                // Ignore any whitespace coming after the operator
-                p->read_pos += opnd_type[o].opnd_len;
-                parser_skip_ws (p);
-
-                // Get the right hand expression
-                if (parse_expr1 (r, p)) {
-                    McExpr* l = NEW (McExpr);
-                    *l        = *e;
-
-                    e->expr_type = opnd_type[o].expr_type;
-                    e->assign.l  = l;
-                    e->assign.r  = r;
-
-                    return true;
-                }
-            }
-        }
+    McLineIndexInit (&p->lines);
 
-        // If none of the operands match, then we make
-        // a direct pass to expr1, which was already parsed,
-        // and now we just need to return as a successful match
-        McExprDeinit (r);
-        FREE (r);
-        return true;
-    }
+    p->stream.active      = true;
+    p->stream.fd          = fd;
+    p->stream.window_size = window_size;
 
-    return false;
+    return p;
 }
 
 
-bool McParseExpr (McExpr* e, McParser* p) {
-    if (!e || !p) {
+McParser* McParserEnableRecovery (McParser* p, u64 max_diagnostics) {
+    if (!p) {
         LOG_ERROR ("invalid arguments.");
-        return false;
+        return NULL;
     }
 
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
-
-    if (parse_expr_list (e, p)) {
-        return true;
+    if (p->recovery.active) {
+        return p;
     }
-    return false;
-}
-
 
-static inline bool parse_expr_list (McExpr* e, McParser* p) {
-    if (!e || !p) {
-        LOG_ERROR ("invalid arguments.");
-        return false;
-    }
+    McParserRecovery* r = &p->recovery;
+    VecInit (&r->diagnostics, NULL, NULL);
+    r->max_diagnostics = max_diagnostics ? max_diagnostics : MC_PARSER_DEFAULT_MAX_DIAGNOSTICS;
+    r->skipped         = 0;
+    r->active          = true;
 
-    if (parse_expr0 (e, p)) {
-        parser_skip_ws (p);
-
-        // if we get a comma, then this is actually a list expression
-        if (parser_peek (p) == ',') {
-            // create a clone of currently parse expr
-            McExpr* xpr = NEW (McExpr);
-            *xpr        = *e;
-
-            // parse complete list first
-            McExprVec list;
-            VecInit (&list, NULL, NULL);
-            VecPushBack (&list, &xpr);
-            while (parser_peek (p) == ',') {
-                p->read_pos++;
-                parser_skip_ws (p);
-
-                if (parse_expr0 (e, p)) {
-                    // make space for one more expression
-                    VecResize (&list, e->list.length + 1);
-                    VecLast (&list)  = NEW (McExpr);
-                    *VecLast (&list) = *e;
-                }
-            }
+    return p;
+}
 
-            // then change current expr's type to list
-            e->expr_type = MC_EXPR_TYPE_LIST;
-            e->list      = list;
-        }
 
-        return true;
+McParser* McParserEnableFolding (McParser* p) {
+    if (!p) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
     }
 
-    return false;
+    p->fold = true;
+    return p;
 }
 
 
-bool McParseProgram (McProgram* prog, McParser* p) {
-    if (!prog || !p) {
+McParser* McParserEnableMemo (McParser* p, u64 budget) {
+    if (!p) {
         LOG_ERROR ("invalid arguments.");
-        return false;
+        return NULL;
     }
 
-    const char* start_pos = p->read_pos;
-    parser_skip_ws (p);
-
-    while (parser_can_read_n (p, 1)) {
-        parser_skip_ws (p);
-        McType type = {0};
-        McExpr e    = {0};
-        if (parse_basic_type (&type, p)) {
-            parser_skip_ws (p);
-            puts ("type");
-        } else if (McParseExpr (&e, p)) {
-            parser_skip_ws (p);
-            printf ("expr value : %lf\n", McExprEval (&e));
-            McExprDeinit (&e);
-        } else {
-            break;
-        }
+    if (p->memo.active) {
+        return p;
     }
 
-    if (parser_can_read_n (p, 1)) {
-        p->read_pos = start_pos;
-        return false;
+    if (!budget) {
+        budget = MC_PARSER_MEMO_DEFAULT_BUDGET;
     }
 
-    return true;
-}
+    // largest table that fits in budget
+    u64 nslots = 64;
+    while (nslots * 2 * sizeof (McParserMemoEntry) <= budget) {
+        nslots *= 2;
+    }
 
-McParser* McParserDeinit (McParser* p) {
-    if (!p) {
-        LOG_ERROR ("invalid arguments.");
+    McParserMemo* m = &p->memo;
+    ArenaInit (&m->arena, nslots * sizeof (McParserMemoEntry));
+    m->slots = ArenaNew (&m->arena, McParserMemoEntry, nslots);
+    if (!m->slots) {
+        LOG_ERROR ("failed to allocate memo table.");
+        ArenaDeinit (&m->arena);
+        memset (m, 0, sizeof (McParserMemo));
         return NULL;
     }
 
-    StrDeinit (&p->code);
-    memset (p, 0, sizeof (McParser));
+    m->nslots = nslots;
+    m->active = true;
 
     return p;
 }
 
 
-McParser* McParserInitFromFile (McParser* p, const char* src_name) {
-    if (!p || !src_name) {
+McParser* McParserStreamCommit (McParser* p) {
+    if (!p) {
         LOG_ERROR ("invalid arguments.");
         return NULL;
     }
 
-    memset (p, 0, sizeof (McParser));
+    if (!p->stream.active) {
+        return p;
+    }
 
-    if (!ReadCompleteFile (src_name, (void**)&p->code.data, &p->code.length, &p->code.capacity)) {
-        LOG_ERROR ("failed to read complete file \"%s\".", src_name);
-        McParserDeinit (p);
+    // everything before current token is consumed, if all lexed
+    // tokens are consumed, then so is all code lexed so far
+    McTokenVec* tokens   = &p->lexer.tokens;
+    u64         consumed = p->tok < tokens->length ? VecAt (tokens, p->tok).offset : p->lexer.pos;
+    if (!consumed) {
+        return p;
+    }
+
+    if (!McLexerDrop (&p->lexer, p->tok, consumed)) {
+        LOG_ERROR ("failed to drop consumed tokens.");
         return NULL;
     }
+    p->peek_end = p->peek_end > p->tok ? p->peek_end - p->tok : 0;
+    p->tok      = 0;
 
-    p->read_pos = p->code.data;
+    // memo is keyed by token index, which just changed
+    memo_clear (&p->memo);
+
+    // line numbers of code after consumed bytes depend on them
+    if (!McLineIndexDrop (&p->lines, p->code.data, consumed)) {
+        LOG_ERROR ("failed to drop line starts.");
+        return NULL;
+    }
+
+    // slide unread code to the beginning of window
+    memmove (p->code.data, p->code.data + consumed, p->code.length - consumed);
+    p->code.length               -= consumed;
+    p->code.data[p->code.length]  = 0;
+    p->stream.base               += consumed;
 
     return p;
 }
 
 
-McParser* McParserInitFromZStr (McParser* p, const char* code) {
-    if (!p || !code) {
+bool McParserLocate (McParser* p, u64 offset, u64* line, u64* column) {
+    if (!p || !line || !column) {
         LOG_ERROR ("invalid arguments.");
-        return NULL;
+        return false;
     }
 
-    memset (p, 0, sizeof (McParser));
-
-    StrInitFromZStr (&p->code, code);
-    p->read_pos = p->code.data;
+    if (!McLineIndexScan (&p->lines, p->code.data, p->code.length)) {
+        LOG_ERROR ("failed to scan code for lines.");
+        return false;
+    }
 
-    return p;
+    return McLineIndexLookup (&p->lines, offset, line, column);
 }
 
 
@@ -0,0 +1,360 @@
+/// file      : misra/mc/ast.c
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Compact index based AST store.
+
+#include <Misra/Mc/Parser/Ast.h>
+#include <Misra/Std/Log.h>
+
+// platform
+#include <string.h>
+
+McAst* McAstInit (McAst* ast) {
+    if (!ast) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    memset (ast, 0, sizeof (McAst));
+    VecInit (&ast->nodes, NULL, NULL);
+    VecInit (&ast->extra, NULL, NULL);
+    VecInit (&ast->types, NULL, NULL);
+    VecInit (&ast->values, NULL, NULL);
+    StrInit (&ast->names);
+
+    // handle 0 is reserved for "no node"
+    McAstNode none = {0};
+    if (!VecPushBack (&ast->nodes, &none)) {
+        LOG_ERROR ("failed to reserve invalid node.");
+        McAstDeinit (ast);
+        return NULL;
+    }
+
+    return ast;
+}
+
+
+McAst* McAstDeinit (McAst* ast) {
+    if (!ast) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    VecDeinit (&ast->nodes);
+    VecDeinit (&ast->extra);
+    VecDeinit (&ast->types);
+    VecDeinit (&ast->values);
+    StrDeinit (&ast->names);
+    memset (ast, 0, sizeof (McAst));
+
+    return ast;
+}
+
+
+static inline McAstId push_node (McAst* ast, McExpr* e, u32 a, u32 b) {
+    if (ast->nodes.length >= (u32)-1) {
+        LOG_ERROR ("too many nodes in AST.");
+        return MC_AST_NONE;
+    }
+
+    McAstNode node = {.expr_type = e->expr_type, .offset = e->offset, .a = a, .b = b};
+    if (!VecPushBack (&ast->nodes, &node)) {
+        LOG_ERROR ("failed to add node to AST.");
+        return MC_AST_NONE;
+    }
+
+    return ast->nodes.length - 1;
+}
+
+
+// Reserve `n` consecutive slots in `ast->extra`, returning index of first.
+static inline bool reserve_extra (McAst* ast, u32 n, u32* start) {
+    *start = ast->extra.length;
+    if (!VecResize (&ast->extra, ast->extra.length + n)) {
+        LOG_ERROR ("failed to reserve space in AST.");
+        return false;
+    }
+    return true;
+}
+
+
+///
+/// Copy tree rooted at `e` into `ast`, children first.
+///
+/// ast[in,out] : McAst object to copy tree into.
+/// e[in]       : Root of tree to copy. NULL and invalid expressions become `MC_AST_NONE`.
+/// id[out]     : Handle of copied root.
+///
+/// SUCCESS : true
+/// FAILURE : false, `ast` may contain part of tree.
+///
+static bool add_expr (McAst* ast, McExpr* e, McAstId* id) {
+    *id = MC_AST_NONE;
+
+    if (!e || e->expr_type == MC_EXPR_TYPE_INVALID) {
+        return true;
+    }
+
+    McAstId l = MC_AST_NONE;
+    McAstId r = MC_AST_NONE;
+
+    switch (e->expr_type) {
+        case MC_EXPR_TYPE_ADD :
+        case MC_EXPR_TYPE_SUB :
+        case MC_EXPR_TYPE_MUL :
+        case MC_EXPR_TYPE_DIV :
+        case MC_EXPR_TYPE_AND :
+        case MC_EXPR_TYPE_OR :
+        case MC_EXPR_TYPE_XOR :
+        case MC_EXPR_TYPE_MOD :
+        case MC_EXPR_TYPE_SHR :
+        case MC_EXPR_TYPE_SHL :
+        case MC_EXPR_TYPE_LE :
+        case MC_EXPR_TYPE_GE :
+        case MC_EXPR_TYPE_LT :
+        case MC_EXPR_TYPE_GT :
+        case MC_EXPR_TYPE_EQ :
+        case MC_EXPR_TYPE_NE :
+        case MC_EXPR_TYPE_LOG_AND :
+        case MC_EXPR_TYPE_LOG_OR :
+        case MC_EXPR_TYPE_ASSIGN :
+        case MC_EXPR_TYPE_ADD_ASSIGN :
+        case MC_EXPR_TYPE_SUB_ASSIGN :
+        case MC_EXPR_TYPE_MUL_ASSIGN :
+        case MC_EXPR_TYPE_DIV_ASSIGN :
+        case MC_EXPR_TYPE_MOD_ASSIGN :
+        case MC_EXPR_TYPE_AND_ASSIGN :
+        case MC_EXPR_TYPE_OR_ASSIGN :
+        case MC_EXPR_TYPE_XOR_ASSIGN :
+        case MC_EXPR_TYPE_SHR_ASSIGN :
+        case MC_EXPR_TYPE_SHL_ASSIGN :
+        case MC_EXPR_TYPE_CALL :
+        case MC_EXPR_TYPE_ARR_SUBSCRIPT :
+        case MC_EXPR_TYPE_ACCESS :
+        case MC_EXPR_TYPE_PTR_ACCESS : {
+            if (!add_expr (ast, e->add.l, &l) || !add_expr (ast, e->add.r, &r)) {
+                return false;
+            }
+            break;
+        }
+
+        case MC_EXPR_TYPE_LOG_NOT :
+        case MC_EXPR_TYPE_NOT :
+        case MC_EXPR_TYPE_UN_PLUS :
+        case MC_EXPR_TYPE_UN_MINUS :
+        case MC_EXPR_TYPE_IN_PARENS :
+        case MC_EXPR_TYPE_ADDR :
+        case MC_EXPR_TYPE_DEREF :
+        case MC_EXPR_TYPE_SIZE_OF :
+        case MC_EXPR_TYPE_ALIGN_OF :
+        case MC_EXPR_TYPE_INC_PFX :
+        case MC_EXPR_TYPE_INC_SFX :
+        case MC_EXPR_TYPE_DEC_PFX :
+        case MC_EXPR_TYPE_DEC_SFX : {
+            if (!add_expr (ast, e->not.e, &l)) {
+                return false;
+            }
+            break;
+        }
+
+        case MC_EXPR_TYPE_CAST : {
+            if (!add_expr (ast, e->cast.e, &l)) {
+                return false;
+            }
+            r = ast->types.length;
+            if (!VecPushBack (&ast->types, &e->cast.type)) {
+                LOG_ERROR ("failed to add cast type to AST.");
+                return false;
+            }
+            break;
+        }
+
+        case MC_EXPR_TYPE_TERN : {
+            // branches are filled in after they're copied, nested ternaries may
+            // grow `extra` in between
+            if (!add_expr (ast, e->tern.c, &l) || !reserve_extra (ast, 2, &r)) {
+                return false;
+            }
+            McAstId t = MC_AST_NONE;
+            McAstId f = MC_AST_NONE;
+            if (!add_expr (ast, e->tern.t, &t) || !add_expr (ast, e->tern.f, &f)) {
+                return false;
+            }
+            VecAt (&ast->extra, r)     = t;
+            VecAt (&ast->extra, r + 1) = f;
+            break;
+        }
+
+        case MC_EXPR_TYPE_LIST : {
+            r = e->list.length;
+            if (!reserve_extra (ast, r, &l)) {
+                return false;
+            }
+            for (u32 i = 0; i < r; i++) {
+                McAstId item = MC_AST_NONE;
+                if (!add_expr (ast, VecAt (&e->list, i), &item)) {
+                    return false;
+                }
+                VecAt (&ast->extra, l + i) = item;
+            }
+            break;
+        }
+
+        case MC_EXPR_TYPE_ID : {
+            l = ast->names.length;
+            r = e->id.length;
+            if (r && !StrPushBackCStr (&ast->names, e->id.data, r)) {
+                LOG_ERROR ("failed to add name to AST.");
+                return false;
+            }
+            break;
+        }
+
+        case MC_EXPR_TYPE_NUM : {
+            u64 bits = 0;
+            if (e->num.is_int) {
+                bits = e->num.i;
+            } else {
+                memcpy (&bits, &e->num.f, sizeof (bits));
+            }
+            l = ast->values.length;
+            r = e->num.is_int;
+            if (!VecPushBack (&ast->values, &bits)) {
+                LOG_ERROR ("failed to add number to AST.");
+                return false;
+            }
+            break;
+        }
+
+        default : {
+            LOG_ERROR ("unreachable code reached : invalid expression type.");
+            return false;
+        }
+    }
+
+    *id = push_node (ast, e, l, r);
+    return *id != MC_AST_NONE;
+}
+
+
+McAstId McAstAddExpr (McAst* ast, McExpr* expr) {
+    if (!ast || !expr) {
+        LOG_ERROR ("invalid arguments.");
+        return MC_AST_NONE;
+    }
+
+    u64 nnodes  = ast->nodes.length;
+    u64 nextra  = ast->extra.length;
+    u64 ntypes  = ast->types.length;
+    u64 nvalues = ast->values.length;
+    u64 nnames  = ast->names.length;
+
+    McAstId id = MC_AST_NONE;
+    if (add_expr (ast, expr, &id)) {
+        return id;
+    }
+
+    // drop partially copied tree
+    VecResize (&ast->nodes, nnodes);
+    VecResize (&ast->extra, nextra);
+    VecResize (&ast->types, ntypes);
+    VecResize (&ast->values, nvalues);
+    StrResize (&ast->names, nnames);
+
+    return MC_AST_NONE;
+}
+
+
+static f64 eval_node (const McAst* ast, McAstId id) {
+    const McAstNode* n = &ast->nodes.data[id];
+
+    switch (n->expr_type) {
+        case MC_EXPR_TYPE_ADD :
+            return eval_node (ast, n->a) + eval_node (ast, n->b);
+        case MC_EXPR_TYPE_SUB :
+            return eval_node (ast, n->a) - eval_node (ast, n->b);
+        case MC_EXPR_TYPE_MUL :
+            return eval_node (ast, n->a) * eval_node (ast, n->b);
+        case MC_EXPR_TYPE_DIV :
+            return eval_node (ast, n->a) / eval_node (ast, n->b);
+        case MC_EXPR_TYPE_AND :
+            return (u64)eval_node (ast, n->a) & (u64)eval_node (ast, n->b);
+        case MC_EXPR_TYPE_OR :
+            return (u64)eval_node (ast, n->a) | (u64)eval_node (ast, n->b);
+        case MC_EXPR_TYPE_XOR :
+            return (u64)eval_node (ast, n->a) ^ (u64)eval_node (ast, n->b);
+        case MC_EXPR_TYPE_MOD :
+            return (u64)eval_node (ast, n->a) % (u64)eval_node (ast, n->b);
+        case MC_EXPR_TYPE_SHR :
+            return (u64)eval_node (ast, n->a) >> (u64)eval_node (ast, n->b);
+        case MC_EXPR_TYPE_SHL :
+            return (u64)eval_node (ast, n->a) << (u64)eval_node (ast, n->b);
+        case MC_EXPR_TYPE_LE :
+            return eval_node (ast, n->a) <= eval_node (ast, n->b);
+        case MC_EXPR_TYPE_GE :
+            return eval_node (ast, n->a) >= eval_node (ast, n->b);
+        case MC_EXPR_TYPE_LT :
+            return eval_node (ast, n->a) < eval_node (ast, n->b);
+        case MC_EXPR_TYPE_GT :
+            return eval_node (ast, n->a) > eval_node (ast, n->b);
+        case MC_EXPR_TYPE_EQ :
+            return eval_node (ast, n->a) == eval_node (ast, n->b);
+        case MC_EXPR_TYPE_NE :
+            return eval_node (ast, n->a) != eval_node (ast, n->b);
+        case MC_EXPR_TYPE_LOG_AND :
+            return eval_node (ast, n->a) && eval_node (ast, n->b);
+        case MC_EXPR_TYPE_LOG_OR :
+            return eval_node (ast, n->a) || eval_node (ast, n->b);
+        case MC_EXPR_TYPE_ASSIGN :
+            return 0;
+        case MC_EXPR_TYPE_UN_PLUS :
+            return eval_node (ast, n->a);
+        case MC_EXPR_TYPE_UN_MINUS :
+            return -eval_node (ast, n->a);
+        case MC_EXPR_TYPE_LOG_NOT :
+            return !eval_node (ast, n->a);
+        case MC_EXPR_TYPE_NOT :
+            return !(u64)eval_node (ast, n->a);
+        case MC_EXPR_TYPE_INC_PFX :
+            return eval_node (ast, n->a) + 1;
+        case MC_EXPR_TYPE_INC_SFX :
+            return eval_node (ast, n->a);
+        case MC_EXPR_TYPE_DEC_PFX :
+            return eval_node (ast, n->a) - 1;
+        case MC_EXPR_TYPE_DEC_SFX :
+            return eval_node (ast, n->a);
+        case MC_EXPR_TYPE_NUM : {
+            u64 bits = VecAt (&ast->values, n->a);
+            if (n->b) {
+                return bits;
+            }
+            f64 f;
+            memcpy (&f, &bits, sizeof (f));
+            return f;
+        }
+        case MC_EXPR_TYPE_TERN :
+            return eval_node (ast, n->a) ? eval_node (ast, VecAt (&ast->extra, n->b)) :
+                                           eval_node (ast, VecAt (&ast->extra, n->b + 1));
+        case MC_EXPR_TYPE_ID :
+            return 0;
+        case MC_EXPR_TYPE_CAST :
+            return eval_node (ast, n->a);
+        case MC_EXPR_TYPE_IN_PARENS :
+            return eval_node (ast, n->a);
+        case MC_EXPR_TYPE_LIST :
+            return n->b ? eval_node (ast, VecAt (&ast->extra, n->a + n->b - 1)) : 0;
+        default :
+            return 0;
+    }
+}
+
+
+f64 McAstEval (McAst* ast, McAstId id) {
+    if (!ast || id >= ast->nodes.length) {
+        LOG_ERROR ("invalid arguments.");
+        return 0;
+    }
+
+    return eval_node (ast, id);
+}
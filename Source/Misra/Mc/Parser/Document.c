@@ -0,0 +1,528 @@
+/// file      : misra/mc/document.c
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Source documents, parsed in parallel and reparsed incrementally.
+
+#include <Misra/Mc/Parser/Document.h>
+#include <Misra/Mc/Parser/Split.h>
+#include <Misra/Std/Log.h>
+
+// platform
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+static inline void item_deinit (McItem* item) {
+    if (item->item_kind == MC_ITEM_KIND_EXPR) {
+        McExprDeinit (&item->expr);
+    }
+    memset (item, 0, sizeof (McItem));
+}
+
+
+///
+/// Parse a single top level item at current token of parser.
+///
+/// doc[in,out] : McDocument object to parse from, must not be at end of code.
+/// item[out]   : Parsed item.
+///
+/// RETURN : Always succeeds. Tokens that don't start an item become an
+///          invalid item of one token.
+///
+static void parse_item (McDocument* doc, McItem* item) {
+    McParser*   p      = &doc->parser;
+    McTokenVec* tokens = &p->lexer.tokens;
+
+    memset (item, 0, sizeof (McItem));
+    item->first_tok     = p->tok;
+    item->offset        = VecAt (tokens, p->tok).offset;
+    item->parsed_offset = item->offset;
+    p->peek_end         = p->tok;
+
+    if (McParseType (&item->type, p)) {
+        item->item_kind = MC_ITEM_KIND_TYPE;
+    } else if (McParseExpr (&item->expr, p)) {
+        item->item_kind = MC_ITEM_KIND_EXPR;
+    } else {
+        item->item_kind = MC_ITEM_KIND_INVALID;
+        item->error_tok = p->peek_end > p->tok ? p->peek_end - 1 : p->tok;
+        p->tok++;
+    }
+
+    // optional ";" after item
+    if (p->tok + 1 > p->peek_end) {
+        p->peek_end = p->tok + 1;
+    }
+    if (VecAt (tokens, p->tok).kind == MC_TOKEN_KIND_SEMICOLON) {
+        p->tok++;
+    }
+
+    item->end_tok  = p->tok;
+    item->peek_end = p->peek_end;
+    if (item->peek_end - item->end_tok > doc->lookahead) {
+        doc->lookahead = item->peek_end - item->end_tok;
+    }
+}
+
+
+// Lex all of code in parser of document, and parse all items of it.
+static bool document_parse (McDocument* doc) {
+    McParser* p = &doc->parser;
+
+    // edits need all tokens up front
+    if (!McLexerRun (&p->lexer, p->code.data, p->code.length, true)) {
+        LOG_ERROR ("failed to lex code.");
+        return false;
+    }
+
+    while (VecAt (&p->lexer.tokens, p->tok).kind != MC_TOKEN_KIND_EOF) {
+        McItem item = {0};
+        parse_item (doc, &item);
+        if (!VecPushBack (&doc->items, &item)) {
+            LOG_ERROR ("failed to add item.");
+            item_deinit (&item);
+            return false;
+        }
+    }
+
+    doc->nrelexed  = p->lexer.tokens.length;
+    doc->nreparsed = doc->items.length;
+
+    return true;
+}
+
+
+McDocument* McDocumentInit (McDocument* doc, const char* code) {
+    if (!doc || !code) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    memset (doc, 0, sizeof (McDocument));
+    VecInit (&doc->items, NULL, NULL);
+
+    if (!McParserInitFromZStr (&doc->parser, code)) {
+        LOG_ERROR ("failed to init parser.");
+        McDocumentDeinit (doc);
+        return NULL;
+    }
+
+    if (!document_parse (doc)) {
+        McDocumentDeinit (doc);
+        return NULL;
+    }
+
+    return doc;
+}
+
+
+McDocument* McDocumentInitFromFile (McDocument* doc, const char* src_name) {
+    if (!doc || !src_name) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    memset (doc, 0, sizeof (McDocument));
+    VecInit (&doc->items, NULL, NULL);
+
+    if (!McParserInitFromFile (&doc->parser, src_name)) {
+        LOG_ERROR ("failed to init parser.");
+        McDocumentDeinit (doc);
+        return NULL;
+    }
+
+    if (!document_parse (doc)) {
+        McDocumentDeinit (doc);
+        return NULL;
+    }
+
+    return doc;
+}
+
+
+///
+/// A slice of code, parsed by a worker as a document of it's own.
+///
+typedef struct DocSlice {
+    const char* code;
+    u64         length;
+
+    /// Offset of slice in complete code.
+    u64 offset;
+
+    McDocument doc;
+    bool       ok;
+
+    /// Index of each name of slice in interner of merged document.
+    Vec (u32) names;
+
+    /// Index of first token and first item of slice in merged document.
+    u64 first_tok;
+    u64 first_item;
+} DocSlice;
+
+typedef struct DocWork {
+    Vec (DocSlice) slices;
+
+    /// Index of next slice no worker has picked yet.
+    u64 next;
+
+    /// Document slices are merged into.
+    McDocument* doc;
+} DocWork;
+
+// Lex and parse slices, each into it's own document.
+static void* parse_slices (void* arg) {
+    DocWork* work = arg;
+
+    u64 idx;
+    while ((idx = __atomic_fetch_add (&work->next, 1, __ATOMIC_RELAXED)) < work->slices.length) {
+        DocSlice*   slice = VecIter (&work->slices, idx);
+        McDocument* doc   = &slice->doc;
+        McParser*   p     = &doc->parser;
+
+        slice->ok = McLexerInit (&p->lexer) && McLineIndexInit (&p->lines) &&
+                    VecInit (&doc->items, NULL, NULL) &&
+                    StrInitFromCStr (&p->code, slice->code, slice->length) &&
+                    document_parse (doc);
+    }
+
+    return NULL;
+}
+
+
+// Copy tokens and items of slices to their place in merged document, which
+// already has room for all of them. Items are moved, not copied.
+static void* merge_slices (void* arg) {
+    DocWork* work = arg;
+
+    u64 idx;
+    while ((idx = __atomic_fetch_add (&work->next, 1, __ATOMIC_RELAXED)) < work->slices.length) {
+        DocSlice*   slice = VecIter (&work->slices, idx);
+        McDocument* part  = &slice->doc;
+        McTokenVec* from  = &part->parser.lexer.tokens;
+        McToken*    tok   = VecIter (&work->doc->parser.lexer.tokens, slice->first_tok);
+        McItem*     item  = VecIter (&work->doc->items, slice->first_item);
+
+        // all tokens but EOF
+        for (u64 t = 0; t + 1 < from->length; t++, tok++) {
+            *tok         = VecAt (from, t);
+            tok->offset += slice->offset;
+            if (tok->kind == MC_TOKEN_KIND_ID) {
+                tok->value = VecAt (&slice->names, tok->value);
+            }
+        }
+
+        // node offsets of items stay relative to slice, like after an edit
+        VecForeachPtr (&part->items, it, {
+            *item            = *it;
+            item->first_tok += slice->first_tok;
+            item->end_tok   += slice->first_tok;
+            item->peek_end  += slice->first_tok;
+            item->error_tok += slice->first_tok;
+            item->offset    += slice->offset;
+            item++;
+        });
+        part->items.length = 0;
+
+        McDocumentDeinit (part);
+        VecDeinit (&slice->names);
+    }
+
+    return NULL;
+}
+
+
+// Run given worker on `nthreads` threads, including this one, till all
+// slices are done.
+static void run_workers (DocWork* work, void* (*worker) (void*), u32 nthreads) {
+    pthread_t threads[MC_DOCUMENT_MAX_THREADS];
+    u32       nstarted = 0;
+
+    work->next = 0;
+    while (nstarted + 1 < nthreads && nstarted + 1 < work->slices.length &&
+           !pthread_create (&threads[nstarted], NULL, worker, work)) {
+        nstarted++;
+    }
+
+    worker (work);
+    for (u32 idx = 0; idx < nstarted; idx++) {
+        pthread_join (threads[idx], NULL);
+    }
+}
+
+
+// Give every slice it's place in merged document, and intern it's names in
+// order of first use, so that they get same index as when complete code is
+// lexed at once.
+static bool place_slices (McDocument* doc, DocWork* work, u64* ntokens, u64* nitems) {
+    McLexer* lx = &doc->parser.lexer;
+
+    *ntokens = 0;
+    *nitems  = 0;
+    VecForeachPtr (&work->slices, slice, {
+        if (!slice->ok) {
+            return false;
+        }
+
+        McLexer* from = &slice->doc.parser.lexer;
+        if (!VecResize (&slice->names, from->interner.offsets.length)) {
+            LOG_ERROR ("failed to map names.");
+            return false;
+        }
+        for (u32 idx = 0; idx < slice->names.length; idx++) {
+            const char* name = McLexerName (from, idx);
+            u32         n    = McLexerIntern (lx, name, strlen (name));
+            if (n == (u32)-1) {
+                return false;
+            }
+            VecAt (&slice->names, idx) = n;
+        }
+
+        slice->first_tok   = *ntokens;
+        slice->first_item  = *nitems;
+        *ntokens          += from->tokens.length - 1;
+        *nitems           += slice->doc.items.length;
+
+        if (slice->doc.lookahead > doc->lookahead) {
+            doc->lookahead = slice->doc.lookahead;
+        }
+    });
+
+    return true;
+}
+
+
+McDocument*
+    McDocumentInitParallel (McDocument* doc, const char* code, u32 nthreads, u64 min_slice) {
+    if (!doc || !code) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    if (!nthreads) {
+        long ncpu = sysconf (_SC_NPROCESSORS_ONLN);
+        nthreads  = ncpu > 0 ? ncpu : 1;
+    }
+    if (nthreads > MC_DOCUMENT_MAX_THREADS) {
+        nthreads = MC_DOCUMENT_MAX_THREADS;
+    }
+
+    u64 length = strlen (code);
+    if (!min_slice) {
+        // a few slices per thread, to balance load
+        min_slice = length / (nthreads * 4);
+        min_slice = min_slice > MC_DOCUMENT_MIN_SLICE ? min_slice : MC_DOCUMENT_MIN_SLICE;
+    }
+
+    McCutVec cuts = {0};
+    VecInit (&cuts, NULL, NULL);
+    if (nthreads == 1 || !McSplitItems (code, length, min_slice, &cuts) || cuts.length < 2) {
+        VecDeinit (&cuts);
+        return McDocumentInit (doc, code);
+    }
+
+    DocWork work = {.doc = doc};
+    VecInit (&work.slices, NULL, NULL);
+    if (!VecResize (&work.slices, cuts.length)) {
+        LOG_ERROR ("failed to allocate slices.");
+        VecDeinit (&cuts);
+        return NULL;
+    }
+    memset (work.slices.data, 0, cuts.length * sizeof (DocSlice));
+    for (u64 idx = 0; idx < cuts.length; idx++) {
+        DocSlice* slice = VecIter (&work.slices, idx);
+        u64       end   = idx + 1 < cuts.length ? VecAt (&cuts, idx + 1) : length;
+        slice->offset   = VecAt (&cuts, idx);
+        slice->code     = code + slice->offset;
+        slice->length   = end - slice->offset;
+        VecInit (&slice->names, NULL, NULL);
+    }
+    VecDeinit (&cuts);
+
+    run_workers (&work, parse_slices, nthreads);
+
+    // merged document starts with code and no tokens
+    memset (doc, 0, sizeof (McDocument));
+    VecInit (&doc->items, NULL, NULL);
+
+    // exact reserve first, resize alone would round up to a power of 2
+    u64  ntokens = 0;
+    u64  nitems  = 0;
+    bool ok      = McParserInitFromZStr (&doc->parser, code) &&
+              place_slices (doc, &work, &ntokens, &nitems) &&
+              VecReserve (&doc->parser.lexer.tokens, ntokens + 1) &&
+              VecResize (&doc->parser.lexer.tokens, ntokens + 1) &&
+              (!nitems || (VecReserve (&doc->items, nitems) && VecResize (&doc->items, nitems)));
+
+    if (!ok) {
+        LOG_ERROR ("failed to parse code in parallel.");
+        VecForeachPtr (&work.slices, slice, {
+            McDocumentDeinit (&slice->doc);
+            VecDeinit (&slice->names);
+        });
+        VecDeinit (&work.slices);
+        McDocumentDeinit (doc);
+        return NULL;
+    }
+
+    run_workers (&work, merge_slices, nthreads);
+    VecDeinit (&work.slices);
+
+    VecLast (&doc->parser.lexer.tokens) = (McToken) {.kind = MC_TOKEN_KIND_EOF, .offset = length};
+    doc->parser.lexer.pos               = length;
+    doc->nrelexed                       = doc->parser.lexer.tokens.length;
+    doc->nreparsed                      = doc->items.length;
+
+    return doc;
+}
+
+
+McDocument* McDocumentDeinit (McDocument* doc) {
+    if (!doc) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    VecForeachPtr (&doc->items, item, { item_deinit (item); });
+    VecDeinit (&doc->items);
+    McParserDeinit (&doc->parser);
+    memset (doc, 0, sizeof (McDocument));
+
+    return doc;
+}
+
+
+McDocument*
+    McDocumentEdit (McDocument* doc, u64 offset, u64 removed, const char* inserted, u64 length) {
+    if (!doc || (!inserted && length)) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    McParser* p    = &doc->parser;
+    Str*      code = &p->code;
+    if (offset > code->length || removed > code->length - offset) {
+        LOG_ERROR ("edit out of code bounds.");
+        return NULL;
+    }
+
+    // edit code, keeping it null-terminated
+    if ((removed && !StrDeleteRange (code, offset, removed)) ||
+        (length && !VecPushArr (code, inserted, length, offset)) ||
+        !StrReserve (code, code->length + 1)) {
+        LOG_ERROR ("failed to edit code.");
+        return NULL;
+    }
+    code->data[code->length] = 0;
+
+    McTokenSplice splice = {0};
+    if (!McLexerEdit (&p->lexer, code->data, code->length, offset, removed, length, &splice)) {
+        LOG_ERROR ("failed to lex edited code.");
+        return NULL;
+    }
+    doc->nrelexed = splice.ninserted;
+
+    // line starts are found again on next lookup
+    McLineIndexDeinit (&p->lines);
+    McLineIndexInit (&p->lines);
+
+    McItemVec* items   = &doc->items;
+    u64        dmg     = splice.first;
+    u64        old_end = splice.first + splice.nremoved;
+    u64        shift   = splice.ninserted - splice.nremoved;
+
+    // first item that looked at a changed token, everything before it stays.
+    // No item looks further than `lookahead` tokens past it's end, so items
+    // ending before that are skipped with a binary search.
+    u64 lo = 0;
+    u64 hi = items->length;
+    while (lo < hi) {
+        u64 mid = lo + (hi - lo) / 2;
+        if (VecAt (items, mid).end_tok + doc->lookahead <= dmg) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    u64 first = lo;
+    while (first < items->length && VecAt (items, first).peek_end <= dmg) {
+        first++;
+    }
+
+    // first old item made only of unchanged tokens, it and everything after
+    // can be reused if parser gets back in step with them
+    u64 last = first;
+    while (last < items->length && VecAt (items, last).first_tok < old_end) {
+        last++;
+    }
+
+    u64 tok = first < items->length ? VecAt (items, first).first_tok :
+              items->length         ? VecLast (items).end_tok :
+                                      0;
+
+    McItemVec fresh = {0};
+    VecInit (&fresh, NULL, NULL);
+
+    while (true) {
+        while (last < items->length && VecAt (items, last).first_tok + shift < tok) {
+            last++;
+        }
+        if (last < items->length && VecAt (items, last).first_tok + shift == tok) {
+            break;
+        }
+        if (VecAt (&p->lexer.tokens, tok).kind == MC_TOKEN_KIND_EOF) {
+            break;
+        }
+
+        McItem item = {0};
+        p->tok      = tok;
+        parse_item (doc, &item);
+        if (!VecPushBack (&fresh, &item)) {
+            LOG_ERROR ("failed to add item.");
+            item_deinit (&item);
+            VecForeachPtr (&fresh, it, { item_deinit (it); });
+            VecDeinit (&fresh);
+            return NULL;
+        }
+        tok = p->tok;
+    }
+
+    // replace damaged items with fresh ones, in place where possible
+    for (u64 idx = first; idx < last; idx++) {
+        item_deinit (VecIter (items, idx));
+    }
+    u64 nold  = last - first;
+    u64 nkept = nold < fresh.length ? nold : fresh.length;
+    if (nkept) {
+        memcpy (VecIter (items, first), fresh.data, nkept * sizeof (McItem));
+    }
+    if ((nold > nkept && !VecDeleteRange (items, first + nkept, nold - nkept)) ||
+        (fresh.length > nkept &&
+         !VecPushArr (items, fresh.data + nkept, fresh.length - nkept, first + nkept))) {
+        LOG_ERROR ("failed to update items.");
+        // items already copied in are owned by document now
+        for (u64 idx = nkept; idx < fresh.length; idx++) {
+            item_deinit (VecIter (&fresh, idx));
+        }
+        VecDeinit (&fresh);
+        return NULL;
+    }
+    doc->nreparsed = fresh.length;
+
+    // reused items moved along with their tokens
+    for (u64 idx = first + fresh.length; (shift || length != removed) && idx < items->length;
+         idx++) {
+        McItem* item     = VecIter (items, idx);
+        item->first_tok += shift;
+        item->end_tok   += shift;
+        item->peek_end  += shift;
+        item->error_tok += shift;
+        item->offset    += length - removed;
+    }
+
+    VecDeinit (&fresh);
+    return doc;
+}
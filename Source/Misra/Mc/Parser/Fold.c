@@ -0,0 +1,681 @@
+/// file      : misra/mc/parser/fold.c
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Constant folding and algebraic simplification of expression trees.
+
+#include <Misra/Mc/Parser/Fold.h>
+#include <Misra/Mc/Parser/Value.h>
+#include <Misra/Std/Log.h>
+
+// platform
+#include <math.h>
+#include <string.h>
+
+typedef enum FoldKind {
+    FOLD_KIND_INT = 1,
+    FOLD_KIND_FLOAT,
+} FoldKind;
+
+static inline bool is_num (const McExpr* e) {
+    return e && e->expr_type == MC_EXPR_TYPE_NUM;
+}
+
+
+// Value of a number where f64 is expected.
+static inline f64 num_f (const McExpr* e) {
+    return e->num.is_int ? e->num.i : e->num.f;
+}
+
+
+// Is number an integer in C? Folded ones that are negative aren't for evaluators.
+static inline bool is_c_int (const McExpr* e) {
+    McBasicTypeKind kind = e->num.type.type_kind;
+    return kind == MC_BASIC_TYPE_KIND_INTEGER ||
+           (kind == MC_BASIC_TYPE_KIND_INVALID && e->num.is_int);
+}
+
+
+// Value of a number where u64 is expected, same conversion as evaluators do.
+static inline u64 num_i (const McExpr* e) {
+    return is_c_int (e) ? e->num.i : (u64)e->num.f;
+}
+
+
+static inline bool num_truth (const McExpr* e) {
+    return e->num.is_int ? e->num.i != 0 : e->num.f != 0;
+}
+
+
+static inline bool is_pow2 (u64 i) {
+    return i && !(i & (i - 1));
+}
+
+
+// Is `f` a power of two with an exactly representable inverse, ie. a normal with no fraction?
+static inline bool is_pow2_f (f64 f) {
+    u64 bits = 0;
+    memcpy (&bits, &f, sizeof (bits));
+
+    u64 exp = (bits >> 52) & 0x7ff;
+    return exp && exp != 0x7ff && !(bits & ((1ULL << 52) - 1));
+}
+
+
+///
+/// Type of value of an expression, same as what `McBytecode` and
+/// `McRegCode` compile it to.
+///
+static FoldKind kind_of (const McExpr* e) {
+    if (!e) {
+        return FOLD_KIND_INT;
+    }
+
+    switch (e->expr_type) {
+        case MC_EXPR_TYPE_NUM :
+            return e->num.is_int ? FOLD_KIND_INT : FOLD_KIND_FLOAT;
+        case MC_EXPR_TYPE_ID :
+        case MC_EXPR_TYPE_ADD :
+        case MC_EXPR_TYPE_SUB :
+        case MC_EXPR_TYPE_MUL :
+        case MC_EXPR_TYPE_DIV :
+        case MC_EXPR_TYPE_UN_MINUS :
+        case MC_EXPR_TYPE_INC_PFX :
+        case MC_EXPR_TYPE_DEC_PFX :
+            return FOLD_KIND_FLOAT;
+        case MC_EXPR_TYPE_UN_PLUS :
+        case MC_EXPR_TYPE_IN_PARENS :
+        case MC_EXPR_TYPE_INC_SFX :
+        case MC_EXPR_TYPE_DEC_SFX :
+            return kind_of (e->un_plus.e);
+        case MC_EXPR_TYPE_CAST :
+            return kind_of (e->cast.e);
+        case MC_EXPR_TYPE_LIST :
+            return e->list.length ? kind_of (VecLast (&e->list)) : FOLD_KIND_INT;
+        case MC_EXPR_TYPE_TERN : {
+            FoldKind t = kind_of (e->tern.t);
+            return t == kind_of (e->tern.f) ? t : FOLD_KIND_FLOAT;
+        }
+        default :
+            return FOLD_KIND_INT;
+    }
+}
+
+
+// Is value of expression always 0 or 1?
+static bool is_bool (const McExpr* e) {
+    switch (e->expr_type) {
+        case MC_EXPR_TYPE_LE :
+        case MC_EXPR_TYPE_GE :
+        case MC_EXPR_TYPE_LT :
+        case MC_EXPR_TYPE_GT :
+        case MC_EXPR_TYPE_EQ :
+        case MC_EXPR_TYPE_NE :
+        case MC_EXPR_TYPE_LOG_AND :
+        case MC_EXPR_TYPE_LOG_OR :
+        case MC_EXPR_TYPE_LOG_NOT :
+        case MC_EXPR_TYPE_NOT :
+            return true;
+        case MC_EXPR_TYPE_NUM :
+            return e->num.is_int && e->num.i <= 1;
+        case MC_EXPR_TYPE_IN_PARENS :
+            return is_bool (e->in_parens.e);
+        default :
+            return false;
+    }
+}
+
+
+// Can expression be dropped without changing anything but it's value?
+static bool is_pure (const McExpr* e) {
+    if (!e) {
+        return true;
+    }
+
+    switch (e->expr_type) {
+        case MC_EXPR_TYPE_NUM :
+        case MC_EXPR_TYPE_ID :
+            return true;
+        case MC_EXPR_TYPE_ADD :
+        case MC_EXPR_TYPE_SUB :
+        case MC_EXPR_TYPE_MUL :
+        case MC_EXPR_TYPE_DIV :
+        case MC_EXPR_TYPE_AND :
+        case MC_EXPR_TYPE_OR :
+        case MC_EXPR_TYPE_XOR :
+        case MC_EXPR_TYPE_MOD :
+        case MC_EXPR_TYPE_SHR :
+        case MC_EXPR_TYPE_SHL :
+        case MC_EXPR_TYPE_LE :
+        case MC_EXPR_TYPE_GE :
+        case MC_EXPR_TYPE_LT :
+        case MC_EXPR_TYPE_GT :
+        case MC_EXPR_TYPE_EQ :
+        case MC_EXPR_TYPE_NE :
+        case MC_EXPR_TYPE_LOG_AND :
+        case MC_EXPR_TYPE_LOG_OR :
+            return is_pure (e->add.l) && is_pure (e->add.r);
+        case MC_EXPR_TYPE_LOG_NOT :
+        case MC_EXPR_TYPE_NOT :
+        case MC_EXPR_TYPE_UN_PLUS :
+        case MC_EXPR_TYPE_UN_MINUS :
+        case MC_EXPR_TYPE_IN_PARENS :
+            return is_pure (e->not.e);
+        case MC_EXPR_TYPE_CAST :
+            return is_pure (e->cast.e);
+        case MC_EXPR_TYPE_TERN :
+            return is_pure (e->tern.c) && is_pure (e->tern.t) && is_pure (e->tern.f);
+        case MC_EXPR_TYPE_LIST :
+            VecForeach (&e->list, xpr, {
+                if (!is_pure (xpr)) {
+                    return false;
+                }
+            });
+            return true;
+
+        // assignments, calls, increments and memory accesses
+        default :
+            return false;
+    }
+}
+
+
+// Replace `e` with a constant of type `u64`.
+static void set_int (McExpr* e, u64 i) {
+    u32 offset = e->offset;
+    McExprDeinit (e);
+    e->expr_type  = MC_EXPR_TYPE_NUM;
+    e->offset     = offset;
+    e->num.is_int = true;
+    e->num.i      = i;
+    e->num.type   = (McBasicType) {
+        .type_kind   = MC_BASIC_TYPE_KIND_INTEGER,
+        .is_unsigned = true,
+        .nbits       = 64,
+        .arr_size    = 1,
+    };
+}
+
+
+// Replace `e` with a constant of type `f64`.
+static void set_float (McExpr* e, f64 f) {
+    u32 offset = e->offset;
+    McExprDeinit (e);
+    e->expr_type  = MC_EXPR_TYPE_NUM;
+    e->offset     = offset;
+    e->num.is_int = false;
+    e->num.f      = f;
+    e->num.type   = (McBasicType) {
+        .type_kind = MC_BASIC_TYPE_KIND_FLOAT,
+        .nbits     = 64,
+        .arr_size  = 1,
+    };
+}
+
+
+// Replace `e` with 0 or 1, of type `i32` that C gives logical operators.
+static void set_bool (McExpr* e, bool b) {
+    set_int (e, b);
+    e->num.type.is_unsigned = false;
+    e->num.type.nbits       = 32;
+}
+
+
+///
+/// Replace `e` with it's value, typed as in C.
+///
+/// SUCCESS : true
+/// FAILURE : false, `e` unchanged, if C gives it no value.
+///
+static bool set_value (McExpr* e) {
+    McValue v = {0};
+    if (!McExprTryEvalValue (&v, e)) {
+        return false;
+    }
+
+    u32 offset = e->offset;
+    McExprDeinit (e);
+    e->expr_type = MC_EXPR_TYPE_NUM;
+    e->offset    = offset;
+    e->num.type  = v.type;
+    if (v.type.type_kind == MC_BASIC_TYPE_KIND_FLOAT) {
+        e->num.is_int = false;
+        e->num.f      = v.f;
+    } else {
+        e->num.is_int = v.type.is_unsigned || v.i >= 0;
+        e->num.i      = v.u;
+        e->num.f      = (f64)v.i;
+    }
+    return true;
+}
+
+
+///
+/// Are operands of `e` numbers, so that C may give it a value? Only left
+/// side of `&&` and `||`, and condition of `?:`, need to be, as C doesn't
+/// evaluate rest unless it must, and operand of `sizeof` is never evaluated.
+///
+static bool has_num_operands (const McExpr* e) {
+    switch (e->expr_type) {
+        case MC_EXPR_TYPE_ADD :
+        case MC_EXPR_TYPE_SUB :
+        case MC_EXPR_TYPE_MUL :
+        case MC_EXPR_TYPE_DIV :
+        case MC_EXPR_TYPE_AND :
+        case MC_EXPR_TYPE_OR :
+        case MC_EXPR_TYPE_XOR :
+        case MC_EXPR_TYPE_MOD :
+        case MC_EXPR_TYPE_SHR :
+        case MC_EXPR_TYPE_SHL :
+        case MC_EXPR_TYPE_LE :
+        case MC_EXPR_TYPE_GE :
+        case MC_EXPR_TYPE_LT :
+        case MC_EXPR_TYPE_GT :
+        case MC_EXPR_TYPE_EQ :
+        case MC_EXPR_TYPE_NE :
+            return is_num (e->add.l) && is_num (e->add.r);
+        case MC_EXPR_TYPE_LOG_AND :
+        case MC_EXPR_TYPE_LOG_OR :
+            return is_num (e->log_and.l);
+        case MC_EXPR_TYPE_LOG_NOT :
+        case MC_EXPR_TYPE_NOT :
+        case MC_EXPR_TYPE_UN_PLUS :
+        case MC_EXPR_TYPE_UN_MINUS :
+        case MC_EXPR_TYPE_IN_PARENS :
+            return is_num (e->not.e);
+        case MC_EXPR_TYPE_SIZE_OF :
+        case MC_EXPR_TYPE_ALIGN_OF :
+            return true;
+        case MC_EXPR_TYPE_CAST :
+            return is_num (e->cast.e);
+        case MC_EXPR_TYPE_TERN :
+            return is_num (e->tern.c);
+        case MC_EXPR_TYPE_LIST :
+            VecForeach (&e->list, xpr, {
+                if (!is_num (xpr)) {
+                    return false;
+                }
+            });
+            return true;
+        default :
+            return false;
+    }
+}
+
+
+// Replace `e` with it's child `c`, destroying everything else in `e`.
+static void replace (McExpr* e, McExpr* c) {
+    McExpr keep = *c;
+
+    // left empty, so that only node itself is freed with rest of e
+    memset (c, 0, sizeof (McExpr));
+    McExprDeinit (e);
+    *e = keep;
+}
+
+
+static void fold_arith (McExpr* e) {
+    McExpr* l = e->add.l;
+    McExpr* r = e->add.r;
+
+    // integer division by zero, left to give infinity at run time as it does unfolded
+    if (is_num (l) && is_num (r)) {
+        return;
+    }
+
+    switch (e->expr_type) {
+        case MC_EXPR_TYPE_ADD :
+            // only -0 leaves every x as it is, +0 turns -0 into +0
+            if (is_num (r) && !r->num.is_int && r->num.f == 0 && signbit (r->num.f) &&
+                kind_of (l) == FOLD_KIND_FLOAT) {
+                replace (e, l);
+            }
+            return;
+        case MC_EXPR_TYPE_SUB :
+            // x - -0 is x + 0 again
+            if (is_num (r) && num_f (r) == 0 && !signbit (num_f (r)) &&
+                kind_of (l) == FOLD_KIND_FLOAT) {
+                replace (e, l);
+            }
+            return;
+        case MC_EXPR_TYPE_MUL :
+            if (is_num (r) && num_f (r) == 1 && kind_of (l) == FOLD_KIND_FLOAT) {
+                replace (e, l);
+            } else if (is_num (l) && num_f (l) == 1 && kind_of (r) == FOLD_KIND_FLOAT) {
+                replace (e, r);
+            }
+            return;
+        default :
+            break;
+    }
+
+    if (!is_num (r)) {
+        return;
+    }
+
+    f64 b = num_f (r);
+    if (b == 1 && kind_of (l) == FOLD_KIND_FLOAT) {
+        replace (e, l);
+        return;
+    }
+
+    // dividing by a power of two and multiplying by it's inverse round exactly same
+    if (is_pow2_f (b)) {
+        e->expr_type = MC_EXPR_TYPE_MUL;
+        set_float (r, 1 / b);
+    }
+}
+
+
+static void fold_bitwise (McExpr* e) {
+    McExpr* l = e->and.l;
+    McExpr* r = e->and.r;
+
+    if (is_num (l) && is_num (r)) {
+        // integer division by zero, or shift count out of range, left for run time
+        if (is_c_int (l) && is_c_int (r)) {
+            return;
+        }
+
+        // float operands, which C doesn't allow, folded as in `McBytecode`
+        u64 a = num_i (l);
+        u64 b = num_i (r);
+        switch (e->expr_type) {
+            case MC_EXPR_TYPE_AND :
+                set_int (e, a & b);
+                return;
+            case MC_EXPR_TYPE_OR :
+                set_int (e, a | b);
+                return;
+            case MC_EXPR_TYPE_XOR :
+                set_int (e, a ^ b);
+                return;
+            case MC_EXPR_TYPE_MOD :
+                // left to trap at run time, as it does unfolded
+                if (b) {
+                    set_int (e, a % b);
+                }
+                return;
+
+            // count is taken modulo 64, same as x86-64 does at run time
+            case MC_EXPR_TYPE_SHR :
+                set_int (e, a >> (b & 63));
+                return;
+            default :
+                set_int (e, a << (b & 63));
+                return;
+        }
+    }
+
+    // constant moved to right for commutative operators, where chains below look for it
+    McExprType type = e->expr_type;
+    bool       commutes =
+        type == MC_EXPR_TYPE_AND || type == MC_EXPR_TYPE_OR || type == MC_EXPR_TYPE_XOR;
+    if (is_num (l) && commutes) {
+        e->and.l = r;
+        e->and.r = l;
+        l        = e->and.l;
+        r        = e->and.r;
+    }
+    if (!is_num (r)) {
+        return;
+    }
+
+    u64  k      = num_i (r);
+    bool l_int  = kind_of (l) == FOLD_KIND_INT;
+    bool l_pure = is_pure (l);
+    switch (type) {
+        case MC_EXPR_TYPE_AND :
+        case MC_EXPR_TYPE_OR :
+        case MC_EXPR_TYPE_XOR :
+            // identity, and absorbing element
+            if (k == (type == MC_EXPR_TYPE_AND ? (u64)-1 : 0)) {
+                if (l_int) {
+                    replace (e, l);
+                }
+                return;
+            }
+            if ((k == 0 && type == MC_EXPR_TYPE_AND) || (k == (u64)-1 && type == MC_EXPR_TYPE_OR)) {
+                if (l_pure) {
+                    set_int (e, k);
+                }
+                return;
+            }
+
+            // (x op a) op b is x op (a op b)
+            if (l->expr_type == type && is_num (l->and.r)) {
+                u64 a = num_i (l->and.r);
+                set_int (
+                    l->and.r,
+                    type == MC_EXPR_TYPE_AND ? a & k :
+                    type == MC_EXPR_TYPE_OR  ? a | k :
+                                               a ^ k
+                );
+                replace (e, l);
+                fold_bitwise (e);
+            }
+            return;
+
+        case MC_EXPR_TYPE_MOD :
+            if (k == 1 && l_pure) {
+                set_int (e, 0);
+            } else if (is_pow2 (k)) {
+                e->expr_type = MC_EXPR_TYPE_AND;
+                set_int (r, k - 1);
+            }
+            return;
+
+        default :
+            if (!(k & 63) && l_int) {
+                replace (e, l);
+            }
+            return;
+    }
+}
+
+
+static void fold_logical (McExpr* e) {
+    McExpr* l      = e->log_and.l;
+    McExpr* r      = e->log_and.r;
+    bool    is_and = e->expr_type == MC_EXPR_TYPE_LOG_AND;
+
+    // right side isn't evaluated when left decides
+    if (is_num (l)) {
+        if (num_truth (l) != is_and) {
+            set_bool (e, !is_and);
+        } else if (is_bool (r)) {
+            replace (e, r);
+        }
+        return;
+    }
+
+    if (is_num (r)) {
+        if (num_truth (r) != is_and) {
+            if (is_pure (l)) {
+                set_bool (e, !is_and);
+            }
+        } else if (is_bool (l)) {
+            replace (e, l);
+        }
+    }
+}
+
+
+static void fold_unary (McExpr* e) {
+    McExpr* x = e->not.e;
+
+    switch (e->expr_type) {
+        case MC_EXPR_TYPE_UN_PLUS :
+            // promotes operands narrower than `i32`, which only casts give
+            if (x->expr_type != MC_EXPR_TYPE_CAST && x->expr_type != MC_EXPR_TYPE_LIST) {
+                replace (e, x);
+            }
+            return;
+        case MC_EXPR_TYPE_IN_PARENS :
+            replace (e, x);
+            return;
+        case MC_EXPR_TYPE_UN_MINUS :
+            if (x->expr_type == MC_EXPR_TYPE_UN_MINUS &&
+                kind_of (x->un_minus.e) == FOLD_KIND_FLOAT) {
+                replace (e, x->un_minus.e);
+            }
+            return;
+        case MC_EXPR_TYPE_LOG_NOT :
+        case MC_EXPR_TYPE_NOT :
+            if (is_num (x)) {
+                // "~" of a float, which C doesn't allow, folded as in `McBytecode`
+                set_int (e, !num_i (x));
+            } else if ((x->expr_type == MC_EXPR_TYPE_LOG_NOT || x->expr_type == MC_EXPR_TYPE_NOT) &&
+                       is_bool (x->not.e)) {
+                replace (e, x->not.e);
+            }
+            return;
+        case MC_EXPR_TYPE_INC_PFX :
+        case MC_EXPR_TYPE_DEC_PFX :
+            if (is_num (x)) {
+                set_float (e, num_f (x) + (e->expr_type == MC_EXPR_TYPE_INC_PFX ? 1 : -1));
+            }
+            return;
+        default :
+            return;
+    }
+}
+
+
+static void fold_tern (McExpr* e) {
+    if (!is_num (e->tern.c)) {
+        return;
+    }
+
+    McExpr* taken = num_truth (e->tern.c) ? e->tern.t : e->tern.f;
+    if (kind_of (e->tern.t) == kind_of (e->tern.f)) {
+        replace (e, taken);
+    } else if (is_num (taken)) {
+        // sides of different types give f64
+        set_float (e, num_f (taken));
+    }
+}
+
+
+static void fold (McExpr* e) {
+    if (!e) {
+        return;
+    }
+
+    // operands first, so that constants bubble up, but not of sizeof, which only types them
+    switch (e->expr_type) {
+        case MC_EXPR_TYPE_ADD :
+        case MC_EXPR_TYPE_SUB :
+        case MC_EXPR_TYPE_MUL :
+        case MC_EXPR_TYPE_DIV :
+        case MC_EXPR_TYPE_AND :
+        case MC_EXPR_TYPE_OR :
+        case MC_EXPR_TYPE_XOR :
+        case MC_EXPR_TYPE_MOD :
+        case MC_EXPR_TYPE_SHR :
+        case MC_EXPR_TYPE_SHL :
+        case MC_EXPR_TYPE_LE :
+        case MC_EXPR_TYPE_GE :
+        case MC_EXPR_TYPE_LT :
+        case MC_EXPR_TYPE_GT :
+        case MC_EXPR_TYPE_EQ :
+        case MC_EXPR_TYPE_NE :
+        case MC_EXPR_TYPE_LOG_AND :
+        case MC_EXPR_TYPE_LOG_OR :
+        case MC_EXPR_TYPE_ASSIGN :
+        case MC_EXPR_TYPE_ADD_ASSIGN :
+        case MC_EXPR_TYPE_SUB_ASSIGN :
+        case MC_EXPR_TYPE_MUL_ASSIGN :
+        case MC_EXPR_TYPE_DIV_ASSIGN :
+        case MC_EXPR_TYPE_MOD_ASSIGN :
+        case MC_EXPR_TYPE_AND_ASSIGN :
+        case MC_EXPR_TYPE_OR_ASSIGN :
+        case MC_EXPR_TYPE_XOR_ASSIGN :
+        case MC_EXPR_TYPE_SHR_ASSIGN :
+        case MC_EXPR_TYPE_SHL_ASSIGN :
+        case MC_EXPR_TYPE_CALL :
+        case MC_EXPR_TYPE_ARR_SUBSCRIPT :
+        case MC_EXPR_TYPE_ACCESS :
+        case MC_EXPR_TYPE_PTR_ACCESS :
+            fold (e->add.l);
+            fold (e->add.r);
+            break;
+        case MC_EXPR_TYPE_LOG_NOT :
+        case MC_EXPR_TYPE_NOT :
+        case MC_EXPR_TYPE_UN_PLUS :
+        case MC_EXPR_TYPE_UN_MINUS :
+        case MC_EXPR_TYPE_IN_PARENS :
+        case MC_EXPR_TYPE_ADDR :
+        case MC_EXPR_TYPE_DEREF :
+        case MC_EXPR_TYPE_INC_PFX :
+        case MC_EXPR_TYPE_INC_SFX :
+        case MC_EXPR_TYPE_DEC_PFX :
+        case MC_EXPR_TYPE_DEC_SFX :
+            fold (e->not.e);
+            break;
+        case MC_EXPR_TYPE_CAST :
+            fold (e->cast.e);
+            break;
+        case MC_EXPR_TYPE_TERN :
+            fold (e->tern.c);
+            fold (e->tern.t);
+            fold (e->tern.f);
+            break;
+        case MC_EXPR_TYPE_LIST :
+            VecForeach (&e->list, xpr, { fold (xpr); });
+            break;
+        default :
+            break;
+    }
+
+    // constants are folded with C types, wherever C gives them a value
+    if (has_num_operands (e) && set_value (e)) {
+        return;
+    }
+
+    switch (e->expr_type) {
+        case MC_EXPR_TYPE_ADD :
+        case MC_EXPR_TYPE_SUB :
+        case MC_EXPR_TYPE_MUL :
+        case MC_EXPR_TYPE_DIV :
+            fold_arith (e);
+            return;
+        case MC_EXPR_TYPE_AND :
+        case MC_EXPR_TYPE_OR :
+        case MC_EXPR_TYPE_XOR :
+        case MC_EXPR_TYPE_MOD :
+        case MC_EXPR_TYPE_SHR :
+        case MC_EXPR_TYPE_SHL :
+            fold_bitwise (e);
+            return;
+        case MC_EXPR_TYPE_LOG_AND :
+        case MC_EXPR_TYPE_LOG_OR :
+            fold_logical (e);
+            return;
+        case MC_EXPR_TYPE_UN_PLUS :
+        case MC_EXPR_TYPE_UN_MINUS :
+        case MC_EXPR_TYPE_IN_PARENS :
+        case MC_EXPR_TYPE_LOG_NOT :
+        case MC_EXPR_TYPE_NOT :
+        case MC_EXPR_TYPE_INC_PFX :
+        case MC_EXPR_TYPE_DEC_PFX :
+            fold_unary (e);
+            return;
+        case MC_EXPR_TYPE_TERN :
+            fold_tern (e);
+            return;
+        default :
+            return;
+    }
+}
+
+
+McExpr* McExprFold (McExpr* expr) {
+    if (!expr) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    fold (expr);
+    return expr;
+}
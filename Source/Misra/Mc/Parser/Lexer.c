@@ -0,0 +1,717 @@
+/// file      : misra/mc/lexer.c
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Table driven lexer for Modern C.
+
+#include <Misra/Mc/Parser/KeywordHash.h>
+#include <Misra/Mc/Parser/Lexer.h>
+#include <Misra/Std/Log.h>
+
+// generated at build time from Keywords.in
+#include <Misra/Mc/Parser/KeywordTable.h>
+
+// platform
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#    include <immintrin.h>
+#    define LEXER_HAVE_SIMD 1
+#else
+#    define LEXER_HAVE_SIMD 0
+#endif
+
+// every byte of code belongs to exactly one of these classes
+typedef enum CharClass {
+    CHAR_CLASS_INVALID = 0,
+    CHAR_CLASS_WS,
+    CHAR_CLASS_ALPHA,
+    CHAR_CLASS_DIGIT,
+    CHAR_CLASS_PUNCT,
+} CharClass;
+
+static const u8 char_class[256] = {
+    [' ']  = CHAR_CLASS_WS,
+    ['\t'] = CHAR_CLASS_WS,
+    ['\r'] = CHAR_CLASS_WS,
+    ['\n'] = CHAR_CLASS_WS,
+    ['\b'] = CHAR_CLASS_WS,
+    ['\f'] = CHAR_CLASS_WS,
+
+    ['a' ... 'z'] = CHAR_CLASS_ALPHA,
+    ['A' ... 'Z'] = CHAR_CLASS_ALPHA,
+    ['_']         = CHAR_CLASS_ALPHA,
+    ['0' ... '9'] = CHAR_CLASS_DIGIT,
+
+    ['+'] = CHAR_CLASS_PUNCT,
+    ['-'] = CHAR_CLASS_PUNCT,
+    ['*'] = CHAR_CLASS_PUNCT,
+    ['/'] = CHAR_CLASS_PUNCT,
+    ['%'] = CHAR_CLASS_PUNCT,
+    ['&'] = CHAR_CLASS_PUNCT,
+    ['|'] = CHAR_CLASS_PUNCT,
+    ['^'] = CHAR_CLASS_PUNCT,
+    ['~'] = CHAR_CLASS_PUNCT,
+    ['!'] = CHAR_CLASS_PUNCT,
+    ['='] = CHAR_CLASS_PUNCT,
+    ['<'] = CHAR_CLASS_PUNCT,
+    ['>'] = CHAR_CLASS_PUNCT,
+    ['?'] = CHAR_CLASS_PUNCT,
+    [':'] = CHAR_CLASS_PUNCT,
+    [','] = CHAR_CLASS_PUNCT,
+    ['.'] = CHAR_CLASS_PUNCT,
+    [';'] = CHAR_CLASS_PUNCT,
+    ['('] = CHAR_CLASS_PUNCT,
+    [')'] = CHAR_CLASS_PUNCT,
+    ['['] = CHAR_CLASS_PUNCT,
+    [']'] = CHAR_CLASS_PUNCT,
+    ['{'] = CHAR_CLASS_PUNCT,
+    ['}'] = CHAR_CLASS_PUNCT,
+};
+
+// Token kinds of punctuators starting with a character. Every punctuator
+// is one of `c`, `c=`, `cc` or `cc=`, except "->", which is handled separately.
+typedef struct PunctKinds {
+    u8 single;
+    u8 with_eq;
+    u8 doubled;
+    u8 doubled_eq;
+} PunctKinds;
+
+static const PunctKinds punct_kinds[256] = {
+    ['+'] = {MC_TOKEN_KIND_PLUS, MC_TOKEN_KIND_PLUS_ASSIGN, MC_TOKEN_KIND_PLUS_PLUS, 0},
+    ['-'] = {MC_TOKEN_KIND_MINUS, MC_TOKEN_KIND_MINUS_ASSIGN, MC_TOKEN_KIND_MINUS_MINUS, 0},
+    ['*'] = {MC_TOKEN_KIND_STAR, MC_TOKEN_KIND_STAR_ASSIGN, 0, 0},
+    ['/'] = {MC_TOKEN_KIND_SLASH, MC_TOKEN_KIND_SLASH_ASSIGN, 0, 0},
+    ['%'] = {MC_TOKEN_KIND_PERCENT, MC_TOKEN_KIND_PERCENT_ASSIGN, 0, 0},
+    ['&'] = {MC_TOKEN_KIND_AMP, MC_TOKEN_KIND_AMP_ASSIGN, MC_TOKEN_KIND_AMP_AMP, 0},
+    ['|'] = {MC_TOKEN_KIND_PIPE, MC_TOKEN_KIND_PIPE_ASSIGN, MC_TOKEN_KIND_PIPE_PIPE, 0},
+    ['^'] = {MC_TOKEN_KIND_CARET, MC_TOKEN_KIND_CARET_ASSIGN, 0, 0},
+    ['~'] = {MC_TOKEN_KIND_TILDE, 0, 0, 0},
+    ['!'] = {MC_TOKEN_KIND_BANG, MC_TOKEN_KIND_NE, 0, 0},
+    ['='] = {MC_TOKEN_KIND_ASSIGN, MC_TOKEN_KIND_EQ, 0, 0},
+    ['<'] = {MC_TOKEN_KIND_LT, MC_TOKEN_KIND_LE, MC_TOKEN_KIND_SHL, MC_TOKEN_KIND_SHL_ASSIGN},
+    ['>'] = {MC_TOKEN_KIND_GT, MC_TOKEN_KIND_GE, MC_TOKEN_KIND_SHR, MC_TOKEN_KIND_SHR_ASSIGN},
+    ['?'] = {MC_TOKEN_KIND_QUESTION, 0, 0, 0},
+    [':'] = {MC_TOKEN_KIND_COLON, 0, 0, 0},
+    [','] = {MC_TOKEN_KIND_COMMA, 0, 0, 0},
+    ['.'] = {MC_TOKEN_KIND_DOT, 0, 0, 0},
+    [';'] = {MC_TOKEN_KIND_SEMICOLON, 0, 0, 0},
+    ['('] = {MC_TOKEN_KIND_LPAREN, 0, 0, 0},
+    [')'] = {MC_TOKEN_KIND_RPAREN, 0, 0, 0},
+    ['['] = {MC_TOKEN_KIND_LBRACKET, 0, 0, 0},
+    [']'] = {MC_TOKEN_KIND_RBRACKET, 0, 0, 0},
+    ['{'] = {MC_TOKEN_KIND_LBRACE, 0, 0, 0},
+    ['}'] = {MC_TOKEN_KIND_RBRACE, 0, 0, 0},
+};
+
+#define IS_CLASS(c, cls) (char_class[(u8)(c)] == (cls))
+#define IS_ID_CHAR(c)    (IS_CLASS (c, CHAR_CLASS_ALPHA) || IS_CLASS (c, CHAR_CLASS_DIGIT))
+#define IS_HEX_DIGIT(c)                                                                            \
+    (IS_CLASS (c, CHAR_CLASS_DIGIT) || ('a' <= (c) && (c) <= 'f') || ('A' <= (c) && (c) <= 'F'))
+
+// minimum number of slots in interner hash table
+#define INTERNER_MIN_SLOTS 64
+
+// Runs of whitespace, identifier characters and digits are skipped many bytes at
+// a time. A byte belongs to a run class if `run_lo[c & 0xf] & run_hi[c >> 4]`
+// has class bit set. Same nibble lookup is done for 16 or 32 bytes at once with
+// pshufb on x86, and one byte at a time everywhere else.
+#define RUN_WS_CTRL    (1 << 0) // \b \t \n \f \r
+#define RUN_WS_SPACE   (1 << 1) // ' '
+#define RUN_DIGIT      (1 << 2) // 0-9
+#define RUN_ALPHA_1    (1 << 3) // A-O a-o
+#define RUN_ALPHA_2    (1 << 4) // P-Z p-z
+#define RUN_UNDERSCORE (1 << 5) // _
+
+#define RUN_WS (RUN_WS_CTRL | RUN_WS_SPACE)
+#define RUN_ID (RUN_DIGIT | RUN_ALPHA_1 | RUN_ALPHA_2 | RUN_UNDERSCORE)
+
+static const u8 run_lo[16] __attribute__ ((aligned (16))) = {
+    [0x0] = RUN_WS_SPACE | RUN_DIGIT | RUN_ALPHA_2,
+    [0x1] = RUN_DIGIT | RUN_ALPHA_1 | RUN_ALPHA_2,
+    [0x2] = RUN_DIGIT | RUN_ALPHA_1 | RUN_ALPHA_2,
+    [0x3] = RUN_DIGIT | RUN_ALPHA_1 | RUN_ALPHA_2,
+    [0x4] = RUN_DIGIT | RUN_ALPHA_1 | RUN_ALPHA_2,
+    [0x5] = RUN_DIGIT | RUN_ALPHA_1 | RUN_ALPHA_2,
+    [0x6] = RUN_DIGIT | RUN_ALPHA_1 | RUN_ALPHA_2,
+    [0x7] = RUN_DIGIT | RUN_ALPHA_1 | RUN_ALPHA_2,
+    [0x8] = RUN_WS_CTRL | RUN_DIGIT | RUN_ALPHA_1 | RUN_ALPHA_2,
+    [0x9] = RUN_WS_CTRL | RUN_DIGIT | RUN_ALPHA_1 | RUN_ALPHA_2,
+    [0xa] = RUN_WS_CTRL | RUN_ALPHA_1 | RUN_ALPHA_2,
+    [0xb] = RUN_ALPHA_1,
+    [0xc] = RUN_WS_CTRL | RUN_ALPHA_1,
+    [0xd] = RUN_WS_CTRL | RUN_ALPHA_1,
+    [0xe] = RUN_ALPHA_1,
+    [0xf] = RUN_ALPHA_1 | RUN_UNDERSCORE,
+};
+
+static const u8 run_hi[16] __attribute__ ((aligned (16))) = {
+    [0x0] = RUN_WS_CTRL,
+    [0x2] = RUN_WS_SPACE,
+    [0x3] = RUN_DIGIT,
+    [0x4] = RUN_ALPHA_1,
+    [0x5] = RUN_ALPHA_2 | RUN_UNDERSCORE,
+    [0x6] = RUN_ALPHA_1,
+    [0x7] = RUN_ALPHA_2,
+};
+
+#define IN_RUN(c, run) (run_lo[(u8)(c) & 0xf] & run_hi[(u8)(c) >> 4] & (run))
+
+static u64 skip_run_scalar (const char* code, u64 pos, u64 length, u8 run) {
+    while (pos < length && IN_RUN (code[pos], run)) {
+        pos++;
+    }
+    return pos;
+}
+
+#if LEXER_HAVE_SIMD
+
+__attribute__ ((target ("ssse3"))) static u64
+    skip_run_ssse3 (const char* code, u64 pos, u64 length, u8 run) {
+    const __m128i lo_table = _mm_load_si128 ((const __m128i*)run_lo);
+    const __m128i hi_table = _mm_load_si128 ((const __m128i*)run_hi);
+    const __m128i nibble   = _mm_set1_epi8 (0x0f);
+    const __m128i mask     = _mm_set1_epi8 (run);
+
+    for (; pos + 16 <= length; pos += 16) {
+        __m128i v  = _mm_loadu_si128 ((const __m128i*)(code + pos));
+        __m128i lo = _mm_shuffle_epi8 (lo_table, _mm_and_si128 (v, nibble));
+        __m128i hi = _mm_shuffle_epi8 (hi_table, _mm_and_si128 (_mm_srli_epi16 (v, 4), nibble));
+        __m128i in = _mm_and_si128 (_mm_and_si128 (lo, hi), mask);
+
+        // one bit for every byte that's not in run
+        u32 out = _mm_movemask_epi8 (_mm_cmpeq_epi8 (in, _mm_setzero_si128()));
+        if (out) {
+            return pos + __builtin_ctz (out);
+        }
+    }
+
+    return skip_run_scalar (code, pos, length, run);
+}
+
+
+__attribute__ ((target ("avx2"))) static u64
+    skip_run_avx2 (const char* code, u64 pos, u64 length, u8 run) {
+    const __m256i lo_table = _mm256_broadcastsi128_si256 (_mm_load_si128 ((const __m128i*)run_lo));
+    const __m256i hi_table = _mm256_broadcastsi128_si256 (_mm_load_si128 ((const __m128i*)run_hi));
+    const __m256i nibble   = _mm256_set1_epi8 (0x0f);
+    const __m256i mask     = _mm256_set1_epi8 (run);
+
+    for (; pos + 32 <= length; pos += 32) {
+        __m256i v  = _mm256_loadu_si256 ((const __m256i*)(code + pos));
+        __m256i lo = _mm256_shuffle_epi8 (lo_table, _mm256_and_si256 (v, nibble));
+        __m256i hi =
+            _mm256_shuffle_epi8 (hi_table, _mm256_and_si256 (_mm256_srli_epi16 (v, 4), nibble));
+        __m256i in = _mm256_and_si256 (_mm256_and_si256 (lo, hi), mask);
+
+        // one bit for every byte that's not in run
+        u32 out = _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (in, _mm256_setzero_si256()));
+        if (out) {
+            return pos + __builtin_ctz (out);
+        }
+    }
+
+    return skip_run_ssse3 (code, pos, length, run);
+}
+
+#endif
+
+// best implementation for this CPU, picked once on first lexer init
+static u64 (*skip_run_impl) (const char* code, u64 pos, u64 length, u8 run) = skip_run_scalar;
+static pthread_once_t skip_run_once = PTHREAD_ONCE_INIT;
+
+static void skip_run_select (void) {
+#if LEXER_HAVE_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports ("avx2")) {
+        skip_run_impl = skip_run_avx2;
+    } else if (__builtin_cpu_supports ("ssse3")) {
+        skip_run_impl = skip_run_ssse3;
+    }
+#endif
+}
+
+///
+/// Get position of first byte at or after `pos` that's not in given run class.
+/// Most runs are a single byte (one space between tokens, short names), so
+/// first byte is checked before going wide.
+///
+static inline u64 skip_run (const char* code, u64 pos, u64 length, u8 run) {
+    if (pos >= length || !IN_RUN (code[pos], run)) {
+        return pos;
+    }
+    if (pos + 1 >= length || !IN_RUN (code[pos + 1], run)) {
+        return pos + 1;
+    }
+    return skip_run_impl (code, pos + 2, length, run);
+}
+
+McLexer* McLexerInit (McLexer* lx) {
+    if (!lx) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    pthread_once (&skip_run_once, skip_run_select);
+
+    memset (lx, 0, sizeof (McLexer));
+    VecInit (&lx->tokens, NULL, NULL);
+    StrInit (&lx->interner.names);
+    VecInit (&lx->interner.offsets, NULL, NULL);
+    VecInit (&lx->interner.slots, NULL, NULL);
+
+    return lx;
+}
+
+
+McLexer* McLexerDeinit (McLexer* lx) {
+    if (!lx) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    VecDeinit (&lx->tokens);
+    StrDeinit (&lx->interner.names);
+    VecDeinit (&lx->interner.offsets);
+    VecDeinit (&lx->interner.slots);
+    memset (lx, 0, sizeof (McLexer));
+
+    return lx;
+}
+
+
+// FNV-1a
+static inline u32 hash_name (const char* name, u32 length) {
+    u32 h = 2166136261u;
+    for (u32 i = 0; i < length; i++) {
+        h = (h ^ (u8)name[i]) * 16777619u;
+    }
+    return h;
+}
+
+
+static inline u32 interned_length (McInterner* in, u32 idx) {
+    u32 end = idx + 1 < in->offsets.length ? VecAt (&in->offsets, idx + 1) : in->names.length;
+    return end - VecAt (&in->offsets, idx) - 1;
+}
+
+
+static bool interner_grow (McInterner* in) {
+    u64 nslots = in->slots.length ? in->slots.length * 2 : INTERNER_MIN_SLOTS;
+    if (!VecResize (&in->slots, nslots)) {
+        LOG_ERROR ("failed to grow interner.");
+        return false;
+    }
+    memset (in->slots.data, 0, nslots * sizeof (u32));
+
+    u32 mask = nslots - 1;
+    for (u32 idx = 0; idx < in->offsets.length; idx++) {
+        u32 h = hash_name (in->names.data + VecAt (&in->offsets, idx), interned_length (in, idx));
+        while (VecAt (&in->slots, h & mask)) {
+            h++;
+        }
+        VecAt (&in->slots, h & mask) = idx + 1;
+    }
+
+    return true;
+}
+
+
+static u32 interner_add (McInterner* in, const char* name, u32 length) {
+    // keep load factor below half
+    if ((in->offsets.length + 1) * 2 > in->slots.length && !interner_grow (in)) {
+        return (u32)-1;
+    }
+
+    u32 mask = in->slots.length - 1;
+    u32 h    = hash_name (name, length);
+    while (VecAt (&in->slots, h & mask)) {
+        u32 idx = VecAt (&in->slots, h & mask) - 1;
+        if (interned_length (in, idx) == length &&
+            !memcmp (in->names.data + VecAt (&in->offsets, idx), name, length)) {
+            return idx;
+        }
+        h++;
+    }
+
+    u32 idx    = in->offsets.length;
+    u32 offset = in->names.length;
+    if (!StrPushBackCStr (&in->names, name, length) || !StrPushBack (&in->names, 0) ||
+        !VecPushBack (&in->offsets, &offset)) {
+        LOG_ERROR ("failed to intern name.");
+        return (u32)-1;
+    }
+    VecAt (&in->slots, h & mask) = idx + 1;
+
+    return idx;
+}
+
+
+u32 McLexerIntern (McLexer* lx, const char* name, u32 length) {
+    if (!lx || !name) {
+        LOG_ERROR ("invalid arguments.");
+        return (u32)-1;
+    }
+
+    return interner_add (&lx->interner, name, length);
+}
+
+
+const char* McLexerName (McLexer* lx, u32 value) {
+    if (!lx || value >= lx->interner.offsets.length) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    return lx->interner.names.data + VecAt (&lx->interner.offsets, value);
+}
+
+
+// Get token kind of a keyword, or MC_TOKEN_KIND_ID if name is not a keyword.
+static inline McTokenKind keyword_kind (const char* name, u32 length) {
+    if (length < MC_KEYWORD_MIN_LENGTH || length > MC_KEYWORD_MAX_LENGTH) {
+        return MC_TOKEN_KIND_ID;
+    }
+
+    u32 slot = McKeywordHash (name, length, MC_KEYWORD_HASH_SEED, MC_KEYWORD_HASH_BITS);
+    const McKeywordSlot* kw = &mc_keyword_slots[slot];
+    if (kw->length == length && !memcmp (kw->name, name, length)) {
+        return kw->kind;
+    }
+
+    return MC_TOKEN_KIND_ID;
+}
+
+
+// Get end of a number starting at `pos`, and it's token kind.
+static inline u64 lex_number (const char* code, u64 pos, u64 length, McTokenKind* kind) {
+    u64 end = pos;
+
+    if (code[end] == '0' && end + 1 < length && code[end + 1] == 'x') {
+        end += 2;
+        while (end < length && IS_HEX_DIGIT (code[end])) {
+            end++;
+        }
+        *kind = end - pos > 2 ? MC_TOKEN_KIND_HEX : MC_TOKEN_KIND_INVALID;
+    } else {
+        *kind = MC_TOKEN_KIND_INT;
+        end   = skip_run (code, end, length, RUN_DIGIT);
+
+        if (end < length && code[end] == '.') {
+            *kind = MC_TOKEN_KIND_FLT;
+            end   = skip_run (code, end + 1, length, RUN_DIGIT);
+        }
+
+        if (end < length && code[end] == 'f') {
+            *kind = MC_TOKEN_KIND_FLT;
+            end++;
+        }
+    }
+
+    // number glued to an identifier is neither a number nor an identifier
+    if (end < length && IS_ID_CHAR (code[end])) {
+        *kind = MC_TOKEN_KIND_INVALID;
+        end   = skip_run (code, end, length, RUN_ID);
+    }
+
+    return end;
+}
+
+
+// Get end of a punctuator starting at `pos`, and it's token kind.
+static inline u64 lex_punct (const char* code, u64 pos, u64 length, McTokenKind* kind) {
+    u8                c     = code[pos];
+    const PunctKinds* kinds = &punct_kinds[c];
+    char              next  = pos + 1 < length ? code[pos + 1] : 0;
+
+    if (c == '-' && next == '>') {
+        *kind = MC_TOKEN_KIND_ARROW;
+        return pos + 2;
+    }
+
+    if (kinds->doubled && next == c) {
+        char after = pos + 2 < length ? code[pos + 2] : 0;
+        if (kinds->doubled_eq && after == '=') {
+            *kind = kinds->doubled_eq;
+            return pos + 3;
+        }
+        *kind = kinds->doubled;
+        return pos + 2;
+    }
+
+    if (kinds->with_eq && next == '=') {
+        *kind = kinds->with_eq;
+        return pos + 2;
+    }
+
+    *kind = kinds->single;
+    return pos + 1;
+}
+
+
+///
+/// Lex a single token starting at `pos`, which must not be whitespace.
+///
+/// lx[in,out] : Lexer to intern names into.
+/// code[in]   : Code to lex.
+/// pos[in]    : Offset of first byte of token.
+/// length[in] : Number of bytes available in `code`.
+/// eof[in]    : Whether `length` is end of code.
+/// tok[out]   : Lexed token. Length is 0 if token might continue in code
+///              that's not available yet.
+///
+/// SUCCESS : true
+/// FAILURE : false
+///
+static inline bool
+    lex_token (McLexer* lx, const char* code, u64 pos, u64 length, bool eof, McToken* tok) {
+    McTokenKind kind = MC_TOKEN_KIND_INVALID;
+    u64         end  = pos + 1;
+    u32         val  = 0;
+
+    switch (char_class[(u8)code[pos]]) {
+        case CHAR_CLASS_ALPHA : {
+            end  = skip_run (code, pos, length, RUN_ID);
+            kind = MC_TOKEN_KIND_ID;
+            break;
+        }
+        case CHAR_CLASS_DIGIT : {
+            end = lex_number (code, pos, length, &kind);
+            break;
+        }
+        case CHAR_CLASS_PUNCT : {
+            end = lex_punct (code, pos, length, &kind);
+            break;
+        }
+        default : {
+            break;
+        }
+    }
+
+    if (end >= length && !eof) {
+        *tok = (McToken) {.kind = MC_TOKEN_KIND_INVALID, .offset = pos};
+        return true;
+    }
+
+    if (kind == MC_TOKEN_KIND_ID) {
+        kind = keyword_kind (code + pos, end - pos);
+    }
+
+    if (kind == MC_TOKEN_KIND_ID) {
+        val = McLexerIntern (lx, code + pos, end - pos);
+        if (val == (u32)-1) {
+            return false;
+        }
+    }
+
+    *tok = (McToken) {.kind = kind, .offset = pos, .length = end - pos, .value = val};
+    return true;
+}
+
+
+McLexer* McLexerRun (McLexer* lx, const char* code, u64 length, bool eof) {
+    if (!lx || (!code && length)) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    if (length > (u32)-1) {
+        LOG_ERROR ("code too large to lex, offsets must fit in 32 bits.");
+        return NULL;
+    }
+
+    // nothing after end of file
+    if (lx->tokens.length && VecLast (&lx->tokens).kind == MC_TOKEN_KIND_EOF) {
+        return lx;
+    }
+
+    u64 pos = lx->pos;
+    while (true) {
+        pos = skip_run (code, pos, length, RUN_WS);
+        if (pos >= length) {
+            break;
+        }
+
+        McToken tok = {0};
+        if (!lex_token (lx, code, pos, length, eof, &tok)) {
+            return NULL;
+        }
+
+        // token might continue in code that's not available yet
+        if (!tok.length) {
+            break;
+        }
+
+        if (!VecPushBack (&lx->tokens, &tok)) {
+            LOG_ERROR ("failed to add token.");
+            return NULL;
+        }
+
+        pos += tok.length;
+    }
+
+    lx->pos = pos;
+
+    if (eof) {
+        McToken tok = {.kind = MC_TOKEN_KIND_EOF, .offset = length};
+        if (!VecPushBack (&lx->tokens, &tok)) {
+            LOG_ERROR ("failed to add token.");
+            return NULL;
+        }
+    }
+
+    return lx;
+}
+
+
+McLexer* McLexerEdit (
+    McLexer*       lx,
+    const char*    code,
+    u64            length,
+    u64            offset,
+    u64            removed,
+    u64            inserted,
+    McTokenSplice* splice
+) {
+    if (!lx || (!code && length) || !splice) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    McTokenVec* tokens = &lx->tokens;
+    if (!tokens->length || VecLast (tokens).kind != MC_TOKEN_KIND_EOF) {
+        LOG_ERROR ("code must be completely lexed before it's edited.");
+        return NULL;
+    }
+
+    u64 old_length = VecLast (tokens).offset;
+    if (length > (u32)-1 || offset + removed > old_length ||
+        length + removed != old_length + inserted) {
+        LOG_ERROR ("edit does not match code.");
+        return NULL;
+    }
+
+    // first token ending at or after edit, it may continue into inserted bytes
+    u64 lo = 0;
+    u64 hi = tokens->length - 1;
+    while (lo < hi) {
+        u64            mid = lo + (hi - lo) / 2;
+        const McToken* tok = VecIter (tokens, mid);
+        if (tok->offset + tok->length < offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    u64 first = lo;
+    u64 pos   = first ? VecAt (tokens, first - 1).offset + VecAt (tokens, first - 1).length : 0;
+
+    // lex until a token starts after edit, exactly where an old token started,
+    // everything from there on is same as before
+    McTokenVec fresh = {0};
+    VecInit (&fresh, NULL, NULL);
+
+    u64 last = first;
+    while (true) {
+        pos = skip_run (code, pos, length, RUN_WS);
+
+        if (pos >= offset + inserted) {
+            u64 old_pos = pos + removed - inserted;
+            while (VecAt (tokens, last).offset < old_pos) {
+                last++;
+            }
+            if (VecAt (tokens, last).offset == old_pos) {
+                break;
+            }
+        }
+
+        McToken tok = {0};
+        if (!lex_token (lx, code, pos, length, true, &tok) || !VecPushBack (&fresh, &tok)) {
+            LOG_ERROR ("failed to lex edited code.");
+            VecDeinit (&fresh);
+            return NULL;
+        }
+        pos += tok.length;
+    }
+
+    // move old tokens after edit
+    if (inserted != removed) {
+        for (u64 idx = last; idx < tokens->length; idx++) {
+            VecAt (tokens, idx).offset += inserted - removed;
+        }
+    }
+
+    // splice fresh tokens in, overwriting old ones in place where possible so
+    // that tokens after edit are moved in memory only if their count changes
+    u64 nold  = last - first;
+    u64 nkept = nold < fresh.length ? nold : fresh.length;
+    if (nkept) {
+        memcpy (VecIter (tokens, first), fresh.data, nkept * sizeof (McToken));
+    }
+    if ((nold > nkept && !VecDeleteRange (tokens, first + nkept, nold - nkept)) ||
+        (fresh.length > nkept &&
+         !VecPushArr (tokens, fresh.data + nkept, fresh.length - nkept, first + nkept))) {
+        LOG_ERROR ("failed to update tokens.");
+        VecDeinit (&fresh);
+        return NULL;
+    }
+
+    splice->first     = first;
+    splice->nremoved  = last - first;
+    splice->ninserted = fresh.length;
+    lx->pos           = lx->pos + inserted - removed;
+
+    VecDeinit (&fresh);
+    return lx;
+}
+
+
+McLexer* McLexerDrop (McLexer* lx, u64 ntokens, u64 nbytes) {
+    if (!lx || ntokens > lx->tokens.length) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    u64 first = ntokens < lx->tokens.length ? VecAt (&lx->tokens, ntokens).offset : lx->pos;
+    if (nbytes > first) {
+        LOG_ERROR ("cannot drop code of tokens that are kept.");
+        return NULL;
+    }
+
+    if (ntokens) {
+        VecDeleteRange (&lx->tokens, 0, ntokens);
+    }
+
+    // keep only names of remaining tokens, in a fresh interner sized for them
+    McInterner kept = {0};
+    StrInit (&kept.names);
+    VecInit (&kept.offsets, NULL, NULL);
+    VecInit (&kept.slots, NULL, NULL);
+
+    McInterner* in = &lx->interner;
+    VecForeachPtr (&lx->tokens, tok, {
+        if (tok->kind == MC_TOKEN_KIND_ID) {
+            const char* name = in->names.data + VecAt (&in->offsets, tok->value);
+            u32         idx  = interner_add (&kept, name, interned_length (in, tok->value));
+            if (idx == (u32)-1) {
+                StrDeinit (&kept.names);
+                VecDeinit (&kept.offsets);
+                VecDeinit (&kept.slots);
+                return NULL;
+            }
+            tok->value = idx;
+        }
+        tok->offset -= nbytes;
+    });
+    lx->pos -= nbytes;
+
+    StrDeinit (&in->names);
+    VecDeinit (&in->offsets);
+    VecDeinit (&in->slots);
+    *in = kept;
+
+    return lx;
+}
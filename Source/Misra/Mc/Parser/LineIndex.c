@@ -0,0 +1,205 @@
+/// file      : misra/mc/lineindex.c
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Lazily built table of line start offsets.
+
+#include <Misra/Mc/Parser/LineIndex.h>
+#include <Misra/Std/Log.h>
+
+// platform
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#    include <immintrin.h>
+#    define LINE_INDEX_HAVE_SIMD 1
+#else
+#    define LINE_INDEX_HAVE_SIMD 0
+#endif
+
+static inline bool push_line_start (McLineIndex* li, u64 offset) {
+    if (!VecPushBack (&li->starts, &offset)) {
+        LOG_ERROR ("failed to add line start.");
+        return false;
+    }
+    return true;
+}
+
+
+static bool scan_scalar (McLineIndex* li, const char* code, u64 pos, u64 length) {
+    for (; pos < length; pos++) {
+        if (code[pos] == '\n' && !push_line_start (li, li->base + pos + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#if LINE_INDEX_HAVE_SIMD
+
+__attribute__ ((target ("sse2"))) static bool
+    scan_sse2 (McLineIndex* li, const char* code, u64 pos, u64 length) {
+    const __m128i nl = _mm_set1_epi8 ('\n');
+
+    for (; pos + 16 <= length; pos += 16) {
+        __m128i v = _mm_loadu_si128 ((const __m128i*)(code + pos));
+
+        // one bit for every newline, most chunks have none
+        u32 mask = _mm_movemask_epi8 (_mm_cmpeq_epi8 (v, nl));
+        for (; mask; mask &= mask - 1) {
+            if (!push_line_start (li, li->base + pos + __builtin_ctz (mask) + 1)) {
+                return false;
+            }
+        }
+    }
+
+    return scan_scalar (li, code, pos, length);
+}
+
+
+__attribute__ ((target ("avx2"))) static bool
+    scan_avx2 (McLineIndex* li, const char* code, u64 pos, u64 length) {
+    const __m256i nl = _mm256_set1_epi8 ('\n');
+
+    for (; pos + 32 <= length; pos += 32) {
+        __m256i v = _mm256_loadu_si256 ((const __m256i*)(code + pos));
+
+        // one bit for every newline, most chunks have none
+        u32 mask = _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (v, nl));
+        for (; mask; mask &= mask - 1) {
+            if (!push_line_start (li, li->base + pos + __builtin_ctz (mask) + 1)) {
+                return false;
+            }
+        }
+    }
+
+    return scan_sse2 (li, code, pos, length);
+}
+
+#endif
+
+// best implementation for this CPU, picked once on first scan
+static bool (*scan_impl) (McLineIndex* li, const char* code, u64 pos, u64 length) = scan_scalar;
+static pthread_once_t scan_once = PTHREAD_ONCE_INIT;
+
+static void scan_select (void) {
+#if LINE_INDEX_HAVE_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports ("avx2")) {
+        scan_impl = scan_avx2;
+    } else if (__builtin_cpu_supports ("sse2")) {
+        scan_impl = scan_sse2;
+    }
+#endif
+}
+
+McLineIndex* McLineIndexInit (McLineIndex* li) {
+    if (!li) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    memset (li, 0, sizeof (McLineIndex));
+    VecInit (&li->starts, NULL, NULL);
+
+    return li;
+}
+
+
+McLineIndex* McLineIndexDeinit (McLineIndex* li) {
+    if (!li) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    VecDeinit (&li->starts);
+    memset (li, 0, sizeof (McLineIndex));
+
+    return li;
+}
+
+
+McLineIndex* McLineIndexScan (McLineIndex* li, const char* code, u64 length) {
+    if (!li || (!code && length)) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    pthread_once (&scan_once, scan_select);
+
+    // nothing is ever dropped before first scan, so first line starts at 0
+    if (!li->starts.length && !push_line_start (li, 0)) {
+        return NULL;
+    }
+
+    u64 pos = li->scanned - li->base;
+    if (pos >= length) {
+        return li;
+    }
+
+    if (!scan_impl (li, code, pos, length)) {
+        return NULL;
+    }
+    li->scanned = li->base + length;
+
+    return li;
+}
+
+
+// Index of last line starting at or before given absolute offset.
+static inline u64 find_line (McLineIndex* li, u64 offset) {
+    u64 lo = 0;
+    u64 hi = li->starts.length;
+    while (hi - lo > 1) {
+        u64 mid = lo + (hi - lo) / 2;
+        if (VecAt (&li->starts, mid) <= offset) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+
+McLineIndex* McLineIndexDrop (McLineIndex* li, const char* code, u64 nbytes) {
+    if (!li || (!code && nbytes)) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    if (!McLineIndexScan (li, code, nbytes)) {
+        return NULL;
+    }
+
+    // forget all lines that end before new start of window
+    u64 base = li->base + nbytes;
+    u64 line = find_line (li, base);
+    if (line && !VecDeleteRange (&li->starts, 0, line)) {
+        LOG_ERROR ("failed to drop line starts.");
+        return NULL;
+    }
+    li->base_line += line;
+    li->base       = base;
+
+    return li;
+}
+
+
+bool McLineIndexLookup (McLineIndex* li, u64 offset, u64* line, u64* column) {
+    if (!li || !line || !column) {
+        LOG_ERROR ("invalid arguments.");
+        return false;
+    }
+
+    if (offset < li->base || offset > li->scanned || !li->starts.length) {
+        return false;
+    }
+
+    u64 idx = find_line (li, offset);
+    *line   = li->base_line + idx + 1;
+    *column = offset - VecAt (&li->starts, idx) + 1;
+
+    return true;
+}
@@ -0,0 +1,355 @@
+/// file      : misra/mc/literal.c
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Numeric literal conversion. Decimal digits are converted eight at a time
+/// with SWAR (SIMD within a register), and floats are rounded correctly
+/// with Eisel-Lemire algorithm, falling back to `strtod` only when a long
+/// number can't be decided from it's first 19 digits.
+
+#include <Misra/Mc/Parser/Literal.h>
+#include <Misra/Std/Log.h>
+
+// generated at build time by gen_pow5_table
+#include <Misra/Mc/Parser/Pow5Table.h>
+
+// platform
+#include <stdlib.h>
+#include <string.h>
+
+#define IS_DIGIT(c) ('0' <= (c) && (c) <= '9')
+
+// max number of decimal digits that always fit in u64
+#define MAX_U64_DIGITS 19
+
+// value of each hex digit plus one, 0 for everything else
+static const u8 hex_digit[256] = {
+    ['0'] = 1,  ['1'] = 2,  ['2'] = 3,  ['3'] = 4,  ['4'] = 5,  ['5'] = 6,  ['6'] = 7,  ['7'] = 8,
+    ['8'] = 9,  ['9'] = 10, ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+    ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+};
+
+// powers of ten that are exactly representable as doubles
+static const f64 exact_pow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                  1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                  1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// Load 8 bytes, first byte in lowest byte of result.
+static inline u64 load_8 (const char* s) {
+    u64 v;
+    memcpy (&v, s, sizeof (v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64 (v);
+#endif
+    return v;
+}
+
+
+// Are all 8 bytes in `v` decimal digits?
+static inline bool is_8_digits (u64 v) {
+    u64 hi     = v & 0xf0f0f0f0f0f0f0f0ULL;
+    u64 hi_inc = ((v + 0x0606060606060606ULL) & 0xf0f0f0f0f0f0f0f0ULL) >> 4;
+    return (hi | hi_inc) == 0x3333333333333333ULL;
+}
+
+
+// Value of 8 decimal digits in `v`, combining pairs of digits, then pairs
+// of pairs, and so on with a few multiplications.
+static inline u32 parse_8_digits (u64 v) {
+    const u64 mask = 0x000000ff000000ffULL;
+    const u64 mul1 = 100 + (1000000ULL << 32);
+    const u64 mul2 = 1 + (10000ULL << 32);
+
+    v -= 0x3030303030303030ULL;
+    v  = (v * 10) + (v >> 8);
+    v  = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+
+    return (u32)v;
+}
+
+
+///
+/// Append up to `max` digits from `s` to `w`, eight at a time where possible.
+///
+/// s[in]           : Digits to take.
+/// end[in]         : End of input.
+/// w[in,out]       : Value digits are appended to.
+/// ndigits[in,out] : Number of digits in `w`, never more than `max` after call.
+/// max[in]         : Max number of digits `w` may hold.
+///
+/// RETURN : Pointer past last digit taken.
+///
+static inline const char*
+    take_digits (const char* s, const char* end, u64* w, u32* ndigits, u32 max) {
+    while (*ndigits + 8 <= max && end - s >= 8) {
+        u64 v = load_8 (s);
+        if (!is_8_digits (v)) {
+            break;
+        }
+        *w        = *w * 100000000 + parse_8_digits (v);
+        *ndigits += 8;
+        s        += 8;
+    }
+
+    while (*ndigits < max && s < end && IS_DIGIT (*s)) {
+        *w = *w * 10 + (*s - '0');
+        (*ndigits)++;
+        s++;
+    }
+
+    return s;
+}
+
+
+bool McLiteralDecToU64 (const char* s, u32 length, u64* value) {
+    if (!s || !value) {
+        LOG_ERROR ("invalid arguments.");
+        return false;
+    }
+
+    if (!length) {
+        return false;
+    }
+
+    // leading zeros don't count towards overflow
+    const char* end = s + length;
+    while (s < end - 1 && *s == '0') {
+        s++;
+    }
+
+    u64 w       = 0;
+    u32 ndigits = 0;
+    s           = take_digits (s, end, &w, &ndigits, MAX_U64_DIGITS);
+
+    // 20th digit may or may not fit
+    if (s < end && IS_DIGIT (*s)) {
+        if (__builtin_mul_overflow (w, 10, &w) || __builtin_add_overflow (w, *s - '0', &w)) {
+            return false;
+        }
+        s++;
+    }
+
+    if (s != end) {
+        return false;
+    }
+
+    *value = w;
+    return true;
+}
+
+
+bool McLiteralHexToU64 (const char* s, u32 length, u64* value) {
+    if (!s || !value) {
+        LOG_ERROR ("invalid arguments.");
+        return false;
+    }
+
+    if (!length) {
+        return false;
+    }
+
+    const char* end = s + length;
+    while (s < end - 1 && *s == '0') {
+        s++;
+    }
+
+    if (end - s > 16) {
+        return false;
+    }
+
+    u64 w = 0;
+    for (; s < end; s++) {
+        u8 d = hex_digit[(u8)*s];
+        if (!d) {
+            return false;
+        }
+        w = (w << 4) | (d - 1);
+    }
+
+    *value = w;
+    return true;
+}
+
+
+///
+/// Eisel-Lemire algorithm. Compute nearest double to w * 10^q, with a
+/// 64x128-bit multiplication by a truncated power of five. This is exact for
+/// every w (with at most 19 digits) and q, as proven by Mushtak and Lemire.
+///
+/// w[in] : Decimal significand, non-zero.
+/// q[in] : Decimal exponent.
+///
+/// RETURN : Bits of nearest double.
+///
+static inline u64 eisel_lemire (u64 w, i64 q) {
+    if (q < MC_POW5_MIN_EXPONENT) {
+        return 0;
+    }
+
+    if (q > MC_POW5_MAX_EXPONENT) {
+        return 0x7ffULL << 52;
+    }
+
+    // normalize significand
+    i32 lz  = __builtin_clzll (w);
+    w     <<= lz;
+
+    // only top 55 bits of product are needed (52 bits of mantissa, an implicit
+    // bit, a rounding bit and one more to detect overflow). If any of the
+    // bits right below them could still change, refine with low half of power.
+    const u64*        pow5  = &mc_pow5_table[2 * (q - MC_POW5_MIN_EXPONENT)];
+    unsigned __int128 prod  = (unsigned __int128)w * pow5[0];
+    u64               hi    = (u64)(prod >> 64);
+    u64               lo    = (u64)prod;
+    const u64         prec  = 0x1ffULL;
+    if ((hi & prec) == prec) {
+        unsigned __int128 prod2 = (unsigned __int128)w * pow5[1];
+        u64               hi2   = (u64)(prod2 >> 64);
+        lo                     += hi2;
+        if (hi2 > lo) {
+            hi++;
+        }
+    }
+
+    i32 upperbit = hi >> 63;
+    i32 shift    = upperbit + 64 - 52 - 3;
+    u64 mantissa = hi >> shift;
+
+    // binary exponent, floor(q * log2(10)) + 63 computed in fixed point, biased
+    i32 power2 = (i32)(((152170 + 65536) * q) >> 16) + 63 + upperbit - lz + 1023;
+
+    // subnormal
+    if (power2 <= 0) {
+        if (-power2 + 1 >= 64) {
+            return 0;
+        }
+        mantissa >>= -power2 + 1;
+        mantissa  += mantissa & 1;
+        mantissa >>= 1;
+        power2     = mantissa < (1ULL << 52) ? 0 : 1;
+        return mantissa | ((u64)power2 << 52);
+    }
+
+    // exactly halfway between two doubles is only possible when 5^q fits in
+    // 64 bits, and then product is exact. Round to even instead of up.
+    if (lo <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1) {
+        if ((mantissa << shift) == hi) {
+            mantissa &= ~1ULL;
+        }
+    }
+
+    mantissa  += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= (2ULL << 52)) {
+        mantissa = 1ULL << 52;
+        power2++;
+    }
+    mantissa &= ~(1ULL << 52);
+
+    if (power2 >= 0x7ff) {
+        return 0x7ffULL << 52;
+    }
+
+    return mantissa | ((u64)power2 << 52);
+}
+
+
+// Correctly rounded conversion of arbitrarily long numbers.
+static inline bool dec_to_f64_slow (const char* s, u32 length, f64* value) {
+    char  buf[64];
+    char* z = length < sizeof (buf) ? buf : malloc (length + 1);
+    if (!z) {
+        LOG_ERROR ("malloc() failed : %s.", strerror (errno));
+        return false;
+    }
+
+    memcpy (z, s, length);
+    z[length] = 0;
+    *value    = strtod (z, NULL);
+
+    if (z != buf) {
+        free (z);
+    }
+
+    return true;
+}
+
+
+bool McLiteralDecToF64 (const char* s, u32 length, f64* value) {
+    if (!s || !value) {
+        LOG_ERROR ("invalid arguments.");
+        return false;
+    }
+
+    const char* p   = s;
+    const char* end = s + length;
+
+    // value is w * 10^q, where w holds first 19 significant digits
+    u64  w         = 0;
+    i64  q         = 0;
+    u32  nsig      = 0;
+    bool truncated = false;
+    bool any       = false;
+
+    // integer part, leading zeros aren't significant
+    while (p < end && *p == '0') {
+        p++;
+        any = true;
+    }
+
+    const char* digits = p;
+    p                  = take_digits (p, end, &w, &nsig, MAX_U64_DIGITS);
+    while (p < end && IS_DIGIT (*p)) {
+        truncated |= *p != '0';
+        q++;
+        p++;
+    }
+    any |= p != digits;
+
+    // fraction part
+    if (p < end && *p == '.') {
+        p++;
+
+        const char* frac = p;
+        if (!nsig) {
+            while (p < end && *p == '0') {
+                p++;
+                q--;
+            }
+        }
+
+        const char* sig  = p;
+        p                = take_digits (p, end, &w, &nsig, MAX_U64_DIGITS);
+        q               -= p - sig;
+        while (p < end && IS_DIGIT (*p)) {
+            truncated |= *p != '0';
+            p++;
+        }
+        any |= p != frac;
+    }
+
+    if (p != end || !any) {
+        return false;
+    }
+
+    if (!w) {
+        *value = 0;
+        return true;
+    }
+
+    // both w and 10^|q| are exact doubles, so a single operation rounds correctly
+    if (!truncated && w <= (1ULL << 53) && q >= -22 && q <= 22) {
+        *value = q < 0 ? (f64)w / exact_pow10[-q] : (f64)w * exact_pow10[q];
+        return true;
+    }
+
+    // dropped digits put value somewhere between w and w + 1,
+    // if both round to same double then that's the answer
+    u64 bits = eisel_lemire (w, q);
+    if (!truncated || eisel_lemire (w + 1, q) == bits) {
+        memcpy (value, &bits, sizeof (bits));
+        return true;
+    }
+
+    return dec_to_f64_slow (s, length, value);
+}
@@ -0,0 +1,213 @@
+/// file      : misra/mc/split.c
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Structural pre-scan of code for top level item boundaries.
+
+#include <Misra/Mc/Parser/Split.h>
+#include <Misra/Std/Log.h>
+
+// platform
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#    include <immintrin.h>
+#    define SPLIT_HAVE_SIMD 1
+#else
+#    define SPLIT_HAVE_SIMD 0
+#endif
+
+typedef struct SplitState {
+    const char* code;
+    u64         length;
+    u64         min_slice;
+
+    /// Bracket nesting depth at current byte.
+    u64 depth;
+
+    /// No cut is made before this offset.
+    u64 next;
+
+    McCutVec* cuts;
+} SplitState;
+
+// same whitespace characters lexer skips
+static inline bool is_ws (char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\b' || c == '\f';
+}
+
+
+// Update state for structural character at given offset, and cut after it
+// if it's a ";" ending an item.
+static inline bool on_structural (SplitState* s, u64 pos) {
+    switch (s->code[pos]) {
+        case '(' :
+        case '[' :
+        case '{' :
+            s->depth++;
+            return true;
+        case ')' :
+        case ']' :
+        case '}' :
+            // unbalanced brackets are parse errors, just don't go below zero
+            s->depth -= !!s->depth;
+            return true;
+        default :
+            break;
+    }
+
+    if (s->depth || pos + 1 < s->next) {
+        return true;
+    }
+
+    // In a run of ";" every second one is an (invalid) item of it's own and
+    // the next one ends it. Runs are never cut, to not have to count them.
+    u64 prev = pos;
+    while (prev && is_ws (s->code[prev - 1])) {
+        prev--;
+    }
+    u64 next = pos + 1;
+    while (next < s->length && is_ws (s->code[next])) {
+        next++;
+    }
+    if ((prev && s->code[prev - 1] == ';') || next >= s->length || s->code[next] == ';') {
+        return true;
+    }
+
+    u64 cut = pos + 1;
+    if (!VecPushBack (s->cuts, &cut)) {
+        LOG_ERROR ("failed to add cut.");
+        return false;
+    }
+    s->next = cut + s->min_slice;
+
+    return true;
+}
+
+
+static bool scan_scalar (SplitState* s, u64 pos) {
+    for (; pos < s->length; pos++) {
+        switch (s->code[pos]) {
+            case '(' :
+            case ')' :
+            case '[' :
+            case ']' :
+            case '{' :
+            case '}' :
+            case ';' :
+                if (!on_structural (s, pos)) {
+                    return false;
+                }
+                break;
+            default :
+                break;
+        }
+    }
+    return true;
+}
+
+#if SPLIT_HAVE_SIMD
+
+// "(" and ")" differ only in lowest bit, "[" and "{" (and "]" and "}") only
+// in bit 5, so setting those bits first finds all seven with four compares.
+
+__attribute__ ((target ("sse2"))) static bool scan_sse2 (SplitState* s, u64 pos) {
+    const __m128i paren = _mm_set1_epi8 (')');
+    const __m128i open  = _mm_set1_epi8 ('{');
+    const __m128i close = _mm_set1_epi8 ('}');
+    const __m128i semi  = _mm_set1_epi8 (';');
+    const __m128i bit0  = _mm_set1_epi8 (0x01);
+    const __m128i bit5  = _mm_set1_epi8 (0x20);
+
+    for (; pos + 16 <= s->length; pos += 16) {
+        __m128i v  = _mm_loadu_si128 ((const __m128i*)(s->code + pos));
+        __m128i v0 = _mm_or_si128 (v, bit0);
+        __m128i v5 = _mm_or_si128 (v, bit5);
+        __m128i m  = _mm_or_si128 (
+            _mm_or_si128 (_mm_cmpeq_epi8 (v0, paren), _mm_cmpeq_epi8 (v, semi)),
+            _mm_or_si128 (_mm_cmpeq_epi8 (v5, open), _mm_cmpeq_epi8 (v5, close))
+        );
+
+        for (u32 mask = _mm_movemask_epi8 (m); mask; mask &= mask - 1) {
+            if (!on_structural (s, pos + __builtin_ctz (mask))) {
+                return false;
+            }
+        }
+    }
+
+    return scan_scalar (s, pos);
+}
+
+
+__attribute__ ((target ("avx2"))) static bool scan_avx2 (SplitState* s, u64 pos) {
+    const __m256i paren = _mm256_set1_epi8 (')');
+    const __m256i open  = _mm256_set1_epi8 ('{');
+    const __m256i close = _mm256_set1_epi8 ('}');
+    const __m256i semi  = _mm256_set1_epi8 (';');
+    const __m256i bit0  = _mm256_set1_epi8 (0x01);
+    const __m256i bit5  = _mm256_set1_epi8 (0x20);
+
+    for (; pos + 32 <= s->length; pos += 32) {
+        __m256i v  = _mm256_loadu_si256 ((const __m256i*)(s->code + pos));
+        __m256i v0 = _mm256_or_si256 (v, bit0);
+        __m256i v5 = _mm256_or_si256 (v, bit5);
+        __m256i m  = _mm256_or_si256 (
+            _mm256_or_si256 (_mm256_cmpeq_epi8 (v0, paren), _mm256_cmpeq_epi8 (v, semi)),
+            _mm256_or_si256 (_mm256_cmpeq_epi8 (v5, open), _mm256_cmpeq_epi8 (v5, close))
+        );
+
+        for (u32 mask = _mm256_movemask_epi8 (m); mask; mask &= mask - 1) {
+            if (!on_structural (s, pos + __builtin_ctz (mask))) {
+                return false;
+            }
+        }
+    }
+
+    return scan_sse2 (s, pos);
+}
+
+#endif
+
+// best implementation for this CPU, picked once on first scan
+static bool (*scan_impl) (SplitState* s, u64 pos) = scan_scalar;
+static pthread_once_t scan_once                  = PTHREAD_ONCE_INIT;
+
+static void scan_select (void) {
+#if SPLIT_HAVE_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports ("avx2")) {
+        scan_impl = scan_avx2;
+    } else if (__builtin_cpu_supports ("sse2")) {
+        scan_impl = scan_sse2;
+    }
+#endif
+}
+
+McCutVec* McSplitItems (const char* code, u64 length, u64 min_slice, McCutVec* cuts) {
+    if ((!code && length) || !cuts) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    pthread_once (&scan_once, scan_select);
+
+    u64 first = 0;
+    if (!VecPushBack (cuts, &first)) {
+        LOG_ERROR ("failed to add cut.");
+        return NULL;
+    }
+
+    SplitState s = {
+        .code      = code,
+        .length    = length,
+        .min_slice = min_slice,
+        .next      = min_slice,
+        .cuts      = cuts,
+    };
+    if (!scan_impl (&s, 0)) {
+        return NULL;
+    }
+
+    return cuts;
+}
@@ -0,0 +1,505 @@
+/// file      : misra/mc/parser/value.c
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Typed compile time evaluation of expressions, with C semantics.
+
+#include <Misra/Mc/Parser/Value.h>
+#include <Misra/Std/Log.h>
+
+static McBasicType int_type (bool is_unsigned, u64 nbits) {
+    return (McBasicType) {
+        .type_kind   = MC_BASIC_TYPE_KIND_INTEGER,
+        .is_unsigned = is_unsigned,
+        .nbits       = nbits,
+        .arr_size    = 1,
+    };
+}
+
+
+static McBasicType float_type (u64 nbits) {
+    return (McBasicType) {.type_kind = MC_BASIC_TYPE_KIND_FLOAT, .nbits = nbits, .arr_size = 1};
+}
+
+
+static inline bool is_float (McBasicType t) {
+    return t.type_kind == MC_BASIC_TYPE_KIND_FLOAT;
+}
+
+
+// Truncate to width of integer type `t`, and extend back to 64 bits.
+static inline u64 wrap (u64 v, McBasicType t) {
+    if (t.nbits >= 64) {
+        return v;
+    }
+
+    u64 mask = (1ULL << t.nbits) - 1;
+    v       &= mask;
+    if (!t.is_unsigned && (v >> (t.nbits - 1))) {
+        v |= ~mask;
+    }
+    return v;
+}
+
+
+// Integer promotion, everything narrower than int becomes int.
+static inline McBasicType promote (McBasicType t) {
+    if (is_float (t)) {
+        return float_type (t.nbits);
+    }
+    return t.nbits < 32 ? int_type (false, 32) : int_type (t.is_unsigned, t.nbits);
+}
+
+
+// Usual arithmetic conversions. After promotion integers are 32 or 64 bits
+// wide, so wider type can always hold values of narrower one.
+static McBasicType common (McBasicType a, McBasicType b) {
+    a = promote (a);
+    b = promote (b);
+
+    if (is_float (a) || is_float (b)) {
+        u64 nbits = is_float (a) ? a.nbits : 0;
+        if (is_float (b) && b.nbits > nbits) {
+            nbits = b.nbits;
+        }
+        return float_type (nbits);
+    }
+
+    if (a.nbits != b.nbits) {
+        return a.nbits > b.nbits ? a : b;
+    }
+    return int_type (a.is_unsigned || b.is_unsigned, a.nbits);
+}
+
+
+static inline bool truth (const McValue* v) {
+    return is_float (v->type) ? v->f != 0 : v->u != 0;
+}
+
+
+static inline void set_bool (McValue* v, bool b) {
+    v->type = int_type (false, 32);
+    v->u    = b;
+}
+
+
+///
+/// Convert value to type `t`, as assignment would.
+///
+/// SUCCESS : true
+/// FAILURE : false, if a float is out of range of integer type.
+///
+static bool convert (McValue* v, McBasicType t) {
+    if (is_float (t)) {
+        // integers are rounded once, straight to width of float
+        if (is_float (v->type)) {
+            v->f = t.nbits == 32 ? (f32)v->f : v->f;
+        } else if (v->type.is_unsigned) {
+            v->f = t.nbits == 32 ? (f32)v->u : (f64)v->u;
+        } else {
+            v->f = t.nbits == 32 ? (f32)v->i : (f64)v->i;
+        }
+        v->type = float_type (t.nbits);
+        return true;
+    }
+
+    if (is_float (v->type)) {
+        // fraction is dropped first, then whatever is left must fit, and lowest
+        // i64 has to be checked on it's own as "-high - 1" rounds back to it
+        f64  f    = v->f;
+        f64  high = t.is_unsigned ? 2.0 * (1ULL << (t.nbits - 1)) : (f64)(1ULL << (t.nbits - 1));
+        f64  low  = t.is_unsigned ? -1 : -high - 1;
+        bool fits = (f > low || (!t.is_unsigned && f == -high)) && f < high;
+        if (!fits) {
+            return false;
+        }
+        v->u = f < 0 ? (u64)(i64)f : (u64)f;
+    }
+
+    v->type = int_type (t.is_unsigned, t.nbits);
+    v->u    = wrap (v->u, v->type);
+    return true;
+}
+
+
+// Type of an integer literal. Hexadecimal literals may be unsigned before moving
+// to a wider type, decimal ones only when no signed type can hold them.
+static inline McBasicType literal_type (u64 i, bool is_hex) {
+    if (i <= 0x7fffffff) {
+        return int_type (false, 32);
+    } else if (is_hex && i <= 0xffffffff) {
+        return int_type (true, 32);
+    }
+    return i <= 0x7fffffffffffffff ? int_type (false, 64) : int_type (true, 64);
+}
+
+
+// Log why evaluation failed, unless it's `quiet`.
+#define EVAL_ERROR(quiet, ...)                                                                     \
+    do {                                                                                           \
+        if (!(quiet)) {                                                                            \
+            LOG_ERROR (__VA_ARGS__);                                                               \
+        }                                                                                          \
+    } while (0)
+
+
+///
+/// Evaluate `e` into `v`, or when `run` is false only find it's type, as C
+/// does for operands of `sizeof` and for branch of "?:" that isn't taken.
+/// Without `run` values are never checked, but they are always defined.
+/// Failures are logged unless `quiet`.
+///
+static bool eval (McExpr* e, McValue* v, bool run, bool quiet);
+
+
+static bool eval_binary (McExpr* e, McValue* v, bool run, bool quiet) {
+    McValue l = {0};
+    McValue r = {0};
+    if (!eval (e->add.l, &l, run, quiet) || !eval (e->add.r, &r, run, quiet)) {
+        return false;
+    }
+
+    McExprType type = e->expr_type;
+    bool       ints = !is_float (l.type) && !is_float (r.type);
+
+    // shifted value keeps it's own type, and count is only checked
+    if (type == MC_EXPR_TYPE_SHL || type == MC_EXPR_TYPE_SHR) {
+        if (!ints) {
+            EVAL_ERROR (quiet, "invalid float operand of shift at offset %u.", e->offset);
+            return false;
+        }
+
+        McBasicType t = promote (l.type);
+        convert (&l, t);
+        if (run && ((!r.type.is_unsigned && r.i < 0) || r.u >= t.nbits)) {
+            EVAL_ERROR (quiet, "shift count %lld out of range at offset %u.", r.i, e->offset);
+            return false;
+        }
+
+        u64 count = r.u & 63;
+        v->type   = t;
+        if (type == MC_EXPR_TYPE_SHL) {
+            v->u = wrap (l.u << count, t);
+        } else {
+            v->u = t.is_unsigned ? l.u >> count : (u64)(l.i >> count);
+        }
+        return true;
+    }
+
+    McBasicType t = common (l.type, r.type);
+    convert (&l, t);
+    convert (&r, t);
+
+    if (is_float (t)) {
+        f64 a = l.f;
+        f64 b = r.f;
+        switch (type) {
+            case MC_EXPR_TYPE_ADD :
+                v->f = a + b;
+                break;
+            case MC_EXPR_TYPE_SUB :
+                v->f = a - b;
+                break;
+            case MC_EXPR_TYPE_MUL :
+                v->f = a * b;
+                break;
+            case MC_EXPR_TYPE_DIV :
+                v->f = a / b;
+                break;
+            case MC_EXPR_TYPE_LE :
+                set_bool (v, a <= b);
+                return true;
+            case MC_EXPR_TYPE_GE :
+                set_bool (v, a >= b);
+                return true;
+            case MC_EXPR_TYPE_LT :
+                set_bool (v, a < b);
+                return true;
+            case MC_EXPR_TYPE_GT :
+                set_bool (v, a > b);
+                return true;
+            case MC_EXPR_TYPE_EQ :
+                set_bool (v, a == b);
+                return true;
+            case MC_EXPR_TYPE_NE :
+                set_bool (v, a != b);
+                return true;
+            default :
+                EVAL_ERROR (
+                    quiet,
+                    "invalid float operand of integer operator at offset %u.",
+                    e->offset
+                );
+                return false;
+        }
+
+        // operands of f32 are exact in f64, and so one rounding to f32 gives same result
+        v->type = t;
+        v->f    = t.nbits == 32 ? (f32)v->f : v->f;
+        return true;
+    }
+
+    u64  a         = l.u;
+    u64  b         = r.u;
+    bool is_signed = !t.is_unsigned;
+    switch (type) {
+        case MC_EXPR_TYPE_ADD :
+            v->u = a + b;
+            break;
+        case MC_EXPR_TYPE_SUB :
+            v->u = a - b;
+            break;
+        case MC_EXPR_TYPE_MUL :
+            v->u = a * b;
+            break;
+        case MC_EXPR_TYPE_AND :
+            v->u = a & b;
+            break;
+        case MC_EXPR_TYPE_OR :
+            v->u = a | b;
+            break;
+        case MC_EXPR_TYPE_XOR :
+            v->u = a ^ b;
+            break;
+        case MC_EXPR_TYPE_DIV :
+        case MC_EXPR_TYPE_MOD :
+            if (!b) {
+                if (run) {
+                    EVAL_ERROR (quiet, "integer division by zero at offset %u.", e->offset);
+                    return false;
+                }
+                v->u = 0;
+            } else if (is_signed && l.i == INT64_MIN && r.i == -1) {
+                // wraps around to itself, and leaves nothing
+                v->u = type == MC_EXPR_TYPE_DIV ? a : 0;
+            } else if (is_signed) {
+                v->u = type == MC_EXPR_TYPE_DIV ? (u64)(l.i / r.i) : (u64)(l.i % r.i);
+            } else {
+                v->u = type == MC_EXPR_TYPE_DIV ? a / b : a % b;
+            }
+            break;
+        case MC_EXPR_TYPE_LE :
+            set_bool (v, is_signed ? l.i <= r.i : a <= b);
+            return true;
+        case MC_EXPR_TYPE_GE :
+            set_bool (v, is_signed ? l.i >= r.i : a >= b);
+            return true;
+        case MC_EXPR_TYPE_LT :
+            set_bool (v, is_signed ? l.i < r.i : a < b);
+            return true;
+        case MC_EXPR_TYPE_GT :
+            set_bool (v, is_signed ? l.i > r.i : a > b);
+            return true;
+        case MC_EXPR_TYPE_EQ :
+            set_bool (v, a == b);
+            return true;
+        default :
+            set_bool (v, a != b);
+            return true;
+    }
+
+    v->type = t;
+    v->u    = wrap (v->u, t);
+    return true;
+}
+
+
+static bool eval_unary (McExpr* e, McValue* v, bool run, bool quiet) {
+    McValue x = {0};
+    if (!eval (e->un_minus.e, &x, run, quiet)) {
+        return false;
+    }
+
+    if (e->expr_type == MC_EXPR_TYPE_LOG_NOT) {
+        set_bool (v, !truth (&x));
+        return true;
+    }
+
+    McBasicType t = promote (x.type);
+    convert (&x, t);
+    *v = x;
+    switch (e->expr_type) {
+        case MC_EXPR_TYPE_UN_MINUS :
+            if (is_float (t)) {
+                v->f = -x.f;
+            } else {
+                v->u = wrap (-x.u, t);
+            }
+            return true;
+        case MC_EXPR_TYPE_NOT :
+            if (is_float (t)) {
+                EVAL_ERROR (quiet, "invalid float operand of \"~\" at offset %u.", e->offset);
+                return false;
+            }
+            v->u = wrap (~x.u, t);
+            return true;
+        default :
+            return true;
+    }
+}
+
+
+static bool eval (McExpr* e, McValue* v, bool run, bool quiet) {
+    if (!e) {
+        EVAL_ERROR (quiet, "missing operand.");
+        return false;
+    }
+
+    switch (e->expr_type) {
+        case MC_EXPR_TYPE_NUM :
+            if (e->num.type.type_kind != MC_BASIC_TYPE_KIND_INVALID) {
+                // folded constant, typed when it was folded
+                v->type = e->num.type;
+                if (is_float (v->type)) {
+                    v->f = e->num.f;
+                } else {
+                    v->u = e->num.i;
+                }
+            } else if (e->num.is_int) {
+                v->type = literal_type (e->num.i, e->num.is_hex);
+                v->u    = e->num.i;
+            } else {
+                v->type = float_type (64);
+                v->f    = e->num.f;
+            }
+            return true;
+
+        case MC_EXPR_TYPE_ADD :
+        case MC_EXPR_TYPE_SUB :
+        case MC_EXPR_TYPE_MUL :
+        case MC_EXPR_TYPE_DIV :
+        case MC_EXPR_TYPE_AND :
+        case MC_EXPR_TYPE_OR :
+        case MC_EXPR_TYPE_XOR :
+        case MC_EXPR_TYPE_MOD :
+        case MC_EXPR_TYPE_SHR :
+        case MC_EXPR_TYPE_SHL :
+        case MC_EXPR_TYPE_LE :
+        case MC_EXPR_TYPE_GE :
+        case MC_EXPR_TYPE_LT :
+        case MC_EXPR_TYPE_GT :
+        case MC_EXPR_TYPE_EQ :
+        case MC_EXPR_TYPE_NE :
+            return eval_binary (e, v, run, quiet);
+
+        case MC_EXPR_TYPE_LOG_AND :
+        case MC_EXPR_TYPE_LOG_OR : {
+            // right side is only type checked when left side decides
+            bool    is_and = e->expr_type == MC_EXPR_TYPE_LOG_AND;
+            McValue x      = {0};
+            if (!eval (e->log_and.l, &x, run, quiet)) {
+                return false;
+            }
+            bool decided = truth (&x) != is_and;
+            if (!eval (e->log_and.r, &x, run && !decided, quiet)) {
+                return false;
+            }
+            set_bool (v, decided ? !is_and : truth (&x));
+            return true;
+        }
+
+        case MC_EXPR_TYPE_LOG_NOT :
+        case MC_EXPR_TYPE_NOT :
+        case MC_EXPR_TYPE_UN_PLUS :
+        case MC_EXPR_TYPE_UN_MINUS :
+            return eval_unary (e, v, run, quiet);
+
+        case MC_EXPR_TYPE_IN_PARENS :
+            return eval (e->in_parens.e, v, run, quiet);
+
+        case MC_EXPR_TYPE_CAST : {
+            McBasicType t       = e->cast.type.basic_type;
+            bool        pointer = t.type_mod & MC_TYPE_MOD_POINTER;
+            if (e->cast.type.type_kind != MC_TYPE_KIND_BASIC || pointer) {
+                EVAL_ERROR (quiet, "unsupported cast at offset %u.", e->offset);
+                return false;
+            }
+            if (!eval (e->cast.e, v, run, quiet)) {
+                return false;
+            }
+            if (!convert (v, t)) {
+                if (run) {
+                    EVAL_ERROR (
+                        quiet,
+                        "float %g out of range of cast at offset %u.",
+                        v->f,
+                        e->offset
+                    );
+                    return false;
+                }
+                v->type = int_type (t.is_unsigned, t.nbits);
+                v->u    = 0;
+            }
+            return true;
+        }
+
+        case MC_EXPR_TYPE_TERN : {
+            McValue c = {0};
+            McValue t = {0};
+            McValue f = {0};
+            if (!eval (e->tern.c, &c, run, quiet)) {
+                return false;
+            }
+
+            // type comes from both sides, value only from the one taken
+            bool taken = truth (&c);
+            if (!eval (e->tern.t, &t, run && taken, quiet) ||
+                !eval (e->tern.f, &f, run && !taken, quiet)) {
+                return false;
+            }
+            *v = taken ? t : f;
+            convert (v, common (t.type, f.type));
+            return true;
+        }
+
+        case MC_EXPR_TYPE_LIST :
+            VecForeach (&e->list, xpr, {
+                if (!eval (xpr, v, run, quiet)) {
+                    return false;
+                }
+            });
+            return e->list.length != 0;
+
+        case MC_EXPR_TYPE_SIZE_OF :
+        case MC_EXPR_TYPE_ALIGN_OF : {
+            // operand is never evaluated, and basic types are aligned to their size
+            McValue x = {0};
+            if (!eval (e->size_of.e, &x, false, quiet)) {
+                return false;
+            }
+            v->type = int_type (true, 64);
+            v->u    = x.type.nbits / 8;
+            return true;
+        }
+
+        default :
+            EVAL_ERROR (quiet, "expression at offset %u is not a constant.", e->offset);
+            return false;
+    }
+}
+
+
+static McValue* eval_value (McValue* value, McExpr* expr, bool quiet) {
+    if (!value || !expr) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    McValue v = {0};
+    if (!eval (expr, &v, true, quiet)) {
+        return NULL;
+    }
+
+    *value = v;
+    return value;
+}
+
+
+McValue* McExprEvalValue (McValue* value, McExpr* expr) {
+    return eval_value (value, expr, false);
+}
+
+
+McValue* McExprTryEvalValue (McValue* value, McExpr* expr) {
+    return eval_value (value, expr, true);
+}
@@ -0,0 +1,624 @@
+/// file      : misra/mc/vm/bytecode.c
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Bytecode compiler and threaded stack machine for expressions.
+
+#include <Misra/Mc/Vm/Bytecode.h>
+#include <Misra/Std/Log.h>
+
+// platform
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__)
+#    define BYTECODE_THREADED 1
+#else
+#    define BYTECODE_THREADED 0
+#endif
+
+// bytes taken by an instruction with operand of given size
+#define INSN_SIZE(operand) (1 + sizeof (operand))
+
+typedef enum BcKind {
+    BC_KIND_ERROR = 0,
+    BC_KIND_INT,
+    BC_KIND_FLOAT,
+} BcKind;
+
+typedef union BcSlot {
+    u64 i;
+    f64 f;
+} BcSlot;
+
+typedef struct BcCompiler {
+    McBytecode* bc;
+
+    /// Number of values on stack after code emitted so far.
+    u64 depth;
+
+    /// Offset of last instruction, if nothing can jump right after it, else -1.
+    u64 last;
+} BcCompiler;
+
+///
+/// Append an instruction.
+///
+/// c[in,out]  : Compiler to emit into.
+/// op[in]     : Opcode.
+/// arg[in]    : Operand bytes, if any.
+/// size[in]   : Number of operand bytes.
+/// effect[in] : Change in stack depth, when instruction doesn't jump.
+///
+/// SUCCESS : true
+/// FAILURE : false
+///
+static bool emit (BcCompiler* c, McOpcode op, const void* arg, u64 size, i64 effect) {
+    McCodeVec* code = &c->bc->code;
+    u8         byte = op;
+
+    c->last = code->length;
+    if (!VecPushBack (code, &byte) || (size && !VecPushBackArr (code, (const u8*)arg, size))) {
+        LOG_ERROR ("failed to emit instruction.");
+        return false;
+    }
+
+    c->depth += effect;
+    if (c->depth > c->bc->max_depth) {
+        c->bc->max_depth = c->depth;
+    }
+    return true;
+}
+
+
+// Emit a jump with zero offset, and return offset of it's operand to patch later.
+static u64 emit_jump (BcCompiler* c, McOpcode op, i64 effect) {
+    i32 zero = 0;
+    if (!emit (c, op, &zero, sizeof (zero), effect)) {
+        return (u64)-1;
+    }
+    return c->bc->code.length - sizeof (zero);
+}
+
+
+// Make jump with operand at given offset land at end of code.
+static bool patch_jump (BcCompiler* c, u64 pos) {
+    if (pos == (u64)-1) {
+        return false;
+    }
+
+    i32 off = c->bc->code.length - (pos + sizeof (i32));
+    memcpy (c->bc->code.data + pos, &off, sizeof (off));
+
+    // end of code is a jump target now, last instruction mustn't be rewritten
+    c->last = (u64)-1;
+    return true;
+}
+
+
+static inline BcKind push_i (BcCompiler* c, u64 i) {
+    return emit (c, MC_OP_PUSH_I, &i, sizeof (i), 1) ? BC_KIND_INT : BC_KIND_ERROR;
+}
+
+
+static inline BcKind push_f (BcCompiler* c, f64 f) {
+    return emit (c, MC_OP_PUSH_F, &f, sizeof (f), 1) ? BC_KIND_FLOAT : BC_KIND_ERROR;
+}
+
+
+// Convert u64 on top of stack to f64. A constant just pushed is converted in place.
+static BcKind to_float (BcCompiler* c) {
+    McCodeVec* code = &c->bc->code;
+    if (c->last != (u64)-1 && c->last + INSN_SIZE (u64) == code->length &&
+        VecAt (code, c->last) == MC_OP_PUSH_I) {
+        u64 i = 0;
+        memcpy (&i, code->data + c->last + 1, sizeof (i));
+        f64 f = i;
+        memcpy (code->data + c->last + 1, &f, sizeof (f));
+        VecAt (code, c->last) = MC_OP_PUSH_F;
+        return BC_KIND_FLOAT;
+    }
+
+    return emit (c, MC_OP_I2F, NULL, 0, 0) ? BC_KIND_FLOAT : BC_KIND_ERROR;
+}
+
+
+// Push value of identifier, adding it to inputs on first use.
+static BcKind load (BcCompiler* c, Str* id) {
+    McInputVec* inputs = &c->bc->inputs;
+
+    u32 idx = 0;
+    while (idx < inputs->length) {
+        Str* name = VecIter (inputs, idx);
+        if (name->length == id->length && !memcmp (name->data, id->data, id->length)) {
+            break;
+        }
+        idx++;
+    }
+
+    if (idx == inputs->length) {
+        Str name = {0};
+        if (!StrInitCopy (&name, id) || !VecPushBack (inputs, &name)) {
+            LOG_ERROR ("failed to add input.");
+            StrDeinit (&name);
+            return BC_KIND_ERROR;
+        }
+    }
+
+    return emit (c, MC_OP_LOAD, &idx, sizeof (idx), 1) ? BC_KIND_FLOAT : BC_KIND_ERROR;
+}
+
+
+static BcKind compile (BcCompiler* c, McExpr* e);
+
+static BcKind compile_float (BcCompiler* c, McExpr* e) {
+    BcKind kind = compile (c, e);
+    return kind == BC_KIND_INT ? to_float (c) : kind;
+}
+
+
+static BcKind compile_int (BcCompiler* c, McExpr* e) {
+    BcKind kind = compile (c, e);
+    if (kind == BC_KIND_FLOAT) {
+        return emit (c, MC_OP_F2I, NULL, 0, 0) ? BC_KIND_INT : BC_KIND_ERROR;
+    }
+    return kind;
+}
+
+
+// Compile to u64 1 if value is non-zero, else 0.
+static BcKind compile_bool (BcCompiler* c, McExpr* e) {
+    BcKind kind = compile (c, e);
+    if (kind == BC_KIND_ERROR) {
+        return kind;
+    }
+    McOpcode op = kind == BC_KIND_INT ? MC_OP_BOOL_I : MC_OP_BOOL_F;
+    return emit (c, op, NULL, 0, 0) ? BC_KIND_INT : BC_KIND_ERROR;
+}
+
+
+static BcKind compile_arith (BcCompiler* c, McExpr* l, McExpr* r, McOpcode op) {
+    if (!compile_float (c, l) || !compile_float (c, r)) {
+        return BC_KIND_ERROR;
+    }
+    return emit (c, op, NULL, 0, -1) ? BC_KIND_FLOAT : BC_KIND_ERROR;
+}
+
+
+static BcKind compile_bitwise (BcCompiler* c, McExpr* l, McExpr* r, McOpcode op) {
+    if (!compile_int (c, l) || !compile_int (c, r)) {
+        return BC_KIND_ERROR;
+    }
+    return emit (c, op, NULL, 0, -1) ? BC_KIND_INT : BC_KIND_ERROR;
+}
+
+
+// Compare as u64 if both sides are, else as f64. `op` is the u64 comparison.
+static BcKind compile_compare (BcCompiler* c, McExpr* l, McExpr* r, McOpcode op) {
+    BcKind lkind = compile (c, l);
+    BcKind rkind = BC_KIND_ERROR;
+    if (lkind == BC_KIND_FLOAT) {
+        rkind = compile_float (c, r);
+    } else if (lkind == BC_KIND_INT) {
+        rkind = compile (c, r);
+    }
+    if (!rkind) {
+        return BC_KIND_ERROR;
+    }
+
+    if (lkind == BC_KIND_INT && rkind == BC_KIND_FLOAT && !emit (c, MC_OP_I2F_NOS, NULL, 0, 0)) {
+        return BC_KIND_ERROR;
+    }
+    if (lkind != BC_KIND_INT || rkind != BC_KIND_INT) {
+        op += MC_OP_LE_F - MC_OP_LE_I;
+    }
+    return emit (c, op, NULL, 0, -1) ? BC_KIND_INT : BC_KIND_ERROR;
+}
+
+
+// "&&" and "||", `jump` skips right side when left side decides result.
+static BcKind compile_logic (BcCompiler* c, McExpr* l, McExpr* r, McOpcode jump) {
+    if (!compile_bool (c, l)) {
+        return BC_KIND_ERROR;
+    }
+    u64 pos = emit_jump (c, jump, -1);
+    if (pos == (u64)-1 || !compile_bool (c, r) || !patch_jump (c, pos)) {
+        return BC_KIND_ERROR;
+    }
+    return BC_KIND_INT;
+}
+
+
+static BcKind compile_tern (BcCompiler* c, McExpr* e) {
+    // JZ takes any u64, only f64 needs to be made one
+    BcKind ckind = compile (c, e->tern.c);
+    if (!ckind || (ckind == BC_KIND_FLOAT && !emit (c, MC_OP_BOOL_F, NULL, 0, 0))) {
+        return BC_KIND_ERROR;
+    }
+
+    u64    skip_t = emit_jump (c, MC_OP_JZ, -1);
+    u64    depth  = c->depth;
+    BcKind tkind  = skip_t != (u64)-1 ? compile (c, e->tern.t) : BC_KIND_ERROR;
+    u64    skip_f = tkind ? emit_jump (c, MC_OP_JMP, 0) : (u64)-1;
+
+    // false side starts with stack as it was before true side
+    c->depth     = depth;
+    BcKind fkind = patch_jump (c, skip_t) ? compile (c, e->tern.f) : BC_KIND_ERROR;
+    if (!fkind) {
+        return BC_KIND_ERROR;
+    }
+
+    if (tkind == fkind) {
+        return patch_jump (c, skip_f) ? tkind : BC_KIND_ERROR;
+    }
+    if (tkind == BC_KIND_FLOAT) {
+        return to_float (c) && patch_jump (c, skip_f) ? BC_KIND_FLOAT : BC_KIND_ERROR;
+    }
+
+    // true side gave u64, it jumps to a conversion false side skips
+    u64 skip_conv = emit_jump (c, MC_OP_JMP, 0);
+    if (!patch_jump (c, skip_f) || !emit (c, MC_OP_I2F, NULL, 0, 0) || !patch_jump (c, skip_conv)) {
+        return BC_KIND_ERROR;
+    }
+    return BC_KIND_FLOAT;
+}
+
+
+static BcKind compile (BcCompiler* c, McExpr* e) {
+    if (!e) {
+        return push_i (c, 0);
+    }
+
+    switch (e->expr_type) {
+        case MC_EXPR_TYPE_ADD :
+            return compile_arith (c, e->add.l, e->add.r, MC_OP_ADD_F);
+        case MC_EXPR_TYPE_SUB :
+            return compile_arith (c, e->sub.l, e->sub.r, MC_OP_SUB_F);
+        case MC_EXPR_TYPE_MUL :
+            return compile_arith (c, e->mul.l, e->mul.r, MC_OP_MUL_F);
+        case MC_EXPR_TYPE_DIV :
+            return compile_arith (c, e->div.l, e->div.r, MC_OP_DIV_F);
+        case MC_EXPR_TYPE_AND :
+            return compile_bitwise (c, e->and.l, e->and.r, MC_OP_AND_I);
+        case MC_EXPR_TYPE_OR :
+            return compile_bitwise (c, e->or.l, e->or.r, MC_OP_OR_I);
+        case MC_EXPR_TYPE_XOR :
+            return compile_bitwise (c, e->xor.l, e->xor.r, MC_OP_XOR_I);
+        case MC_EXPR_TYPE_MOD :
+            return compile_bitwise (c, e->mod.l, e->mod.r, MC_OP_MOD_I);
+        case MC_EXPR_TYPE_SHR :
+            return compile_bitwise (c, e->shr.l, e->shr.r, MC_OP_SHR_I);
+        case MC_EXPR_TYPE_SHL :
+            return compile_bitwise (c, e->shl.l, e->shl.r, MC_OP_SHL_I);
+        case MC_EXPR_TYPE_LE :
+            return compile_compare (c, e->le.l, e->le.r, MC_OP_LE_I);
+        case MC_EXPR_TYPE_GE :
+            return compile_compare (c, e->ge.l, e->ge.r, MC_OP_GE_I);
+        case MC_EXPR_TYPE_LT :
+            return compile_compare (c, e->lt.l, e->lt.r, MC_OP_LT_I);
+        case MC_EXPR_TYPE_GT :
+            return compile_compare (c, e->gt.l, e->gt.r, MC_OP_GT_I);
+        case MC_EXPR_TYPE_EQ :
+            return compile_compare (c, e->eq.l, e->eq.r, MC_OP_EQ_I);
+        case MC_EXPR_TYPE_NE :
+            return compile_compare (c, e->ne.l, e->ne.r, MC_OP_NE_I);
+        case MC_EXPR_TYPE_LOG_AND :
+            return compile_logic (c, e->log_and.l, e->log_and.r, MC_OP_JZ_KEEP);
+        case MC_EXPR_TYPE_LOG_OR :
+            return compile_logic (c, e->log_or.l, e->log_or.r, MC_OP_JNZ_KEEP);
+        case MC_EXPR_TYPE_UN_PLUS :
+            return compile (c, e->un_plus.e);
+        case MC_EXPR_TYPE_UN_MINUS :
+            if (!compile_float (c, e->un_minus.e)) {
+                return BC_KIND_ERROR;
+            }
+            return emit (c, MC_OP_NEG_F, NULL, 0, 0) ? BC_KIND_FLOAT : BC_KIND_ERROR;
+        case MC_EXPR_TYPE_LOG_NOT : {
+            BcKind kind = compile (c, e->log_not.e);
+            if (!kind) {
+                return BC_KIND_ERROR;
+            }
+            McOpcode op = kind == BC_KIND_INT ? MC_OP_NOT_I : MC_OP_NOT_F;
+            return emit (c, op, NULL, 0, 0) ? BC_KIND_INT : BC_KIND_ERROR;
+        }
+        case MC_EXPR_TYPE_NOT :
+            // same as McExprEval
+            if (!compile_int (c, e->not.e)) {
+                return BC_KIND_ERROR;
+            }
+            return emit (c, MC_OP_NOT_I, NULL, 0, 0) ? BC_KIND_INT : BC_KIND_ERROR;
+        case MC_EXPR_TYPE_INC_PFX :
+            if (!compile_float (c, e->inc_pfx.e) || !push_f (c, 1)) {
+                return BC_KIND_ERROR;
+            }
+            return emit (c, MC_OP_ADD_F, NULL, 0, -1) ? BC_KIND_FLOAT : BC_KIND_ERROR;
+        case MC_EXPR_TYPE_DEC_PFX :
+            if (!compile_float (c, e->dec_pfx.e) || !push_f (c, 1)) {
+                return BC_KIND_ERROR;
+            }
+            return emit (c, MC_OP_SUB_F, NULL, 0, -1) ? BC_KIND_FLOAT : BC_KIND_ERROR;
+        case MC_EXPR_TYPE_INC_SFX :
+            return compile (c, e->inc_sfx.e);
+        case MC_EXPR_TYPE_DEC_SFX :
+            return compile (c, e->dec_sfx.e);
+        case MC_EXPR_TYPE_NUM :
+            return e->num.is_int ? push_i (c, e->num.i) : push_f (c, e->num.f);
+        case MC_EXPR_TYPE_TERN :
+            return compile_tern (c, e);
+        case MC_EXPR_TYPE_ID :
+            return load (c, &e->id);
+        case MC_EXPR_TYPE_CAST :
+            return compile (c, e->cast.e);
+        case MC_EXPR_TYPE_IN_PARENS :
+            return compile (c, e->in_parens.e);
+        case MC_EXPR_TYPE_LIST :
+            return e->list.length ? compile (c, VecLast (&e->list)) : push_i (c, 0);
+        default :
+            return push_i (c, 0);
+    }
+}
+
+
+McBytecode* McBytecodeCompile (McBytecode* bc, McExpr* expr) {
+    if (!bc || !expr) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    memset (bc, 0, sizeof (McBytecode));
+    VecInit (&bc->code, NULL, NULL);
+    VecInit (&bc->inputs, NULL, NULL);
+
+    BcCompiler c = {.bc = bc, .last = (u64)-1};
+    if (!compile_float (&c, expr) || !emit (&c, MC_OP_RET, NULL, 0, -1)) {
+        LOG_ERROR ("failed to compile expression.");
+        McBytecodeDeinit (bc);
+        return NULL;
+    }
+
+    return bc;
+}
+
+
+McBytecode* McBytecodeDeinit (McBytecode* bc) {
+    if (!bc) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    VecForeachPtr (&bc->inputs, name, { StrDeinit (name); });
+    VecDeinit (&bc->inputs);
+    VecDeinit (&bc->code);
+    memset (bc, 0, sizeof (McBytecode));
+
+    return bc;
+}
+
+
+u64 McBytecodeFindInput (const McBytecode* bc, const char* name) {
+    if (!bc || !name) {
+        LOG_ERROR ("invalid arguments.");
+        return (u64)-1;
+    }
+
+    u64 length = strlen (name);
+    for (u64 idx = 0; idx < bc->inputs.length; idx++) {
+        const Str* input = VecIter (&bc->inputs, idx);
+        if (input->length == length && !memcmp (input->data, name, length)) {
+            return idx;
+        }
+    }
+
+    return (u64)-1;
+}
+
+
+f64 McBytecodeEval (const McBytecode* bc, const f64* inputs) {
+    if (!bc || !bc->code.length || (!inputs && bc->inputs.length)) {
+        LOG_ERROR ("invalid arguments.");
+        return 0;
+    }
+
+    BcSlot  local[MC_BYTECODE_LOCAL_STACK];
+    BcSlot* stack = local;
+    if (bc->max_depth > MC_BYTECODE_LOCAL_STACK) {
+        stack = malloc (bc->max_depth * sizeof (BcSlot));
+        if (!stack) {
+            LOG_ERROR ("malloc() failed : %s.", strerror (errno));
+            return 0;
+        }
+    }
+
+    const u8* ip  = bc->code.data;
+    BcSlot*   sp  = stack; // one past top of stack
+    f64       ret = 0;
+    u64       i   = 0;
+    f64       f   = 0;
+    u32       idx = 0;
+    i32       off = 0;
+
+#if BYTECODE_THREADED
+    // every handler jumps to next one on it's own
+    static const void* const labels[MC_OP_MAX] = {
+        [MC_OP_RET]      = &&op_ret,
+        [MC_OP_PUSH_I]   = &&op_push_i,
+        [MC_OP_PUSH_F]   = &&op_push_f,
+        [MC_OP_LOAD]     = &&op_load,
+        [MC_OP_I2F]      = &&op_i2f,
+        [MC_OP_I2F_NOS]  = &&op_i2f_nos,
+        [MC_OP_F2I]      = &&op_f2i,
+        [MC_OP_BOOL_I]   = &&op_bool_i,
+        [MC_OP_BOOL_F]   = &&op_bool_f,
+        [MC_OP_ADD_F]    = &&op_add_f,
+        [MC_OP_SUB_F]    = &&op_sub_f,
+        [MC_OP_MUL_F]    = &&op_mul_f,
+        [MC_OP_DIV_F]    = &&op_div_f,
+        [MC_OP_NEG_F]    = &&op_neg_f,
+        [MC_OP_NOT_F]    = &&op_not_f,
+        [MC_OP_AND_I]    = &&op_and_i,
+        [MC_OP_OR_I]     = &&op_or_i,
+        [MC_OP_XOR_I]    = &&op_xor_i,
+        [MC_OP_MOD_I]    = &&op_mod_i,
+        [MC_OP_SHR_I]    = &&op_shr_i,
+        [MC_OP_SHL_I]    = &&op_shl_i,
+        [MC_OP_NOT_I]    = &&op_not_i,
+        [MC_OP_LE_I]     = &&op_le_i,
+        [MC_OP_GE_I]     = &&op_ge_i,
+        [MC_OP_LT_I]     = &&op_lt_i,
+        [MC_OP_GT_I]     = &&op_gt_i,
+        [MC_OP_EQ_I]     = &&op_eq_i,
+        [MC_OP_NE_I]     = &&op_ne_i,
+        [MC_OP_LE_F]     = &&op_le_f,
+        [MC_OP_GE_F]     = &&op_ge_f,
+        [MC_OP_LT_F]     = &&op_lt_f,
+        [MC_OP_GT_F]     = &&op_gt_f,
+        [MC_OP_EQ_F]     = &&op_eq_f,
+        [MC_OP_NE_F]     = &&op_ne_f,
+        [MC_OP_JMP]      = &&op_jmp,
+        [MC_OP_JZ]       = &&op_jz,
+        [MC_OP_JZ_KEEP]  = &&op_jz_keep,
+        [MC_OP_JNZ_KEEP] = &&op_jnz_keep,
+    };
+#    define OP(name, NAME) op_##name:
+#    define NEXT()         goto* labels[*ip++]
+    NEXT();
+#else
+#    define OP(name, NAME) case MC_OP_##NAME:
+#    define NEXT()         continue
+    for (;;) {
+        switch (*ip++) {
+#endif
+
+#define BINARY(name, NAME, field, result, operator)                                                \
+    OP (name, NAME) {                                                                              \
+        sp[-2].result = sp[-2].field operator sp[-1].field;                                        \
+        sp--;                                                                                      \
+        NEXT();                                                                                    \
+    }
+
+    OP (ret, RET) {
+        ret = sp[-1].f;
+        goto done;
+    }
+    OP (push_i, PUSH_I) {
+        memcpy (&i, ip, sizeof (i));
+        ip          += sizeof (i);
+        (sp++)->i    = i;
+        NEXT();
+    }
+    OP (push_f, PUSH_F) {
+        memcpy (&f, ip, sizeof (f));
+        ip          += sizeof (f);
+        (sp++)->f    = f;
+        NEXT();
+    }
+    OP (load, LOAD) {
+        memcpy (&idx, ip, sizeof (idx));
+        ip          += sizeof (idx);
+        (sp++)->f    = inputs[idx];
+        NEXT();
+    }
+    OP (i2f, I2F) {
+        sp[-1].f = sp[-1].i;
+        NEXT();
+    }
+    OP (i2f_nos, I2F_NOS) {
+        sp[-2].f = sp[-2].i;
+        NEXT();
+    }
+    OP (f2i, F2I) {
+        sp[-1].i = sp[-1].f;
+        NEXT();
+    }
+    OP (bool_i, BOOL_I) {
+        sp[-1].i = !!sp[-1].i;
+        NEXT();
+    }
+    OP (bool_f, BOOL_F) {
+        sp[-1].i = sp[-1].f != 0;
+        NEXT();
+    }
+    BINARY (add_f, ADD_F, f, f, +)
+    BINARY (sub_f, SUB_F, f, f, -)
+    BINARY (mul_f, MUL_F, f, f, *)
+    BINARY (div_f, DIV_F, f, f, /)
+    OP (neg_f, NEG_F) {
+        sp[-1].f = -sp[-1].f;
+        NEXT();
+    }
+    OP (not_f, NOT_F) {
+        sp[-1].i = !sp[-1].f;
+        NEXT();
+    }
+    BINARY (and_i, AND_I, i, i, &)
+    BINARY (or_i, OR_I, i, i, |)
+    BINARY (xor_i, XOR_I, i, i, ^)
+    BINARY (mod_i, MOD_I, i, i, %)
+    BINARY (shr_i, SHR_I, i, i, >>)
+    BINARY (shl_i, SHL_I, i, i, <<)
+    OP (not_i, NOT_I) {
+        sp[-1].i = !sp[-1].i;
+        NEXT();
+    }
+    BINARY (le_i, LE_I, i, i, <=)
+    BINARY (ge_i, GE_I, i, i, >=)
+    BINARY (lt_i, LT_I, i, i, <)
+    BINARY (gt_i, GT_I, i, i, >)
+    BINARY (eq_i, EQ_I, i, i, ==)
+    BINARY (ne_i, NE_I, i, i, !=)
+    BINARY (le_f, LE_F, f, i, <=)
+    BINARY (ge_f, GE_F, f, i, >=)
+    BINARY (lt_f, LT_F, f, i, <)
+    BINARY (gt_f, GT_F, f, i, >)
+    BINARY (eq_f, EQ_F, f, i, ==)
+    BINARY (ne_f, NE_F, f, i, !=)
+    OP (jmp, JMP) {
+        memcpy (&off, ip, sizeof (off));
+        ip += sizeof (off) + off;
+        NEXT();
+    }
+    OP (jz, JZ) {
+        memcpy (&off, ip, sizeof (off));
+        ip += sizeof (off) + ((--sp)->i ? 0 : off);
+        NEXT();
+    }
+    OP (jz_keep, JZ_KEEP) {
+        memcpy (&off, ip, sizeof (off));
+        ip += sizeof (off);
+        if (sp[-1].i) {
+            sp--;
+        } else {
+            ip += off;
+        }
+        NEXT();
+    }
+    OP (jnz_keep, JNZ_KEEP) {
+        memcpy (&off, ip, sizeof (off));
+        ip += sizeof (off);
+        if (sp[-1].i) {
+            ip += off;
+        } else {
+            sp--;
+        }
+        NEXT();
+    }
+
+#undef BINARY
+#undef OP
+#undef NEXT
+
+#if !BYTECODE_THREADED
+            default :
+                LOG_ERROR ("invalid opcode %u.", ip[-1]);
+                goto done;
+        }
+    }
+#endif
+
+done:
+    if (stack != local) {
+        free (stack);
+    }
+    return ret;
+}
@@ -0,0 +1,734 @@
+/// file      : misra/mc/vm/jit.c
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Translation of register code to x86-64 machine code.
+///
+/// Every register of register code has a slot of memory, pointed to by rdi,
+/// and every instruction becomes a few machine instructions that load it's
+/// operands, compute in rax (u64) or xmm0 (f64), and store result back to
+/// it's slot. Last value stored or loaded stays in rax and xmm0, and is
+/// not loaded again by next instruction, so chains of operations, which
+/// is most of what parser produces, run without going through memory.
+
+#include <Misra/Mc/Vm/Jit.h>
+#include <Misra/Std/Log.h>
+
+// platform
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#    include <sys/mman.h>
+#    include <unistd.h>
+#    define JIT_HAVE_X86_64 1
+#else
+#    define JIT_HAVE_X86_64 0
+#endif
+
+#if JIT_HAVE_X86_64
+
+typedef union JitSlot {
+    u64 i;
+    f64 f;
+} JitSlot;
+
+/// Native code takes registers, inputs first, and returns value of expression.
+typedef f64 (*JitFn) (JitSlot* r);
+
+// nothing cached in a machine register
+#define JIT_NONE ((u32)-1)
+
+// machine registers, by their number in encoding
+#define RAX  0
+#define RCX  1
+#define RDX  2
+#define RDI  7
+#define XMM0 0
+#define XMM1 1
+
+// condition codes, negated by flipping lowest bit
+typedef enum JitCond {
+    JIT_CC_B  = 0x2,
+    JIT_CC_AE = 0x3,
+    JIT_CC_E  = 0x4,
+    JIT_CC_NE = 0x5,
+    JIT_CC_BE = 0x6,
+    JIT_CC_A  = 0x7,
+    JIT_CC_S  = 0x8,
+    JIT_CC_P  = 0xa,
+    JIT_CC_NP = 0xb,
+} JitCond;
+
+// comparisons, in same order as in opcodes
+typedef enum JitCmp {
+    JIT_CMP_LE = 0,
+    JIT_CMP_GE,
+    JIT_CMP_LT,
+    JIT_CMP_GT,
+    JIT_CMP_EQ,
+    JIT_CMP_NE,
+} JitCmp;
+
+// condition true after `compare`, for u64 and for f64 operands
+static const JitCond int_cc[] = {JIT_CC_BE, JIT_CC_AE, JIT_CC_B, JIT_CC_A, JIT_CC_E, JIT_CC_NE};
+static const JitCond flt_cc[] = {JIT_CC_AE, JIT_CC_AE, JIT_CC_A, JIT_CC_A, JIT_CC_E, JIT_CC_NE};
+
+///
+/// A 32 bit field to fill in once all code is emitted : offset of a jump to
+/// an instruction, or of an access to a constant.
+///
+typedef struct JitFixup {
+    /// Offset of field in code.
+    u32 at;
+
+    /// Index of instruction or constant.
+    u32 to;
+} JitFixup;
+
+typedef Vec (JitFixup) JitFixupVec;
+
+///
+/// Source operand of an instruction : slot of a register, or a constant.
+///
+typedef struct JitSrc {
+    bool is_k;
+    u32  idx;
+} JitSrc;
+
+typedef struct JitAsm {
+    const McRegCode* rc;
+
+    McCodeVec   code;
+    JitFixupVec jumps;
+    JitFixupVec consts;
+
+    /// Register whose value rax and xmm0 hold, or JIT_NONE.
+    u32 cache_i;
+    u32 cache_f;
+
+    /// Set when anything fails to emit, checked once at end.
+    bool failed;
+} JitAsm;
+
+// constants code generator adds after those of register code
+#define JIT_K_TWO63(a) ((a)->rc->consts.length)
+#define JIT_K_SIGN(a)  ((a)->rc->consts.length + 1)
+#define JIT_NEXTRA_K   2
+
+static inline JitSrc src_reg (u32 r) {
+    return (JitSrc) {.is_k = false, .idx = r};
+}
+
+
+static inline JitSrc src_k (u32 k) {
+    return (JitSrc) {.is_k = true, .idx = k};
+}
+
+
+static void put (JitAsm* a, const u8* bytes, u64 size) {
+    if (!a->failed && !VecPushBackArr (&a->code, bytes, size)) {
+        LOG_ERROR ("failed to emit native code.");
+        a->failed = true;
+    }
+}
+
+#define PUT(a, ...) put ((a), (const u8[]) {__VA_ARGS__}, sizeof ((const u8[]) {__VA_ARGS__}))
+
+
+static void put32 (JitAsm* a, u32 v) {
+    put (a, (const u8*)&v, sizeof (v));
+}
+
+
+static void put64 (JitAsm* a, u64 v) {
+    put (a, (const u8*)&v, sizeof (v));
+}
+
+
+// Emit a zero 32 bit field, to be filled in later.
+static void put_fixup (JitAsm* a, JitFixupVec* fixups, u32 to) {
+    JitFixup f = {.at = a->code.length, .to = to};
+    if (!a->failed && !VecPushBack (fixups, &f)) {
+        LOG_ERROR ("failed to add fixup.");
+        a->failed = true;
+    }
+    put32 (a, 0);
+}
+
+
+///
+/// Emit ModRM byte and displacement of a memory operand. Constants are
+/// addressed relative to rip, which is only correct when their field is
+/// last thing in an instruction, as it is for all instructions here.
+///
+static void put_src (JitAsm* a, u8 reg, JitSrc src) {
+    if (src.is_k) {
+        PUT (a, 0x05 | reg << 3);
+        put_fixup (a, &a->consts, src.idx);
+        return;
+    }
+
+    u32 disp = src.idx * sizeof (JitSlot);
+    if (disp < 0x80) {
+        PUT (a, 0x40 | reg << 3 | RDI, disp);
+    } else {
+        PUT (a, 0x80 | reg << 3 | RDI);
+        put32 (a, disp);
+    }
+}
+
+
+static void load_i (JitAsm* a, u32 r) {
+    if (a->cache_i != r) {
+        PUT (a, 0x48, 0x8b); // mov rax, [r]
+        put_src (a, RAX, src_reg (r));
+        a->cache_i = r;
+    }
+}
+
+
+static void store_i (JitAsm* a, u32 d) {
+    PUT (a, 0x48, 0x89); // mov [d], rax
+    put_src (a, RAX, src_reg (d));
+    a->cache_i = d;
+    if (a->cache_f == d) {
+        a->cache_f = JIT_NONE;
+    }
+}
+
+
+static void load_f (JitAsm* a, u32 r) {
+    if (a->cache_f != r) {
+        PUT (a, 0xf2, 0x0f, 0x10); // movsd xmm0, [r]
+        put_src (a, XMM0, src_reg (r));
+        a->cache_f = r;
+    }
+}
+
+
+static void store_f (JitAsm* a, u32 d) {
+    PUT (a, 0xf2, 0x0f, 0x11); // movsd [d], xmm0
+    put_src (a, XMM0, src_reg (d));
+    a->cache_f = d;
+    if (a->cache_i == d) {
+        a->cache_i = JIT_NONE;
+    }
+}
+
+
+// Emit a short jump with given opcode, and return where it's offset ends.
+static u64 jump8 (JitAsm* a, u8 opcode) {
+    PUT (a, opcode, 0);
+    return a->code.length;
+}
+
+
+// Make short jump ending at `from` land at end of code.
+static void land8 (JitAsm* a, u64 from) {
+    if (!a->failed) {
+        a->code.data[from - 1] = a->code.length - from;
+    }
+}
+
+
+static void jmp_to (JitAsm* a, u32 target) {
+    PUT (a, 0xe9);
+    put_fixup (a, &a->jumps, target);
+}
+
+
+static void jcc_to (JitAsm* a, JitCond cc, u32 target) {
+    PUT (a, 0x0f, 0x80 | cc);
+    put_fixup (a, &a->jumps, target);
+}
+
+
+// xmm0 = rax, rounding same as a C compiler does for u64 to f64. Clobbers rax and rcx.
+static void int_to_float (JitAsm* a) {
+    PUT (a, 0x66, 0x0f, 0xef, 0xc0); // pxor xmm0, xmm0
+    PUT (a, 0x48, 0x85, 0xc0);       // test rax, rax
+    u64 big = jump8 (a, 0x70 | JIT_CC_S);
+    PUT (a, 0xf2, 0x48, 0x0f, 0x2a, 0xc0); // cvtsi2sd xmm0, rax
+    u64 done = jump8 (a, 0xeb);
+
+    // halve keeping lowest bit, so that rounding is right, and double back
+    land8 (a, big);
+    PUT (a, 0x48, 0x89, 0xc1);             // mov rcx, rax
+    PUT (a, 0x48, 0xd1, 0xe9);             // shr rcx, 1
+    PUT (a, 0x83, 0xe0, 0x01);             // and eax, 1
+    PUT (a, 0x48, 0x09, 0xc1);             // or rcx, rax
+    PUT (a, 0xf2, 0x48, 0x0f, 0x2a, 0xc1); // cvtsi2sd xmm0, rcx
+    PUT (a, 0xf2, 0x0f, 0x58, 0xc0);       // addsd xmm0, xmm0
+    land8 (a, done);
+
+    a->cache_i = JIT_NONE;
+    a->cache_f = JIT_NONE;
+}
+
+
+// rax = xmm0, same as a C compiler does for f64 to u64. Clobbers xmm1 and xmm2.
+static void float_to_int (JitAsm* a) {
+    PUT (a, 0xf2, 0x0f, 0x10); // movsd xmm1, [2^63]
+    put_src (a, XMM1, src_k (JIT_K_TWO63 (a)));
+    PUT (a, 0x66, 0x0f, 0x2f, 0xc1); // comisd xmm0, xmm1
+    u64 big = jump8 (a, 0x70 | JIT_CC_AE);
+    PUT (a, 0xf2, 0x48, 0x0f, 0x2c, 0xc0); // cvttsd2si rax, xmm0
+    u64 done = jump8 (a, 0xeb);
+
+    land8 (a, big);
+    PUT (a, 0x66, 0x0f, 0x28, 0xd0);       // movapd xmm2, xmm0
+    PUT (a, 0xf2, 0x0f, 0x5c, 0xd1);       // subsd xmm2, xmm1
+    PUT (a, 0xf2, 0x48, 0x0f, 0x2c, 0xc2); // cvttsd2si rax, xmm2
+    PUT (a, 0x48, 0x0f, 0xba, 0xf8, 0x3f); // btc rax, 63
+    land8 (a, done);
+
+    a->cache_i = JIT_NONE;
+}
+
+
+// Set flags by comparing register `ra` with `b`, so that `int_cc` or `flt_cc` tell result.
+static void compare (JitAsm* a, JitCmp cmp, bool is_float, u32 ra, JitSrc b) {
+    if (!is_float) {
+        load_i (a, ra);
+        PUT (a, 0x48, 0x3b); // cmp rax, b
+        put_src (a, RAX, b);
+        return;
+    }
+
+    // unordered operands set carry, so "<" and "<=" are tested as ">" and ">=" swapped
+    if (cmp == JIT_CMP_LE || cmp == JIT_CMP_LT) {
+        PUT (a, 0xf2, 0x0f, 0x10); // movsd xmm1, b
+        put_src (a, XMM1, b);
+        load_f (a, ra);
+        PUT (a, 0x66, 0x0f, 0x2e, 0xc8); // ucomisd xmm1, xmm0
+        return;
+    }
+
+    load_f (a, ra);
+    PUT (a, 0x66, 0x0f, 0x2e); // ucomisd xmm0, b
+    put_src (a, XMM0, b);
+}
+
+
+// Set flags by comparing f64 register `ra` with zero, as `compare` does.
+static void compare_zero (JitAsm* a, u32 ra) {
+    load_f (a, ra);
+    PUT (a, 0x66, 0x0f, 0x57, 0xc9); // xorpd xmm1, xmm1
+    PUT (a, 0x66, 0x0f, 0x2e, 0xc1); // ucomisd xmm0, xmm1
+}
+
+
+// Store u64 1 to `d` if comparison just done holds, else 0.
+static void set_on (JitAsm* a, JitCmp cmp, bool is_float, u32 d) {
+    if (is_float && cmp == JIT_CMP_EQ) {
+        PUT (a, 0x0f, 0x94, 0xc0); // sete al
+        PUT (a, 0x0f, 0x9b, 0xc1); // setnp cl
+        PUT (a, 0x20, 0xc8);       // and al, cl
+    } else if (is_float && cmp == JIT_CMP_NE) {
+        PUT (a, 0x0f, 0x95, 0xc0); // setne al
+        PUT (a, 0x0f, 0x9a, 0xc1); // setp cl
+        PUT (a, 0x08, 0xc8);       // or al, cl
+    } else {
+        PUT (a, 0x0f, 0x90 | (is_float ? flt_cc : int_cc)[cmp], 0xc0); // setcc al
+    }
+    PUT (a, 0x0f, 0xb6, 0xc0); // movzx eax, al
+
+    a->cache_i = JIT_NONE;
+    store_i (a, d);
+}
+
+
+// Jump to `target` if comparison just done holds (`when` is true) or doesn't.
+static void jump_on (JitAsm* a, JitCmp cmp, bool is_float, bool when, u32 target) {
+    if (is_float && (cmp == JIT_CMP_EQ || cmp == JIT_CMP_NE)) {
+        if ((cmp == JIT_CMP_EQ) == when) {
+            u64 skip = jump8 (a, 0x70 | JIT_CC_P);
+            jcc_to (a, JIT_CC_E, target);
+            land8 (a, skip);
+        } else {
+            jcc_to (a, JIT_CC_NE, target);
+            jcc_to (a, JIT_CC_P, target);
+        }
+        return;
+    }
+
+    JitCond cc = (is_float ? flt_cc : int_cc)[cmp];
+    jcc_to (a, when ? cc : cc ^ 1, target);
+}
+
+
+static void emit_insn (JitAsm* a, const McRegInsn* insn) {
+    McRegOp op = insn->op;
+    u32     d  = insn->d;
+    u32     ra = insn->a;
+    u32     rb = insn->b;
+
+    // comparisons, to a value or fused with a jump
+    if (op >= MC_REG_OP_LE_I && op <= MC_REG_OP_NE_F) {
+        JitCmp cmp = (op - MC_REG_OP_LE_I) % 6;
+        compare (a, cmp, op >= MC_REG_OP_LE_F, ra, src_reg (rb));
+        set_on (a, cmp, op >= MC_REG_OP_LE_F, d);
+        return;
+    }
+    if (op >= MC_REG_OP_LE_IK && op <= MC_REG_OP_NE_FK) {
+        JitCmp cmp = (op - MC_REG_OP_LE_IK) % 6;
+        compare (a, cmp, op >= MC_REG_OP_LE_FK, ra, src_k (rb));
+        set_on (a, cmp, op >= MC_REG_OP_LE_FK, d);
+        return;
+    }
+    if (op >= MC_REG_OP_JF_LE_I && op <= MC_REG_OP_JF_NE_FK) {
+        bool   is_k     = op >= MC_REG_OP_JF_LE_IK;
+        u32    idx      = op - (is_k ? MC_REG_OP_JF_LE_IK : MC_REG_OP_JF_LE_I);
+        JitCmp cmp      = idx % 6;
+        bool   is_float = idx >= 6;
+        compare (a, cmp, is_float, ra, is_k ? src_k (rb) : src_reg (rb));
+        jump_on (a, cmp, is_float, false, insn->target);
+        return;
+    }
+
+    switch (op) {
+        case MC_REG_OP_RET_F :
+            load_f (a, ra);
+            PUT (a, 0xc3); // ret
+            break;
+        case MC_REG_OP_RET_I :
+            load_i (a, ra);
+            int_to_float (a);
+            PUT (a, 0xc3); // ret
+            break;
+
+        case MC_REG_OP_MOV :
+            if (a->cache_f == ra) {
+                store_f (a, d);
+            } else {
+                load_i (a, ra);
+                store_i (a, d);
+            }
+            break;
+        case MC_REG_OP_MOV_K :
+            PUT (a, 0x48, 0xb8); // mov rax, imm64
+            put64 (a, a->rc->consts.data[rb]);
+            a->cache_i = JIT_NONE;
+            store_i (a, d);
+            break;
+        case MC_REG_OP_I2F :
+            load_i (a, ra);
+            int_to_float (a);
+            store_f (a, d);
+            break;
+        case MC_REG_OP_F2I :
+            load_f (a, ra);
+            float_to_int (a);
+            store_i (a, d);
+            break;
+        case MC_REG_OP_BOOL_I :
+        case MC_REG_OP_NOT_I :
+            load_i (a, ra);
+            PUT (a, 0x48, 0x85, 0xc0); // test rax, rax
+            set_on (a, op == MC_REG_OP_BOOL_I ? JIT_CMP_NE : JIT_CMP_EQ, false, d);
+            break;
+        case MC_REG_OP_BOOL_F :
+        case MC_REG_OP_NOT_F :
+            compare_zero (a, ra);
+            set_on (a, op == MC_REG_OP_BOOL_F ? JIT_CMP_NE : JIT_CMP_EQ, true, d);
+            break;
+        case MC_REG_OP_NEG_F :
+            load_f (a, ra);
+            PUT (a, 0xf2, 0x0f, 0x10); // movsd xmm1, [-0.0]
+            put_src (a, XMM1, src_k (JIT_K_SIGN (a)));
+            PUT (a, 0x66, 0x0f, 0x57, 0xc1); // xorpd xmm0, xmm1
+            a->cache_f = JIT_NONE;
+            store_f (a, d);
+            break;
+
+        case MC_REG_OP_ADD_F :
+        case MC_REG_OP_SUB_F :
+        case MC_REG_OP_MUL_F :
+        case MC_REG_OP_DIV_F :
+        case MC_REG_OP_ADD_FK :
+        case MC_REG_OP_SUB_FK :
+        case MC_REG_OP_MUL_FK :
+        case MC_REG_OP_DIV_FK : {
+            static const u8 sse[] = {0x58, 0x5c, 0x59, 0x5e};
+            bool            is_k  = op >= MC_REG_OP_ADD_FK;
+            load_f (a, ra);
+            PUT (a, 0xf2, 0x0f, sse[op - (is_k ? MC_REG_OP_ADD_FK : MC_REG_OP_ADD_F)]);
+            put_src (a, XMM0, is_k ? src_k (rb) : src_reg (rb));
+            a->cache_f = JIT_NONE;
+            store_f (a, d);
+            break;
+        }
+        case MC_REG_OP_RSUB_FK :
+        case MC_REG_OP_RDIV_FK :
+            PUT (a, 0xf2, 0x0f, 0x10); // movsd xmm0, k
+            put_src (a, XMM0, src_k (rb));
+            PUT (a, 0xf2, 0x0f, op == MC_REG_OP_RSUB_FK ? 0x5c : 0x5e);
+            put_src (a, XMM0, src_reg (ra));
+            a->cache_f = JIT_NONE;
+            store_f (a, d);
+            break;
+
+        case MC_REG_OP_AND_I :
+        case MC_REG_OP_OR_I :
+        case MC_REG_OP_XOR_I :
+        case MC_REG_OP_AND_IK :
+        case MC_REG_OP_OR_IK :
+        case MC_REG_OP_XOR_IK : {
+            static const u8 alu[] = {0x23, 0x0b, 0x33};
+            bool            is_k  = op >= MC_REG_OP_AND_IK;
+            load_i (a, ra);
+            PUT (a, 0x48, alu[op - (is_k ? MC_REG_OP_AND_IK : MC_REG_OP_AND_I)]);
+            put_src (a, RAX, is_k ? src_k (rb) : src_reg (rb));
+            a->cache_i = JIT_NONE;
+            store_i (a, d);
+            break;
+        }
+        case MC_REG_OP_MOD_I :
+        case MC_REG_OP_MOD_IK :
+            load_i (a, ra);
+            PUT (a, 0x31, 0xd2); // xor edx, edx
+            PUT (a, 0x48, 0xf7); // div b
+            put_src (a, 6, op == MC_REG_OP_MOD_IK ? src_k (rb) : src_reg (rb));
+            PUT (a, 0x48, 0x89, 0xd0); // mov rax, rdx
+            a->cache_i = JIT_NONE;
+            store_i (a, d);
+            break;
+        case MC_REG_OP_SHR_I :
+        case MC_REG_OP_SHL_I :
+            PUT (a, 0x48, 0x8b); // mov rcx, b
+            put_src (a, RCX, src_reg (rb));
+            load_i (a, ra);
+            PUT (a, 0x48, 0xd3, op == MC_REG_OP_SHR_I ? 0xe8 : 0xe0); // shr/shl rax, cl
+            a->cache_i = JIT_NONE;
+            store_i (a, d);
+            break;
+
+        // shifts count modulo 64 on x86-64, same as a count in cl does in interpreter
+        case MC_REG_OP_SHR_IK :
+        case MC_REG_OP_SHL_IK :
+            load_i (a, ra);
+            PUT (a, 0x48, 0xc1, op == MC_REG_OP_SHR_IK ? 0xe8 : 0xe0, a->rc->consts.data[rb] & 63);
+            a->cache_i = JIT_NONE;
+            store_i (a, d);
+            break;
+        case MC_REG_OP_SHR_AND_IK :
+        case MC_REG_OP_SHL_AND_IK :
+            load_i (a, ra);
+            PUT (a, 0x48, 0xc1, op == MC_REG_OP_SHR_AND_IK ? 0xe8 : 0xe0, insn->target & 63);
+            PUT (a, 0x48, 0x23); // and rax, k
+            put_src (a, RAX, src_k (rb));
+            a->cache_i = JIT_NONE;
+            store_i (a, d);
+            break;
+
+        case MC_REG_OP_JMP :
+            jmp_to (a, insn->target);
+            break;
+        case MC_REG_OP_JZ_I :
+        case MC_REG_OP_JNZ_I :
+            load_i (a, ra);
+            PUT (a, 0x48, 0x85, 0xc0); // test rax, rax
+            jump_on (a, op == MC_REG_OP_JZ_I ? JIT_CMP_EQ : JIT_CMP_NE, false, true, insn->target);
+            break;
+        case MC_REG_OP_JZ_F :
+        case MC_REG_OP_JNZ_F :
+            compare_zero (a, ra);
+            jump_on (a, op == MC_REG_OP_JZ_F ? JIT_CMP_EQ : JIT_CMP_NE, true, true, insn->target);
+            break;
+
+        default :
+            LOG_ERROR ("invalid opcode %u.", op);
+            a->failed = true;
+            break;
+    }
+}
+
+
+///
+/// Translate register code of `jit` and map it into executable memory.
+///
+/// SUCCESS : true, `jit->code` and `jit->size` set.
+/// FAILURE : false
+///
+static bool jit_translate (McJit* jit) {
+    const McRegCode* rc = &jit->rc;
+    u64              n  = rc->code.length;
+
+    JitAsm a = {.rc = rc, .cache_i = JIT_NONE, .cache_f = JIT_NONE};
+    VecInit (&a.code, NULL, NULL);
+    VecInit (&a.jumps, NULL, NULL);
+    VecInit (&a.consts, NULL, NULL);
+
+    u32* offsets = malloc (n * sizeof (u32));
+    u8*  targets = calloc (n, sizeof (u8));
+    void* mem    = MAP_FAILED;
+    u64   size   = 0;
+    bool  ok     = false;
+    if (!offsets || !targets) {
+        LOG_ERROR ("malloc() failed : %s.", strerror (errno));
+        goto done;
+    }
+
+    // values cached in machine registers are only known when falling into an instruction
+    for (u64 idx = 0; idx < n; idx++) {
+        const McRegInsn* insn = rc->code.data + idx;
+        bool             jump = insn->op == MC_REG_OP_JMP ||
+                    (insn->op >= MC_REG_OP_JZ_I && insn->op <= MC_REG_OP_JNZ_F) ||
+                    insn->op >= MC_REG_OP_JF_LE_I;
+        if (jump && insn->target < n) {
+            targets[insn->target] = 1;
+        }
+    }
+
+    for (u64 idx = 0; idx < n && !a.failed; idx++) {
+        const McRegInsn* insn = rc->code.data + idx;
+        if (targets[idx] || (idx && (insn[-1].op == MC_REG_OP_JMP))) {
+            a.cache_i = JIT_NONE;
+            a.cache_f = JIT_NONE;
+        }
+        offsets[idx] = a.code.length;
+        emit_insn (&a, insn);
+    }
+    if (a.failed) {
+        goto done;
+    }
+
+    // constants go right after code, 8 byte aligned
+    u64 pool  = (a.code.length + 7) & ~(u64)7;
+    u64 total = pool + (rc->consts.length + JIT_NEXTRA_K) * sizeof (u64);
+    u64 page  = sysconf (_SC_PAGESIZE);
+    size      = (total + page - 1) / page * page;
+
+    VecForeach (&a.jumps, f, {
+        if (f.to >= n) {
+            LOG_ERROR ("jump out of code.");
+            goto done;
+        }
+        i32 rel = (i64)offsets[f.to] - (i64)(f.at + sizeof (i32));
+        memcpy (a.code.data + f.at, &rel, sizeof (rel));
+    });
+    VecForeach (&a.consts, f, {
+        i32 rel = (i64)(pool + f.to * sizeof (u64)) - (i64)(f.at + sizeof (i32));
+        memcpy (a.code.data + f.at, &rel, sizeof (rel));
+    });
+
+    // written while only writable, then made only executable
+    mem = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        LOG_ERROR ("mmap() failed : %s.", strerror (errno));
+        goto done;
+    }
+
+    u64 extra[JIT_NEXTRA_K] = {0x43e0000000000000ULL, 0x8000000000000000ULL}; // 2^63, -0.0
+    memcpy (mem, a.code.data, a.code.length);
+    if (rc->consts.length) {
+        memcpy ((u8*)mem + pool, rc->consts.data, rc->consts.length * sizeof (u64));
+    }
+    memcpy ((u8*)mem + pool + rc->consts.length * sizeof (u64), extra, sizeof (extra));
+
+    if (mprotect (mem, size, PROT_READ | PROT_EXEC)) {
+        LOG_ERROR ("mprotect() failed : %s.", strerror (errno));
+        munmap (mem, size);
+        goto done;
+    }
+
+    jit->code = mem;
+    jit->size = size;
+    ok        = true;
+
+done:
+    free (offsets);
+    free (targets);
+    VecDeinit (&a.consts);
+    VecDeinit (&a.jumps);
+    VecDeinit (&a.code);
+    return ok;
+}
+
+#endif // JIT_HAVE_X86_64
+
+
+McJit* McJitCompile (McJit* jit, McExpr* expr) {
+    if (!jit || !expr) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    memset (jit, 0, sizeof (McJit));
+    if (!McRegCodeCompile (&jit->rc, expr)) {
+        LOG_ERROR ("failed to compile register code.");
+        return NULL;
+    }
+
+#if JIT_HAVE_X86_64
+    if (!jit_translate (jit)) {
+        LOG_ERROR ("failed to generate native code, expression will be interpreted.");
+    }
+#endif
+
+    return jit;
+}
+
+
+McJit* McJitDeinit (McJit* jit) {
+    if (!jit) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+#if JIT_HAVE_X86_64
+    if (jit->code) {
+        munmap (jit->code, jit->size);
+    }
+#endif
+    McRegCodeDeinit (&jit->rc);
+    memset (jit, 0, sizeof (McJit));
+
+    return jit;
+}
+
+
+u64 McJitFindInput (const McJit* jit, const char* name) {
+    if (!jit) {
+        LOG_ERROR ("invalid arguments.");
+        return (u64)-1;
+    }
+    return McRegCodeFindInput (&jit->rc, name);
+}
+
+
+f64 McJitEval (const McJit* jit, const f64* inputs) {
+    if (!jit || (!inputs && jit->rc.inputs.length)) {
+        LOG_ERROR ("invalid arguments.");
+        return 0;
+    }
+
+#if JIT_HAVE_X86_64
+    if (jit->code) {
+        const McRegCode* rc = &jit->rc;
+
+        JitSlot  local[MC_REG_LOCAL_REGS];
+        JitSlot* r = local;
+        if (rc->nregs > MC_REG_LOCAL_REGS) {
+            r = malloc (rc->nregs * sizeof (JitSlot));
+            if (!r) {
+                LOG_ERROR ("malloc() failed : %s.", strerror (errno));
+                return 0;
+            }
+        }
+        for (u64 idx = 0; idx < rc->inputs.length; idx++) {
+            r[idx].f = inputs[idx];
+        }
+
+        f64 ret = ((JitFn)jit->code) (r);
+        if (r != local) {
+            free (r);
+        }
+        return ret;
+    }
+#endif
+
+    return McRegCodeEval (&jit->rc, inputs);
+}
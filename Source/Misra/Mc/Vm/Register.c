@@ -0,0 +1,1096 @@
+/// file      : misra/mc/vm/register.c
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Register machine compiler and threaded interpreter for expressions.
+
+#include <Misra/Mc/Vm/Register.h>
+#include <Misra/Std/Log.h>
+
+// platform
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__)
+#    define REGISTER_THREADED 1
+#else
+#    define REGISTER_THREADED 0
+#endif
+
+// no register, and end of an empty chain of jumps
+#define REG_NONE ((u32)-1)
+
+// comparisons, in same order as in opcodes
+typedef enum RegCmp {
+    REG_CMP_LE = 0,
+    REG_CMP_GE,
+    REG_CMP_LT,
+    REG_CMP_GT,
+    REG_CMP_EQ,
+    REG_CMP_NE,
+} RegCmp;
+
+typedef enum RegKind {
+    REG_KIND_ERROR = 0,
+    REG_KIND_INT,
+    REG_KIND_FLOAT,
+} RegKind;
+
+typedef union RegSlot {
+    u64 i;
+    f64 f;
+} RegSlot;
+
+///
+/// Where value of a compiled subexpression is : a register, or a constant
+/// not loaded anywhere yet.
+///
+typedef struct RegVal {
+    RegKind kind;
+    bool    is_const;
+    u16     reg;
+    RegSlot k;
+} RegVal;
+
+static const RegVal reg_error = {0};
+
+typedef struct RegCompiler {
+    McRegCode* rc;
+} RegCompiler;
+
+// Chain of jumps to a place not known yet, threaded through their targets.
+typedef u32 RegLabel;
+
+static inline RegVal reg_val (RegKind kind, u16 reg) {
+    return (RegVal) {.kind = kind, .reg = reg};
+}
+
+
+static inline RegVal const_i (u64 i) {
+    return (RegVal) {.kind = REG_KIND_INT, .is_const = true, .k.i = i};
+}
+
+
+static inline RegVal const_f (f64 f) {
+    return (RegVal) {.kind = REG_KIND_FLOAT, .is_const = true, .k.f = f};
+}
+
+
+///
+/// Append an instruction.
+///
+/// c[in,out] : Compiler to emit into.
+/// op[in]    : Opcode.
+/// d[in]     : Destination register, ignored for jumps.
+/// a[in]     : First source register.
+/// b[in]     : Second source register, or index of constant.
+/// target[in] : Jump target, or shift amount.
+///
+/// SUCCESS : true
+/// FAILURE : false
+///
+static bool emit (RegCompiler* c, McRegOp op, u32 d, u32 a, u32 b, u32 target) {
+    if (d > 0xffff || a > 0xffff || b > 0xffff) {
+        LOG_ERROR ("expression needs too many registers or constants.");
+        return false;
+    }
+
+    McRegInsn insn = {.op = op, .d = d, .a = a, .b = b, .target = target};
+    if (!VecPushBack (&c->rc->code, &insn)) {
+        LOG_ERROR ("failed to emit instruction.");
+        return false;
+    }
+
+    bool jump = op == MC_REG_OP_JMP || (op >= MC_REG_OP_JZ_I && op <= MC_REG_OP_JNZ_F) ||
+                op >= MC_REG_OP_JF_LE_I;
+    if (!jump && op != MC_REG_OP_RET_F && op != MC_REG_OP_RET_I && d + 1 > c->rc->nregs) {
+        c->rc->nregs = d + 1;
+    }
+    return true;
+}
+
+
+// Add a constant to pool, and return it's index, or REG_NONE.
+static u32 add_const (RegCompiler* c, RegSlot k) {
+    if (!VecPushBack (&c->rc->consts, &k.i)) {
+        LOG_ERROR ("failed to add constant.");
+        return REG_NONE;
+    }
+    return c->rc->consts.length - 1;
+}
+
+
+static bool emit_k (RegCompiler* c, McRegOp op, u32 d, u32 a, RegSlot k, u32 target) {
+    u32 idx = add_const (c, k);
+    return idx != REG_NONE && emit (c, op, d, a, idx, target);
+}
+
+
+// Emit a jump to a place given later by `bind`.
+static bool emit_jump (RegCompiler* c, McRegOp op, u32 a, u32 b, RegLabel* label) {
+    if (!emit (c, op, 0, a, b, *label)) {
+        return false;
+    }
+    *label = c->rc->code.length - 1;
+    return true;
+}
+
+
+static bool emit_jump_k (RegCompiler* c, McRegOp op, u32 a, RegSlot k, RegLabel* label) {
+    u32 idx = add_const (c, k);
+    return idx != REG_NONE && emit_jump (c, op, a, idx, label);
+}
+
+
+// Make all jumps in chain land at end of code.
+static void bind (RegCompiler* c, RegLabel label) {
+    u32 here = c->rc->code.length;
+    while (label != REG_NONE) {
+        McRegInsn* insn = VecIter (&c->rc->code, label);
+        label           = insn->target;
+        insn->target    = here;
+    }
+}
+
+
+// Get value into a register, loading it into `d` if it's a constant.
+static RegVal to_reg (RegCompiler* c, RegVal v, u32 d) {
+    if (!v.kind || !v.is_const) {
+        return v;
+    }
+    return emit_k (c, MC_REG_OP_MOV_K, d, 0, v.k, 0) ? reg_val (v.kind, d) : reg_error;
+}
+
+
+// Get value into register `d`.
+static RegVal to_dest (RegCompiler* c, RegVal v, u32 d) {
+    if (!v.kind || (!v.is_const && v.reg == d)) {
+        return v;
+    }
+    if (v.is_const) {
+        return to_reg (c, v, d);
+    }
+    return emit (c, MC_REG_OP_MOV, d, v.reg, 0, 0) ? reg_val (v.kind, d) : reg_error;
+}
+
+
+static RegVal as_float (RegCompiler* c, RegVal v, u32 d) {
+    if (v.kind != REG_KIND_INT) {
+        return v;
+    }
+    if (v.is_const) {
+        return const_f (v.k.i);
+    }
+    return emit (c, MC_REG_OP_I2F, d, v.reg, 0, 0) ? reg_val (REG_KIND_FLOAT, d) : reg_error;
+}
+
+
+static RegVal as_int (RegCompiler* c, RegVal v, u32 d) {
+    if (v.kind != REG_KIND_FLOAT) {
+        return v;
+    }
+    if (v.is_const) {
+        return const_i (v.k.f);
+    }
+    return emit (c, MC_REG_OP_F2I, d, v.reg, 0, 0) ? reg_val (REG_KIND_INT, d) : reg_error;
+}
+
+
+static RegVal as_kind (RegCompiler* c, RegVal v, RegKind kind, u32 d) {
+    return kind == REG_KIND_INT ? as_int (c, v, d) : as_float (c, v, d);
+}
+
+
+// Skip parentheses, which compile to nothing.
+static inline McExpr* unparen (McExpr* e) {
+    while (e && e->expr_type == MC_EXPR_TYPE_IN_PARENS) {
+        e = e->in_parens.e;
+    }
+    return e;
+}
+
+
+static inline bool is_int_const (McExpr* e) {
+    return e && e->expr_type == MC_EXPR_TYPE_NUM && e->num.is_int;
+}
+
+
+///
+/// Add identifiers to inputs of register code, in same order as they're
+/// compiled, so that registers of inputs are known before temporaries.
+///
+static bool scan_inputs (RegCompiler* c, McExpr* e) {
+    if (!e) {
+        return true;
+    }
+
+    switch (e->expr_type) {
+        case MC_EXPR_TYPE_ADD :
+        case MC_EXPR_TYPE_SUB :
+        case MC_EXPR_TYPE_MUL :
+        case MC_EXPR_TYPE_DIV :
+        case MC_EXPR_TYPE_AND :
+        case MC_EXPR_TYPE_OR :
+        case MC_EXPR_TYPE_XOR :
+        case MC_EXPR_TYPE_MOD :
+        case MC_EXPR_TYPE_SHR :
+        case MC_EXPR_TYPE_SHL :
+        case MC_EXPR_TYPE_LE :
+        case MC_EXPR_TYPE_GE :
+        case MC_EXPR_TYPE_LT :
+        case MC_EXPR_TYPE_GT :
+        case MC_EXPR_TYPE_EQ :
+        case MC_EXPR_TYPE_NE :
+        case MC_EXPR_TYPE_LOG_AND :
+        case MC_EXPR_TYPE_LOG_OR :
+            // all binary operators share layout of `add`
+            return scan_inputs (c, e->add.l) && scan_inputs (c, e->add.r);
+        case MC_EXPR_TYPE_UN_PLUS :
+        case MC_EXPR_TYPE_UN_MINUS :
+        case MC_EXPR_TYPE_LOG_NOT :
+        case MC_EXPR_TYPE_NOT :
+        case MC_EXPR_TYPE_INC_PFX :
+        case MC_EXPR_TYPE_INC_SFX :
+        case MC_EXPR_TYPE_DEC_PFX :
+        case MC_EXPR_TYPE_DEC_SFX :
+        case MC_EXPR_TYPE_IN_PARENS :
+            // and unary ones that of `un_plus`
+            return scan_inputs (c, e->un_plus.e);
+        case MC_EXPR_TYPE_CAST :
+            return scan_inputs (c, e->cast.e);
+        case MC_EXPR_TYPE_TERN :
+            return scan_inputs (c, e->tern.c) && scan_inputs (c, e->tern.t) &&
+                   scan_inputs (c, e->tern.f);
+        case MC_EXPR_TYPE_LIST :
+            return !e->list.length || scan_inputs (c, VecLast (&e->list));
+        case MC_EXPR_TYPE_ID :
+            break;
+        default :
+            return true;
+    }
+
+    McInputVec* inputs = &c->rc->inputs;
+    VecForeachPtr (inputs, name, {
+        if (name->length == e->id.length && !memcmp (name->data, e->id.data, e->id.length)) {
+            return true;
+        }
+    });
+
+    Str name = {0};
+    if (!StrInitCopy (&name, &e->id) || !VecPushBack (inputs, &name)) {
+        LOG_ERROR ("failed to add input.");
+        StrDeinit (&name);
+        return false;
+    }
+    return true;
+}
+
+
+static RegVal load (RegCompiler* c, Str* id) {
+    for (u32 idx = 0; idx < c->rc->inputs.length; idx++) {
+        Str* name = VecIter (&c->rc->inputs, idx);
+        if (name->length == id->length && !memcmp (name->data, id->data, id->length)) {
+            return reg_val (REG_KIND_FLOAT, idx);
+        }
+    }
+
+    LOG_ERROR ("identifier not found in inputs.");
+    return reg_error;
+}
+
+
+static RegVal compile (RegCompiler* c, McExpr* e, u32 d);
+
+///
+/// Compile a binary operator on values of given kind.
+///
+/// c[in,out] : Compiler.
+/// l[in]     : Left operand.
+/// r[in]     : Right operand.
+/// d[in]     : Register to put result in.
+/// kind[in]  : Kind both operands are converted to, and of result.
+/// op[in]    : Opcode taking two registers. Opcode taking a constant
+///             instead of right one is at a fixed distance from it.
+/// rop[in]   : Opcode taking a constant instead of left one, 0 if none.
+///
+static RegVal compile_binary (
+    RegCompiler* c,
+    McExpr*      l,
+    McExpr*      r,
+    u32          d,
+    RegKind      kind,
+    McRegOp      op,
+    McRegOp      rop
+) {
+    McRegOp op_k = op + (MC_REG_OP_ADD_FK - MC_REG_OP_ADD_F);
+
+    RegVal lv = as_kind (c, compile (c, l, d), kind, d);
+    if (!lv.kind) {
+        return reg_error;
+    }
+
+    // right side mustn't overwrite left side
+    u32    rd = !lv.is_const && lv.reg == d ? d + 1 : d;
+    RegVal rv = as_kind (c, compile (c, r, rd), kind, rd);
+    if (!rv.kind) {
+        return reg_error;
+    }
+
+    if (lv.is_const && !rv.is_const && rop) {
+        return emit_k (c, rop, d, rv.reg, lv.k, 0) ? reg_val (kind, d) : reg_error;
+    }
+
+    lv = to_reg (c, lv, !rv.is_const && rv.reg == d ? d + 1 : d);
+    if (!lv.kind) {
+        return reg_error;
+    }
+    if (rv.is_const) {
+        return emit_k (c, op_k, d, lv.reg, rv.k, 0) ? reg_val (kind, d) : reg_error;
+    }
+    return emit (c, op, d, lv.reg, rv.reg, 0) ? reg_val (kind, d) : reg_error;
+}
+
+
+// "(x >> s) & m" and "m & (x << s)" with constant s and m, as a single instruction.
+static bool is_shift_and (McExpr* e, McExpr** shift, McExpr** mask) {
+    McExpr* l = unparen (e->and.l);
+    McExpr* r = unparen (e->and.r);
+    if (is_int_const (l)) {
+        McExpr* t = l;
+        l         = r;
+        r         = t;
+    }
+
+    if (!l || !is_int_const (r) ||
+        (l->expr_type != MC_EXPR_TYPE_SHR && l->expr_type != MC_EXPR_TYPE_SHL)) {
+        return false;
+    }
+
+    McExpr* amount = unparen (l->shr.r);
+    if (!is_int_const (amount) || amount->num.i >= 64) {
+        return false;
+    }
+
+    *shift = l;
+    *mask  = r;
+    return true;
+}
+
+
+static RegVal compile_shift_and (RegCompiler* c, McExpr* shift, McExpr* mask, u32 d) {
+    RegVal v = to_reg (c, as_int (c, compile (c, shift->shr.l, d), d), d);
+    if (!v.kind) {
+        return reg_error;
+    }
+
+    McRegOp op     = shift->expr_type == MC_EXPR_TYPE_SHR ? MC_REG_OP_SHR_AND_IK :
+                                                            MC_REG_OP_SHL_AND_IK;
+    u32     amount = unparen (shift->shr.r)->num.i;
+    RegSlot k      = {.i = mask->num.i};
+    return emit_k (c, op, d, v.reg, k, amount) ? reg_val (REG_KIND_INT, d) : reg_error;
+}
+
+
+///
+/// Compile both sides of a comparison, and convert them to a common kind.
+///
+/// SUCCESS : Kind both sides are compared as, `lv` and `rv` set.
+/// FAILURE : REG_KIND_ERROR
+///
+static RegKind compile_compare_sides (
+    RegCompiler* c,
+    McExpr*      l,
+    McExpr*      r,
+    u32          d,
+    RegVal*      lv,
+    RegVal*      rv
+) {
+    *lv = compile (c, l, d);
+    if (!lv->kind) {
+        return REG_KIND_ERROR;
+    }
+
+    u32 rd = !lv->is_const && lv->reg == d ? d + 1 : d;
+    *rv    = compile (c, r, rd);
+    if (!rv->kind) {
+        return REG_KIND_ERROR;
+    }
+
+    if (lv->kind == rv->kind) {
+        return lv->kind;
+    }
+
+    // only temporaries hold u64, so left side is in `d` if it's not a constant
+    *lv = as_float (c, *lv, d);
+    *rv = as_float (c, *rv, rd);
+    return lv->kind && rv->kind ? REG_KIND_FLOAT : REG_KIND_ERROR;
+}
+
+
+// Comparison with sides swapped.
+static inline RegCmp cmp_swap (RegCmp cmp) {
+    static const RegCmp swapped[] = {REG_CMP_GE, REG_CMP_LE, REG_CMP_GT, REG_CMP_LT, REG_CMP_EQ, REG_CMP_NE};
+    return swapped[cmp];
+}
+
+
+// Opposite comparison, exact only for u64.
+static inline RegCmp cmp_negate (RegCmp cmp) {
+    static const RegCmp negated[] = {REG_CMP_GT, REG_CMP_LT, REG_CMP_GE, REG_CMP_LE, REG_CMP_NE, REG_CMP_EQ};
+    return negated[cmp];
+}
+
+
+///
+/// Put comparison sides in order for a register and register, or register
+/// and constant instruction.
+///
+/// SUCCESS : true, and whether right side is a constant in `with_k`.
+/// FAILURE : false
+///
+static bool order_compare (RegCompiler* c, RegCmp* cmp, RegVal* lv, RegVal* rv, u32 d, bool* with_k) {
+    if (lv->is_const && !rv->is_const) {
+        RegVal t = *lv;
+        *lv      = *rv;
+        *rv      = t;
+        *cmp     = cmp_swap (*cmp);
+    }
+
+    *lv = to_reg (c, *lv, !rv->is_const && rv->reg == d ? d + 1 : d);
+    *with_k = rv->is_const;
+    return lv->kind;
+}
+
+
+static RegVal compile_compare (RegCompiler* c, McExpr* l, McExpr* r, RegCmp cmp, u32 d) {
+    RegVal  lv   = {0};
+    RegVal  rv   = {0};
+    RegKind kind = compile_compare_sides (c, l, r, d, &lv, &rv);
+    bool    with_k;
+    if (!kind || !order_compare (c, &cmp, &lv, &rv, d, &with_k)) {
+        return reg_error;
+    }
+
+    McRegOp op = (kind == REG_KIND_INT ? MC_REG_OP_LE_I : MC_REG_OP_LE_F) + cmp;
+    if (with_k) {
+        op += MC_REG_OP_ADD_FK - MC_REG_OP_ADD_F;
+        return emit_k (c, op, d, lv.reg, rv.k, 0) ? reg_val (REG_KIND_INT, d) : reg_error;
+    }
+    return emit (c, op, d, lv.reg, rv.reg, 0) ? reg_val (REG_KIND_INT, d) : reg_error;
+}
+
+
+static inline bool is_compare (McExprType type) {
+    return type >= MC_EXPR_TYPE_LE && type <= MC_EXPR_TYPE_NE;
+}
+
+
+static inline RegCmp compare_of (McExprType type) {
+    static const RegCmp cmps[] = {REG_CMP_LE, REG_CMP_GE, REG_CMP_LT, REG_CMP_GT, REG_CMP_EQ, REG_CMP_NE};
+    return cmps[type - MC_EXPR_TYPE_LE];
+}
+
+
+///
+/// Compile a condition into jumps, without computing it's value where
+/// possible.
+///
+/// c[in,out]     : Compiler.
+/// e[in]         : Condition.
+/// label[in,out] : Chain of jumps to add jump to.
+/// jump_if[in]   : Whether to jump when condition is true or when false.
+/// d[in]         : First free register.
+///
+/// SUCCESS : true
+/// FAILURE : false
+///
+static bool compile_cond (RegCompiler* c, McExpr* e, RegLabel* label, bool jump_if, u32 d) {
+    e = unparen (e);
+
+    if (e && is_compare (e->expr_type)) {
+        RegCmp  cmp  = compare_of (e->expr_type);
+        RegVal  lv   = {0};
+        RegVal  rv   = {0};
+        RegKind kind = compile_compare_sides (c, e->le.l, e->le.r, d, &lv, &rv);
+        bool    with_k;
+        if (!kind || !order_compare (c, &cmp, &lv, &rv, d, &with_k)) {
+            return false;
+        }
+
+        // jump if true is jump if opposite is false, but not for NaN, where
+        // f64 jumps over a jump instead
+        RegLabel skip = REG_NONE;
+        RegLabel* jf  = label;
+        if (jump_if && kind == REG_KIND_INT) {
+            cmp = cmp_negate (cmp);
+        } else if (jump_if) {
+            jf = &skip;
+        }
+
+        McRegOp op = (kind == REG_KIND_INT ? MC_REG_OP_JF_LE_I : MC_REG_OP_JF_LE_F) + cmp;
+        bool    ok = with_k ? emit_jump_k (c, op + (MC_REG_OP_JF_LE_IK - MC_REG_OP_JF_LE_I), lv.reg, rv.k, jf) :
+                              emit_jump (c, op, lv.reg, rv.reg, jf);
+        if (ok && jf == &skip) {
+            ok = emit_jump (c, MC_REG_OP_JMP, 0, 0, label);
+            bind (c, skip);
+        }
+        return ok;
+    }
+
+    if (e && (e->expr_type == MC_EXPR_TYPE_LOG_AND || e->expr_type == MC_EXPR_TYPE_LOG_OR)) {
+        // "&&" jumps if false when either side is, "||" jumps if true when
+        // either side is, else left side decides whether to go on to right
+        bool     is_and = e->expr_type == MC_EXPR_TYPE_LOG_AND;
+        RegLabel skip   = REG_NONE;
+        bool     ok     = is_and != jump_if ? compile_cond (c, e->log_and.l, label, jump_if, d) :
+                                              compile_cond (c, e->log_and.l, &skip, !jump_if, d);
+        ok              = ok && compile_cond (c, e->log_and.r, label, jump_if, d);
+        bind (c, skip);
+        return ok;
+    }
+
+    if (e && e->expr_type == MC_EXPR_TYPE_LOG_NOT) {
+        return compile_cond (c, e->log_not.e, label, !jump_if, d);
+    }
+
+    RegVal v = compile (c, e, d);
+    if (!v.kind) {
+        return false;
+    }
+
+    if (v.is_const) {
+        bool truth = v.kind == REG_KIND_INT ? v.k.i != 0 : v.k.f != 0;
+        return truth != jump_if || emit_jump (c, MC_REG_OP_JMP, 0, 0, label);
+    }
+
+    McRegOp op = jump_if ? MC_REG_OP_JNZ_I : MC_REG_OP_JZ_I;
+    return emit_jump (c, op + (v.kind == REG_KIND_FLOAT), v.reg, 0, label);
+}
+
+
+// Value of "&&", "||" or "!", as u64 0 or 1.
+static RegVal compile_bool_value (RegCompiler* c, McExpr* e, u32 d) {
+    RegLabel is_false = REG_NONE;
+    if (!to_reg (c, const_i (0), d).kind || !compile_cond (c, e, &is_false, false, d + 1) ||
+        !to_reg (c, const_i (1), d).kind) {
+        return reg_error;
+    }
+    bind (c, is_false);
+    return reg_val (REG_KIND_INT, d);
+}
+
+
+static RegVal compile_tern (RegCompiler* c, McExpr* e, u32 d) {
+    RegLabel is_false = REG_NONE;
+    RegLabel done     = REG_NONE;
+    RegLabel convert  = REG_NONE;
+
+    if (!compile_cond (c, e->tern.c, &is_false, false, d)) {
+        return reg_error;
+    }
+
+    RegVal tv = to_dest (c, compile (c, e->tern.t, d), d);
+    if (!tv.kind || !emit_jump (c, MC_REG_OP_JMP, 0, 0, &done)) {
+        return reg_error;
+    }
+
+    bind (c, is_false);
+    RegVal fv = compile (c, e->tern.f, d);
+    if (fv.kind && tv.kind == REG_KIND_FLOAT) {
+        fv = as_float (c, fv, d);
+    }
+    fv = to_dest (c, fv, d);
+    if (!fv.kind) {
+        return reg_error;
+    }
+
+    if (tv.kind == fv.kind) {
+        bind (c, done);
+        return fv;
+    }
+
+    // true side gave u64, it jumps to a conversion false side skips
+    if (!emit_jump (c, MC_REG_OP_JMP, 0, 0, &convert)) {
+        return reg_error;
+    }
+    bind (c, done);
+    if (!emit (c, MC_REG_OP_I2F, d, d, 0, 0)) {
+        return reg_error;
+    }
+    bind (c, convert);
+    return reg_val (REG_KIND_FLOAT, d);
+}
+
+
+// Unary operator taking and giving given kinds.
+static RegVal compile_unary (RegCompiler* c, McExpr* e, u32 d, RegKind from, McRegOp op, RegKind to) {
+    RegVal v = to_reg (c, as_kind (c, compile (c, e, d), from, d), d);
+    if (!v.kind) {
+        return reg_error;
+    }
+    return emit (c, op, d, v.reg, 0, 0) ? reg_val (to, d) : reg_error;
+}
+
+
+///
+/// Compile expression, with `d` as first register free to use.
+///
+/// SUCCESS : Where value is, either `d`, a register of an input, or a constant.
+/// FAILURE : `reg_error`
+///
+static RegVal compile (RegCompiler* c, McExpr* e, u32 d) {
+    if (!e) {
+        return const_i (0);
+    }
+
+    switch (e->expr_type) {
+        case MC_EXPR_TYPE_ADD :
+            return compile_binary (c, e->add.l, e->add.r, d, REG_KIND_FLOAT, MC_REG_OP_ADD_F, MC_REG_OP_ADD_FK);
+        case MC_EXPR_TYPE_SUB :
+            return compile_binary (c, e->sub.l, e->sub.r, d, REG_KIND_FLOAT, MC_REG_OP_SUB_F, MC_REG_OP_RSUB_FK);
+        case MC_EXPR_TYPE_MUL :
+            return compile_binary (c, e->mul.l, e->mul.r, d, REG_KIND_FLOAT, MC_REG_OP_MUL_F, MC_REG_OP_MUL_FK);
+        case MC_EXPR_TYPE_DIV :
+            return compile_binary (c, e->div.l, e->div.r, d, REG_KIND_FLOAT, MC_REG_OP_DIV_F, MC_REG_OP_RDIV_FK);
+        case MC_EXPR_TYPE_AND : {
+            McExpr* shift = NULL;
+            McExpr* mask  = NULL;
+            if (is_shift_and (e, &shift, &mask)) {
+                return compile_shift_and (c, shift, mask, d);
+            }
+            return compile_binary (c, e->and.l, e->and.r, d, REG_KIND_INT, MC_REG_OP_AND_I, MC_REG_OP_AND_IK);
+        }
+        case MC_EXPR_TYPE_OR :
+            return compile_binary (c, e->or.l, e->or.r, d, REG_KIND_INT, MC_REG_OP_OR_I, MC_REG_OP_OR_IK);
+        case MC_EXPR_TYPE_XOR :
+            return compile_binary (c, e->xor.l, e->xor.r, d, REG_KIND_INT, MC_REG_OP_XOR_I, MC_REG_OP_XOR_IK);
+        case MC_EXPR_TYPE_MOD :
+            return compile_binary (c, e->mod.l, e->mod.r, d, REG_KIND_INT, MC_REG_OP_MOD_I, 0);
+        case MC_EXPR_TYPE_SHR :
+            return compile_binary (c, e->shr.l, e->shr.r, d, REG_KIND_INT, MC_REG_OP_SHR_I, 0);
+        case MC_EXPR_TYPE_SHL :
+            return compile_binary (c, e->shl.l, e->shl.r, d, REG_KIND_INT, MC_REG_OP_SHL_I, 0);
+        case MC_EXPR_TYPE_LE :
+            return compile_compare (c, e->le.l, e->le.r, REG_CMP_LE, d);
+        case MC_EXPR_TYPE_GE :
+            return compile_compare (c, e->ge.l, e->ge.r, REG_CMP_GE, d);
+        case MC_EXPR_TYPE_LT :
+            return compile_compare (c, e->lt.l, e->lt.r, REG_CMP_LT, d);
+        case MC_EXPR_TYPE_GT :
+            return compile_compare (c, e->gt.l, e->gt.r, REG_CMP_GT, d);
+        case MC_EXPR_TYPE_EQ :
+            return compile_compare (c, e->eq.l, e->eq.r, REG_CMP_EQ, d);
+        case MC_EXPR_TYPE_NE :
+            return compile_compare (c, e->ne.l, e->ne.r, REG_CMP_NE, d);
+        case MC_EXPR_TYPE_LOG_AND :
+        case MC_EXPR_TYPE_LOG_OR :
+            return compile_bool_value (c, e, d);
+        case MC_EXPR_TYPE_UN_PLUS :
+            return compile (c, e->un_plus.e, d);
+        case MC_EXPR_TYPE_UN_MINUS :
+            return compile_unary (c, e->un_minus.e, d, REG_KIND_FLOAT, MC_REG_OP_NEG_F, REG_KIND_FLOAT);
+        case MC_EXPR_TYPE_LOG_NOT : {
+            RegVal v = to_reg (c, compile (c, e->log_not.e, d), d);
+            if (!v.kind) {
+                return reg_error;
+            }
+            McRegOp op = v.kind == REG_KIND_INT ? MC_REG_OP_NOT_I : MC_REG_OP_NOT_F;
+            return emit (c, op, d, v.reg, 0, 0) ? reg_val (REG_KIND_INT, d) : reg_error;
+        }
+        case MC_EXPR_TYPE_NOT :
+            // same as McExprEval
+            return compile_unary (c, e->not.e, d, REG_KIND_INT, MC_REG_OP_NOT_I, REG_KIND_INT);
+        case MC_EXPR_TYPE_INC_PFX : {
+            RegVal v = to_reg (c, as_float (c, compile (c, e->inc_pfx.e, d), d), d);
+            if (!v.kind) {
+                return reg_error;
+            }
+            return emit_k (c, MC_REG_OP_ADD_FK, d, v.reg, const_f (1).k, 0) ? reg_val (REG_KIND_FLOAT, d) :
+                                                                               reg_error;
+        }
+        case MC_EXPR_TYPE_DEC_PFX : {
+            RegVal v = to_reg (c, as_float (c, compile (c, e->dec_pfx.e, d), d), d);
+            if (!v.kind) {
+                return reg_error;
+            }
+            return emit_k (c, MC_REG_OP_SUB_FK, d, v.reg, const_f (1).k, 0) ? reg_val (REG_KIND_FLOAT, d) :
+                                                                               reg_error;
+        }
+        case MC_EXPR_TYPE_INC_SFX :
+            return compile (c, e->inc_sfx.e, d);
+        case MC_EXPR_TYPE_DEC_SFX :
+            return compile (c, e->dec_sfx.e, d);
+        case MC_EXPR_TYPE_NUM :
+            return e->num.is_int ? const_i (e->num.i) : const_f (e->num.f);
+        case MC_EXPR_TYPE_TERN :
+            return compile_tern (c, e, d);
+        case MC_EXPR_TYPE_ID :
+            return load (c, &e->id);
+        case MC_EXPR_TYPE_CAST :
+            return compile (c, e->cast.e, d);
+        case MC_EXPR_TYPE_IN_PARENS :
+            return compile (c, e->in_parens.e, d);
+        case MC_EXPR_TYPE_LIST :
+            return e->list.length ? compile (c, VecLast (&e->list), d) : const_i (0);
+        default :
+            return const_i (0);
+    }
+}
+
+
+McRegCode* McRegCodeCompile (McRegCode* rc, McExpr* expr) {
+    if (!rc || !expr) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    memset (rc, 0, sizeof (McRegCode));
+    VecInit (&rc->code, NULL, NULL);
+    VecInit (&rc->consts, NULL, NULL);
+    VecInit (&rc->inputs, NULL, NULL);
+
+    RegCompiler c = {.rc = rc};
+    if (!scan_inputs (&c, expr)) {
+        McRegCodeDeinit (rc);
+        return NULL;
+    }
+    rc->nregs = rc->inputs.length;
+
+    RegVal v = to_reg (&c, compile (&c, expr, rc->inputs.length), rc->inputs.length);
+    if (!v.kind ||
+        !emit (&c, v.kind == REG_KIND_INT ? MC_REG_OP_RET_I : MC_REG_OP_RET_F, 0, v.reg, 0, 0)) {
+        LOG_ERROR ("failed to compile expression.");
+        McRegCodeDeinit (rc);
+        return NULL;
+    }
+
+    return rc;
+}
+
+
+McRegCode* McRegCodeDeinit (McRegCode* rc) {
+    if (!rc) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    VecForeachPtr (&rc->inputs, name, { StrDeinit (name); });
+    VecDeinit (&rc->inputs);
+    VecDeinit (&rc->consts);
+    VecDeinit (&rc->code);
+    memset (rc, 0, sizeof (McRegCode));
+
+    return rc;
+}
+
+
+u64 McRegCodeFindInput (const McRegCode* rc, const char* name) {
+    if (!rc || !name) {
+        LOG_ERROR ("invalid arguments.");
+        return (u64)-1;
+    }
+
+    u64 length = strlen (name);
+    for (u64 idx = 0; idx < rc->inputs.length; idx++) {
+        const Str* input = VecIter (&rc->inputs, idx);
+        if (input->length == length && !memcmp (input->data, name, length)) {
+            return idx;
+        }
+    }
+
+    return (u64)-1;
+}
+
+
+///
+/// Interpreter shared by `McRegCodeEval` and `McRegCodeEvalCounted`.
+/// Counting costs nothing when not asked for : it only switches dispatch
+/// to a table that sends every instruction through a counting stub first.
+///
+static f64 reg_eval (const McRegCode* rc, const f64* inputs, McRegStats* stats) {
+    if (!rc || !rc->code.length || (!inputs && rc->inputs.length)) {
+        LOG_ERROR ("invalid arguments.");
+        return 0;
+    }
+
+    RegSlot  local[MC_REG_LOCAL_REGS];
+    RegSlot* r = local;
+    if (rc->nregs > MC_REG_LOCAL_REGS) {
+        r = malloc (rc->nregs * sizeof (RegSlot));
+        if (!r) {
+            LOG_ERROR ("malloc() failed : %s.", strerror (errno));
+            return 0;
+        }
+    }
+    for (u64 idx = 0; idx < rc->inputs.length; idx++) {
+        r[idx].f = inputs[idx];
+    }
+
+    const McRegInsn* code = rc->code.data;
+    const RegSlot*   k    = (const RegSlot*)rc->consts.data;
+    const McRegInsn* ip   = code;
+    f64              ret  = 0;
+
+#define COUNT()                                                                                    \
+    do {                                                                                           \
+        stats->ninsns++;                                                                           \
+        stats->nsuper += ip->op >= MC_REG_OP_FIRST_SUPER;                                          \
+    } while (0)
+
+#if REGISTER_THREADED
+    static const void* const labels[MC_REG_OP_MAX] = {
+        [MC_REG_OP_RET_F]      = &&op_RET_F,
+        [MC_REG_OP_RET_I]      = &&op_RET_I,
+        [MC_REG_OP_MOV]        = &&op_MOV,
+        [MC_REG_OP_MOV_K]      = &&op_MOV_K,
+        [MC_REG_OP_I2F]        = &&op_I2F,
+        [MC_REG_OP_F2I]        = &&op_F2I,
+        [MC_REG_OP_BOOL_I]     = &&op_BOOL_I,
+        [MC_REG_OP_BOOL_F]     = &&op_BOOL_F,
+        [MC_REG_OP_NEG_F]      = &&op_NEG_F,
+        [MC_REG_OP_NOT_I]      = &&op_NOT_I,
+        [MC_REG_OP_NOT_F]      = &&op_NOT_F,
+        [MC_REG_OP_ADD_F]      = &&op_ADD_F,
+        [MC_REG_OP_SUB_F]      = &&op_SUB_F,
+        [MC_REG_OP_MUL_F]      = &&op_MUL_F,
+        [MC_REG_OP_DIV_F]      = &&op_DIV_F,
+        [MC_REG_OP_AND_I]      = &&op_AND_I,
+        [MC_REG_OP_OR_I]       = &&op_OR_I,
+        [MC_REG_OP_XOR_I]      = &&op_XOR_I,
+        [MC_REG_OP_MOD_I]      = &&op_MOD_I,
+        [MC_REG_OP_SHR_I]      = &&op_SHR_I,
+        [MC_REG_OP_SHL_I]      = &&op_SHL_I,
+        [MC_REG_OP_LE_I]       = &&op_LE_I,
+        [MC_REG_OP_GE_I]       = &&op_GE_I,
+        [MC_REG_OP_LT_I]       = &&op_LT_I,
+        [MC_REG_OP_GT_I]       = &&op_GT_I,
+        [MC_REG_OP_EQ_I]       = &&op_EQ_I,
+        [MC_REG_OP_NE_I]       = &&op_NE_I,
+        [MC_REG_OP_LE_F]       = &&op_LE_F,
+        [MC_REG_OP_GE_F]       = &&op_GE_F,
+        [MC_REG_OP_LT_F]       = &&op_LT_F,
+        [MC_REG_OP_GT_F]       = &&op_GT_F,
+        [MC_REG_OP_EQ_F]       = &&op_EQ_F,
+        [MC_REG_OP_NE_F]       = &&op_NE_F,
+        [MC_REG_OP_JMP]        = &&op_JMP,
+        [MC_REG_OP_JZ_I]       = &&op_JZ_I,
+        [MC_REG_OP_JZ_F]       = &&op_JZ_F,
+        [MC_REG_OP_JNZ_I]      = &&op_JNZ_I,
+        [MC_REG_OP_JNZ_F]      = &&op_JNZ_F,
+        [MC_REG_OP_ADD_FK]     = &&op_ADD_FK,
+        [MC_REG_OP_SUB_FK]     = &&op_SUB_FK,
+        [MC_REG_OP_MUL_FK]     = &&op_MUL_FK,
+        [MC_REG_OP_DIV_FK]     = &&op_DIV_FK,
+        [MC_REG_OP_AND_IK]     = &&op_AND_IK,
+        [MC_REG_OP_OR_IK]      = &&op_OR_IK,
+        [MC_REG_OP_XOR_IK]     = &&op_XOR_IK,
+        [MC_REG_OP_MOD_IK]     = &&op_MOD_IK,
+        [MC_REG_OP_SHR_IK]     = &&op_SHR_IK,
+        [MC_REG_OP_SHL_IK]     = &&op_SHL_IK,
+        [MC_REG_OP_LE_IK]      = &&op_LE_IK,
+        [MC_REG_OP_GE_IK]      = &&op_GE_IK,
+        [MC_REG_OP_LT_IK]      = &&op_LT_IK,
+        [MC_REG_OP_GT_IK]      = &&op_GT_IK,
+        [MC_REG_OP_EQ_IK]      = &&op_EQ_IK,
+        [MC_REG_OP_NE_IK]      = &&op_NE_IK,
+        [MC_REG_OP_LE_FK]      = &&op_LE_FK,
+        [MC_REG_OP_GE_FK]      = &&op_GE_FK,
+        [MC_REG_OP_LT_FK]      = &&op_LT_FK,
+        [MC_REG_OP_GT_FK]      = &&op_GT_FK,
+        [MC_REG_OP_EQ_FK]      = &&op_EQ_FK,
+        [MC_REG_OP_NE_FK]      = &&op_NE_FK,
+        [MC_REG_OP_RSUB_FK]    = &&op_RSUB_FK,
+        [MC_REG_OP_RDIV_FK]    = &&op_RDIV_FK,
+        [MC_REG_OP_SHR_AND_IK] = &&op_SHR_AND_IK,
+        [MC_REG_OP_SHL_AND_IK] = &&op_SHL_AND_IK,
+        [MC_REG_OP_JF_LE_I]    = &&op_JF_LE_I,
+        [MC_REG_OP_JF_GE_I]    = &&op_JF_GE_I,
+        [MC_REG_OP_JF_LT_I]    = &&op_JF_LT_I,
+        [MC_REG_OP_JF_GT_I]    = &&op_JF_GT_I,
+        [MC_REG_OP_JF_EQ_I]    = &&op_JF_EQ_I,
+        [MC_REG_OP_JF_NE_I]    = &&op_JF_NE_I,
+        [MC_REG_OP_JF_LE_F]    = &&op_JF_LE_F,
+        [MC_REG_OP_JF_GE_F]    = &&op_JF_GE_F,
+        [MC_REG_OP_JF_LT_F]    = &&op_JF_LT_F,
+        [MC_REG_OP_JF_GT_F]    = &&op_JF_GT_F,
+        [MC_REG_OP_JF_EQ_F]    = &&op_JF_EQ_F,
+        [MC_REG_OP_JF_NE_F]    = &&op_JF_NE_F,
+        [MC_REG_OP_JF_LE_IK]   = &&op_JF_LE_IK,
+        [MC_REG_OP_JF_GE_IK]   = &&op_JF_GE_IK,
+        [MC_REG_OP_JF_LT_IK]   = &&op_JF_LT_IK,
+        [MC_REG_OP_JF_GT_IK]   = &&op_JF_GT_IK,
+        [MC_REG_OP_JF_EQ_IK]   = &&op_JF_EQ_IK,
+        [MC_REG_OP_JF_NE_IK]   = &&op_JF_NE_IK,
+        [MC_REG_OP_JF_LE_FK]   = &&op_JF_LE_FK,
+        [MC_REG_OP_JF_GE_FK]   = &&op_JF_GE_FK,
+        [MC_REG_OP_JF_LT_FK]   = &&op_JF_LT_FK,
+        [MC_REG_OP_JF_GT_FK]   = &&op_JF_GT_FK,
+        [MC_REG_OP_JF_EQ_FK]   = &&op_JF_EQ_FK,
+        [MC_REG_OP_JF_NE_FK]   = &&op_JF_NE_FK,
+    };
+    static const void* const counted[MC_REG_OP_MAX] = {
+        [0 ... MC_REG_OP_MAX - 1] = &&count,
+    };
+    const void* const* table = stats ? counted : labels;
+
+#    define OP(NAME)   op_##NAME:
+#    define DISPATCH() goto* table[ip->op]
+    DISPATCH();
+
+count:
+    COUNT();
+    goto* labels[ip->op];
+#else
+#    define OP(NAME)   case MC_REG_OP_##NAME:
+#    define DISPATCH() continue
+    for (;;) {
+        if (stats) {
+            COUNT();
+        }
+        switch (ip->op) {
+#endif
+
+#define NEXT()                                                                                     \
+    do {                                                                                           \
+        ip++;                                                                                      \
+        DISPATCH();                                                                                \
+    } while (0)
+
+#define JUMP_IF(cond)                                                                              \
+    do {                                                                                           \
+        ip = (cond) ? code + ip->target : ip + 1;                                                  \
+        DISPATCH();                                                                                \
+    } while (0)
+
+#define UNARY(NAME, expr)                                                                          \
+    OP (NAME) {                                                                                    \
+        expr;                                                                                      \
+        NEXT();                                                                                    \
+    }
+
+#define BINARY(NAME, field, result, operator)                                                      \
+    UNARY (NAME, r[ip->d].result = r[ip->a].field operator r[ip->b].field)                         \
+    UNARY (NAME##K, r[ip->d].result = r[ip->a].field operator k[ip->b].field)
+
+#define JF(NAME, field, operator)                                                                  \
+    OP (JF_##NAME) {                                                                               \
+        JUMP_IF (!(r[ip->a].field operator r[ip->b].field));                                       \
+    }                                                                                              \
+    OP (JF_##NAME##K) {                                                                            \
+        JUMP_IF (!(r[ip->a].field operator k[ip->b].field));                                       \
+    }
+
+    OP (RET_F) {
+        ret = r[ip->a].f;
+        goto done;
+    }
+    OP (RET_I) {
+        ret = r[ip->a].i;
+        goto done;
+    }
+
+    UNARY (MOV, r[ip->d] = r[ip->a])
+    UNARY (MOV_K, r[ip->d] = k[ip->b])
+    UNARY (I2F, r[ip->d].f = r[ip->a].i)
+    UNARY (F2I, r[ip->d].i = r[ip->a].f)
+    UNARY (BOOL_I, r[ip->d].i = !!r[ip->a].i)
+    UNARY (BOOL_F, r[ip->d].i = r[ip->a].f != 0)
+    UNARY (NEG_F, r[ip->d].f = -r[ip->a].f)
+    UNARY (NOT_I, r[ip->d].i = !r[ip->a].i)
+    UNARY (NOT_F, r[ip->d].i = !r[ip->a].f)
+
+    BINARY (ADD_F, f, f, +)
+    BINARY (SUB_F, f, f, -)
+    BINARY (MUL_F, f, f, *)
+    BINARY (DIV_F, f, f, /)
+    BINARY (AND_I, i, i, &)
+    BINARY (OR_I, i, i, |)
+    BINARY (XOR_I, i, i, ^)
+    BINARY (MOD_I, i, i, %)
+    BINARY (SHR_I, i, i, >>)
+    BINARY (SHL_I, i, i, <<)
+    BINARY (LE_I, i, i, <=)
+    BINARY (GE_I, i, i, >=)
+    BINARY (LT_I, i, i, <)
+    BINARY (GT_I, i, i, >)
+    BINARY (EQ_I, i, i, ==)
+    BINARY (NE_I, i, i, !=)
+    BINARY (LE_F, f, i, <=)
+    BINARY (GE_F, f, i, >=)
+    BINARY (LT_F, f, i, <)
+    BINARY (GT_F, f, i, >)
+    BINARY (EQ_F, f, i, ==)
+    BINARY (NE_F, f, i, !=)
+
+    UNARY (RSUB_FK, r[ip->d].f = k[ip->b].f - r[ip->a].f)
+    UNARY (RDIV_FK, r[ip->d].f = k[ip->b].f / r[ip->a].f)
+    UNARY (SHR_AND_IK, r[ip->d].i = (r[ip->a].i >> ip->target) & k[ip->b].i)
+    UNARY (SHL_AND_IK, r[ip->d].i = (r[ip->a].i << ip->target) & k[ip->b].i)
+
+    OP (JMP) {
+        JUMP_IF (true);
+    }
+    OP (JZ_I) {
+        JUMP_IF (!r[ip->a].i);
+    }
+    OP (JZ_F) {
+        JUMP_IF (r[ip->a].f == 0);
+    }
+    OP (JNZ_I) {
+        JUMP_IF (r[ip->a].i);
+    }
+    OP (JNZ_F) {
+        JUMP_IF (r[ip->a].f != 0);
+    }
+
+    JF (LE_I, i, <=)
+    JF (GE_I, i, >=)
+    JF (LT_I, i, <)
+    JF (GT_I, i, >)
+    JF (EQ_I, i, ==)
+    JF (NE_I, i, !=)
+    JF (LE_F, f, <=)
+    JF (GE_F, f, >=)
+    JF (LT_F, f, <)
+    JF (GT_F, f, >)
+    JF (EQ_F, f, ==)
+    JF (NE_F, f, !=)
+
+#undef JF
+#undef BINARY
+#undef UNARY
+#undef JUMP_IF
+#undef NEXT
+#undef DISPATCH
+#undef OP
+#undef COUNT
+
+#if !REGISTER_THREADED
+            default :
+                LOG_ERROR ("invalid opcode %u.", ip->op);
+                goto done;
+        }
+    }
+#endif
+
+done:
+    if (r != local) {
+        free (r);
+    }
+    return ret;
+}
+
+
+f64 McRegCodeEval (const McRegCode* rc, const f64* inputs) {
+    return reg_eval (rc, inputs, NULL);
+}
+
+
+f64 McRegCodeEvalCounted (const McRegCode* rc, const f64* inputs, McRegStats* stats) {
+    if (!stats) {
+        LOG_ERROR ("invalid arguments.");
+        return 0;
+    }
+    return reg_eval (rc, inputs, stats);
+}
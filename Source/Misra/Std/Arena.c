@@ -0,0 +1,162 @@
+/// file      : std/arena.c
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, All rights reserved.
+///
+/// Arena allocator implementation
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ct
+#include <Misra/Std/Arena.h>
+#include <Misra/Std/Log.h>
+
+#define ARENA_DEFAULT_BLOCK_SIZE (64 * 1024)
+
+static inline void free_block_list (ArenaBlock *block) {
+    while (block) {
+        ArenaBlock *next = block->next;
+        free (block);
+        block = next;
+    }
+}
+
+
+Arena *ArenaInit (Arena *arena, size_t block_size) {
+    if (!arena) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    memset (arena, 0, sizeof (Arena));
+    arena->block_size = block_size ? block_size : ARENA_DEFAULT_BLOCK_SIZE;
+
+    return arena;
+}
+
+
+Arena *ArenaDeinit (Arena *arena) {
+    if (!arena) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    free_block_list (arena->blocks);
+    free_block_list (arena->free_blocks);
+    memset (arena, 0, sizeof (Arena));
+
+    return arena;
+}
+
+
+// Get a block that can hold atleast `size` bytes, reusing a free one if possible.
+static ArenaBlock *arena_new_block (Arena *arena, size_t size) {
+    ArenaBlock **iter = &arena->free_blocks;
+    while (*iter) {
+        if ((*iter)->size >= size) {
+            ArenaBlock *block = *iter;
+            *iter             = block->next;
+            block->used       = 0;
+            return block;
+        }
+        iter = &(*iter)->next;
+    }
+
+    if (size < arena->block_size) {
+        size = arena->block_size;
+    }
+
+    ArenaBlock *block = malloc (sizeof (ArenaBlock) + size);
+    if (!block) {
+        LOG_ERROR ("malloc() failed : %s.", strerror (errno));
+        return NULL;
+    }
+
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+
+    return block;
+}
+
+
+void *ArenaAlloc (Arena *arena, size_t size, size_t align) {
+    if (!arena || !align || (align & (align - 1))) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    if (!arena->block_size) {
+        arena->block_size = ARENA_DEFAULT_BLOCK_SIZE;
+    }
+
+    ArenaBlock *block = arena->blocks;
+    if (block) {
+        uintptr_t addr = (uintptr_t)(block->data + block->used);
+        size_t    pad  = (align - (addr & (align - 1))) & (align - 1);
+        if (block->used + pad + size <= block->size) {
+            block->used += pad;
+            void *ptr    = block->data + block->used;
+            block->used += size;
+            return ptr;
+        }
+    }
+
+    // current block is full, start a new one with enough space for alignment padding
+    if (!(block = arena_new_block (arena, size + align))) {
+        return NULL;
+    }
+    block->next   = arena->blocks;
+    arena->blocks = block;
+
+    uintptr_t addr = (uintptr_t)block->data;
+    size_t    pad  = (align - (addr & (align - 1))) & (align - 1);
+    block->used    = pad + size;
+
+    return block->data + pad;
+}
+
+
+void *arena_alloc_zero (Arena *arena, size_t size, size_t align) {
+    void *ptr = ArenaAlloc (arena, size, align);
+    if (ptr) {
+        memset (ptr, 0, size);
+    }
+    return ptr;
+}
+
+
+ArenaMark ArenaGetMark (Arena *arena) {
+    if (!arena) {
+        LOG_ERROR ("invalid arguments.");
+        return (ArenaMark) {0};
+    }
+
+    return (ArenaMark) {.block = arena->blocks, .used = arena->blocks ? arena->blocks->used : 0};
+}
+
+
+Arena *ArenaRestore (Arena *arena, ArenaMark mark) {
+    if (!arena) {
+        LOG_ERROR ("invalid arguments.");
+        return NULL;
+    }
+
+    // move all blocks created after mark to free list
+    while (arena->blocks && arena->blocks != mark.block) {
+        ArenaBlock *block  = arena->blocks;
+        arena->blocks      = block->next;
+        block->next        = arena->free_blocks;
+        arena->free_blocks = block;
+    }
+
+    if (arena->blocks) {
+        arena->blocks->used = mark.used;
+    } else if (mark.block) {
+        LOG_ERROR ("mark does not belong to this arena.");
+        return NULL;
+    }
+
+    return arena;
+}
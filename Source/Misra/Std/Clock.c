@@ -0,0 +1,141 @@
+/// file      : std/clock.c
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, All rights reserved.
+///
+/// Clock implementation
+
+#include <time.h>
+
+// platform
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#    include <cpuid.h>
+#    include <x86intrin.h>
+#    define CLOCK_HAVE_TSC 1
+#else
+#    define CLOCK_HAVE_TSC 0
+#endif
+
+// ct
+#include <Misra/Std/Clock.h>
+
+// coarse and raw clocks are Linux extensions, use precise clocks where they're missing
+#ifndef CLOCK_MONOTONIC_COARSE
+#    define CLOCK_MONOTONIC_COARSE CLOCK_MONOTONIC
+#endif
+#ifndef CLOCK_REALTIME_COARSE
+#    define CLOCK_REALTIME_COARSE CLOCK_REALTIME
+#endif
+#ifndef CLOCK_MONOTONIC_RAW
+#    define CLOCK_MONOTONIC_RAW CLOCK_MONOTONIC
+#endif
+
+/// How long to spin while calibrating timestamp counter.
+#define CLOCK_CALIBRATION_NS (5 * 1000 * 1000)
+
+static inline u64 clock_read (clockid_t id) {
+    struct timespec ts;
+    clock_gettime (id, &ts);
+    return (u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+u64 ClockMonotonicNs (void) {
+    return clock_read (CLOCK_MONOTONIC);
+}
+
+
+u64 ClockMonotonicCoarseNs (void) {
+    return clock_read (CLOCK_MONOTONIC_COARSE);
+}
+
+
+u64 ClockMonotonicRawNs (void) {
+    return clock_read (CLOCK_MONOTONIC_RAW);
+}
+
+
+u64 ClockRealtimeNs (void) {
+    return clock_read (CLOCK_REALTIME);
+}
+
+
+u64 ClockRealtimeCoarseNs (void) {
+    return clock_read (CLOCK_REALTIME_COARSE);
+}
+
+
+u64 ClockTicks (void) {
+#if CLOCK_HAVE_TSC
+    return __rdtsc();
+#else
+    return ClockMonotonicRawNs();
+#endif
+}
+
+
+// ns = (ticks * tick_mult) >> 32
+static u64            tick_mult      = 1ULL << 32;
+static bool           tsc_invariant  = false;
+static pthread_once_t calibrate_once = PTHREAD_ONCE_INIT;
+
+static void clock_calibrate (void) {
+#if CLOCK_HAVE_TSC
+    // invariant TSC runs at constant rate in all power states
+    u32 eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid (0x80000007, &eax, &ebx, &ecx, &edx)) {
+        tsc_invariant = (edx >> 8) & 1;
+    }
+
+    u64 ns_start    = ClockMonotonicRawNs();
+    u64 ticks_start = __rdtsc();
+    u64 ns_end      = ns_start;
+    while ((ns_end = ClockMonotonicRawNs()) - ns_start < CLOCK_CALIBRATION_NS) {}
+    u64 ticks_end = __rdtsc();
+
+    u64 ticks = ticks_end - ticks_start;
+    if (ticks) {
+        // calibration takes far less than 2^32 ns, so shifted duration fits in 64 bits
+        tick_mult = ((ns_end - ns_start) << 32) / ticks;
+    } else {
+        tsc_invariant = false;
+    }
+#endif
+}
+
+
+u64 ClockTicksToNs (u64 ticks) {
+    pthread_once (&calibrate_once, clock_calibrate);
+
+    // bits 32..95 of 128 bit product, from 32 bit halves, as 32 bit targets lack __int128
+    u64 ticks_lo = ticks & 0xffffffffULL, ticks_hi = ticks >> 32;
+    u64 mult_lo  = tick_mult & 0xffffffffULL, mult_hi = tick_mult >> 32;
+    return ((ticks_hi * mult_hi) << 32) + ticks_hi * mult_lo + ticks_lo * mult_hi +
+           ((ticks_lo * mult_lo) >> 32);
+}
+
+
+u64 ClockFastNs (void) {
+    pthread_once (&calibrate_once, clock_calibrate);
+    if (tsc_invariant) {
+        return ClockTicksToNs (ClockTicks());
+    }
+    return ClockMonotonicNs();
+}
+
+
+const char *ClockWallTimeStr (u64 realtime_ns) {
+    static __thread time_t last_sec = -1;
+    static __thread char   time_buffer[20];
+
+    time_t sec = realtime_ns / 1000000000ULL;
+    if (sec != last_sec) {
+        struct tm time_info;
+        localtime_r (&sec, &time_info);
+        strftime (time_buffer, sizeof (time_buffer), "%Y-%m-%d %H:%M:%S", &time_info);
+        last_sec = sec;
+    }
+
+    return time_buffer;
+}
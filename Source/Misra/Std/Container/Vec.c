@@ -275,7 +275,7 @@ GenericVec *remove_range_vec (
         vec->data + (start + count) * item_size,
         (vec->length - start - count) * item_size
     );
-    memset (vec->data + (vec->length - start - count) * item_size, 0, count * item_size);
+    memset (vec->data + (vec->length - count) * item_size, 0, count * item_size);
 
     vec->length -= count;
 
@@ -314,12 +314,14 @@ GenericVec *fast_remove_range_vec (
         }
     }
 
+    // fill hole with as many items from the end as there are after it
+    size_t nmove = vec->length - start - count < count ? vec->length - start - count : count;
     memmove (
         vec->data + start * item_size,
-        vec->data + (vec->length - count) * item_size,
-        count * item_size
+        vec->data + (vec->length - nmove) * item_size,
+        nmove * item_size
     );
-    memset (vec->data + (vec->length - start - count) * item_size, 0, count * item_size);
+    memset (vec->data + (vec->length - count) * item_size, 0, count * item_size);
 
     vec->length -= count;
 
@@ -404,7 +406,7 @@ GenericVec *push_arr_vec (GenericVec *vec, size_t item_size, void *arr, size_t c
         memmove (
             vec->data + (pos + count) * item_size,
             vec->data + pos * item_size,
-            count * item_size
+            (vec->length - pos) * item_size
         );
 
         memset (vec->data + pos * item_size, 0, count * item_size);
@@ -7,12 +7,22 @@
 #include <stdlib.h>
 
 // beam
+#include <Misra/Std/Arena.h>
 #include <Misra/Std/File.h>
 #include <Misra/Std/Log.h>
 
 // platform
 #include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <sys/stat.h>
+#include <unistd.h>
+
+#if __linux__
+#    include <sys/syscall.h>
+#endif
 
 const char *DirEntryTypeToZStr (DirEntryType type) {
     switch (type) {
@@ -85,8 +95,9 @@ DirContents *ReadDirContents (DirContents *dir_contents, const char *path) {
     while (NULL != (entry = readdir (dir))) {
 #if __APPLE__
         size_t namelen = entry->d_namlen;
-#elif __linux__
-        size_t namelen = entry->d_reclen;
+#else
+        // d_reclen is size of whole record (with padding), not of name
+        size_t namelen = strlen (entry->d_name);
 #endif
 
         if ('.' == DNAME (0) && 0 == DNAME (1)) {
@@ -136,15 +147,696 @@ DirContents *ReadDirContents (DirContents *dir_contents, const char *path) {
 }
 
 
+// size of buffer directory entries are read into in one go
+#define WALK_DIR_BATCH_SIZE (32 * 1024)
+
+// directories waiting for a worker hold an open descriptor each, so past this
+// many waiting, directories are walked by thread that found them instead
+#define WALK_DIR_MAX_JOBS 256
+
+static DirEntryType dir_entry_type_from_dt (unsigned char d_type) {
+    switch (d_type) {
+        case DT_REG :
+            return DIR_ENTRY_TYPE_REGULAR_FILE;
+        case DT_DIR :
+            return DIR_ENTRY_TYPE_DIRECTORY;
+        case DT_FIFO :
+            return DIR_ENTRY_TYPE_PIPE;
+        case DT_SOCK :
+            return DIR_ENTRY_TYPE_SOCKET;
+        case DT_CHR :
+            return DIR_ENTRY_TYPE_CHARACTER_DEVICE;
+        case DT_BLK :
+            return DIR_ENTRY_TYPE_BLOCK_DEVICE;
+        case DT_LNK :
+            return DIR_ENTRY_TYPE_SYMBOLIC_LINK;
+        case DT_UNKNOWN :
+        default :
+            return DIR_ENTRY_TYPE_UNKNOWN;
+    }
+}
+
+
+static DirEntryType dir_entry_type_from_mode (mode_t mode) {
+    if (S_ISREG (mode)) {
+        return DIR_ENTRY_TYPE_REGULAR_FILE;
+    } else if (S_ISDIR (mode)) {
+        return DIR_ENTRY_TYPE_DIRECTORY;
+    } else if (S_ISFIFO (mode)) {
+        return DIR_ENTRY_TYPE_PIPE;
+    } else if (S_ISSOCK (mode)) {
+        return DIR_ENTRY_TYPE_SOCKET;
+    } else if (S_ISCHR (mode)) {
+        return DIR_ENTRY_TYPE_CHARACTER_DEVICE;
+    } else if (S_ISBLK (mode)) {
+        return DIR_ENTRY_TYPE_BLOCK_DEVICE;
+    } else if (S_ISLNK (mode)) {
+        return DIR_ENTRY_TYPE_SYMBOLIC_LINK;
+    }
+    return DIR_ENTRY_TYPE_UNKNOWN;
+}
+
+typedef struct WalkDirJob WalkDirJob;
+
+// a directory waiting to be walked by one of the worker threads, already
+// opened relative to it's parent, so that it's path is never resolved again
+struct WalkDirJob {
+    WalkDirJob *next;
+    int         fd;
+    u32         depth;
+    size_t      path_len;
+    char        path[];
+};
+
+typedef struct WalkDirCtx {
+    WalkDirFilter  filter;
+    WalkDirVisitor visit;
+    void          *user_data;
+
+    // set when visitor asks to stop or an error occurs, from any thread
+    _Atomic bool stop;
+    _Atomic bool failed;
+
+    // parallel walk only
+    bool            parallel;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    WalkDirJob     *jobs;
+    u32             njobs;
+    u32             nbusy;
+} WalkDirCtx;
+
+// per thread state
+typedef struct WalkDirWorker {
+    WalkDirCtx *ctx;
+    Arena       arena;
+    char        path[PATH_MAX];
+} WalkDirWorker;
+
+static void walk_dir_fd (WalkDirWorker *w, int fd, size_t path_len, u32 depth);
+
+// Hand over directory open at `fd` to worker threads.
+// Returns false if queue is full, and caller must walk directory itself.
+static bool walk_dir_push_job (
+    WalkDirCtx *ctx,
+    int         fd,
+    const char *path,
+    size_t      path_len,
+    u32         depth
+) {
+    WalkDirJob *job = malloc (sizeof (WalkDirJob) + path_len + 1);
+    if (!job) {
+        return false;
+    }
+
+    memcpy (job->path, path, path_len);
+    job->path[path_len] = 0;
+    job->path_len       = path_len;
+    job->depth          = depth;
+    job->fd             = fd;
+
+    pthread_mutex_lock (&ctx->lock);
+    if (ctx->njobs >= WALK_DIR_MAX_JOBS) {
+        pthread_mutex_unlock (&ctx->lock);
+        free (job);
+        return false;
+    }
+    job->next = ctx->jobs;
+    ctx->jobs = job;
+    ctx->njobs++;
+    pthread_cond_signal (&ctx->cond);
+    pthread_mutex_unlock (&ctx->lock);
+
+    return true;
+}
+
+// Handle a single entry of directory open at `fd`.
+// Returns false if walk must stop.
+static bool walk_dir_entry (
+    WalkDirWorker *w,
+    int            fd,
+    const char    *name,
+    unsigned char  d_type,
+    size_t         path_len,
+    u32            depth
+) {
+    WalkDirCtx *ctx = w->ctx;
+
+    if ('.' == name[0] && (0 == name[1] || ('.' == name[1] && 0 == name[2]))) {
+        return true;
+    }
+
+    size_t name_len = strlen (name);
+    if (path_len + 1 + name_len + 1 > sizeof (w->path)) {
+        LOG_ERROR ("path too long, skipping entry.");
+        ctx->failed = true;
+        return true;
+    }
+
+    // append name to path of parent, in place
+    w->path[path_len] = '/';
+    memcpy (w->path + path_len + 1, name, name_len + 1);
+
+    WalkDirEntry entry = {
+        .type     = dir_entry_type_from_dt (d_type),
+        .depth    = depth,
+        .dir_fd   = fd,
+        .name     = name,
+        .name_len = name_len,
+        .path     = w->path,
+        .path_len = path_len + 1 + name_len,
+    };
+
+    // some filesystems don't report type in directory entries
+    if (DIR_ENTRY_TYPE_UNKNOWN == entry.type) {
+        struct stat st;
+        if (0 == fstatat (fd, name, &st, AT_SYMLINK_NOFOLLOW)) {
+            entry.type = dir_entry_type_from_mode (st.st_mode);
+        }
+    }
+
+    if (ctx->filter && !ctx->filter (&entry, ctx->user_data)) {
+        w->path[path_len] = 0;
+        return true;
+    }
+
+    if (!ctx->visit (&entry, ctx->user_data)) {
+        ctx->stop = true;
+        return false;
+    }
+
+    // opened relative to parent in both sequential and parallel walk, so that a
+    // directory replaced by a symbolic link is never followed
+    if (DIR_ENTRY_TYPE_DIRECTORY == entry.type) {
+        int sub_fd = openat (fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOFOLLOW);
+        if (sub_fd < 0) {
+            LOG_ERROR ("openat() failed : %s.", strerror (errno));
+            ctx->failed = true;
+        } else if (!ctx->parallel ||
+                   !walk_dir_push_job (ctx, sub_fd, entry.path, entry.path_len, depth + 1)) {
+            walk_dir_fd (w, sub_fd, entry.path_len, depth + 1);
+            close (sub_fd);
+        }
+    }
+
+    w->path[path_len] = 0;
+    return !ctx->stop;
+}
+
+// Walk all entries of directory open at `fd`, whose path is in worker path buffer.
+static void walk_dir_fd (WalkDirWorker *w, int fd, size_t path_len, u32 depth) {
+    // each level of recursion gets it's own batch buffer
+    ArenaMark mark  = ArenaGetMark (&w->arena);
+    u8       *batch = ArenaAlloc (&w->arena, WALK_DIR_BATCH_SIZE, 8);
+    if (!batch) {
+        w->ctx->failed = true;
+        return;
+    }
+
+#if __linux__
+    struct linux_dirent64 {
+        u64            d_ino;
+        i64            d_off;
+        unsigned short d_reclen;
+        unsigned char  d_type;
+        char           d_name[];
+    };
+
+    while (!w->ctx->stop) {
+        long nread = syscall (SYS_getdents64, fd, batch, WALK_DIR_BATCH_SIZE);
+        if (nread < 0) {
+            LOG_ERROR ("getdents64() failed : %s.", strerror (errno));
+            w->ctx->failed = true;
+            break;
+        }
+
+        if (!nread) {
+            break;
+        }
+
+        for (long off = 0; off < nread;) {
+            struct linux_dirent64 *d = (struct linux_dirent64 *)(batch + off);
+            off                     += d->d_reclen;
+
+            if (!walk_dir_entry (w, fd, d->d_name, d->d_type, path_len, depth)) {
+                break;
+            }
+        }
+    }
+#else
+    // readdir takes ownership of descriptor, so give it a copy
+    int  dup_fd = dup (fd);
+    DIR *dir    = dup_fd < 0 ? NULL : fdopendir (dup_fd);
+    if (!dir) {
+        LOG_ERROR ("fdopendir() failed : %s.", strerror (errno));
+        if (dup_fd >= 0) {
+            close (dup_fd);
+        }
+        w->ctx->failed = true;
+    } else {
+        struct dirent *d = NULL;
+        while (!w->ctx->stop && (d = readdir (dir))) {
+            if (!walk_dir_entry (w, fd, d->d_name, d->d_type, path_len, depth)) {
+                break;
+            }
+        }
+        closedir (dir);
+    }
+#endif
+
+    ArenaRestore (&w->arena, mark);
+}
+
+static void *walk_dir_worker (void *arg) {
+    WalkDirWorker *w   = arg;
+    WalkDirCtx    *ctx = w->ctx;
+
+    while (true) {
+        pthread_mutex_lock (&ctx->lock);
+        while (!ctx->jobs && ctx->nbusy && !ctx->stop) {
+            pthread_cond_wait (&ctx->cond, &ctx->lock);
+        }
+
+        // no work left and nobody can produce more
+        if (!ctx->jobs || ctx->stop) {
+            pthread_cond_broadcast (&ctx->cond);
+            pthread_mutex_unlock (&ctx->lock);
+            break;
+        }
+
+        WalkDirJob *job = ctx->jobs;
+        ctx->jobs       = job->next;
+        ctx->njobs--;
+        ctx->nbusy++;
+        pthread_mutex_unlock (&ctx->lock);
+
+        memcpy (w->path, job->path, job->path_len + 1);
+        walk_dir_fd (w, job->fd, job->path_len, job->depth);
+        close (job->fd);
+        free (job);
+
+        pthread_mutex_lock (&ctx->lock);
+        ctx->nbusy--;
+        if (!ctx->nbusy && !ctx->jobs) {
+            pthread_cond_broadcast (&ctx->cond);
+        }
+        pthread_mutex_unlock (&ctx->lock);
+    }
+
+    return NULL;
+}
+
+
+bool WalkDir (
+    const char    *root,
+    WalkDirFilter  filter,
+    WalkDirVisitor visit,
+    void          *user_data,
+    u32            nthreads
+) {
+    if (!root || !visit) {
+        LOG_ERROR ("invalid arguments.");
+        return false;
+    }
+
+    size_t root_len = strlen (root);
+    while (root_len > 1 && '/' == root[root_len - 1]) {
+        root_len--;
+    }
+
+    if (root_len + 1 > PATH_MAX) {
+        LOG_ERROR ("root path too long.");
+        return false;
+    }
+
+    WalkDirCtx ctx = {
+        .filter    = filter,
+        .visit     = visit,
+        .user_data = user_data,
+        .parallel  = nthreads > 1,
+    };
+
+    if (!ctx.parallel) {
+        WalkDirWorker *w = NEW (WalkDirWorker);
+        if (!w) {
+            LOG_ERROR ("malloc() failed : %s.", strerror (errno));
+            return false;
+        }
+
+        w->ctx = &ctx;
+        ArenaInit (&w->arena, WALK_DIR_BATCH_SIZE * 4);
+        memcpy (w->path, root, root_len);
+        w->path[root_len] = 0;
+
+        int fd = open (w->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            LOG_ERROR ("open() failed : %s.", strerror (errno));
+            ctx.failed = true;
+        } else {
+            walk_dir_fd (w, fd, root_len, 0);
+            close (fd);
+        }
+
+        ArenaDeinit (&w->arena);
+        FREE (w);
+        return !ctx.failed;
+    }
+
+    char root_path[PATH_MAX];
+    memcpy (root_path, root, root_len);
+    root_path[root_len] = 0;
+
+    // root is opened here, so that it fails walk same as it does above
+    int root_fd = open (root_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (root_fd < 0) {
+        LOG_ERROR ("open() failed : %s.", strerror (errno));
+        return false;
+    }
+
+    pthread_mutex_init (&ctx.lock, NULL);
+    pthread_cond_init (&ctx.cond, NULL);
+
+    WalkDirWorker *workers = calloc (nthreads, sizeof (WalkDirWorker));
+    pthread_t     *threads = calloc (nthreads, sizeof (pthread_t));
+    if (!workers || !threads || !walk_dir_push_job (&ctx, root_fd, root_path, root_len, 0)) {
+        LOG_ERROR ("failed to setup walk workers.");
+        free (workers);
+        free (threads);
+        close (root_fd);
+        pthread_mutex_destroy (&ctx.lock);
+        pthread_cond_destroy (&ctx.cond);
+        return false;
+    }
+
+    u32 nstarted = 0;
+    for (u32 t = 0; t < nthreads; t++) {
+        workers[t].ctx = &ctx;
+        ArenaInit (&workers[t].arena, WALK_DIR_BATCH_SIZE * 4);
+        if (pthread_create (&threads[t], NULL, walk_dir_worker, &workers[t])) {
+            LOG_ERROR ("pthread_create() failed.");
+            break;
+        }
+        nstarted++;
+    }
+
+    // walk on this thread too if no worker could be started
+    if (!nstarted) {
+        walk_dir_worker (&workers[0]);
+    }
+
+    for (u32 t = 0; t < nstarted; t++) {
+        pthread_join (threads[t], NULL);
+    }
+
+    // jobs left over if walk was stopped early
+    while (ctx.jobs) {
+        WalkDirJob *job = ctx.jobs;
+        ctx.jobs        = job->next;
+        close (job->fd);
+        free (job);
+    }
+
+    for (u32 t = 0; t < nthreads; t++) {
+        ArenaDeinit (&workers[t].arena);
+    }
+
+    free (workers);
+    free (threads);
+    pthread_mutex_destroy (&ctx.lock);
+    pthread_cond_destroy (&ctx.cond);
+
+    return !ctx.failed;
+}
+
+
+// A cached file info. Empty slots have NULL path.
+typedef struct FileInfoCacheEntry {
+    char    *path;
+    u64      path_hash;
+    u64      generation;
+    bool     exists;
+    int      error; // errno of failed stat, for missing files
+    FileInfo info;
+} FileInfoCacheEntry;
+
+// stat keeps nanosecond timestamps under different names on different platforms
+#if __APPLE__
+#    define STAT_MTIM(st) ((st).st_mtimespec)
+#    define STAT_CTIM(st) ((st).st_ctimespec)
+#else
+#    define STAT_MTIM(st) ((st).st_mtim)
+#    define STAT_CTIM(st) ((st).st_ctim)
+#endif
+
+static inline int64_t timespec_ns (struct timespec ts) {
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static struct {
+    pthread_rwlock_t    lock;
+    FileInfoCacheEntry *entries;
+    u64                 capacity; // always power of two
+    u64                 length;
+    u64                 generation;
+} file_info_cache = {.lock = PTHREAD_RWLOCK_INITIALIZER, .generation = 1};
+
+// MurmurHash64A, hashes 8 bytes at a time
+static u64 hash_bytes (const void *data, size_t len, u64 seed) {
+    const u64 m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    u64       h = seed ^ (len * m);
+
+    const u8 *p   = data;
+    const u8 *end = p + (len & ~(size_t)7);
+    for (; p != end; p += 8) {
+        u64 k;
+        memcpy (&k, p, 8);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    switch (len & 7) {
+        case 7 :
+            h ^= (u64)p[6] << 48;
+            // fall through
+        case 6 :
+            h ^= (u64)p[5] << 40;
+            // fall through
+        case 5 :
+            h ^= (u64)p[4] << 32;
+            // fall through
+        case 4 :
+            h ^= (u64)p[3] << 24;
+            // fall through
+        case 3 :
+            h ^= (u64)p[2] << 16;
+            // fall through
+        case 2 :
+            h ^= (u64)p[1] << 8;
+            // fall through
+        case 1 :
+            h ^= (u64)p[0];
+            h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+// hash complete contents of file, reading it in chunks
+static bool hash_file_contents (const char *path, u64 *hash) {
+    int fd = open (path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR ("open() failed : %s.", strerror (errno));
+        return false;
+    }
+
+    u8      buf[64 * 1024];
+    u64     h = 0;
+    ssize_t n = 0;
+    while ((n = read (fd, buf, sizeof (buf))) != 0) {
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR ("read() failed : %s.", strerror (errno));
+            close (fd);
+            return false;
+        }
+        h = hash_bytes (buf, n, h);
+    }
+
+    close (fd);
+    *hash = h;
+    return true;
+}
+
+// Find slot for given path. Must be called with cache lock held.
+static FileInfoCacheEntry *file_info_cache_slot (const char *path, u64 path_hash) {
+    if (!file_info_cache.capacity) {
+        return NULL;
+    }
+
+    u64 mask = file_info_cache.capacity - 1;
+    for (u64 i = path_hash & mask;; i = (i + 1) & mask) {
+        FileInfoCacheEntry *e = file_info_cache.entries + i;
+        if (!e->path || (e->path_hash == path_hash && !strcmp (e->path, path))) {
+            return e;
+        }
+    }
+}
+
+// Make sure there's space for one more entry. Must be called with write lock held.
+static bool file_info_cache_grow (void) {
+    if ((file_info_cache.length + 1) * 2 <= file_info_cache.capacity) {
+        return true;
+    }
+
+    u64                 old_capacity = file_info_cache.capacity;
+    FileInfoCacheEntry *old_entries  = file_info_cache.entries;
+
+    u64                 capacity = old_capacity ? old_capacity * 2 : 256;
+    FileInfoCacheEntry *entries  = calloc (capacity, sizeof (FileInfoCacheEntry));
+    if (!entries) {
+        LOG_ERROR ("calloc() failed : %s.", strerror (errno));
+        return false;
+    }
+
+    file_info_cache.entries  = entries;
+    file_info_cache.capacity = capacity;
+
+    for (u64 i = 0; i < old_capacity; i++) {
+        if (old_entries[i].path) {
+            *file_info_cache_slot (old_entries[i].path, old_entries[i].path_hash) = old_entries[i];
+        }
+    }
+
+    free (old_entries);
+    return true;
+}
+
+
+bool GetFileInfo (const char *path, FileInfo *info, FileInfoFlags flags) {
+    if (!path || !info) {
+        LOG_ERROR ("invalid arguments.");
+        return false;
+    }
+
+    u64 path_hash  = hash_bytes (path, strlen (path), 0);
+    u64 generation = __atomic_load_n (&file_info_cache.generation, __ATOMIC_ACQUIRE);
+
+    // fast path : entry from current generation, nothing more to compute
+    FileInfoCacheEntry cached = {0};
+    pthread_rwlock_rdlock (&file_info_cache.lock);
+    FileInfoCacheEntry *slot = file_info_cache_slot (path, path_hash);
+    if (slot && slot->path) {
+        cached      = *slot;
+        cached.path = NULL;
+    }
+    pthread_rwlock_unlock (&file_info_cache.lock);
+
+    // missing files are trusted only on request, existing ones only with hash if one is wanted
+    bool fresh = cached.generation == generation &&
+                 (cached.exists ? (flags & FILE_INFO_CACHED) : (flags & FILE_INFO_CACHE_MISSING));
+    if (fresh && (!cached.exists || cached.info.has_hash || !(flags & FILE_INFO_HASH))) {
+        if (!cached.exists) {
+            errno = cached.error;
+        }
+        *info = cached.info;
+        return cached.exists;
+    }
+
+    // slow path : stat the file and compare with what we know
+    FileInfoCacheEntry entry = {.path_hash = path_hash, .generation = generation};
+    if (fresh) {
+        entry = cached;
+    } else {
+        struct stat st;
+        if (0 != stat (path, &st)) {
+            entry.error = errno;
+        } else {
+            entry.exists        = true;
+            entry.info.size     = st.st_size;
+            entry.info.mtime_ns = timespec_ns (STAT_MTIM (st));
+            entry.info.ctime_ns = timespec_ns (STAT_CTIM (st));
+            entry.info.inode    = st.st_ino;
+            entry.info.device   = st.st_dev;
+
+            // keep hash if file is unchanged
+            if (cached.exists && cached.info.has_hash && cached.info.size == entry.info.size &&
+                cached.info.mtime_ns == entry.info.mtime_ns &&
+                cached.info.ctime_ns == entry.info.ctime_ns &&
+                cached.info.inode == entry.info.inode && cached.info.device == entry.info.device) {
+                entry.info.hash     = cached.info.hash;
+                entry.info.has_hash = true;
+            }
+        }
+    }
+
+    if (entry.exists && (flags & FILE_INFO_HASH) && !entry.info.has_hash) {
+        entry.info.has_hash = hash_file_contents (path, &entry.info.hash);
+    }
+
+    // publish
+    pthread_rwlock_wrlock (&file_info_cache.lock);
+    if (file_info_cache_grow ()) {
+        slot = file_info_cache_slot (path, path_hash);
+        if (!slot->path) {
+            entry.path = strdup (path);
+            if (entry.path) {
+                file_info_cache.length++;
+                *slot = entry;
+            }
+        } else {
+            entry.path = slot->path;
+            *slot      = entry;
+        }
+    }
+    pthread_rwlock_unlock (&file_info_cache.lock);
+
+    if (!entry.exists) {
+        errno = entry.error;
+    }
+    *info = entry.info;
+    return entry.exists;
+}
+
+
+u64 FileInfoCacheBump (void) {
+    return __atomic_add_fetch (&file_info_cache.generation, 1, __ATOMIC_ACQ_REL);
+}
+
+
+void FileInfoCacheClear (void) {
+    pthread_rwlock_wrlock (&file_info_cache.lock);
+
+    for (u64 i = 0; i < file_info_cache.capacity; i++) {
+        free (file_info_cache.entries[i].path);
+    }
+    free (file_info_cache.entries);
+
+    file_info_cache.entries  = NULL;
+    file_info_cache.capacity = 0;
+    file_info_cache.length   = 0;
+
+    pthread_rwlock_unlock (&file_info_cache.lock);
+}
+
+
 int64_t GetFileSize (const char *filename) {
     if (!filename) {
         LOG_ERROR ("invalid arguments.");
         return -1;
     }
 
-    struct stat file_stat;
-    if (0 == stat (filename, &file_stat)) {
-        return file_stat.st_size;
+    struct stat st;
+    if (0 == stat (filename, &st)) {
+        return st.st_size;
     } else {
         LOG_ERROR ("failed to get file size : %s.", strerror (errno));
         return -1;
@@ -158,33 +850,37 @@ void *ReadCompleteFile (const char *filename, void **data, size_t *file_size, si
         return NULL;
     }
 
-    // get actual size of file
-    int64_t size = GetFileSize (filename);
-    if (-1 == size) {
-        LOG_ERROR ("failed to get file size");
+    // Open the file in binary mode
+    FILE *file = fopen (filename, "rb");
+    if (!file) {
+        LOG_ERROR ("fopen() failed : %s.", strerror (errno));
         return NULL;
     }
 
+    // size of the opened file itself, so it matches what is read below even
+    // if file is replaced by another one at same path meanwhile
+    struct stat file_stat;
+    if (0 != fstat (fileno (file), &file_stat)) {
+        LOG_ERROR ("failed to get file size : %s.", strerror (errno));
+        fclose (file);
+        return NULL;
+    }
+    int64_t size = file_stat.st_size;
+
     // allocate memory to hold the file contents if required
     void *buffer = *data;
-    if (*capacity < (size_t)size) {
+    if (*capacity < (size_t)size + 1) {
         buffer = realloc (buffer, size + 1);
         if (!buffer) {
             LOG_ERROR ("malloc() failed : %s.", strerror (errno));
+            fclose (file);
             return NULL;
         }
 
+        *data     = buffer;
         *capacity = size + 1;
     }
 
-    // Open the file in binary mode
-    FILE *file = fopen (filename, "rb");
-    if (!file) {
-        LOG_ERROR ("fopen() failed : %s.", strerror (errno));
-        free (buffer);
-        return NULL;
-    }
-
     // Read the entire file into the buffer
     if (size != (int64_t)fread (buffer, 1, size, file)) {
         LOG_ERROR ("failed to read complete file. : %s", strerror (errno));
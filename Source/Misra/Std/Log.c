@@ -1,104 +1,1180 @@
-#include <stdio.h>
+/// file      : std/log.c
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2024, Siddharth Mishra, All rights reserved.
+///
+/// Asynchronous logging backend. Each thread owns a single-producer single-consumer
+/// ring buffer. `LogWrite` only copies the format pointer and raw arguments into
+/// calling thread's ring, without taking any lock. A background thread drains all
+/// rings, formats the messages and writes them out in batches, and sleeps till a
+/// producer wakes it up when there's nothing left to write.
+
+#include <assert.h>
 #include <stdarg.h>
-#include <time.h>
+#include <stdatomic.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 // linux
 #include <pthread.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 // beam
+#include <Misra/Std/Clock.h>
 #include <Misra/Std/Log.h>
 
-static FILE           *stderror = NULL;
-static pthread_mutex_t lock     = PTHREAD_MUTEX_INITIALIZER;
+/// Size of each per-thread ring. Must be a power of two.
+#define LOG_RING_SIZE (64 * 1024)
+
+/// Max size of a single encoded message. Longer string arguments are truncated.
+#define LOG_RECORD_MAX_SIZE (4 * 1024)
+
+/// Size of output buffer formatted messages are batched in.
+#define LOG_OUTPUT_SIZE (64 * 1024)
+
+/// Longest drain thread waits for messages, so that messages suppressed by
+/// rate limit are still reported about once a window when nothing is logged.
+#define LOG_DRAIN_TIMEOUT_NS (LOG_RATE_LIMIT_WINDOW_MS * 1000000ULL)
+
+#define LOG_ALIGN(x) (((x) + 7) & ~(size_t)7)
+
+typedef enum {
+    LOG_ARG_NONE,
+    LOG_ARG_INT,
+    LOG_ARG_LONG,
+    LOG_ARG_LLONG,
+    LOG_ARG_SIZE,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_LDOUBLE,
+    LOG_ARG_STR,
+    LOG_ARG_PTR,
+    LOG_ARG_WRITE_COUNT, // %n, never written to
+} LogArgKind;
+
+typedef struct LogSpec {
+    LogArgKind kind;
+    u32        nstars;         // number of '*' width/precision arguments
+    bool       star_precision; // precision is last '*' argument
+    int        precision;      // precision written in format, -1 if none
+} LogSpec;
+
+/// Header of each message in ring. Encoded arguments follow it.
+typedef struct LogRecord {
+    u32             size; // total size including header, 0 marks padding till end of ring
+    const LogSite  *site;
+    u64             time_ns; // realtime, coarse
+} LogRecord;
+
+/// Binary log starts with this magic and version, followed by a sequence of
+/// records, each starting with one of `LogBinaryKind`.
+#define LOG_BINARY_MAGIC   "MLOG"
+#define LOG_BINARY_VERSION 1
+
+typedef enum {
+    /// u32 id, i32 type, i32 line, then tag, file and format as (u32 size, bytes with nul)
+    LOG_BINARY_SITE = 1,
+
+    /// u32 site id, u64 realtime in ns, u32 args size, then encoded args.
+    LOG_BINARY_MESSAGE,
+
+    /// u64 number of messages dropped.
+    LOG_BINARY_DROPPED,
+
+    /// u32 site id, u64 realtime in ns, u64 number of messages suppressed by rate limit.
+    LOG_BINARY_SUPPRESSED,
+} LogBinaryKind;
+
+typedef struct LogRing LogRing;
+
+struct LogRing {
+    /// Written only by producer.
+    _Atomic u64 head __attribute__ ((aligned (64)));
+
+    /// Written only by consumer.
+    _Atomic u64 tail __attribute__ ((aligned (64)));
+
+    /// Number of messages dropped because ring was full.
+    _Atomic u64 dropped;
 
-#define LOCK()   pthread_mutex_lock(&lock);
-#define UNLOCK() pthread_mutex_unlock(&lock);
+    /// Set when owner thread exits, so another thread can adopt this ring.
+    _Atomic bool released;
 
-void LogInit(bool redirect) {
-    if(redirect) {
+    LogRing *next;
+    u8       data[LOG_RING_SIZE];
+};
+
+static FILE *stderror = NULL;
+
+/// Sites that had messages suppressed by rate limit.
+static _Atomic (LogSite *) limited_sites = NULL;
+
+/// All rings ever created. Rings are never freed, only reused.
+static _Atomic (LogRing *) rings = NULL;
+
+static __thread LogRing *thread_ring = NULL;
+static pthread_key_t     thread_ring_key;
+
+/// Only one consumer at a time, either drain thread or someone calling `LogFlush`.
+static pthread_mutex_t drain_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t  start_once = PTHREAD_ONCE_INIT;
+static pthread_t       drain_thread;
+static _Atomic bool    drain_running = false;
+static _Atomic bool    drain_stop    = false;
+
+/// Drain thread sleeps on `drain_wake` when all rings are empty, with `drain_waiting`
+/// set, and first producer to see it set wakes it up.
+static pthread_mutex_t drain_wake_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  drain_wake      = PTHREAD_COND_INITIALIZER;
+static _Atomic bool    drain_waiting   = false;
+
+void LogInit (bool redirect) {
+    if (redirect) {
         // Get the current time
-        time_t     raw_time;
-        struct tm *time_info;
-        char       time_buffer[20] = {0};
+        time_t    raw_time;
+        struct tm time_info;
+        char      time_buffer[20] = {0};
 
-        time(&raw_time);
-        time_info = localtime(&raw_time);
-        strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%d-%H-%M-%S", time_info);
+        time (&raw_time);
+        localtime_r (&raw_time, &time_info);
+        strftime (time_buffer, sizeof (time_buffer), "%Y-%m-%d-%H-%M-%S", &time_info);
 
         // generate log file name
         char file_name[128] = {0};
-        snprintf(file_name, 127, "/tmp/beam-%s", time_buffer);
-        printf("storing logs in %s\n", file_name);
+        snprintf (file_name, 127, "/tmp/beam-%s", time_buffer);
+        printf ("storing logs in %s\n", file_name);
 
         // Open the file for writing (create if it doesn't exist, overwrite if it does)
-        stderror = freopen(file_name, "w", stderr);
+        stderror = freopen (file_name, "w", stderr);
 
-        if(stderror == NULL) {
-            printf("error opening file : %s\n", strerror(errno));
+        if (stderror == NULL) {
+            printf ("error opening file : %s\n", strerror (errno));
             return;
         }
 
-        setbuf(stderror, 0);
+        setbuf (stderror, 0);
     } else {
-        setbuf(stderr, 0);
+        setbuf (stderr, 0);
     }
 }
 
 
-void LogDeinit() {
-    if(stderror) {
-        fclose(stderror);
+// Parse a single conversion specification, `fmt` points just after '%'.
+// Returns pointer to character after conversion specifier.
+static const char *parse_spec (const char *fmt, LogSpec *spec) {
+    spec->kind           = LOG_ARG_NONE;
+    spec->nstars         = 0;
+    spec->star_precision = false;
+    spec->precision      = -1;
+
+    // flags
+    while (*fmt && strchr ("-+ #0'", *fmt)) {
+        fmt++;
+    }
+
+    // width
+    if (*fmt == '*') {
+        spec->nstars++;
+        fmt++;
+    }
+    while (*fmt >= '0' && *fmt <= '9') {
+        fmt++;
+    }
+
+    // precision
+    if (*fmt == '.') {
+        fmt++;
+        if (*fmt == '*') {
+            spec->nstars++;
+            spec->star_precision = true;
+            fmt++;
+        }
+        // precisions past size of a record bound nothing, and aren't parsed further
+        spec->precision = 0;
+        while (*fmt >= '0' && *fmt <= '9') {
+            if (spec->precision < LOG_RECORD_MAX_SIZE) {
+                spec->precision = spec->precision * 10 + (*fmt - '0');
+            }
+            fmt++;
+        }
+    }
+
+    // length modifier
+    LogArgKind int_kind = LOG_ARG_INT;
+    bool       is_long  = false;
+    switch (*fmt) {
+        case 'h' :
+            fmt += fmt[1] == 'h' ? 2 : 1;
+            break;
+        case 'l' :
+            if (fmt[1] == 'l') {
+                int_kind  = LOG_ARG_LLONG;
+                fmt      += 2;
+            } else {
+                int_kind = LOG_ARG_LONG;
+                is_long  = true;
+                fmt++;
+            }
+            break;
+        case 'j' :
+        case 'q' :
+            int_kind = LOG_ARG_LLONG;
+            fmt++;
+            break;
+        case 'z' :
+        case 't' :
+            int_kind = LOG_ARG_SIZE;
+            fmt++;
+            break;
+        case 'L' :
+            int_kind = LOG_ARG_LDOUBLE;
+            fmt++;
+            break;
+        default :
+            break;
     }
+
+    switch (*fmt) {
+        case 'd' :
+        case 'i' :
+        case 'u' :
+        case 'o' :
+        case 'x' :
+        case 'X' :
+            spec->kind = int_kind == LOG_ARG_LDOUBLE ? LOG_ARG_LLONG : int_kind;
+            break;
+        case 'c' :
+            spec->kind = LOG_ARG_INT;
+            break;
+        case 'f' :
+        case 'F' :
+        case 'e' :
+        case 'E' :
+        case 'g' :
+        case 'G' :
+        case 'a' :
+        case 'A' :
+            spec->kind = int_kind == LOG_ARG_LDOUBLE ? LOG_ARG_LDOUBLE : LOG_ARG_DOUBLE;
+            break;
+        case 's' :
+            // wide strings are not copied, only their address is printed
+            spec->kind = is_long ? LOG_ARG_PTR : LOG_ARG_STR;
+            break;
+        case 'p' :
+            spec->kind = LOG_ARG_PTR;
+            break;
+        case 'n' :
+            spec->kind = LOG_ARG_WRITE_COUNT;
+            break;
+        case '\0' :
+            return fmt;
+        default :
+            break;
+    }
+
+    return fmt + 1;
 }
 
 
-void LogWrite(LogMessageType type, const char *tag, int line, const char *format, ...) {
-    if(!tag || !format) {
-        LOG_ERROR("invalid arguments.");
-        return;
+// Encode arguments of a message after it's header into `buf`.
+// Returns total size of encoded message.
+static size_t encode_record (u8 *buf, const char *format, va_list args) {
+    size_t pos = LOG_ALIGN (sizeof (LogRecord));
+
+    for (const char *iter = format; *iter;) {
+        if (*iter++ != '%') {
+            continue;
+        }
+        if (*iter == '%') {
+            iter++;
+            continue;
+        }
+
+        LogSpec spec;
+        iter = parse_spec (iter, &spec);
+
+        // negative precision is same as none
+        int precision = spec.precision;
+        for (u32 s = 0; s < spec.nstars; s++) {
+            int star = va_arg (args, int);
+            if (spec.star_precision && s + 1 == spec.nstars) {
+                precision = star;
+            }
+            *(i64 *)(buf + pos)  = star;
+            pos                 += 8;
+        }
+
+        switch (spec.kind) {
+            case LOG_ARG_INT :
+                *(i64 *)(buf + pos) = va_arg (args, int);
+                break;
+            case LOG_ARG_LONG :
+                *(i64 *)(buf + pos) = va_arg (args, long);
+                break;
+            case LOG_ARG_LLONG :
+                *(i64 *)(buf + pos) = va_arg (args, long long);
+                break;
+            case LOG_ARG_SIZE :
+                *(u64 *)(buf + pos) = va_arg (args, size_t);
+                break;
+            case LOG_ARG_DOUBLE :
+                *(f64 *)(buf + pos) = va_arg (args, double);
+                break;
+            case LOG_ARG_LDOUBLE : {
+                long double v = va_arg (args, long double);
+                memcpy (buf + pos, &v, sizeof (v));
+                pos += LOG_ALIGN (sizeof (v)) - 8;
+                break;
+            }
+            case LOG_ARG_PTR :
+            case LOG_ARG_WRITE_COUNT :
+                *(void **)(buf + pos) = va_arg (args, void *);
+                break;
+            case LOG_ARG_STR : {
+                // strings are copied, as they might not live till message is written,
+                // and never read past precision, as they needn't be terminated before it
+                const char *str   = va_arg (args, const char *);
+                size_t      avail = LOG_RECORD_MAX_SIZE - pos - 8 - 1;
+                if (precision >= 0 && (size_t)precision < avail) {
+                    avail = precision;
+                }
+                size_t len = str ? strnlen (str, avail) : 0;
+
+                *(i64 *)(buf + pos) = str ? (i64)len : -1;
+                memcpy (buf + pos + 8, str, len);
+                buf[pos + 8 + len]  = 0;
+                pos                += LOG_ALIGN (len + 1);
+                break;
+            }
+            case LOG_ARG_NONE :
+                continue;
+        }
+        pos += 8;
+
+        // no space left for any more arguments, rest are not captured
+        if (pos + 32 > LOG_RECORD_MAX_SIZE) {
+            break;
+        }
+    }
+
+    return pos;
+}
+
+
+// Get ring buffer of calling thread, adopting a released one or creating a new one.
+static LogRing *get_thread_ring() {
+    if (thread_ring) {
+        return thread_ring;
+    }
+
+    // only adopt drained rings, so new thread starts with full capacity
+    for (LogRing *ring = atomic_load (&rings); ring; ring = ring->next) {
+        bool released = true;
+        if (atomic_load (&ring->head) == atomic_load (&ring->tail) &&
+            atomic_compare_exchange_strong (&ring->released, &released, false)) {
+            thread_ring = ring;
+            break;
+        }
     }
 
-    // Get the current time
-    time_t     raw_time;
-    struct tm *time_info;
-    char       time_buffer[20];
+    if (!thread_ring) {
+        LogRing *ring = calloc (1, sizeof (LogRing));
+        if (!ring) {
+            return NULL;
+        }
+
+        ring->next = atomic_load (&rings);
+        while (!atomic_compare_exchange_weak (&rings, &ring->next, ring)) {}
+        thread_ring = ring;
+    }
 
-    time(&raw_time);
-    time_info = localtime(&raw_time);
-    strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%d %H:%M:%S", time_info);
+    // release ring when thread exits
+    pthread_setspecific (thread_ring_key, thread_ring);
 
+    return thread_ring;
+}
+
+
+static void release_thread_ring (void *ring) {
+    atomic_store_explicit (&((LogRing *)ring)->released, true, memory_order_release);
+}
+
+
+// Where and how formatted messages are written.
+typedef struct LogOutput {
+    int    fd;
+    bool   binary;
+    size_t len;
+    char   buf[LOG_OUTPUT_SIZE];
+
+    // binary log : next id to assign to a site
+    u32 next_site_id;
+
+    // binary log : incremented for each new binary log
+    u32 generation;
+} LogOutput;
+
+/// Output used by drain thread, protected by `drain_lock`.
+static LogOutput output = {.fd = STDERR_FILENO};
+
+static void output_flush (LogOutput *out) {
+    size_t written = 0;
+    while (written < out->len) {
+        ssize_t ret = write (out->fd, out->buf + written, out->len - written);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        } else if (ret <= 0) {
+            break;
+        }
+        written += ret;
+    }
+    out->len = 0;
+}
+
+
+static void output_append (LogOutput *out, const char *fmt, ...) {
+    size_t avail = LOG_OUTPUT_SIZE - out->len;
+
+    va_list args;
+    va_start (args, fmt);
+    int len = vsnprintf (out->buf + out->len, avail, fmt, args);
+    va_end (args);
+
+    if (len > 0) {
+        out->len += (size_t)len < avail ? (size_t)len : avail - 1;
+    }
+}
+
+
+static void output_append_bytes (LogOutput *out, const void *data, size_t size) {
+    if (out->len + size > LOG_OUTPUT_SIZE) {
+        output_flush (out);
+    }
+    memcpy (out->buf + out->len, data, size);
+    out->len += size;
+}
+
+
+// Format a single conversion spec with it's arguments decoded from `args`.
+// Advances `pos` past consumed arguments. Fails without writing anything if
+// arguments don't fit in `args_size`, which happens only for corrupt binary logs.
+static bool output_append_arg (
+    LogOutput  *out,
+    const char *spec_str,
+    LogSpec    *spec,
+    const u8   *args,
+    size_t      args_size,
+    size_t     *pos
+) {
+    size_t p    = *pos;
+    size_t need = spec->nstars * 8;
+    switch (spec->kind) {
+        case LOG_ARG_NONE :
+            break;
+        case LOG_ARG_LDOUBLE :
+            need += LOG_ALIGN (sizeof (long double));
+            break;
+        default :
+            need += 8;
+            break;
+    }
+    if (need > args_size - p) {
+        return false;
+    }
+
+    int stars[2] = {0};
+    for (u32 s = 0; s < spec->nstars; s++) {
+        stars[s]  = (int)*(i64 *)(args + p);
+        p        += 8;
+    }
+
+#define APPEND_WITH_STARS(value)                                                                   \
+    do {                                                                                           \
+        if (spec->nstars == 2) {                                                                   \
+            output_append (out, spec_str, stars[0], stars[1], value);                              \
+        } else if (spec->nstars == 1) {                                                            \
+            output_append (out, spec_str, stars[0], value);                                        \
+        } else {                                                                                   \
+            output_append (out, spec_str, value);                                                  \
+        }                                                                                          \
+    } while (0)
+
+    switch (spec->kind) {
+        case LOG_ARG_INT :
+            APPEND_WITH_STARS ((int)*(i64 *)(args + p));
+            break;
+        case LOG_ARG_LONG :
+            APPEND_WITH_STARS ((long)*(i64 *)(args + p));
+            break;
+        case LOG_ARG_LLONG :
+            APPEND_WITH_STARS ((long long)*(i64 *)(args + p));
+            break;
+        case LOG_ARG_SIZE :
+            APPEND_WITH_STARS ((size_t)*(u64 *)(args + p));
+            break;
+        case LOG_ARG_DOUBLE :
+            APPEND_WITH_STARS (*(f64 *)(args + p));
+            break;
+        case LOG_ARG_LDOUBLE : {
+            long double v;
+            memcpy (&v, args + p, sizeof (v));
+            APPEND_WITH_STARS (v);
+            p += LOG_ALIGN (sizeof (v)) - 8;
+            break;
+        }
+        case LOG_ARG_PTR :
+            APPEND_WITH_STARS (*(void **)(args + p));
+            break;
+        case LOG_ARG_STR : {
+            // string must end with it's nul, within arguments
+            i64    len   = *(i64 *)(args + p);
+            size_t avail = args_size - p - 8;
+            size_t size  = LOG_ALIGN (len < 0 ? 1 : (u64)len + 1);
+            if ((len >= 0 && ((u64)len >= avail || args[p + 8 + len])) || size > avail) {
+                return false;
+            }
+            APPEND_WITH_STARS (len < 0 ? NULL : (const char *)(args + p + 8));
+            p += size;
+            break;
+        }
+        case LOG_ARG_WRITE_COUNT :
+            break;
+        case LOG_ARG_NONE :
+            output_append (out, "%s", spec_str);
+            *pos = p;
+            return true;
+    }
+
+#undef APPEND_WITH_STARS
+
+    *pos = p + 8;
+    return true;
+}
+
+
+// Append "[TYPE] [time] [tag:line] " prefix of a text message.
+// Returns offset in output buffer message starts at.
+static size_t output_append_prefix (LogOutput *out, const LogSite *site, u64 time_ns) {
     const char *msg_type = NULL;
-    switch(type) {
+    switch (site->type) {
         case LOG_MESSAGE_TYPE_INFO :
             msg_type = "INFO";
             break;
         case LOG_MESSAGE_TYPE_ERROR :
-            msg_type = "INFO";
+            msg_type = "ERROR";
             break;
         case LOG_MESSAGE_TYPE_FATAL :
-            msg_type = "INFO";
+            msg_type = "FATAL";
             break;
         default :
             msg_type = "UNKNOWN_MESSAGE_TYPE";
             break;
     }
 
-    LOCK();
+    // make sure a complete message fits, long ones get truncated
+    if (out->len + LOG_RECORD_MAX_SIZE * 2 > LOG_OUTPUT_SIZE) {
+        output_flush (out);
+    }
+
+    size_t      start    = out->len;
+    const char *time_str = ClockWallTimeStr (time_ns);
+    output_append (out, "[%s] [%s] [%s:%d] ", msg_type, time_str, site->tag, site->line);
+    return start;
+}
+
+
+// Format a message as text.
+// Fails, writing nothing, if arguments don't match site's format. This is only
+// possible in corrupt binary logs.
+static bool output_append_text (
+    LogOutput     *out,
+    const LogSite *site,
+    u64            time_ns,
+    const u8      *args,
+    size_t         args_size
+) {
+    size_t msg_start = output_append_prefix (out, site, time_ns);
+    size_t pos       = 0;
+    for (const char *iter = site->format; *iter;) {
+        const char *start = iter;
+        while (*iter && *iter != '%') {
+            iter++;
+        }
+        if (iter != start) {
+            output_append (out, "%.*s", (int)(iter - start), start);
+        }
+        if (!*iter) {
+            break;
+        }
+
+        if (iter[1] == '%') {
+            output_append (out, "%%");
+            iter += 2;
+            continue;
+        }
+
+        // copy out single conversion spec to format it's argument with
+        LogSpec spec;
+        start = iter;
+        iter  = parse_spec (iter + 1, &spec);
+
+        char   spec_str[64];
+        size_t spec_len = iter - start < 63 ? iter - start : 63;
+        memcpy (spec_str, start, spec_len);
+        spec_str[spec_len] = 0;
+
+        if (pos >= args_size) {
+            continue;
+        }
+        if (!output_append_arg (out, spec_str, &spec, args, args_size, &pos)) {
+            out->len = msg_start;
+            return false;
+        }
+    }
+
+    output_append (out, "\n");
+    return true;
+}
+
 
-    // Print the log prefix to stderr
-    fprintf(stderr, "[%s] [%s] [%s:%d] ", msg_type, time_buffer, tag, line);
+static void output_append_dropped (LogOutput *out, u64 dropped) {
+    if (out->binary) {
+        u8 kind = LOG_BINARY_DROPPED;
+        output_append_bytes (out, &kind, sizeof (kind));
+        output_append_bytes (out, &dropped, sizeof (dropped));
+    } else {
+        output_flush (out);
+        output_append (out, "[ERROR] [log] %llu log messages dropped, ring buffer full\n", dropped);
+    }
+}
+
+
+static void output_append_string (LogOutput *out, const char *str) {
+    u32 len = str ? strlen (str) + 1 : 0;
+    output_append_bytes (out, &len, sizeof (len));
+    output_append_bytes (out, str, len);
+}
+
+
+// Describe site in binary log once, before it's first use.
+static void output_append_site (LogOutput *out, LogSite *site) {
+    if (site->generation != out->generation) {
+        site->generation = out->generation;
+        site->id         = ++out->next_site_id;
+
+        u8  kind = LOG_BINARY_SITE;
+        i32 type = site->type;
+        i32 line = site->line;
+        output_append_bytes (out, &kind, sizeof (kind));
+        output_append_bytes (out, &site->id, sizeof (site->id));
+        output_append_bytes (out, &type, sizeof (type));
+        output_append_bytes (out, &line, sizeof (line));
+        output_append_string (out, site->tag);
+        output_append_string (out, site->file);
+        output_append_string (out, site->format);
+    }
+}
+
+
+static void output_append_suppressed (LogOutput *out, LogSite *site, u64 time_ns, u64 count) {
+    if (out->binary) {
+        output_append_site (out, site);
+
+        u8 kind = LOG_BINARY_SUPPRESSED;
+        output_append_bytes (out, &kind, sizeof (kind));
+        output_append_bytes (out, &site->id, sizeof (site->id));
+        output_append_bytes (out, &time_ns, sizeof (time_ns));
+        output_append_bytes (out, &count, sizeof (count));
+    } else {
+        output_append_prefix (out, site, time_ns);
+        output_append (out, "message repeated %llu times (suppressed)\n", count);
+    }
+}
+
+
+static void output_append_record (LogOutput *out, const LogRecord *record) {
+    const u8 *args      = (const u8 *)record + LOG_ALIGN (sizeof (LogRecord));
+    size_t    args_size = record->size - LOG_ALIGN (sizeof (LogRecord));
+
+    if (!out->binary) {
+        output_append_text (out, record->site, record->time_ns, args, args_size);
+        return;
+    }
+
+    LogSite *site = (LogSite *)record->site;
+    output_append_site (out, site);
+
+    u8  kind = LOG_BINARY_MESSAGE;
+    u32 size = args_size;
+    output_append_bytes (out, &kind, sizeof (kind));
+    output_append_bytes (out, &site->id, sizeof (site->id));
+    output_append_bytes (out, &record->time_ns, sizeof (record->time_ns));
+    output_append_bytes (out, &size, sizeof (size));
+    output_append_bytes (out, args, size);
+}
+
+
+bool LogSiteRateLimited (LogSite *site) {
+    u64 now        = ClockMonotonicCoarseNs();
+    u64 window_ns  = LOG_RATE_LIMIT_WINDOW_MS * 1000000ULL;
+    u64 window_end = atomic_load_explicit (&site->window_end_ns, memory_order_relaxed);
+
+    if (!window_end) {
+        // first burst is over, window starts now
+        atomic_compare_exchange_strong (&site->window_end_ns, &window_end, now + window_ns);
+    } else if (now >= window_end &&
+               atomic_compare_exchange_strong (&site->window_end_ns, &window_end, now + window_ns)) {
+        // only one thread starts a new window
+        atomic_store_explicit (&site->count, 1, memory_order_relaxed);
+        return false;
+    }
+
+    atomic_fetch_add_explicit (&site->suppressed, 1, memory_order_relaxed);
+
+    // link site for reporting suppressed messages, only once
+    bool limited = false;
+    if (atomic_compare_exchange_strong (&site->limited, &limited, true)) {
+        site->next_limited = atomic_load (&limited_sites);
+        while (!atomic_compare_exchange_weak (&limited_sites, &site->next_limited, site)) {}
+    }
+
+    return true;
+}
+
+
+// Report messages suppressed by rate limit, once every window per site,
+// or right away if `all` is set.
+static void report_suppressed (bool all) {
+    u64 now  = ClockMonotonicCoarseNs();
+    u64 wall = ClockRealtimeCoarseNs();
+
+    for (LogSite *site = atomic_load (&limited_sites); site; site = site->next_limited) {
+        if (!atomic_load_explicit (&site->suppressed, memory_order_relaxed) ||
+            (!all && now < site->last_report_ns + LOG_RATE_LIMIT_WINDOW_MS * 1000000ULL)) {
+            continue;
+        }
+
+        u64 count = atomic_exchange_explicit (&site->suppressed, 0, memory_order_relaxed);
+        if (count) {
+            output_append_suppressed (&output, site, wall, count);
+            site->last_report_ns = now;
+        }
+    }
+}
+
+
+// Drain all rings. Caller must hold `drain_lock`.
+// Returns number of messages written.
+static size_t drain_rings (bool all) {
+    size_t count = 0;
+
+    for (LogRing *ring = atomic_load (&rings); ring; ring = ring->next) {
+        u64 dropped = atomic_exchange_explicit (&ring->dropped, 0, memory_order_relaxed);
+        if (dropped) {
+            output_append_dropped (&output, dropped);
+        }
+
+        u64 tail = atomic_load_explicit (&ring->tail, memory_order_relaxed);
+        u64 head = atomic_load_explicit (&ring->head, memory_order_acquire);
+
+        while (tail != head) {
+            LogRecord *record = (LogRecord *)(ring->data + (tail & (LOG_RING_SIZE - 1)));
+            if (!record->size) {
+                // padding till end of ring
+                tail += LOG_RING_SIZE - (tail & (LOG_RING_SIZE - 1));
+                continue;
+            }
+
+            output_append_record (&output, record);
+            tail += record->size;
+            count++;
+        }
+
+        atomic_store_explicit (&ring->tail, tail, memory_order_release);
+    }
+
+    report_suppressed (all);
+    output_flush (&output);
+    return count;
+}
+
+
+static bool rings_empty() {
+    for (LogRing *ring = atomic_load (&rings); ring; ring = ring->next) {
+        if (atomic_load (&ring->head) != atomic_load (&ring->tail)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// Wake drain thread, if it's waiting for messages. Message must be published with
+// a sequentially consistent store, so that either this sees `drain_waiting` set, or
+// drain thread, which sets it before looking at rings again, sees the message.
+static void wake_drain_thread() {
+    if (atomic_load (&drain_waiting) && atomic_exchange (&drain_waiting, false)) {
+        pthread_mutex_lock (&drain_wake_lock);
+        pthread_cond_signal (&drain_wake);
+        pthread_mutex_unlock (&drain_wake_lock);
+    }
+}
+
+
+static void *drain_thread_main (void *arg) {
+    (void)arg;
+
+    while (!atomic_load (&drain_stop)) {
+        pthread_mutex_lock (&drain_lock);
+        size_t count = drain_rings (false);
+        pthread_mutex_unlock (&drain_lock);
+        if (count) {
+            continue;
+        }
+
+        // lock is held till wait starts, so producer's wake up can't be missed
+        pthread_mutex_lock (&drain_wake_lock);
+        atomic_store (&drain_waiting, true);
+        if (rings_empty() && !atomic_load (&drain_stop)) {
+            struct timespec deadline;
+            clock_gettime (CLOCK_REALTIME, &deadline);
+            u64 nsec          = deadline.tv_nsec + LOG_DRAIN_TIMEOUT_NS;
+            deadline.tv_sec  += nsec / 1000000000;
+            deadline.tv_nsec  = nsec % 1000000000;
+            pthread_cond_timedwait (&drain_wake, &drain_wake_lock, &deadline);
+        }
+        atomic_store (&drain_waiting, false);
+        pthread_mutex_unlock (&drain_wake_lock);
+    }
+
+    return NULL;
+}
+
+
+static void stop_drain_thread() {
+    if (atomic_exchange (&drain_running, false)) {
+        pthread_mutex_lock (&drain_wake_lock);
+        atomic_store (&drain_stop, true);
+        pthread_cond_signal (&drain_wake);
+        pthread_mutex_unlock (&drain_wake_lock);
+        pthread_join (drain_thread, NULL);
+    }
+    LogFlush();
+}
+
+
+// Make sure no consumer is active while forking, and that forked child
+// (which won't have a drain thread) writes messages synchronously.
+static void before_fork() {
+    pthread_mutex_lock (&drain_lock);
+    pthread_mutex_lock (&drain_wake_lock);
+}
+
+
+static void after_fork_parent() {
+    pthread_mutex_unlock (&drain_wake_lock);
+    pthread_mutex_unlock (&drain_lock);
+}
+
+
+static void after_fork_child() {
+    atomic_store (&drain_running, false);
+    atomic_store (&drain_waiting, false);
+    pthread_mutex_unlock (&drain_wake_lock);
+
+    // pending messages belong to parent, it'll write them
+    for (LogRing *ring = atomic_load (&rings); ring; ring = ring->next) {
+        atomic_store (&ring->tail, atomic_load (&ring->head));
+        atomic_store (&ring->dropped, 0);
+    }
+    for (LogSite *site = atomic_load (&limited_sites); site; site = site->next_limited) {
+        atomic_store (&site->suppressed, 0);
+    }
+
+    pthread_mutex_unlock (&drain_lock);
+}
+
+
+static void start_drain_thread() {
+    pthread_key_create (&thread_ring_key, release_thread_ring);
+    pthread_atfork (before_fork, after_fork_parent, after_fork_child);
+
+    if (!pthread_create (&drain_thread, NULL, drain_thread_main, NULL)) {
+        atomic_store (&drain_running, true);
+    }
+
+    // don't lose pending messages on exit
+    atexit (stop_drain_thread);
+}
+
+
+void LogDeinit() {
+    LogFlush();
+
+    if (stderror) {
+        fclose (stderror);
+        stderror = NULL;
+    }
+
+    pthread_mutex_lock (&drain_lock);
+    if (output.binary) {
+        close (output.fd);
+        output.fd     = STDERR_FILENO;
+        output.binary = false;
+    }
+    pthread_mutex_unlock (&drain_lock);
+}
+
+
+bool LogInitBinary (const char *path) {
+    if (!path) {
+        LOG_ERROR ("invalid arguments.");
+        return false;
+    }
+
+    int fd = open (path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_ERROR ("open() failed : %s.", strerror (errno));
+        return false;
+    }
+
+    // write pending text messages to old output first
+    LogFlush();
+
+    pthread_mutex_lock (&drain_lock);
+    output.fd     = fd;
+    output.binary = true;
+
+    u32 version = LOG_BINARY_VERSION;
+    output_append_bytes (&output, LOG_BINARY_MAGIC, 4);
+    output_append_bytes (&output, &version, sizeof (version));
+    output_flush (&output);
+
+    // sites already described in a previous binary log must be described again
+    output.next_site_id = 0;
+    output.generation++;
+    pthread_mutex_unlock (&drain_lock);
+
+    return true;
+}
+
+
+void LogFlush() {
+    pthread_mutex_lock (&drain_lock);
+    drain_rings (true);
+    pthread_mutex_unlock (&drain_lock);
+}
+
+
+void LogWrite (const LogSite *site, const char *format, ...) {
+    if (!site || !format) {
+        LOG_ERROR ("invalid arguments.");
+        return;
+    }
+
+    // arguments are decoded later using site's format, so both must agree
+    assert (format == site->format || !strcmp (format, site->format));
+
+    pthread_once (&start_once, start_drain_thread);
+
+    LogRing *ring = get_thread_ring();
+    if (!ring) {
+        return;
+    }
+
+    // encode message on stack first, and then copy it to ring in one go
+    u8 buf[LOG_RECORD_MAX_SIZE] __attribute__ ((aligned (16)));
 
-    // Process the variadic arguments and print the log message
     va_list args;
-    va_start(args, format);
-    vfprintf(stderr, format, args);
-    va_end(args);
+    va_start (args, format);
+    size_t size = encode_record (buf, format, args);
+    va_end (args);
 
-    // Print a newline for better readability
-    fprintf(stderr, "\n");
+    LogRecord *record = (LogRecord *)buf;
+    record->size      = size;
+    record->site      = site;
+    record->time_ns   = ClockRealtimeCoarseNs();
+
+    u64    head   = atomic_load_explicit (&ring->head, memory_order_relaxed);
+    u64    tail   = atomic_load_explicit (&ring->tail, memory_order_acquire);
+    size_t offset = head & (LOG_RING_SIZE - 1);
+
+    // records never wrap around, pad till end of ring if it won't fit there
+    size_t pad = offset + size > LOG_RING_SIZE ? LOG_RING_SIZE - offset : 0;
+    if (head + pad + size - tail > LOG_RING_SIZE) {
+        atomic_fetch_add_explicit (&ring->dropped, 1, memory_order_relaxed);
+    } else {
+        if (pad) {
+            ((LogRecord *)(ring->data + offset))->size = 0;
+            head                                       += pad;
+            offset                                      = 0;
+        }
+
+        memcpy (ring->data + offset, buf, size);
+        atomic_store (&ring->head, head + size);
+    }
+
+    // fatal messages are written out right away, process might not live much longer
+    if (site->type == LOG_MESSAGE_TYPE_FATAL || !atomic_load (&drain_running)) {
+        LogFlush();
+    } else {
+        wake_drain_thread();
+    }
+}
+
+
+static bool decode_bytes (const u8 **iter, const u8 *end, void *dst, size_t size) {
+    if ((size_t)(end - *iter) < size) {
+        return false;
+    }
+    memcpy (dst, *iter, size);
+    *iter += size;
+    return true;
+}
+
+
+static bool decode_string (const u8 **iter, const u8 *end, const char **str) {
+    u32 len = 0;
+    if (!decode_bytes (iter, end, &len, sizeof (len)) || (size_t)(end - *iter) < len ||
+        (len && (*iter)[len - 1])) {
+        return false;
+    }
+    *str   = len ? (const char *)*iter : "";
+    *iter += len;
+    return true;
+}
+
+
+bool LogDecode (int in_fd, int out_fd) {
+    u8        *data  = NULL;
+    size_t     size  = 0;
+    LogSite   *sites = NULL;
+    u32        nsite = 0;
+    LogOutput *out   = calloc (1, sizeof (LogOutput));
+    u8        *args  = malloc (LOG_RECORD_MAX_SIZE);
+    bool       ok    = false;
+
+    if (!out || !args) {
+        LOG_ERROR ("malloc() failed : %s.", strerror (errno));
+        goto DONE;
+    }
+    out->fd = out_fd;
+
+    // read complete log
+    for (size_t cap = 0;;) {
+        if (size == cap) {
+            u8 *tmp = realloc (data, cap = cap ? cap * 2 : 64 * 1024);
+            if (!tmp) {
+                LOG_ERROR ("realloc() failed : %s.", strerror (errno));
+                goto DONE;
+            }
+            data = tmp;
+        }
+
+        ssize_t ret = read (in_fd, data + size, cap - size);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        } else if (ret < 0) {
+            LOG_ERROR ("read() failed : %s.", strerror (errno));
+            goto DONE;
+        } else if (!ret) {
+            break;
+        }
+        size += ret;
+    }
+
+    const u8 *iter    = data;
+    const u8 *end     = data + size;
+    u32       version = 0;
+    if (size < 8 || memcmp (data, LOG_BINARY_MAGIC, 4)) {
+        LOG_ERROR ("not a binary log.");
+        goto DONE;
+    }
+    iter += 4;
+    decode_bytes (&iter, end, &version, sizeof (version));
+    if (version != LOG_BINARY_VERSION) {
+        LOG_ERROR ("unsupported binary log version %u.", version);
+        goto DONE;
+    }
+
+    // a record that fails to decode is left in `record`
+    const u8 *record = iter;
+    while ((record = iter) < end) {
+        u8 kind = *iter++;
+
+        if (kind == LOG_BINARY_SITE) {
+            LogSite site = {0};
+            i32     type = 0;
+            if (!decode_bytes (&iter, end, &site.id, sizeof (site.id)) ||
+                !decode_bytes (&iter, end, &type, sizeof (type)) ||
+                !decode_bytes (&iter, end, &site.line, sizeof (site.line)) ||
+                !decode_string (&iter, end, &site.tag) || !decode_string (&iter, end, &site.file) ||
+                !decode_string (&iter, end, &site.format) || !site.id) {
+                break;
+            }
+            site.type = type;
+
+            // sites are numbered in order they are described in
+            if (site.id > nsite + 1) {
+                break;
+            } else if (site.id > nsite) {
+                LogSite *tmp = realloc (sites, sizeof (LogSite) * ((size_t)site.id + 1));
+                if (!tmp) {
+                    LOG_ERROR ("realloc() failed : %s.", strerror (errno));
+                    goto DONE;
+                }
+                memset (tmp + nsite + 1, 0, sizeof (LogSite) * (site.id - nsite));
+                sites = tmp;
+                nsite = site.id;
+            }
+            sites[site.id] = site;
+        } else if (kind == LOG_BINARY_MESSAGE) {
+            u32 id        = 0;
+            u64 time_ns   = 0;
+            u32 args_size = 0;
+            if (!decode_bytes (&iter, end, &id, sizeof (id)) ||
+                !decode_bytes (&iter, end, &time_ns, sizeof (time_ns)) ||
+                !decode_bytes (&iter, end, &args_size, sizeof (args_size)) ||
+                args_size > LOG_RECORD_MAX_SIZE || !decode_bytes (&iter, end, args, args_size) ||
+                !id || id > nsite || !sites[id].id ||
+                !output_append_text (out, sites + id, time_ns, args, args_size)) {
+                break;
+            }
+        } else if (kind == LOG_BINARY_SUPPRESSED) {
+            u32 id      = 0;
+            u64 time_ns = 0;
+            u64 count   = 0;
+            if (!decode_bytes (&iter, end, &id, sizeof (id)) ||
+                !decode_bytes (&iter, end, &time_ns, sizeof (time_ns)) ||
+                !decode_bytes (&iter, end, &count, sizeof (count)) || !id || id > nsite ||
+                !sites[id].id) {
+                break;
+            }
+
+            output_append_suppressed (out, sites + id, time_ns, count);
+        } else if (kind == LOG_BINARY_DROPPED) {
+            u64 dropped = 0;
+            if (!decode_bytes (&iter, end, &dropped, sizeof (dropped))) {
+                break;
+            }
+            output_append_dropped (out, dropped);
+        } else {
+            break;
+        }
+    }
+
+    ok = record == end;
+    if (!ok) {
+        LOG_ERROR ("corrupted binary log at offset %zu.", (size_t)(record - data));
+    }
+    output_flush (out);
 
-    UNLOCK();
+DONE:
+    free (data);
+    free (sites);
+    free (out);
+    free (args);
+    return ok;
 }
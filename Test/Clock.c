@@ -0,0 +1,101 @@
+#include <Misra/Std/Clock.h>
+
+// platform
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+u64 npass  = 0;
+u64 ntotal = 0;
+
+#define TEST(cond)                                                                                 \
+    do {                                                                                           \
+        ntotal++;                                                                                  \
+        if (!(cond)) {                                                                             \
+            fprintf (stderr, "[FAIL @ LINE %d] : %s\n", __LINE__, #cond);                          \
+        } else {                                                                                   \
+            npass++;                                                                               \
+        }                                                                                          \
+    } while (0)
+
+#define RESULT()                                                                                   \
+    if (ntotal == npass)                                                                           \
+        fprintf (stderr, "\nALL PASS! TOTAL = %llu\n", ntotal);                                    \
+    else                                                                                           \
+        fprintf (stderr, "%llu/%llu PASS\n", npass, ntotal)
+
+static u64 monotonic_ns (void) {
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// difference of `a` and `b` is within 2% of `b`, plus 1ms of scheduling noise
+static bool close_to (u64 a, u64 b) {
+    u64 diff = a > b ? a - b : b - a;
+    return diff <= b / 50 + 1000000;
+}
+
+// Fast clock and calibrated timestamp counter measure same intervals as CLOCK_MONOTONIC.
+static void test_fast_clock (void) {
+    bool fast_ok  = true;
+    bool ticks_ok = true;
+
+    // first use calibrates timestamp counter, which takes a few ms
+    ClockFastNs();
+
+    for (u32 i = 0; i < 5; i++) {
+        u64 mono_start  = monotonic_ns();
+        u64 fast_start  = ClockFastNs();
+        u64 ticks_start = ClockTicks();
+
+        struct timespec ts = {.tv_nsec = 20 * 1000 * 1000};
+        nanosleep (&ts, NULL);
+
+        u64 ticks_end = ClockTicks();
+        u64 fast_end  = ClockFastNs();
+        u64 mono_end  = monotonic_ns();
+
+        u64 mono = mono_end - mono_start;
+        fast_ok  = fast_ok && fast_end >= fast_start && close_to (fast_end - fast_start, mono);
+        ticks_ok = ticks_ok && close_to (ClockTicksToNs (ticks_end - ticks_start), mono);
+    }
+
+    TEST (fast_ok);
+    TEST (ticks_ok);
+
+    // never goes backwards
+    bool monotonic = true;
+    u64  last      = ClockFastNs();
+    for (u32 i = 0; i < 100000; i++) {
+        u64 now   = ClockFastNs();
+        monotonic = monotonic && now >= last;
+        last      = now;
+    }
+    TEST (monotonic);
+}
+
+static void test_wall_time_str (void) {
+    u64    now = ClockRealtimeNs();
+    time_t sec = now / 1000000000ULL;
+
+    struct tm time_info;
+    char      want[32];
+    localtime_r (&sec, &time_info);
+    strftime (want, sizeof (want), "%Y-%m-%d %H:%M:%S", &time_info);
+    TEST (!strcmp (ClockWallTimeStr (now), want));
+
+    // cached string is formatted again for another second, and not for same one
+    const char *str = ClockWallTimeStr (now + 1000000000ULL);
+    TEST (strcmp (str, want));
+    TEST (!strcmp (ClockWallTimeStr (sec * 1000000000ULL), want));
+    TEST (!strcmp (ClockWallTimeStr (sec * 1000000000ULL + 999999999ULL), want));
+}
+
+int main() {
+    test_fast_clock();
+    test_wall_time_str();
+
+    RESULT();
+    return ntotal != npass;
+}
@@ -1,6 +1,18 @@
 #include <Misra/Mc/Parser/ASTNodeTypes.h>
+#include <Misra/Mc/Parser/Ast.h>
+#include <Misra/Mc/Parser/Document.h>
+#include <Misra/Mc/Parser/Fold.h>
+#include <Misra/Mc/Parser/Split.h>
+#include <Misra/Mc/Parser/Value.h>
+#include <Misra/Mc/Vm/Bytecode.h>
+#include <Misra/Mc/Vm/Jit.h>
+#include <Misra/Mc/Vm/Register.h>
 #include <Misra/Std/Log.h>
 
+// platform
+#include <sys/wait.h>
+#include <unistd.h>
+
 u64 npass  = 0;
 u64 ntotal = 0;
 
@@ -73,6 +85,517 @@ u64 ntotal = 0;
         McParserDeinit (&p);                                                                       \
     } while (0)
 
+// same as TEST_EQ, but code is streamed to parser through a pipe,
+// with given (small) parser window size
+#define TEST_STREAM_EQ(xpr_str, xpr, window)                                                       \
+    do {                                                                                           \
+        ntotal++;                                                                                  \
+        int fds[2] = {-1, -1};                                                                     \
+        if (pipe (fds)) {                                                                          \
+            fprintf (stderr, "[FAIL @ LINE %d] : pipe() failed\n", __LINE__);                      \
+            break;                                                                                 \
+        }                                                                                          \
+        write (fds[1], xpr_str, strlen (xpr_str));                                                 \
+        close (fds[1]);                                                                            \
+        McParser p = {0};                                                                          \
+        McParserInitFromFd (&p, fds[0], window);                                                   \
+        McExpr e = {0};                                                                            \
+        McParseExpr (&e, &p);                                                                      \
+        f64 v = 0;                                                                                 \
+        if (!FCMPEQ ((v = McExprEval (&e)), (xpr))) {                                              \
+            fprintf (                                                                              \
+                stderr,                                                                            \
+                "[FAIL @ LINE %d] : %s (expected EQ with %lf, got %lf)\n",                         \
+                __LINE__,                                                                          \
+                xpr_str,                                                                           \
+                (f64)(xpr),                                                                        \
+                v                                                                                  \
+            );                                                                                     \
+        } else {                                                                                   \
+            npass++;                                                                               \
+        }                                                                                          \
+        McExprDeinit (&e);                                                                         \
+        McParserDeinit (&p);                                                                       \
+        close (fds[0]);                                                                            \
+    } while (0)
+
+// Stream `count` expressions, each using a name not seen before, committing after each
+// one. Every name must be read back right, and only names of code in window can be kept.
+#define TEST_STREAM_NAMES(count, window)                                                           \
+    do {                                                                                           \
+        ntotal++;                                                                                  \
+        int fds[2] = {-1, -1};                                                                     \
+        if (pipe (fds)) {                                                                          \
+            fprintf (stderr, "[FAIL @ LINE %d] : pipe() failed\n", __LINE__);                      \
+            break;                                                                                 \
+        }                                                                                          \
+        pid_t pid = fork();                                                                        \
+        if (!pid) {                                                                                \
+            close (fds[0]);                                                                        \
+            FILE* f = fdopen (fds[1], "w");                                                        \
+            for (u64 i = 0; i < (count); i++) {                                                    \
+                fprintf (f, "name_%llu + 1 ", i);                                                  \
+            }                                                                                      \
+            fclose (f);                                                                            \
+            _exit (0);                                                                             \
+        }                                                                                          \
+        close (fds[1]);                                                                            \
+        McParser p = {0};                                                                          \
+        McParserInitFromFd (&p, fds[0], window);                                                   \
+        McExpr e         = {0};                                                                    \
+        u64    nparsed   = 0;                                                                      \
+        u64    max_names = 0;                                                                      \
+        bool   names_ok  = true;                                                                   \
+        while (McParseExpr (&e, &p)) {                                                             \
+            char name[32];                                                                         \
+            int  len = snprintf (name, sizeof (name), "name_%llu", nparsed++);                     \
+            names_ok = names_ok && e.expr_type == MC_EXPR_TYPE_ADD &&                              \
+                       e.add.l->expr_type == MC_EXPR_TYPE_ID && e.add.l->id.length == (u64)len &&  \
+                       !memcmp (e.add.l->id.data, name, len);                                      \
+            McExprDeinit (&e);                                                                     \
+            McParserStreamCommit (&p);                                                             \
+            if (p.lexer.interner.offsets.length > max_names) {                                     \
+                max_names = p.lexer.interner.offsets.length;                                       \
+            }                                                                                      \
+        }                                                                                          \
+        waitpid (pid, NULL, 0);                                                                    \
+        if (nparsed != (count) || !names_ok || max_names * 2 > (window)) {                         \
+            fprintf (                                                                              \
+                stderr,                                                                            \
+                "[FAIL @ LINE %d] : parsed %llu of %llu, names %s, at most %llu names kept\n",     \
+                __LINE__,                                                                          \
+                nparsed,                                                                           \
+                (u64)(count),                                                                      \
+                names_ok ? "ok" : "wrong",                                                         \
+                max_names                                                                          \
+            );                                                                                     \
+        } else {                                                                                   \
+            npass++;                                                                               \
+        }                                                                                          \
+        McParserDeinit (&p);                                                                       \
+        close (fds[0]);                                                                            \
+    } while (0)
+
+#define TEST_MEMO_EQ(xpr_str, xpr, budget)                                                         \
+    do {                                                                                           \
+        ntotal++;                                                                                  \
+        McParser p = {0};                                                                          \
+        McParserInitFromZStr (&p, xpr_str);                                                        \
+        McParserEnableMemo (&p, budget);                                                           \
+        McExpr e = {0};                                                                            \
+        McParseExpr (&e, &p);                                                                      \
+        f64 v = 0;                                                                                 \
+        if (!FCMPEQ ((v = McExprEval (&e)), (xpr))) {                                              \
+            fprintf (                                                                              \
+                stderr,                                                                            \
+                "[FAIL @ LINE %d] : %s (expected EQ with %lf, got %lf)\n",                         \
+                __LINE__,                                                                          \
+                xpr_str,                                                                           \
+                (f64)(xpr),                                                                        \
+                v                                                                                  \
+            );                                                                                     \
+        } else {                                                                                   \
+            npass++;                                                                               \
+        }                                                                                          \
+        McExprDeinit (&e);                                                                         \
+        McParserDeinit (&p);                                                                       \
+    } while (0)
+
+// same as TEST_EQ, but tree is evaluated after copying it to a compact AST store
+#define TEST_AST_EQ(xpr_str, xpr)                                                                  \
+    do {                                                                                           \
+        ntotal++;                                                                                  \
+        McParser p = {0};                                                                          \
+        McParserInitFromZStr (&p, xpr_str);                                                        \
+        McExpr e = {0};                                                                            \
+        McParseExpr (&e, &p);                                                                      \
+        McAst ast = {0};                                                                           \
+        McAstInit (&ast);                                                                          \
+        McAstId id = McAstAddExpr (&ast, &e);                                                      \
+        McExprDeinit (&e);                                                                         \
+        f64 v = 0;                                                                                 \
+        if (id == MC_AST_NONE || !FCMPEQ ((v = McAstEval (&ast, id)), (xpr))) {                    \
+            fprintf (                                                                              \
+                stderr,                                                                            \
+                "[FAIL @ LINE %d] : %s (expected EQ with %lf, got %lf)\n",                         \
+                __LINE__,                                                                          \
+                xpr_str,                                                                           \
+                (f64)(xpr),                                                                        \
+                v                                                                                  \
+            );                                                                                     \
+        } else {                                                                                   \
+            npass++;                                                                               \
+        }                                                                                          \
+        McAstDeinit (&ast);                                                                        \
+        McParserDeinit (&p);                                                                       \
+    } while (0)
+
+// parse expression and check line and column of an offset taken from parsed expression `e`
+#define TEST_LOC(xpr_str, offset_of, ln, col)                                                      \
+    do {                                                                                           \
+        ntotal++;                                                                                  \
+        McParser p = {0};                                                                          \
+        McParserInitFromZStr (&p, xpr_str);                                                        \
+        McExpr e = {0};                                                                            \
+        McParseExpr (&e, &p);                                                                      \
+        u64 line = 0, column = 0;                                                                  \
+        if (!McParserLocate (&p, (offset_of), &line, &column) || line != (ln) ||                   \
+            column != (col)) {                                                                     \
+            fprintf (                                                                              \
+                stderr,                                                                            \
+                "[FAIL @ LINE %d] : %s (expected %d:%d, got %llu:%llu)\n",                         \
+                __LINE__,                                                                          \
+                xpr_str,                                                                           \
+                (ln),                                                                              \
+                (col),                                                                             \
+                line,                                                                              \
+                column                                                                             \
+            );                                                                                     \
+        } else {                                                                                   \
+            npass++;                                                                               \
+        }                                                                                          \
+        McExprDeinit (&e);                                                                         \
+        McParserDeinit (&p);                                                                       \
+    } while (0)
+
+// apply an edit to a document, and evaluate item at given index after it
+#define TEST_DOC_EQ(code_str, off, rm, ins, idx, xpr, nreparsed_max)                               \
+    do {                                                                                           \
+        ntotal++;                                                                                  \
+        McDocument doc = {0};                                                                      \
+        McDocumentInit (&doc, code_str);                                                           \
+        f64  v  = 0;                                                                               \
+        bool ok = McDocumentEdit (&doc, (off), (rm), (ins), strlen (ins)) &&                       \
+                  (idx) < doc.items.length && doc.nreparsed <= (nreparsed_max) &&                  \
+                  VecAt (&doc.items, (idx)).item_kind == MC_ITEM_KIND_EXPR;                        \
+        if (!ok || !FCMPEQ ((v = McExprEval (&VecAt (&doc.items, (idx)).expr)), (xpr))) {          \
+            fprintf (                                                                              \
+                stderr,                                                                            \
+                "[FAIL @ LINE %d] : %s (expected EQ with %lf, got %lf)\n",                         \
+                __LINE__,                                                                          \
+                code_str,                                                                          \
+                (f64)(xpr),                                                                        \
+                v                                                                                  \
+            );                                                                                     \
+        } else {                                                                                   \
+            npass++;                                                                               \
+        }                                                                                          \
+        McDocumentDeinit (&doc);                                                                   \
+    } while (0)
+
+// offset of token item at given index failed to parse at, -1 if item is valid
+static u64 doc_error_offset (McDocument* doc, u64 idx) {
+    if (idx >= doc->items.length || VecAt (&doc->items, idx).item_kind != MC_ITEM_KIND_INVALID) {
+        return (u64)-1;
+    }
+    return VecAt (&doc->parser.lexer.tokens, VecAt (&doc->items, idx).error_tok).offset;
+}
+
+// check where item at given index failed to parse, after a plain parse, a parallel
+// one, and an edit inserting an item before it
+#define TEST_DOC_ERROR(code_str, idx, err_offset)                                                  \
+    do {                                                                                           \
+        ntotal++;                                                                                  \
+        McDocument doc = {0};                                                                      \
+        McDocument par = {0};                                                                      \
+        bool       ok  = McDocumentInit (&doc, code_str) &&                                        \
+                  McDocumentInitParallel (&par, code_str, 4, 1) &&                                 \
+                  doc_error_offset (&doc, (idx)) == (err_offset) &&                                \
+                  doc_error_offset (&par, (idx)) == (err_offset) &&                                \
+                  McDocumentEdit (&doc, 0, 0, "0;", 2) &&                                          \
+                  doc_error_offset (&doc, (idx) + 1) == (err_offset) + 2;                          \
+        if (!ok) {                                                                                 \
+            fprintf (stderr, "[FAIL @ LINE %d] : %s (wrong error location)\n", __LINE__, code_str);\
+        } else {                                                                                   \
+            npass++;                                                                               \
+        }                                                                                          \
+        McDocumentDeinit (&doc);                                                                   \
+        McDocumentDeinit (&par);                                                                   \
+    } while (0)
+
+// parse code on a few threads, cut in smallest possible slices, and evaluate
+// item at given index
+#define TEST_PAR_EQ(code_str, nitems, idx, xpr)                                                    \
+    do {                                                                                           \
+        ntotal++;                                                                                  \
+        McDocument doc = {0};                                                                      \
+        f64        v   = 0;                                                                        \
+        bool ok = McDocumentInitParallel (&doc, code_str, 4, 1) && doc.items.length == (nitems) && \
+                  VecAt (&doc.items, (idx)).item_kind == MC_ITEM_KIND_EXPR;                        \
+        if (!ok || !FCMPEQ ((v = McExprEval (&VecAt (&doc.items, (idx)).expr)), (xpr))) {          \
+            fprintf (                                                                              \
+                stderr,                                                                            \
+                "[FAIL @ LINE %d] : %s (expected EQ with %lf, got %lf)\n",                         \
+                __LINE__,                                                                          \
+                code_str,                                                                          \
+                (f64)(xpr),                                                                        \
+                v                                                                                  \
+            );                                                                                     \
+        } else {                                                                                   \
+            npass++;                                                                               \
+        }                                                                                          \
+        if (ok) {                                                                                  \
+            McDocumentDeinit (&doc);                                                               \
+        }                                                                                          \
+    } while (0)
+
+// check number of slices code is cut into
+#define TEST_SPLIT(code_str, nslices)                                                              \
+    do {                                                                                           \
+        ntotal++;                                                                                  \
+        McCutVec cuts = {0};                                                                       \
+        VecInit (&cuts, NULL, NULL);                                                               \
+        McSplitItems (code_str, strlen (code_str), 1, &cuts);                                      \
+        if (cuts.length != (nslices)) {                                                            \
+            fprintf (                                                                              \
+                stderr,                                                                            \
+                "[FAIL @ LINE %d] : %s (expected %d slices, got %llu)\n",                          \
+                __LINE__,                                                                          \
+                code_str,                                                                          \
+                (nslices),                                                                         \
+                (u64)cuts.length                                                                   \
+            );                                                                                     \
+        } else {                                                                                   \
+            npass++;                                                                               \
+        }                                                                                          \
+        VecDeinit (&cuts);                                                                         \
+    } while (0)
+
+// parse code with error recovery, and check number of diagnostics and
+// location of last one
+#define TEST_RECOVER(code_str, ndiags, line_, column_)                                             \
+    do {                                                                                           \
+        ntotal++;                                                                                  \
+        McParser  p    = {0};                                                                      \
+        McProgram prog = {};                                                                       \
+        McParserInitFromZStr (&p, code_str);                                                       \
+        McParserEnableRecovery (&p, 0);                                                            \
+        bool             ok = McParseProgram (&prog, &p);                                          \
+        McDiagnosticVec* d  = &p.recovery.diagnostics;                                             \
+        if (ok != !(ndiags) || d->length != (ndiags) ||                                            \
+            (d->length && (VecLast (d).line != (line_) || VecLast (d).column != (column_)))) {     \
+            fprintf (                                                                              \
+                stderr,                                                                            \
+                "[FAIL @ LINE %d] : %s (expected %d diagnostics, got %llu)\n",                     \
+                __LINE__,                                                                          \
+                code_str,                                                                          \
+                (ndiags),                                                                          \
+                (u64)d->length                                                                     \
+            );                                                                                     \
+        } else {                                                                                   \
+            npass++;                                                                               \
+        }                                                                                          \
+        McParserDeinit (&p);                                                                       \
+    } while (0)
+
+// compile expression to bytecode, and evaluate it with given value of "x"
+#define TEST_BC_EQ(xpr_str, x, xpr)                                                                \
+    do {                                                                                           \
+        ntotal++;                                                                                  \
+        McParser p = {0};                                                                          \
+        McParserInitFromZStr (&p, xpr_str);                                                        \
+        McExpr     e      = {0};                                                                   \
+        McBytecode bc     = {0};                                                                   \
+        f64        in[4]  = {0};                                                                   \
+        f64        v      = 0;                                                                     \
+        bool       ok     = McParseExpr (&e, &p) && McBytecodeCompile (&bc, &e);                   \
+        u64        in_idx = ok ? McBytecodeFindInput (&bc, "x") : (u64)-1;                         \
+        if (in_idx < 4) {                                                                          \
+            in[in_idx] = (x);                                                                      \
+        }                                                                                          \
+        if (!ok || !FCMPEQ ((v = McBytecodeEval (&bc, in)), (xpr))) {                              \
+            fprintf (                                                                              \
+                stderr,                                                                            \
+                "[FAIL @ LINE %d] : %s (expected EQ with %lf, got %lf)\n",                         \
+                __LINE__,                                                                          \
+                xpr_str,                                                                           \
+                (f64)(xpr),                                                                        \
+                v                                                                                  \
+            );                                                                                     \
+        } else {                                                                                   \
+            npass++;                                                                               \
+        }                                                                                          \
+        if (ok) {                                                                                  \
+            McBytecodeDeinit (&bc);                                                                \
+        }                                                                                          \
+        McExprDeinit (&e);                                                                         \
+        McParserDeinit (&p);                                                                       \
+    } while (0)
+
+// compile expression for register machine, and evaluate it with given value of "x"
+#define TEST_REG_EQ(xpr_str, x, xpr)                                                               \
+    do {                                                                                           \
+        ntotal++;                                                                                  \
+        McParser p = {0};                                                                          \
+        McParserInitFromZStr (&p, xpr_str);                                                        \
+        McExpr     e      = {0};                                                                   \
+        McRegCode  rc     = {0};                                                                   \
+        f64        in[4]  = {0};                                                                   \
+        f64        v      = 0;                                                                     \
+        bool       ok     = McParseExpr (&e, &p) && McRegCodeCompile (&rc, &e);                    \
+        u64        in_idx = ok ? McRegCodeFindInput (&rc, "x") : (u64)-1;                          \
+        if (in_idx < 4) {                                                                          \
+            in[in_idx] = (x);                                                                      \
+        }                                                                                          \
+        if (!ok || !FCMPEQ ((v = McRegCodeEval (&rc, in)), (xpr))) {                               \
+            fprintf (                                                                              \
+                stderr,                                                                            \
+                "[FAIL @ LINE %d] : %s (expected EQ with %lf, got %lf)\n",                         \
+                __LINE__,                                                                          \
+                xpr_str,                                                                           \
+                (f64)(xpr),                                                                        \
+                v                                                                                  \
+            );                                                                                     \
+        } else {                                                                                   \
+            npass++;                                                                               \
+        }                                                                                          \
+        if (ok) {                                                                                  \
+            McRegCodeDeinit (&rc);                                                                 \
+        }                                                                                          \
+        McExprDeinit (&e);                                                                         \
+        McParserDeinit (&p);                                                                       \
+    } while (0)
+
+// compile expression to native code, and evaluate it with given value of "x"
+#define TEST_JIT_EQ(xpr_str, x, xpr)                                                               \
+    do {                                                                                           \
+        ntotal++;                                                                                  \
+        McParser p = {0};                                                                          \
+        McParserInitFromZStr (&p, xpr_str);                                                        \
+        McExpr     e      = {0};                                                                   \
+        McJit      jit    = {0};                                                                   \
+        f64        in[4]  = {0};                                                                   \
+        f64        v      = 0;                                                                     \
+        bool       ok     = McParseExpr (&e, &p) && McJitCompile (&jit, &e);                       \
+        u64        in_idx = ok ? McJitFindInput (&jit, "x") : (u64)-1;                             \
+        if (in_idx < 4) {                                                                          \
+            in[in_idx] = (x);                                                                      \
+        }                                                                                          \
+        if (!ok || !FCMPEQ ((v = McJitEval (&jit, in)), (xpr))) {                                  \
+            fprintf (                                                                              \
+                stderr,                                                                            \
+                "[FAIL @ LINE %d] : %s (expected EQ with %lf, got %lf)\n",                         \
+                __LINE__,                                                                          \
+                xpr_str,                                                                           \
+                (f64)(xpr),                                                                        \
+                v                                                                                  \
+            );                                                                                     \
+        } else {                                                                                   \
+            npass++;                                                                               \
+        }                                                                                          \
+        if (ok) {                                                                                  \
+            McJitDeinit (&jit);                                                                    \
+        }                                                                                          \
+        McExprDeinit (&e);                                                                         \
+        McParserDeinit (&p);                                                                       \
+    } while (0)
+
+// fold expression, check type of what remains, and evaluate it with given value of "x"
+#define TEST_FOLD_EQ(xpr_str, type, x, xpr)                                                        \
+    do {                                                                                           \
+        ntotal++;                                                                                  \
+        McParser p = {0};                                                                          \
+        McParserInitFromZStr (&p, xpr_str);                                                        \
+        McExpr     e      = {0};                                                                   \
+        McRegCode  rc     = {0};                                                                   \
+        f64        in[4]  = {0};                                                                   \
+        f64        v      = 0;                                                                     \
+        bool       ok     = McParseExpr (&e, &p) && McExprFold (&e) && e.expr_type == (type) &&    \
+                   McRegCodeCompile (&rc, &e);                                                     \
+        u64        in_idx = ok ? McRegCodeFindInput (&rc, "x") : (u64)-1;                          \
+        if (in_idx < 4) {                                                                          \
+            in[in_idx] = (x);                                                                      \
+        }                                                                                          \
+        if (!ok || !FCMPEQ ((v = McRegCodeEval (&rc, in)), (xpr))) {                               \
+            fprintf (                                                                              \
+                stderr,                                                                            \
+                "[FAIL @ LINE %d] : %s (expected type %d and EQ with %lf, got type %d and %lf)\n", \
+                __LINE__,                                                                          \
+                xpr_str,                                                                           \
+                (type),                                                                            \
+                (f64)(xpr),                                                                        \
+                e.expr_type,                                                                       \
+                v                                                                                  \
+            );                                                                                     \
+        } else {                                                                                   \
+            npass++;                                                                               \
+        }                                                                                          \
+        if (ok) {                                                                                  \
+            McRegCodeDeinit (&rc);                                                                 \
+        }                                                                                          \
+        McExprDeinit (&e);                                                                         \
+        McParserDeinit (&p);                                                                       \
+    } while (0)
+
+// evaluate with C types, expecting given type and value, or failure if kind is INVALID
+#define TEST_VALUE_EQ(xpr_str, kind, unsgnd, bits, xpr)                                            \
+    do {                                                                                           \
+        ntotal++;                                                                                  \
+        McParser p = {0};                                                                          \
+        McParserInitFromZStr (&p, xpr_str);                                                        \
+        McExpr  e    = {0};                                                                        \
+        McValue v    = {0};                                                                        \
+        bool    ok   = McParseExpr (&e, &p) && McExprEvalValue (&v, &e);                           \
+        bool    is_f = v.type.type_kind == MC_BASIC_TYPE_KIND_FLOAT;                               \
+        bool    eq   = ok && v.type.type_kind == (kind) && v.type.is_unsigned == (unsgnd) &&       \
+                  v.type.nbits == (bits) && (is_f ? FCMPEQ (v.f, (xpr)) : v.u == (u64)(xpr));      \
+        if ((kind) == MC_BASIC_TYPE_KIND_INVALID ? ok : !eq) {                                     \
+            fprintf (                                                                              \
+                stderr,                                                                            \
+                "[FAIL @ LINE %d] : %s (expected %d %d %d and %lf, got %d %d %llu and %lf)\n",     \
+                __LINE__,                                                                          \
+                xpr_str,                                                                           \
+                (kind),                                                                            \
+                (unsgnd),                                                                          \
+                (bits),                                                                            \
+                (f64)(xpr),                                                                        \
+                v.type.type_kind,                                                                  \
+                v.type.is_unsigned,                                                                \
+                v.type.nbits,                                                                      \
+                is_f ? v.f : (f64)v.i                                                              \
+            );                                                                                     \
+        } else {                                                                                   \
+            npass++;                                                                               \
+        }                                                                                          \
+        McExprDeinit (&e);                                                                         \
+        McParserDeinit (&p);                                                                       \
+    } while (0)
+
+// parse with folding enabled, and evaluate what remains with types of folded constants
+#define TEST_FOLDED_VALUE_EQ(xpr_str, kind, unsgnd, bits, xpr)                                     \
+    do {                                                                                           \
+        ntotal++;                                                                                  \
+        McParser p = {0};                                                                          \
+        McParserInitFromZStr (&p, xpr_str);                                                        \
+        McParserEnableFolding (&p);                                                                \
+        McExpr  e    = {0};                                                                        \
+        McValue v    = {0};                                                                        \
+        bool    ok   = McParseExpr (&e, &p) && McExprEvalValue (&v, &e);                           \
+        bool    is_f = v.type.type_kind == MC_BASIC_TYPE_KIND_FLOAT;                               \
+        bool    eq   = ok && v.type.type_kind == (kind) && v.type.is_unsigned == (unsgnd) &&       \
+                  v.type.nbits == (bits) && (is_f ? FCMPEQ (v.f, (xpr)) : v.u == (u64)(xpr));      \
+        if (!eq) {                                                                                 \
+            fprintf (                                                                              \
+                stderr,                                                                            \
+                "[FAIL @ LINE %d] : %s (expected %d %d %d and %lf, got %d %d %llu and %lf)\n",     \
+                __LINE__,                                                                          \
+                xpr_str,                                                                           \
+                (kind),                                                                            \
+                (unsgnd),                                                                          \
+                (bits),                                                                            \
+                (f64)(xpr),                                                                        \
+                v.type.type_kind,                                                                  \
+                v.type.is_unsigned,                                                                \
+                v.type.nbits,                                                                      \
+                is_f ? v.f : (f64)v.i                                                              \
+            );                                                                                     \
+        } else {                                                                                   \
+            npass++;                                                                               \
+        }                                                                                          \
+        McExprDeinit (&e);                                                                         \
+        McParserDeinit (&p);                                                                       \
+    } while (0)
+
 #define RESULT()                                                                                   \
     if (ntotal == npass)                                                                           \
         fprintf (stderr, "\nALL PASS! TOTAL = %llu\n", ntotal);                                    \
@@ -100,6 +623,210 @@ int main() {
     TEST_EQ ("0xcafebabe << 4", 0xcafebabeULL << 4);
     TEST_EQ ("0xbaadb00b << 13", 0xbaadb00bULL << 13);
 
+    // multi character operators
+    TEST_EQ ("2 >= 2", 2 >= 2);
+    TEST_EQ ("1 <= 2", 1 <= 2);
+    TEST_EQ ("3 && 0", 3 && 0);
+    TEST_EQ ("5 | 2", 5 | 2);
+    TEST_EQ ("(1 + 2) * 3", (1 + 2) * 3);
+    TEST_EQ ("0 ? 2 : 3", 0 ? 2 : 3);
+    TEST_TYPE_EQ ("x = y = 3", MC_EXPR_TYPE_ASSIGN);
+    TEST_TYPE_EQ ("a.b->c", MC_EXPR_TYPE_PTR_ACCESS);
+    TEST_TYPE_EQ ("f(1, 2)", MC_EXPR_TYPE_CALL);
+
+    // precedence
+    TEST_EQ ("1 + 2 * 3 - 4", 1 + 2 * 3 - 4);
+    TEST_EQ ("1 << 2 + 1 == 8", (1 << (2 + 1)) == 8);
+    TEST_EQ ("1 || 0 ? 2 + 3 : 4", 5);
+    TEST_TYPE_EQ ("a ? b : c = d", MC_EXPR_TYPE_ASSIGN);
+    TEST_TYPE_EQ ("a = b ? c : d", MC_EXPR_TYPE_ASSIGN);
+    TEST_TYPE_EQ ("-a[1]", MC_EXPR_TYPE_UN_MINUS);
+    TEST_TYPE_EQ ("(u32){1}.x", MC_EXPR_TYPE_ACCESS);
+
+    // literals
+    TEST_EQ ("0.1", 0.1);
+    TEST_EQ ("3.14159265358979323846264338327950288", 3.14159265358979323846264338327950288);
+    TEST_EQ ("123456789.125f", 123456789.125);
+    TEST_EQ ("18446744073709551615", 18446744073709551615ULL);
+    TEST_EQ ("0xFFFFFFFFFFFFFFFF", 0xFFFFFFFFFFFFFFFFULL);
+    TEST_TYPE_EQ ("18446744073709551616", MC_EXPR_TYPE_INVALID);
+    TEST_TYPE_EQ ("0x10000000000000000", MC_EXPR_TYPE_INVALID);
+
+    // keywords and type names
+    TEST_TYPE_EQ ("(u32)1", MC_EXPR_TYPE_CAST);
+    TEST_TYPE_EQ ("(const char*)x", MC_EXPR_TYPE_CAST);
+    TEST_TYPE_EQ ("sizeof x", MC_EXPR_TYPE_SIZE_OF);
+    TEST_TYPE_EQ ("u8x", MC_EXPR_TYPE_ID);
+    TEST_TYPE_EQ ("sizeofx", MC_EXPR_TYPE_ID);
+    TEST_EQ ("(f64)1 + 2", 3);
+
+    // runs longer than a vector register
+    TEST_EQ ("\n\t\t                                        1 +\n                                 2", 3);
+    TEST_TYPE_EQ (
+        "                                                  "
+        "a_very_long_identifier_name_used_by_generated_code_0123456789_abcdefghijklmnopqrstuvwxyz",
+        MC_EXPR_TYPE_ID
+    );
+    TEST_TYPE_EQ ("12345678901234567890123456789012345678901234567890x", MC_EXPR_TYPE_INVALID);
+
+    // packrat mode, with default and smallest possible memo
+    static char casts[7 * 512 + 8];
+    for (int i = 0; i < 512; i++) {
+        memcpy (casts + i * 6, "(u32)(", 6);
+    }
+    strcpy (casts + 6 * 512, "1 + 2");
+    memset (casts + strlen (casts), ')', 512);
+    TEST_MEMO_EQ ("(1 + 2) * 3", (1 + 2) * 3, 0);
+    TEST_MEMO_EQ ("a ? (f64)1 : 2, 4", 4, 0);
+    TEST_MEMO_EQ (casts, 3, 0);
+    TEST_MEMO_EQ (casts, 3, 1);
+
+    // compact AST store
+    TEST_AST_EQ ("1 + 2 * 3", 1 + 2 * 3);
+    TEST_AST_EQ ("(1 < 2) ? 10 : 20", 10);
+    TEST_AST_EQ ("0 ? 1 : 1 ? 2 : 3", 2);
+    TEST_AST_EQ ("(u32)-1.5 + 2", 0.5);
+    TEST_AST_EQ ("f(), a.b, x[1, 2], 0.25", 0.25);
+    TEST_AST_EQ ("(1, (2, 3 ? 4 : 5), 6) * 7", 42);
+
+    // source locations
+    TEST_LOC ("1 + 2", e.offset, 1, 1);
+    TEST_LOC ("  1 + 2", e.add.r->offset, 1, 7);
+    TEST_LOC ("a +\n\n    -b", e.add.r->offset, 3, 5);
+    TEST_LOC ("x,\n (u8)y,\nf(z)", VecAt (&e.list, 1)->offset, 2, 2);
+    TEST_LOC ("x,\n (u8)y,\nf(z)", VecAt (&e.list, 2)->add.r->offset, 3, 3);
+    TEST_LOC ("c\n? t\n: (f)", e.tern.f->offset, 3, 3);
+
+    // incremental reparse
+    TEST_DOC_EQ ("1 + 2; 3 * 4; 5 - 6;", 9, 1, "+", 1, 3 + 4, 1);
+    TEST_DOC_EQ ("1 + 2; 3 * 4; 5 - 6;", 0, 0, "10 * ", 0, 10 * 1 + 2, 1);
+    TEST_DOC_EQ ("1 + 2; 3 * 4; 5 - 6;", 5, 1, " *", 0, 1 + 2 * 3 * 4, 1);
+    TEST_DOC_EQ ("1 + 2; 3 * 4; 5 - 6;", 14, 0, "100 / ", 2, 100 / 5 - 6, 1);
+    TEST_DOC_EQ ("1 + 2; 3 * 4; 5 - 6;", 13, 0, " 7;", 2, 7, 2);
+    TEST_DOC_EQ ("1 + 2; 3 * 4; 5 - 6;", 13, 0, " 7;", 3, 5 - 6, 2);
+    TEST_DOC_EQ ("1 + 2;\n(u8)\n300;", 7, 4, "", 1, 300, 1);
+
+    // parallel parse
+    TEST_SPLIT ("1 + 2", 1);
+    TEST_SPLIT ("a; b; c", 3);
+    TEST_SPLIT ("f(a; b); [c; d]; {e;}", 3);
+    TEST_SPLIT ("a;; b; ;c", 1);
+    TEST_SPLIT ("a; b;", 2);
+    TEST_PAR_EQ ("1 + 2; 3 * 4; 5 - 6;", 3, 1, 3 * 4);
+    TEST_PAR_EQ ("1;;; x = 2 ; ;(u8)300", 5, 4, 300);
+    TEST_PAR_EQ ("a; (b; c); d, 7", 6, 5, 7);
+
+    // invalid items point at token parser got stuck at
+    TEST_DOC_ERROR ("1 + 2;\n3 * (4;", 1, 13);
+    TEST_DOC_ERROR ("x; } y", 1, 3);
+    TEST_DOC_ERROR ("3 * (4", 0, 6);
+
+    // error recovery
+    TEST_RECOVER ("1 + 2; 3", 0, 0, 0);
+    TEST_RECOVER ("1 + ;", 1, 1, 5);
+    TEST_RECOVER ("1 + ; 2 * 3;\n4 / ; 5", 2, 2, 5);
+    TEST_RECOVER ("(1 + 2;\n) 3; } 99999999999999999999999", 4, 2, 8);
+    TEST_RECOVER ("1 +\n+ } u8 ;\n2 )", 2, 3, 3);
+
+    // bytecode
+    TEST_BC_EQ ("1 + 2 * 3 - 4", 0, 1 + 2 * 3 - 4);
+    TEST_BC_EQ ("1 / 2", 0, 0.5);
+    TEST_BC_EQ ("0xbaadb00b << 13", 0, 0xbaadb00bULL << 13);
+    TEST_BC_EQ ("(0x20000000000001 | 0) == 0x20000000000000", 0, 0);
+    TEST_BC_EQ ("x * x + 1", 3, 10);
+    TEST_BC_EQ ("x > 2 && x < 5 ? x : -x", 4, 4);
+    TEST_BC_EQ ("x > 2 && x < 5 ? x : -x", 7, -7);
+    TEST_BC_EQ ("x || 0 ? 1 : 2.5", 0, 2.5);
+    TEST_BC_EQ ("(x, 3) % 2 | 4", 1, 5);
+    TEST_BC_EQ ("y + x / 2", 5, 2.5);
+
+    // register machine
+    TEST_REG_EQ ("1 + 2 * 3 - 4", 0, 1 + 2 * 3 - 4);
+    TEST_REG_EQ ("0xbaadb00b << 13", 0, 0xbaadb00bULL << 13);
+    TEST_REG_EQ ("(x >> 4) & 0xf", 0xab, 0xa);
+    TEST_REG_EQ ("x < 5 ? x + 1 : 2 - x", 3, 4);
+    TEST_REG_EQ ("x < 5 ? x + 1 : 2 - x", 9, -7);
+    TEST_REG_EQ ("x > 2 && x < 5", 4, 1);
+    TEST_REG_EQ ("x > 2 && x < 5", 5, 0);
+    TEST_REG_EQ ("1 / x", 4, 0.25);
+    TEST_REG_EQ ("x == 1.5 ? x % 4 : x", 1.5, 1);
+    TEST_REG_EQ ("x || 0 ? 1 : 2.5", 0, 2.5);
+
+    // native code
+    TEST_JIT_EQ ("1 + 2 * 3 - 4", 0, 1 + 2 * 3 - 4);
+    TEST_JIT_EQ ("0xbaadb00b << 13", 0, 0xbaadb00bULL << 13);
+    TEST_JIT_EQ ("(x >> 4) & 0xf", 0xab, 0xa);
+    TEST_JIT_EQ ("x % 7 + (x ^ 3)", 100, 2 + (100 ^ 3));
+    TEST_JIT_EQ ("x < 5 ? x + 1 : 2 - x", 3, 4);
+    TEST_JIT_EQ ("x < 5 ? x + 1 : 2 - x", 9, -7);
+    TEST_JIT_EQ ("x > 2 && x < 5", 4, 1);
+    TEST_JIT_EQ ("x != x", 0.0 / 0.0, 1);
+    TEST_JIT_EQ ("x <= 1 || !x", 0.0 / 0.0, 0);
+    TEST_JIT_EQ ("-x * 2.5 / (x + 0.5)", 2, -2);
+
+    // constant folding
+    TEST_FOLD_EQ ("0xcafebabe << 4", MC_EXPR_TYPE_NUM, 0, 0xcafebabe << 4);
+    TEST_FOLD_EQ ("1 + 2 * 3 - 4", MC_EXPR_TYPE_NUM, 0, 1 + 2 * 3 - 4);
+    TEST_FOLD_EQ ("9007199254740993 - 9007199254740992", MC_EXPR_TYPE_NUM, 0, 1);
+    TEST_FOLD_EQ ("x + (1 - 3)", MC_EXPR_TYPE_ADD, 5, 3);
+    TEST_FOLD_EQ ("0 - 1", MC_EXPR_TYPE_NUM, 0, -1);
+    TEST_FOLD_EQ ("(x & 0) + 1", MC_EXPR_TYPE_NUM, 5, 1);
+    TEST_FOLD_EQ ("0 && x", MC_EXPR_TYPE_NUM, 5, 0);
+    TEST_FOLD_EQ ("x * 1", MC_EXPR_TYPE_ID, 2.5, 2.5);
+    TEST_FOLD_EQ ("-(-x)", MC_EXPR_TYPE_ID, 2.5, 2.5);
+    TEST_FOLD_EQ ("1 ? x : 2.5", MC_EXPR_TYPE_ID, 3, 3);
+    TEST_FOLD_EQ ("x / 4", MC_EXPR_TYPE_MUL, 3, 0.75);
+    TEST_FOLD_EQ ("x % 8", MC_EXPR_TYPE_AND, 13, 5);
+    TEST_FOLD_EQ ("!!(x < 3)", MC_EXPR_TYPE_LT, 2, 1);
+    TEST_FOLD_EQ ("((x | 1) | 2) | 4", MC_EXPR_TYPE_OR, 8, 15);
+    TEST_FOLD_EQ ("0 + (x - 0)", MC_EXPR_TYPE_ADD, -0.0, 0);
+
+    // typed evaluation
+    TEST_VALUE_EQ ("0xbaadb00b << 30", MC_BASIC_TYPE_KIND_INTEGER, 1, 32, 0xbaadb00b << 30);
+    TEST_VALUE_EQ ("0xFFFFFFFFFFFFFFFF - 1", MC_BASIC_TYPE_KIND_INTEGER, 1, 64, (u64)-2);
+    TEST_VALUE_EQ ("(u8)300 + 1", MC_BASIC_TYPE_KIND_INTEGER, 0, 32, 45);
+    TEST_VALUE_EQ ("(u32)0 - 1", MC_BASIC_TYPE_KIND_INTEGER, 1, 32, 0xFFFFFFFFULL);
+    TEST_VALUE_EQ ("(-7 / 2) * 10 + -7 % 2", MC_BASIC_TYPE_KIND_INTEGER, 0, 32, -31);
+    TEST_VALUE_EQ ("(i8)-128 / (i8)-1", MC_BASIC_TYPE_KIND_INTEGER, 0, 32, 128);
+    TEST_VALUE_EQ ("(u32)1 < -1", MC_BASIC_TYPE_KIND_INTEGER, 0, 32, 1);
+    TEST_VALUE_EQ ("2147483647 + 1", MC_BASIC_TYPE_KIND_INTEGER, 0, 32, -2147483648LL);
+    TEST_VALUE_EQ ("1 / 2.0 + 1 / 2", MC_BASIC_TYPE_KIND_FLOAT, 0, 64, 0.5);
+    TEST_VALUE_EQ ("(f32)0.1 * 3", MC_BASIC_TYPE_KIND_FLOAT, 0, 32, (f32)0.1 * 3);
+    TEST_VALUE_EQ ("sizeof ((u16)1 + 1)", MC_BASIC_TYPE_KIND_INTEGER, 1, 64, 4);
+    TEST_VALUE_EQ ("1 ? 2 : 3.5", MC_BASIC_TYPE_KIND_FLOAT, 0, 64, 2);
+    TEST_VALUE_EQ ("0 && 1 / 0", MC_BASIC_TYPE_KIND_INTEGER, 0, 32, 0);
+    TEST_VALUE_EQ ("1 / 0", MC_BASIC_TYPE_KIND_INVALID, 0, 0, 0);
+    TEST_VALUE_EQ ("1 << 32", MC_BASIC_TYPE_KIND_INVALID, 0, 0, 0);
+    TEST_VALUE_EQ ("x + 1", MC_BASIC_TYPE_KIND_INVALID, 0, 0, 0);
+    TEST_VALUE_EQ ("0xffffffff + 1", MC_BASIC_TYPE_KIND_INTEGER, 1, 32, 0);
+    TEST_VALUE_EQ ("-0x80000000 > 0", MC_BASIC_TYPE_KIND_INTEGER, 0, 32, 1);
+    TEST_VALUE_EQ ("4294967295 + 1", MC_BASIC_TYPE_KIND_INTEGER, 0, 64, 4294967296ULL);
+    TEST_VALUE_EQ ("0x8000000000000000 >> 63", MC_BASIC_TYPE_KIND_INTEGER, 1, 64, 1);
+    TEST_FOLDED_VALUE_EQ ("1 + 2", MC_BASIC_TYPE_KIND_INTEGER, 0, 32, 3);
+    TEST_FOLDED_VALUE_EQ ("1 / 2", MC_BASIC_TYPE_KIND_INTEGER, 0, 32, 0);
+    TEST_FOLDED_VALUE_EQ ("0xffffffff + 1", MC_BASIC_TYPE_KIND_INTEGER, 1, 32, 0);
+    TEST_FOLDED_VALUE_EQ (
+        "9007199254740993 + 0",
+        MC_BASIC_TYPE_KIND_INTEGER,
+        0,
+        64,
+        9007199254740993ULL
+    );
+    TEST_FOLDED_VALUE_EQ ("18446744073709551615 - 1", MC_BASIC_TYPE_KIND_INTEGER, 1, 64, -2);
+    TEST_FOLDED_VALUE_EQ ("-1 < 0", MC_BASIC_TYPE_KIND_INTEGER, 0, 32, 1);
+    TEST_FOLDED_VALUE_EQ ("(1 << 2) < 5", MC_BASIC_TYPE_KIND_INTEGER, 0, 32, 1);
+    TEST_FOLDED_VALUE_EQ ("(0xff | 0x100) * (char)2", MC_BASIC_TYPE_KIND_INTEGER, 0, 32, 1022);
+    TEST_FOLDED_VALUE_EQ ("(2 - 3) * 1.5", MC_BASIC_TYPE_KIND_FLOAT, 0, 64, -1.5);
+    TEST_FOLDED_VALUE_EQ ("(u8)300 + 0", MC_BASIC_TYPE_KIND_INTEGER, 0, 32, 44);
+    TEST_FOLDED_VALUE_EQ ("sizeof (+(char)(1 + 2))", MC_BASIC_TYPE_KIND_INTEGER, 1, 64, 4);
+    TEST_FOLDED_VALUE_EQ ("0 ? 1 : 2.5", MC_BASIC_TYPE_KIND_FLOAT, 0, 64, 2.5);
+
+    // streamed input
+    TEST_STREAM_EQ ("1 + 2", 1 + 2, 8);
+    TEST_STREAM_EQ ("   13 % 5", 13 % 5, 16);
+    TEST_STREAM_EQ ("1337 * 1337 + 1", 1337 * 1337 + 1, 0);
+    TEST_STREAM_NAMES (100000, 4096);
+
     // show result
     RESULT();
 }
@@ -0,0 +1,247 @@
+#include <Misra/Std/File.h>
+#include <Misra/Std/Log.h>
+
+// platform
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+u64 npass  = 0;
+u64 ntotal = 0;
+
+#define TEST(cond)                                                                                 \
+    do {                                                                                           \
+        ntotal++;                                                                                  \
+        if (!(cond)) {                                                                             \
+            fprintf (stderr, "[FAIL @ LINE %d] : %s\n", __LINE__, #cond);                          \
+        } else {                                                                                   \
+            npass++;                                                                               \
+        }                                                                                          \
+    } while (0)
+
+#define RESULT()                                                                                   \
+    if (ntotal == npass)                                                                           \
+        fprintf (stderr, "\nALL PASS! TOTAL = %llu\n", ntotal);                                    \
+    else                                                                                           \
+        fprintf (stderr, "%llu/%llu PASS\n", npass, ntotal)
+
+// scratch directory all files of tests are created in
+static char root[64] = "/tmp/misra_file_test_XXXXXX";
+
+static const char *at (const char *name) {
+    static char path[256];
+    snprintf (path, sizeof (path), "%s/%s", root, name);
+    return path;
+}
+
+static void write_file (const char *name, const char *data) {
+    FILE *f = fopen (at (name), "wb");
+    if (f) {
+        fputs (data, f);
+        fclose (f);
+    }
+}
+
+typedef struct WalkCount {
+    _Atomic u64 nentries;
+    _Atomic u64 nlinks;
+    u64         stop_after;
+} WalkCount;
+
+static bool count_entry (const WalkDirEntry *entry, void *user_data) {
+    WalkCount *c = user_data;
+    if (DIR_ENTRY_TYPE_SYMBOLIC_LINK == entry->type) {
+        c->nlinks++;
+    }
+    return ++c->nentries != c->stop_after;
+}
+
+// walk `dir` inside scratch directory, checking result and number of entries visited
+#define TEST_WALK(dir, nthreads, ok, count, links)                                                 \
+    do {                                                                                           \
+        WalkCount c = {0};                                                                         \
+        TEST (WalkDir (at (dir), NULL, count_entry, &c, (nthreads)) == (ok));                      \
+        TEST (c.nentries == (count));                                                              \
+        TEST (c.nlinks == (links));                                                                \
+    } while (0)
+
+static void test_walk_dir (void) {
+    // a.txt, sub, sub/b.txt, sub/deep, sub/deep/c.txt and a link to sub
+    mkdir (at ("tree"), 0755);
+    mkdir (at ("tree/sub"), 0755);
+    mkdir (at ("tree/sub/deep"), 0755);
+    write_file ("tree/a.txt", "a");
+    write_file ("tree/sub/b.txt", "b");
+    write_file ("tree/sub/deep/c.txt", "c");
+    TEST (!symlink ("sub", at ("tree/lnk")));
+
+    TEST_WALK ("tree", 0, true, 6, 1);
+    TEST_WALK ("tree", 4, true, 6, 1);
+
+    // missing root fails with and without threads
+    TEST_WALK ("missing", 0, false, 0, 0);
+    TEST_WALK ("missing", 4, false, 0, 0);
+
+    // more directories than can wait for workers at once
+    mkdir (at ("wide"), 0755);
+    for (u32 i = 0; i < 600; i++) {
+        char name[64];
+        snprintf (name, sizeof (name), "wide/%u", i);
+        mkdir (at (name), 0755);
+        snprintf (name, sizeof (name), "wide/%u/f", i);
+        write_file (name, "");
+    }
+    TEST_WALK ("wide", 0, true, 1200, 0);
+    TEST_WALK ("wide", 4, true, 1200, 0);
+
+    // entries with paths longer than PATH_MAX are skipped, and walk fails
+    char name[201];
+    memset (name, 'd', sizeof (name) - 1);
+    name[sizeof (name) - 1] = 0;
+    u32 nlevels = PATH_MAX / sizeof (name) + 1;
+    mkdir (at ("deep"), 0755);
+    int fd = open (at ("deep"), O_RDONLY | O_DIRECTORY);
+    for (u32 i = 0; fd >= 0 && i < nlevels; i++) {
+        int sub_fd = mkdirat (fd, name, 0755) ? -1 : openat (fd, name, O_RDONLY | O_DIRECTORY);
+        close (fd);
+        fd = sub_fd;
+    }
+    TEST (fd >= 0 && !close (fd));
+    for (u32 nthreads = 0; nthreads <= 4; nthreads += 4) {
+        WalkCount c = {0};
+        TEST (!WalkDir (at ("deep"), NULL, count_entry, &c, nthreads));
+        TEST (c.nentries && c.nentries < nlevels);
+    }
+
+    // visitor stops walk
+    WalkCount c = {.stop_after = 1};
+    TEST (WalkDir (at ("tree"), NULL, count_entry, &c, 0));
+    TEST (c.nentries == 1);
+    c = (WalkCount) {.stop_after = 1};
+    TEST (WalkDir (at ("wide"), NULL, count_entry, &c, 4));
+    TEST (c.nentries < 1200);
+}
+
+static void test_file_info_cache (void) {
+    FileInfo info = {0};
+
+    // size is never served stale, without cache
+    write_file ("grow", "12345");
+    TEST (GetFileSize (at ("grow")) == 5);
+    write_file ("grow", "12345678901");
+    TEST (GetFileSize (at ("grow")) == 11);
+
+    // default lookups validate
+    TEST (GetFileInfo (at ("grow"), &info, FILE_INFO_VALIDATE) && info.size == 11);
+    write_file ("grow", "1234");
+    TEST (GetFileInfo (at ("grow"), &info, FILE_INFO_VALIDATE) && info.size == 4);
+
+    // cached lookups are stale until next generation
+    write_file ("grow", "123456");
+    TEST (GetFileInfo (at ("grow"), &info, FILE_INFO_CACHED) && info.size == 4);
+    FileInfoCacheBump();
+    TEST (GetFileInfo (at ("grow"), &info, FILE_INFO_CACHED) && info.size == 6);
+
+    // missing files are seen as soon as they appear, unless asked otherwise
+    TEST (GetFileSize (at ("late")) == -1);
+    TEST (!GetFileInfo (at ("late"), &info, FILE_INFO_CACHED) && errno == ENOENT);
+    write_file ("late", "ab");
+    TEST (GetFileSize (at ("late")) == 2);
+    TEST (GetFileInfo (at ("late"), &info, FILE_INFO_CACHED) && info.size == 2);
+
+    TEST (!GetFileInfo (at ("later"), &info, FILE_INFO_CACHE_MISSING));
+    write_file ("later", "abc");
+    errno = 0;
+    TEST (!GetFileInfo (at ("later"), &info, FILE_INFO_CACHE_MISSING) && errno == ENOENT);
+    FileInfoCacheBump();
+    TEST (GetFileInfo (at ("later"), &info, FILE_INFO_CACHE_MISSING) && info.size == 3);
+
+    // hash is kept for unchanged file, and recomputed when it changes
+    FileInfo a = {0};
+    FileInfo b = {0};
+    write_file ("h1", "same contents");
+    write_file ("h2", "same contents");
+    TEST (GetFileInfo (at ("h1"), &a, FILE_INFO_HASH) && a.has_hash);
+    TEST (GetFileInfo (at ("h2"), &b, FILE_INFO_HASH) && b.has_hash && a.hash == b.hash);
+    TEST (GetFileInfo (at ("h1"), &b, FILE_INFO_VALIDATE) && b.has_hash && a.hash == b.hash);
+    write_file ("h1", "other contents");
+    TEST (GetFileInfo (at ("h1"), &b, FILE_INFO_VALIDATE) && !b.has_hash);
+    TEST (GetFileInfo (at ("h1"), &b, FILE_INFO_HASH) && b.has_hash && a.hash != b.hash);
+
+    FileInfoCacheClear();
+    TEST (GetFileInfo (at ("h1"), &b, FILE_INFO_CACHED) && b.size == 14);
+}
+
+#define NCACHE_FILES   64
+#define NCACHE_THREADS 8
+
+static _Atomic u64 ncache_bad;
+
+// look up files of known sizes over and over, through cache, while generations change
+static void *cache_lookups (void *arg) {
+    u64 seed = (u64)(uintptr_t)arg;
+    for (u32 i = 0; i < 20000; i++) {
+        seed          = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        u32      idx  = (seed >> 33) % NCACHE_FILES;
+        FileInfo info = {0};
+        char     path[128];
+        snprintf (path, sizeof (path), "%s/cache/%u", root, idx);
+
+        FileInfoFlags flags = FILE_INFO_CACHED | ((seed >> 20) & 1 ? FILE_INFO_HASH : 0);
+        if (!GetFileInfo (path, &info, flags) || info.size != idx) {
+            ncache_bad++;
+        }
+        if (idx == 0 && (seed >> 40) % 64 == 0) {
+            FileInfoCacheBump();
+        }
+    }
+    return NULL;
+}
+
+static void test_file_info_cache_threads (void) {
+    mkdir (at ("cache"), 0755);
+    for (u32 i = 0; i < NCACHE_FILES; i++) {
+        char name[32];
+        char data[NCACHE_FILES + 1] = {0};
+        snprintf (name, sizeof (name), "cache/%u", i);
+        memset (data, 'x', i);
+        write_file (name, data);
+    }
+
+    pthread_t threads[NCACHE_THREADS];
+    for (u64 t = 0; t < NCACHE_THREADS; t++) {
+        pthread_create (&threads[t], NULL, cache_lookups, (void *)(uintptr_t)(t + 1));
+    }
+    for (u32 t = 0; t < NCACHE_THREADS; t++) {
+        pthread_join (threads[t], NULL);
+    }
+    TEST (ncache_bad == 0);
+    FileInfoCacheClear();
+}
+
+int main() {
+    if (!mkdtemp (root)) {
+        fprintf (stderr, "failed to create scratch directory\n");
+        return 1;
+    }
+
+    test_walk_dir();
+    test_file_info_cache();
+    test_file_info_cache_threads();
+
+    char cmd[128];
+    snprintf (cmd, sizeof (cmd), "rm -rf %s", root);
+    if (system (cmd)) {
+        fprintf (stderr, "failed to remove scratch directory %s\n", root);
+    }
+
+    RESULT();
+    return ntotal != npass;
+}
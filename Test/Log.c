@@ -0,0 +1,481 @@
+// small burst, so rate limiting kicks in quickly
+#define LOG_RATE_LIMIT_BURST 3
+
+#include <Misra/Std/Log.h>
+
+// platform
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+u64 npass  = 0;
+u64 ntotal = 0;
+
+#define TEST(cond)                                                                                 \
+    do {                                                                                           \
+        ntotal++;                                                                                  \
+        if (!(cond)) {                                                                             \
+            fprintf (stderr, "[FAIL @ LINE %d] : %s\n", __LINE__, #cond);                          \
+        } else {                                                                                   \
+            npass++;                                                                               \
+        }                                                                                          \
+    } while (0)
+
+#define RESULT()                                                                                   \
+    if (ntotal == npass)                                                                           \
+        fprintf (stderr, "\nALL PASS! TOTAL = %llu\n", ntotal);                                    \
+    else                                                                                           \
+        fprintf (stderr, "%llu/%llu PASS\n", npass, ntotal)
+
+// Logs are written to stderr, so tests capture it through a pipe.
+typedef struct Capture {
+    int       pipe_fd[2];
+    int       saved_stderr;
+    pthread_t reader;
+    char     *data;
+    size_t    size;
+} Capture;
+
+static void *capture_read (void *arg) {
+    Capture *c   = arg;
+    size_t   cap = 0;
+    while (true) {
+        if (c->size + 1 >= cap) {
+            cap     = cap ? cap * 2 : 64 * 1024;
+            c->data = realloc (c->data, cap);
+        }
+
+        ssize_t ret = read (c->pipe_fd[0], c->data + c->size, cap - c->size - 1);
+        if (ret <= 0) {
+            break;
+        }
+        c->size += ret;
+    }
+    c->data[c->size] = 0;
+    return NULL;
+}
+
+// Start sending stderr to pipe. Nothing reads it till `capture_read_start`,
+// so log writer blocks once pipe is full.
+static void capture_begin (Capture *c) {
+    *c = (Capture) {0};
+    fflush (stderr);
+    if (pipe (c->pipe_fd)) {
+        perror ("pipe");
+        exit (1);
+    }
+    c->saved_stderr = dup (STDERR_FILENO);
+    dup2 (c->pipe_fd[1], STDERR_FILENO);
+    close (c->pipe_fd[1]);
+}
+
+static void capture_read_start (Capture *c) {
+    pthread_create (&c->reader, NULL, capture_read, c);
+}
+
+// Write out pending logs, restore stderr and wait till all of it is read.
+static void capture_end (Capture *c) {
+    LogFlush();
+    dup2 (c->saved_stderr, STDERR_FILENO);
+    close (c->saved_stderr);
+    pthread_join (c->reader, NULL);
+    close (c->pipe_fd[0]);
+}
+
+#define NWRITERS        4
+#define NWRITER_MSGS    5000
+#define RING_MSG_FORMAT "msg %d %d %s"
+
+static LogSite ring_site = {
+    .type   = LOG_MESSAGE_TYPE_INFO,
+    .tag    = "ring",
+    .file   = __FILE__,
+    .line   = __LINE__,
+    .format = RING_MSG_FORMAT
+};
+
+static const char *payload =
+    "a payload long enough to fill a ring buffer quickly when log writer can't keep up";
+
+static void *ring_writer (void *arg) {
+    int writer = (int)(intptr_t)arg;
+    for (int seq = 0; seq < NWRITER_MSGS; seq++) {
+        LogWrite (&ring_site, ring_site.format, writer, seq, payload);
+    }
+    return NULL;
+}
+
+// Every message is either written, in order it was logged in by it's thread,
+// or counted as dropped. Nothing is lost or written twice.
+static void test_ring_overflow (void) {
+    Capture c;
+    capture_begin (&c);
+
+    pthread_t writers[NWRITERS];
+    for (int w = 0; w < NWRITERS; w++) {
+        pthread_create (&writers[w], NULL, ring_writer, (void *)(intptr_t)w);
+    }
+    for (int w = 0; w < NWRITERS; w++) {
+        pthread_join (writers[w], NULL);
+    }
+
+    // forking waits for log writer, which is stuck till pipe is read
+    capture_read_start (&c);
+
+    // a child writes only it's own messages, never ones pending in parent
+    pid_t pid = fork();
+    if (!pid) {
+        LogWrite (&ring_site, ring_site.format, NWRITERS, 0, "child");
+        exit (0);
+    }
+    waitpid (pid, NULL, 0);
+
+    // messages of different threads are ordered only by flushes
+    LogFlush();
+    LogWrite (&ring_site, ring_site.format, NWRITERS + 1, 0, "last");
+    capture_end (&c);
+
+    int  next_seq[NWRITERS + 2] = {0};
+    u64  nwritten               = 0;
+    u64  ndropped               = 0;
+    bool in_order               = true;
+    int  last_writer            = -1;
+
+    for (char *line = c.data; line && *line;) {
+        char *eol = strchr (line, '\n');
+        if (eol) {
+            *eol = 0;
+        }
+
+        const char        *msg     = strstr (line, "] msg ");
+        int                writer  = 0;
+        int                seq     = 0;
+        unsigned long long dropped = 0;
+        if (msg && sscanf (msg, "] msg %d %d", &writer, &seq) == 2 && writer >= 0 &&
+            writer < NWRITERS + 2) {
+            in_order          = in_order && seq >= next_seq[writer];
+            next_seq[writer]  = seq + 1;
+            last_writer       = writer;
+            nwritten         += writer < NWRITERS;
+        } else if (sscanf (line, "[ERROR] [log] %llu log messages dropped", &dropped) == 1) {
+            ndropped += dropped;
+        }
+
+        line = eol ? eol + 1 : NULL;
+    }
+
+    TEST (ndropped > 0);
+    TEST (nwritten + ndropped == NWRITERS * NWRITER_MSGS);
+    TEST (in_order);
+    TEST (next_seq[NWRITERS] == 1);
+    TEST (last_writer == NWRITERS + 1);
+
+    free (c.data);
+}
+
+// Read complete contents of an open file, from start.
+static char *read_all (FILE *f, size_t *size) {
+    char  *data = NULL;
+    size_t cap  = 0;
+    *size       = 0;
+    rewind (f);
+    while (true) {
+        if (*size + 1 >= cap) {
+            cap  = cap ? cap * 2 : 4096;
+            data = realloc (data, cap);
+        }
+        size_t n = fread (data + *size, 1, cap - *size - 1, f);
+        if (!n) {
+            break;
+        }
+        *size += n;
+    }
+    data[*size] = 0;
+    return data;
+}
+
+// Decode given binary log contents to text.
+static bool decode (const u8 *data, size_t size, char **text) {
+    FILE *in  = tmpfile();
+    FILE *out = tmpfile();
+    fwrite (data, 1, size, in);
+    fflush (in);
+    rewind (in);
+
+    bool   ok  = LogDecode (fileno (in), fileno (out));
+    size_t len = 0;
+    *text      = read_all (out, &len);
+
+    fclose (in);
+    fclose (out);
+    return ok;
+}
+
+// Convert a binary log to text by running log_decode tool, built next to this test.
+static bool run_log_decode (const char *log_path, char **text) {
+    char exe[512] = {0};
+    if (readlink ("/proc/self/exe", exe, sizeof (exe) - 1) < 0 || !strrchr (exe, '/')) {
+        return false;
+    }
+    *strrchr (exe, '/') = 0;
+
+    char cmd[1024];
+    snprintf (cmd, sizeof (cmd), "%s/log_decode %s 2>/dev/null", exe, log_path);
+    FILE *p = popen (cmd, "r");
+    if (!p) {
+        return false;
+    }
+
+    size_t cap = 4096;
+    size_t len = 0;
+    size_t n   = 0;
+    *text      = malloc (cap);
+    while ((n = fread (*text + len, 1, cap - len - 1, p))) {
+        len += n;
+        if (len + 1 == cap) {
+            *text = realloc (*text, cap *= 2);
+        }
+    }
+    (*text)[len] = 0;
+
+    int status = pclose (p);
+    return WIFEXITED (status) && !WEXITSTATUS (status);
+}
+
+static void test_binary_log (void) {
+    char path[64] = "/tmp/misra_log_test_XXXXXX";
+    int  fd       = mkstemp (path);
+    if (fd < 0) {
+        TEST (false);
+        return;
+    }
+    close (fd);
+
+    // every kind of argument, each message from it's own site
+    char expected[4][256];
+    char temp[]  = "temporary";
+    int  line[4] = {0};
+
+    TEST (LogInitBinary (path));
+    LOG_INFO ("int %d, long %ld, long long %lld, size %zu", -5, 1L << 40, -12345678LL, (size_t)42);
+    line[0] = __LINE__ - 1;
+    LOG_INFO ("double %.3f, %e, long double %.2Lf", 3.14159, 1e-10, (long double)2.5);
+    line[1] = __LINE__ - 1;
+    LOG_ERROR ("string %s, width %*d, precision %.*s, %% %c", temp, 6, 7, 3, "abcdef", 'x');
+    line[2] = __LINE__ - 1;
+    memset (temp, 0, sizeof (temp));
+    LOG_INFO ("%s", "");
+    line[3] = __LINE__ - 1;
+    LogDeinit();
+
+    snprintf (expected[0], 256, "int %d, long %ld, long long %lld, size %zu", -5, 1L << 40,
+              -12345678LL, (size_t)42);
+    snprintf (expected[1], 256, "double %.3f, %e, long double %.2Lf", 3.14159, 1e-10,
+              (long double)2.5);
+    snprintf (expected[2], 256, "string %s, width %*d, precision %.*s, %% %c", "temporary", 6, 7,
+              3, "abcdef", 'x');
+    snprintf (expected[3], 256, "%s", "");
+
+    FILE  *f    = fopen (path, "rb");
+    size_t size = 0;
+    u8    *data = f ? (u8 *)read_all (f, &size) : NULL;
+    if (f) {
+        fclose (f);
+    }
+    TEST (data && size > 8);
+    if (!data) {
+        return;
+    }
+
+    // round trip, each message on it's own line
+    char       *text     = NULL;
+    const char *types[4] = {"INFO", "INFO", "ERROR", "INFO"};
+    TEST (decode (data, size, &text));
+
+    const char *iter = text;
+    for (int i = 0; i < 4; i++) {
+        char want[512];
+        snprintf (want, sizeof (want), "] [test_binary_log:%d] %s\n", line[i], expected[i]);
+
+        char type[16];
+        snprintf (type, sizeof (type), "[%s] [", types[i]);
+
+        const char *found = strstr (iter, want);
+        TEST (found && !strncmp (iter, type, strlen (type)) && !memchr (iter, '\n', found - iter));
+        iter = found ? found + strlen (want) : iter;
+    }
+    TEST (!*iter);
+
+    // log_decode tool gives same text, and fails on what isn't a binary log
+    char *tool_text = NULL;
+    TEST (run_log_decode (path, &tool_text) && !strcmp (tool_text, text));
+    free (tool_text);
+    tool_text = NULL;
+    TEST (!run_log_decode ("/dev/null", &tool_text) && !*tool_text);
+    free (tool_text);
+
+    // string lengths are checked against record size
+    u8 *str = NULL;
+    for (size_t i = 8; i + sizeof ("temporary") <= size && !str; i++) {
+        str = memcmp (data + i, "temporary", sizeof ("temporary")) ? NULL : data + i;
+    }
+    i64 len = 0;
+    if (str) {
+        memcpy (&len, str - 8, sizeof (len));
+    }
+    TEST (len == 9);
+
+    // decoder errors are logged, keep them out of test output
+    Capture c;
+    capture_begin (&c);
+    capture_read_start (&c);
+
+    // truncated logs decode only till last complete record, and fail if cut within one
+    bool   prefixes_match = true;
+    size_t ntruncated_ok  = 0;
+    for (size_t n = 0; n < size; n++) {
+        char *part      = NULL;
+        ntruncated_ok  += decode (data, n, &part);
+        prefixes_match  = prefixes_match && !strncmp (part, text, strlen (part));
+        free (part);
+    }
+
+    bool  long_str_accepted  = true;
+    bool  short_str_accepted = true;
+    char *part               = NULL;
+    if (str) {
+        len = 1000;
+        memcpy (str - 8, &len, sizeof (len));
+        long_str_accepted = decode (data, size, &part) || strncmp (part, text, strlen (part));
+        free (part);
+
+        len = 4;
+        memcpy (str - 8, &len, sizeof (len));
+        short_str_accepted = decode (data, size, &part);
+        free (part);
+    }
+
+    capture_end (&c);
+    free (c.data);
+
+    TEST (prefixes_match);
+    TEST (ntruncated_ok == 8); // after header, then after each site and message but last
+    TEST (!long_str_accepted);
+    TEST (!short_str_accepted);
+
+    free (text);
+    free (data);
+    unlink (path);
+}
+
+static void log_limited (int from, int count) {
+    for (int i = from; i < from + count; i++) {
+        LOG_INFO ("limited %d", i);
+    }
+}
+
+static void log_fatal (int count) {
+    for (int i = 0; i < count; i++) {
+        LOG_FATAL ("fatal %d", i);
+    }
+}
+
+// Each site writes a burst of messages per window, rest are counted and reported.
+static void test_rate_limit (void) {
+    Capture c;
+    capture_begin (&c);
+    capture_read_start (&c);
+
+    log_limited (0, 10);
+    LogFlush();
+
+    // next window allows another burst
+    struct timespec ts = {.tv_sec = LOG_RATE_LIMIT_WINDOW_MS / 1000,
+                          .tv_nsec = (LOG_RATE_LIMIT_WINDOW_MS % 1000 + 100) * 1000000L};
+    nanosleep (&ts, NULL);
+    log_limited (10, 10);
+
+    log_fatal (2 * LOG_RATE_LIMIT_BURST);
+    capture_end (&c);
+
+    int                emitted[20] = {0};
+    u64                nemitted    = 0;
+    u64                nsuppressed = 0;
+    u64                nreports    = 0;
+    u64                nfatal      = 0;
+    unsigned long long repeated    = 0;
+
+    for (char *line = c.data; line && *line;) {
+        char *eol = strchr (line, '\n');
+        if (eol) {
+            *eol = 0;
+        }
+
+        const char *msg    = strstr (line, "] limited ");
+        const char *report = strstr (line, "[log_limited:");
+        int         i      = 0;
+        if (msg && sscanf (msg, "] limited %d", &i) == 1 && i >= 0 && i < 20) {
+            emitted[i]++;
+            nemitted++;
+        } else if (report && sscanf (report, "[log_limited:%*d] message repeated %llu",
+                                     &repeated) == 1) {
+            nsuppressed += repeated;
+            nreports++;
+        } else if (!strncmp (line, "[FATAL]", 7) && strstr (line, "] fatal ")) {
+            nfatal++;
+        }
+
+        line = eol ? eol + 1 : NULL;
+    }
+
+    // first burst of each window is written, in full
+    TEST (nemitted == 2 * LOG_RATE_LIMIT_BURST);
+    TEST (emitted[0] && emitted[1] && emitted[2] && !emitted[3] && !emitted[9]);
+    TEST (emitted[10] && emitted[11] && emitted[12] && !emitted[13] && !emitted[19]);
+
+    // rest are reported as repeated, atleast once every window
+    TEST (nsuppressed == 20 - 2 * LOG_RATE_LIMIT_BURST);
+    TEST (nreports >= 2);
+
+    // fatal messages are never suppressed
+    TEST (nfatal == 2 * LOG_RATE_LIMIT_BURST);
+
+    free (c.data);
+}
+
+// Strings with a precision needn't be terminated, and nothing past precision is read.
+static void test_string_precision (void) {
+    // string ends right where a page nobody can read starts
+    size_t page = sysconf (_SC_PAGESIZE);
+    char  *map  = mmap (NULL, 2 * page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED || mprotect (map + page, page, PROT_NONE)) {
+        TEST (false);
+        return;
+    }
+    char *str = map + page - 6;
+    memcpy (str, "abcdef", 6);
+
+    Capture c;
+    capture_begin (&c);
+    capture_read_start (&c);
+    LOG_INFO ("[%.*s] [%.3s] [%.*s]", 6, str, str + 3, 2, str + 1);
+    capture_end (&c);
+
+    TEST (c.data && strstr (c.data, "[abcdef] [def] [bc]\n"));
+
+    free (c.data);
+    munmap (map, 2 * page);
+}
+
+int main() {
+    test_ring_overflow();
+    test_binary_log();
+    test_rate_limit();
+    test_string_precision();
+
+    RESULT();
+    return ntotal != npass;
+}
@@ -0,0 +1,152 @@
+// Watch mode of build system and watcher under it are header only, and tested as is.
+#include "../Vidyut/Watch.h"
+
+// platform
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <time.h>
+
+typedef unsigned long long u64;
+
+u64 npass  = 0;
+u64 ntotal = 0;
+
+#define TEST(cond)                                                                                 \
+    do {                                                                                           \
+        ntotal++;                                                                                  \
+        if (!(cond)) {                                                                             \
+            fprintf (stderr, "[FAIL @ LINE %d] : %s\n", __LINE__, #cond);                          \
+        } else {                                                                                   \
+            npass++;                                                                               \
+        }                                                                                          \
+    } while (0)
+
+#define RESULT()                                                                                   \
+    if (ntotal == npass)                                                                           \
+        fprintf (stderr, "\nALL PASS! TOTAL = %llu\n", ntotal);                                    \
+    else                                                                                           \
+        fprintf (stderr, "%llu/%llu PASS\n", npass, ntotal)
+
+static void write_file (const char *name, const char *data) {
+    FILE *f = fopen (name, "wb");
+    if (f) {
+        fputs (data, f);
+        fclose (f);
+    }
+}
+
+// true if watcher has no events left to read
+static bool drained (void) {
+    struct pollfd pfd = {.fd = vidyut_watcher.fd, .events = POLLIN};
+    return poll (&pfd, 1, 0) == 0;
+}
+
+// keep writing to a file, each write well within debounce period of previous one
+static void *write_burst (void *arg) {
+    struct timespec gap = {.tv_nsec = WATCH_DEBOUNCE_MS * 1000000L / 4};
+    for (int i = 0; i < 8; i++) {
+        write_file (arg, "int x;");
+        nanosleep (&gap, NULL);
+    }
+    return NULL;
+}
+
+static bool changes_are (WatchChanges *changes, const char *first, const char *second) {
+    return changes->length == (second ? 2 : 1) && !strcmp (changes->paths[0], first) &&
+           (!second || !strcmp (changes->paths[1], second));
+}
+
+// watcher underneath watch mode, on its own
+static void test_watcher (void) {
+    mkdir ("tree", 0755);
+    mkdir ("tree/a", 0755);
+
+    Watcher      w;
+    WatchChanges changes = {0};
+    TEST (WatcherInit (&w, WATCH_DEBOUNCE_MS) && WatcherAddDir (&w, "tree", true));
+
+    // nothing changed yet
+    TEST (!WatcherWait (&w, &changes, 10) && errno == ETIMEDOUT);
+
+    // every path is reported once, sorted, from whole tree
+    write_file ("tree/x.c", "");
+    write_file ("tree/x.c", "int x;");
+    write_file ("tree/a/y.h", "");
+    TEST (WatcherWait (&w, &changes, -1) && changes_are (&changes, "tree/a/y.h", "tree/x.c"));
+
+    // directories created later are watched too
+    mkdir ("tree/b", 0755);
+    TEST (WatcherWait (&w, &changes, -1) && changes_are (&changes, "tree/b", NULL));
+    write_file ("tree/b/z.c", "");
+    TEST (WatcherWait (&w, &changes, -1) && changes_are (&changes, "tree/b/z.c", NULL));
+
+    WatchChangesDeinit (&changes);
+    WatcherDeinit (&w);
+}
+
+int main() {
+#ifndef __linux__
+    // no inotify, watch mode must refuse to start
+    TEST (!WatchInit() && errno == ENOSYS);
+    RESULT();
+    return ntotal != npass;
+#endif
+
+    char root[64] = "/tmp/vidyut_watch_test_XXXXXX";
+    if (!mkdtemp (root) || chdir (root)) {
+        fprintf (stderr, "failed to create scratch directory\n");
+        return 1;
+    }
+
+    // sources watched through build files, dependency files and new directories
+    mkdir ("inc", 0755);
+    mkdir ("late", 0755);
+    write_file ("src.c", "");
+    write_file ("inc/h.h", "");
+    write_file ("obj.d", "obj.o: src.c \\\n inc/h.h\n");
+
+    TEST (WatchInit());
+    WatchFileDir ("src.c");
+    WatchDepFile ("obj.d");
+
+    bool self_changed = true;
+
+    // a burst of writes is reported as a single change
+    pthread_t writer;
+    pthread_create (&writer, NULL, write_burst, "src.c");
+    TEST (WaitForChanges (&self_changed) && !self_changed);
+    pthread_join (writer, NULL);
+    TEST (drained());
+
+    // header found only in dependency file
+    write_file ("inc/h.h", "#pragma once");
+    TEST (WaitForChanges (&self_changed) && !self_changed);
+    TEST (drained());
+
+    // directories added after start are watched too
+    WatchFileDir ("late/x.c");
+    write_file ("late/x.c", "");
+    TEST (WaitForChanges (&self_changed) && !self_changed);
+    TEST (drained());
+
+    // build files rebuild build system itself
+    write_file ("BuildCommands.c", "");
+    TEST (WaitForChanges (&self_changed) && self_changed);
+    TEST (drained());
+
+    WatcherDeinit (&vidyut_watcher);
+
+    test_watcher();
+
+    char cmd[128];
+    snprintf (cmd, sizeof (cmd), "rm -rf %s", root);
+    if (system (cmd)) {
+        fprintf (stderr, "failed to remove scratch directory %s\n", root);
+    }
+
+    RESULT();
+    return ntotal != npass;
+}
@@ -0,0 +1,196 @@
+/// file      : tools/genkeywordhash.c
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Generate perfect hash table of keywords (see `McKeywordHash`).
+/// Run by build system, whenever keyword list changes.
+
+#include <Misra/Mc/Parser/KeywordHash.h>
+#include <Misra/Std/Log.h>
+
+// platform
+#include <stdio.h>
+
+#define MAX_KEYWORDS       256
+#define MAX_KEYWORD_LENGTH 63
+#define MAX_KIND_LENGTH    127
+
+// max number of seeds tried for each table size
+#define MAX_SEED_TRIES (1 << 20)
+
+typedef struct Keyword {
+    char name[MAX_KEYWORD_LENGTH + 1];
+    char kind[MAX_KIND_LENGTH + 1];
+    u32  length;
+} Keyword;
+
+static Keyword keywords[MAX_KEYWORDS];
+static u32     nkeywords = 0;
+
+// Read "<name> <kind>" lines, ignoring blank lines and lines starting with '#'.
+static bool read_keywords (const char* path) {
+    FILE* in = fopen (path, "r");
+    if (!in) {
+        LOG_ERROR ("failed to open \"%s\" : %s.", path, strerror (errno));
+        return false;
+    }
+
+    char line[512];
+    u32  lineno = 0;
+    while (fgets (line, sizeof (line), in)) {
+        lineno++;
+
+        char name[MAX_KEYWORD_LENGTH + 1];
+        char kind[MAX_KIND_LENGTH + 1];
+        int  n = sscanf (line, "%63s %127s", name, kind);
+        if (n <= 0 || name[0] == '#') {
+            continue;
+        }
+
+        if (n != 2) {
+            LOG_ERROR ("%s:%u : expected \"<keyword> <token kind>\".", path, lineno);
+            fclose (in);
+            return false;
+        }
+
+        if (nkeywords == MAX_KEYWORDS) {
+            LOG_ERROR ("%s:%u : too many keywords.", path, lineno);
+            fclose (in);
+            return false;
+        }
+
+        Keyword* kw = &keywords[nkeywords++];
+        strcpy (kw->name, name);
+        strcpy (kw->kind, kind);
+        kw->length = strlen (name);
+    }
+
+    fclose (in);
+
+    if (!nkeywords) {
+        LOG_ERROR ("no keywords in \"%s\".", path);
+        return false;
+    }
+
+    return true;
+}
+
+
+// splitmix64, so that generated table is same on every run
+static u64 next_seed (u64* state) {
+    u64 z = (*state += 0x9e3779b97f4a7c15ULL);
+    z     = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z     = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return (z ^ (z >> 31)) | 1;
+}
+
+
+// Find smallest table and a seed that maps every keyword to a different slot.
+static bool find_seed (u64* seed, u32* bits) {
+    static u8 used[1 << 16];
+
+    u32 min_bits = 1;
+    while ((1u << min_bits) < nkeywords) {
+        min_bits++;
+    }
+
+    for (*bits = min_bits; *bits <= 16; (*bits)++) {
+        u64 state = 0;
+        for (u32 t = 0; t < MAX_SEED_TRIES; t++) {
+            *seed = next_seed (&state);
+            memset (used, 0, 1u << *bits);
+
+            u32 k = 0;
+            for (; k < nkeywords; k++) {
+                u32 slot = McKeywordHash (keywords[k].name, keywords[k].length, *seed, *bits);
+                if (used[slot]) {
+                    break;
+                }
+                used[slot] = 1;
+            }
+
+            if (k == nkeywords) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+
+static bool write_table (const char* path, const char* input, u64 seed, u32 bits) {
+    // write to a temporary file first, so that a failed run never leaves half a table behind
+    char tmp_path[4096];
+    snprintf (tmp_path, sizeof (tmp_path), "%s.tmp", path);
+
+    FILE* out = fopen (tmp_path, "w");
+    if (!out) {
+        LOG_ERROR ("failed to open \"%s\" : %s.", tmp_path, strerror (errno));
+        return false;
+    }
+
+    u32 min_length = (u32)-1;
+    u32 max_length = 0;
+    for (u32 k = 0; k < nkeywords; k++) {
+        min_length = keywords[k].length < min_length ? keywords[k].length : min_length;
+        max_length = keywords[k].length > max_length ? keywords[k].length : max_length;
+    }
+
+    fprintf (out, "/// Generated by gen_keyword_hash from %s. Do not edit.\n\n", input);
+    fprintf (out, "#define MC_KEYWORD_HASH_SEED  0x%016llxULL\n", seed);
+    fprintf (out, "#define MC_KEYWORD_HASH_BITS  %u\n", bits);
+    fprintf (out, "#define MC_KEYWORD_MIN_LENGTH %u\n", min_length);
+    fprintf (out, "#define MC_KEYWORD_MAX_LENGTH %u\n\n", max_length);
+    fprintf (out, "typedef struct McKeywordSlot {\n");
+    fprintf (out, "    char name[MC_KEYWORD_MAX_LENGTH + 1];\n");
+    fprintf (out, "    u8   length;\n");
+    fprintf (out, "    u8   kind;\n");
+    fprintf (out, "} McKeywordSlot;\n\n");
+    fprintf (out, "static const McKeywordSlot mc_keyword_slots[1 << MC_KEYWORD_HASH_BITS] = {\n");
+    for (u32 k = 0; k < nkeywords; k++) {
+        u32 slot = McKeywordHash (keywords[k].name, keywords[k].length, seed, bits);
+        fprintf (
+            out,
+            "    [%u] = {\"%s\", %u, %s},\n",
+            slot,
+            keywords[k].name,
+            keywords[k].length,
+            keywords[k].kind
+        );
+    }
+    fprintf (out, "};\n");
+
+    if (fclose (out)) {
+        LOG_ERROR ("failed to write \"%s\" : %s.", tmp_path, strerror (errno));
+        return false;
+    }
+
+    if (rename (tmp_path, path)) {
+        LOG_ERROR ("failed to rename \"%s\" to \"%s\" : %s.", tmp_path, path, strerror (errno));
+        return false;
+    }
+
+    return true;
+}
+
+
+int main (int argc, char** argv) {
+    if (argc != 3) {
+        fprintf (stderr, "usage: gen_keyword_hash <output header> <keyword list>\n");
+        return 1;
+    }
+
+    if (!read_keywords (argv[2])) {
+        return 1;
+    }
+
+    u64 seed = 0;
+    u32 bits = 0;
+    if (!find_seed (&seed, &bits)) {
+        LOG_ERROR ("failed to find a perfect hash for %u keywords.", nkeywords);
+        return 1;
+    }
+
+    return write_table (argv[1], argv[2], seed, bits) ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+/// file      : tools/genpow5table.c
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, Anvie Labs, All rights reserved.
+///
+/// Generate table of 128-bit approximations of powers of five, used by
+/// `McLiteralDecToF64` to convert decimal literals to correctly rounded
+/// floats (Eisel-Lemire algorithm). Run by build system.
+///
+/// For q >= 0, entry is 5^q shifted so that it's top bit is bit 127, and
+/// truncated to 128 bits. For q < 0, entry is 2^b / 5^-q for a large enough b,
+/// plus one, truncated the same way.
+
+#include <Misra/Std/Log.h>
+
+// platform
+#include <stdio.h>
+
+#define MIN_EXPONENT (-342)
+#define MAX_EXPONENT 308
+
+// enough for 2^b with b = 2 * bits(5^342) + 128
+#define NLIMBS 64
+
+typedef struct BigInt {
+    u32 limbs[NLIMBS];
+} BigInt;
+
+static void big_set_u32 (BigInt* x, u32 v) {
+    memset (x, 0, sizeof (BigInt));
+    x->limbs[0] = v;
+}
+
+
+static void big_mul_u32 (BigInt* x, u32 v) {
+    u64 carry = 0;
+    for (u32 i = 0; i < NLIMBS; i++) {
+        u64 t       = (u64)x->limbs[i] * v + carry;
+        x->limbs[i] = (u32)t;
+        carry       = t >> 32;
+    }
+}
+
+
+static void big_add_u32 (BigInt* x, u32 v) {
+    u64 carry = v;
+    for (u32 i = 0; i < NLIMBS && carry; i++) {
+        u64 t       = (u64)x->limbs[i] + carry;
+        x->limbs[i] = (u32)t;
+        carry       = t >> 32;
+    }
+}
+
+
+static void big_shl1 (BigInt* x) {
+    for (u32 i = NLIMBS - 1; i > 0; i--) {
+        x->limbs[i] = (x->limbs[i] << 1) | (x->limbs[i - 1] >> 31);
+    }
+    x->limbs[0] <<= 1;
+}
+
+
+static void big_shr1 (BigInt* x) {
+    for (u32 i = 0; i < NLIMBS - 1; i++) {
+        x->limbs[i] = (x->limbs[i] >> 1) | (x->limbs[i + 1] << 31);
+    }
+    x->limbs[NLIMBS - 1] >>= 1;
+}
+
+
+static u32 big_bits (const BigInt* x) {
+    for (u32 i = NLIMBS; i > 0; i--) {
+        if (x->limbs[i - 1]) {
+            return (i - 1) * 32 + (32 - __builtin_clz (x->limbs[i - 1]));
+        }
+    }
+    return 0;
+}
+
+
+static int big_cmp (const BigInt* a, const BigInt* b) {
+    for (u32 i = NLIMBS; i > 0; i--) {
+        if (a->limbs[i - 1] != b->limbs[i - 1]) {
+            return a->limbs[i - 1] < b->limbs[i - 1] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+
+static void big_sub (BigInt* a, const BigInt* b) {
+    u64 borrow = 0;
+    for (u32 i = 0; i < NLIMBS; i++) {
+        u64 t       = (u64)a->limbs[i] - b->limbs[i] - borrow;
+        a->limbs[i] = (u32)t;
+        borrow      = (t >> 32) & 1;
+    }
+}
+
+
+// quotient = 2^b / d, by shift and subtract long division
+static void big_pow2_div (BigInt* quotient, u32 b, const BigInt* d) {
+    BigInt rem = {0};
+    memset (quotient, 0, sizeof (BigInt));
+
+    for (u32 i = b + 1; i > 0; i--) {
+        u32 bit = i - 1;
+        big_shl1 (&rem);
+        rem.limbs[0] |= bit == b;
+
+        if (big_cmp (&rem, d) >= 0) {
+            big_sub (&rem, d);
+            quotient->limbs[bit / 32] |= 1u << (bit % 32);
+        }
+    }
+}
+
+
+// Get 128-bit approximation of 5^q as (hi, lo).
+static void pow5_128 (i32 q, u64* hi, u64* lo) {
+    BigInt p = {0};
+    big_set_u32 (&p, 1);
+    for (i32 i = 0; i < (q < 0 ? -q : q); i++) {
+        big_mul_u32 (&p, 5);
+    }
+
+    BigInt c = {0};
+    if (q >= 0) {
+        c = p;
+        while (big_bits (&c) < 128) {
+            big_shl1 (&c);
+        }
+    } else {
+        // smallest z with 2^z >= 5^-q, 5^-q is never a power of two
+        u32 z = big_bits (&p);
+        u32 b = q >= -27 ? z + 127 : 2 * z + 128;
+        big_pow2_div (&c, b, &p);
+        big_add_u32 (&c, 1);
+    }
+
+    // truncate
+    while (big_bits (&c) > 128) {
+        big_shr1 (&c);
+    }
+
+    *hi = ((u64)c.limbs[3] << 32) | c.limbs[2];
+    *lo = ((u64)c.limbs[1] << 32) | c.limbs[0];
+}
+
+
+static bool write_table (const char* path) {
+    // write to a temporary file first, so that a failed run never leaves half a table behind
+    char tmp_path[4096];
+    snprintf (tmp_path, sizeof (tmp_path), "%s.tmp", path);
+
+    FILE* out = fopen (tmp_path, "w");
+    if (!out) {
+        LOG_ERROR ("failed to open \"%s\" : %s.", tmp_path, strerror (errno));
+        return false;
+    }
+
+    fprintf (out, "/// Generated by gen_pow5_table. Do not edit.\n\n");
+    fprintf (out, "#define MC_POW5_MIN_EXPONENT (%d)\n", MIN_EXPONENT);
+    fprintf (out, "#define MC_POW5_MAX_EXPONENT %d\n", MAX_EXPONENT);
+    fprintf (out, "#define MC_POW5_COUNT (MC_POW5_MAX_EXPONENT - MC_POW5_MIN_EXPONENT + 1)\n\n");
+    fprintf (out, "// high and low 64 bits of each power, from MC_POW5_MIN_EXPONENT\n");
+    fprintf (out, "static const u64 mc_pow5_table[2 * MC_POW5_COUNT] = {\n");
+    for (i32 q = MIN_EXPONENT; q <= MAX_EXPONENT; q++) {
+        u64 hi = 0;
+        u64 lo = 0;
+        pow5_128 (q, &hi, &lo);
+        fprintf (out, "    0x%016llxULL, 0x%016llxULL,\n", hi, lo);
+    }
+    fprintf (out, "};\n");
+
+    if (fclose (out)) {
+        LOG_ERROR ("failed to write \"%s\" : %s.", tmp_path, strerror (errno));
+        return false;
+    }
+
+    if (rename (tmp_path, path)) {
+        LOG_ERROR ("failed to rename \"%s\" to \"%s\" : %s.", tmp_path, path, strerror (errno));
+        return false;
+    }
+
+    return true;
+}
+
+
+int main (int argc, char** argv) {
+    if (argc != 2) {
+        fprintf (stderr, "usage: gen_pow5_table <output header>\n");
+        return 1;
+    }
+
+    return write_table (argv[1]) ? 0 : 1;
+}
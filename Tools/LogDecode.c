@@ -0,0 +1,33 @@
+/// file      : tools/logdecode.c
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, All rights reserved.
+///
+/// Convert binary logs (see `LogInitBinary`) to text.
+
+#include <Misra/Std/Log.h>
+
+// platform
+#include <fcntl.h>
+#include <unistd.h>
+
+int main (int argc, char** argv) {
+    if (argc > 2) {
+        fprintf (stderr, "usage: log_decode [binary log]\n");
+        fprintf (stderr, "       reads binary log from stdin if no file is given\n");
+        return 1;
+    }
+
+    int fd = STDIN_FILENO;
+    if (argc == 2 && (fd = open (argv[1], O_RDONLY)) < 0) {
+        fprintf (stderr, "failed to open \"%s\" : %s\n", argv[1], strerror (errno));
+        return 1;
+    }
+
+    bool ok = LogDecode (fd, STDOUT_FILENO);
+
+    if (fd != STDIN_FILENO) {
+        close (fd);
+    }
+
+    return ok ? 0 : 1;
+}
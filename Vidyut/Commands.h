@@ -17,53 +17,106 @@
 #include "File.h"
 #include "Log.h"
 #include "Str.h"
+#include "Watch.h"
 
-static inline void ExecCmd (const char* cmd) {
+/// When set, failing commands do not terminate build (used in watch mode).
+static int vidyut_keep_going = 0;
+
+/// Set when any command fails.
+static int vidyut_failed = 0;
+
+/// Number of object files actually compiled in current build.
+static int vidyut_nrebuilt = 0;
+
+///
+/// Execute given command. Build is terminated if command fails, unless
+/// `vidyut_keep_going` is set.
+///
+/// return exit status of command.
+///
+static inline int ExecCmd (const char* cmd) {
     if (!cmd) {
         LOG_ERROR ("Invalid arguments.");
-        return;
+        return -1;
     }
 
     puts (cmd);
+    fflush (stdout);
 
     int ret = 0;
     if ((ret = system (cmd))) {
-        exit (ret);
+        if (!vidyut_keep_going) {
+            exit (ret);
+        }
+        vidyut_failed = 1;
     }
+
+    return ret;
 }
 
 ///
-/// Instructs the build ExecCmd to build itself, create a child process,
-/// run the newly built binary, and exit from old build binary.
+/// Build the build system again and replace current process with rebuilt binary.
+/// All arguments are passed on to the new process. Returns only if rebuilding fails.
 ///
 /// argc[in] : required
 /// argv[in] : required
 /// envp[in] : required
 ///
-static inline void RebuildSelf (
-    int    argc,
-    char** argv,
-    char** envp
-) { /* do not continue if this is already a forked process */
-    if (argc < 1 || !argv || !envp || (argc > 1 && strcmp (argv[argc - 1], "--forked") == 0)) {
-        return;
-    }
-
+static inline void RestartSelf (int argc, char** argv, char** envp) {
     /* build self first */
     LOG_INFO ("Rebuilding self");
     ExecCmd ("mkdir -pv " BUILD_BINARY_DIR);
     ExecCmd ("mkdir -pv " BUILD_LIBRARY_DIR);
     ExecCmd ("mkdir -pv " BUILD_ARCHIVE_DIR);
-    ExecCmd ("gcc -O3 -o Make BuildCommands.c");
+    if (ExecCmd ("gcc -O3 -o Make BuildCommands.c")) {
+        return;
+    }
+
+    /* forward user arguments, marking child as forked */
+    char** child_argv = calloc (argc + 2, sizeof (char*));
+    if (!child_argv) {
+        LOG_ERROR ("Failed to allocate memory");
+        exit (1);
+    }
+
+    int child_argc           = 0;
+    child_argv[child_argc++] = argv[0];
+    for (int i = 1; i < argc; i++) {
+        if (strcmp (argv[i], "--forked")) {
+            child_argv[child_argc++] = argv[i];
+        }
+    }
+    child_argv[child_argc++] = "--forked";
+    child_argv[child_argc]   = NULL;
 
     /* replace execution with rebuilt binary */
-    char* child_argv[] = {argv[0], "--forked", NULL};
     if (execve ("Make", child_argv, envp) == -1) {
         perror ("execve");
         exit (1);
     }
 }
 
+///
+/// Instructs the build ExecCmd to build itself, create a child process,
+/// run the newly built binary, and exit from old build binary.
+///
+/// argc[in] : required
+/// argv[in] : required
+/// envp[in] : required
+///
+static inline void RebuildSelf (
+    int    argc,
+    char** argv,
+    char** envp
+) { /* do not continue if this is already a forked process */
+    if (argc < 1 || !argv || !envp || (argc > 1 && strcmp (argv[argc - 1], "--forked") == 0)) {
+        return;
+    }
+
+    RestartSelf (argc, argv, envp);
+    exit (1);
+}
+
 ///
 /// Takes a command string and appends libraries to link with, and compiler flags
 /// to be passed to compiler.
@@ -100,6 +153,74 @@ static inline const char* AppendLibrariesAndCompilationFlagsToCommand (
     return cmd;
 }
 
+///
+/// Check whether an object file is out of date. An object is rebuilt when it
+/// does not exist, when command used to build it changed, or when the source
+/// or any header listed in it's dependency file is newer than it.
+///
+/// obj_file[in] : Object file to check.
+/// dep_file[in] : Dependency file generated by compiler for this object.
+/// cmd_file[in] : File containing command last used to build this object.
+/// cmd[in]      : Command that will be used to build this object.
+///
+/// return true if object must be rebuilt
+/// return false otherwise
+///
+static inline bool ObjectNeedsRebuild (
+    const char* obj_file,
+    const char* dep_file,
+    const char* cmd_file,
+    const char* cmd
+) {
+    long long obj_mtime = GetFileMtime (obj_file);
+    if (obj_mtime < 0) {
+        return true;
+    }
+
+    const char* old_cmd = ReadFromFile (cmd_file);
+    bool        changed = !old_cmd || strcmp (old_cmd, cmd);
+    free ((void*)old_cmd);
+    if (changed) {
+        return true;
+    }
+
+    const char* deps = ReadFromFile (dep_file);
+    if (!deps) {
+        return true;
+    }
+
+    const char* iter = deps;
+    char        path[4096];
+    while (!changed && NextDepPath (&iter, path, sizeof (path))) {
+        changed = GetFileMtime (path) > obj_mtime || !FILE_EXISTS (path);
+    }
+
+    free ((void*)deps);
+    return changed;
+}
+
+///
+/// Check whether an output built from given objects needs to be linked again.
+/// Nothing is linked if any object is missing, because it failed to compile.
+///
+static inline bool OutputNeedsRelink (const char* out_file, const char** src_names) {
+    long long out_mtime = GetFileMtime (out_file);
+    bool      relink    = out_mtime < 0;
+
+    while (*src_names) {
+        const char* obj_file = Appendf (NULL, "%s/%s.o", BUILD_TMP_DIR, *src_names++);
+        long long   mtime    = GetFileMtime (obj_file);
+        free ((void*)obj_file);
+
+        if (mtime < 0) {
+            return false;
+        }
+        relink = relink || mtime > out_mtime;
+    }
+
+    return relink;
+}
+
 ///
 /// Create object file for given source file.
 ///
@@ -122,26 +243,43 @@ static inline const char* CreateObjectFile (
         return NULL;
     }
 
-    const char* wd = GetDirFromFilePath (src_name);
+    const char* obj_file = Appendf (NULL, "%s/%s.o", BUILD_TMP_DIR, src_name);
+    const char* dep_file = Appendf (NULL, "%s/%s.d", BUILD_TMP_DIR, src_name);
+    const char* cmd_file = Appendf (NULL, "%s/%s.cmd", BUILD_TMP_DIR, src_name);
 
-    /* create directory first */
-    const char* cmd = Appendf (NULL, "mkdir -pv %s/%s", BUILD_TMP_DIR, wd);
-    ExecCmd (cmd);
-    *(char*)cmd = 0; /* clear */
-
-    /* compile and create .o file */
-    cmd = Appendf (
-        cmd,
-        "gcc -o %s/%s.o -c %s -Wl,-rpath=%s",
-        BUILD_TMP_DIR,
-        src_name,
+    /* compile and create .o file, along with list of headers it depends on */
+    const char* cmd = Appendf (
+        NULL,
+        "gcc -o %s -c %s -MMD -MF %s -Wl,-rpath=%s",
+        obj_file,
         src_name,
+        dep_file,
         BUILD_LIBRARY_DIR
     );
     cmd = AppendLibrariesAndCompilationFlagsToCommand (cmd, lib_names, comp_flags);
 
-    /* execute command */
-    ExecCmd (cmd);
+    /* compile only if object is out of date */
+    if (ObjectNeedsRebuild (obj_file, dep_file, cmd_file, cmd)) {
+        const char* wd     = GetDirFromFilePath (src_name);
+        const char* mkdir  = Appendf (NULL, "mkdir -p %s/%s", BUILD_TMP_DIR, wd);
+        ExecCmd (mkdir);
+
+        if (ExecCmd (cmd)) {
+            /* make sure failed object gets compiled again next time */
+            unlink (obj_file);
+            unlink (cmd_file);
+        } else {
+            WriteToFile (cmd_file, cmd);
+        }
+        vidyut_nrebuilt++;
+
+        free ((void*)mkdir);
+        free ((void*)wd);
+    }
+
+    /* in watch mode, look out for changes in source and all it's headers */
+    WatchFileDir (src_name);
+    WatchDepFile (dep_file);
 
     /* append compile command data */
     /* reference https://releases.llvm.org/8.0.1/tools/clang/docs/JSONCompilationDatabase.html */
@@ -154,7 +292,9 @@ static inline const char* CreateObjectFile (
         src_name
     );
 
-    free ((void*)wd);
+    free ((void*)obj_file);
+    free ((void*)dep_file);
+    free ((void*)cmd_file);
     free ((void*)cmd);
 
     return ccj;
@@ -202,8 +342,12 @@ static inline const char* AddExecutable (
     }
     cmd = AppendLibrariesAndCompilationFlagsToCommand (cmd, lib_names, comp_flags);
 
-    /* create executable */
-    ExecCmd (cmd);
+    /* create executable, only if any of it's objects changed */
+    const char* exec_file = Appendf (NULL, "%s/%s", BUILD_BINARY_DIR, exec_name);
+    if (OutputNeedsRelink (exec_file, src_names)) {
+        ExecCmd (cmd);
+    }
+    free ((void*)exec_file);
 
     free ((void*)cmd);
 
@@ -248,11 +392,20 @@ static inline const char* AddLibrary (
 
     so_cmd = AppendLibrariesAndCompilationFlagsToCommand (so_cmd, lib_names, comp_flags);
 
-    /* create archive */
-    ExecCmd (ar_cmd);
+    /* create archive, only if any of it's objects changed */
+    const char* ar_file = Appendf (NULL, "%s/lib%s.a", BUILD_ARCHIVE_DIR, lib_name);
+    if (OutputNeedsRelink (ar_file, src_names)) {
+        ExecCmd (ar_cmd);
+    }
 
     /* create shared object */
-    ExecCmd (so_cmd);
+    const char* so_file = Appendf (NULL, "%s/lib%s.so", BUILD_LIBRARY_DIR, lib_name);
+    if (OutputNeedsRelink (so_file, src_names)) {
+        ExecCmd (so_cmd);
+    }
+
+    free ((void*)ar_file);
+    free ((void*)so_file);
 
     free ((void*)ar_cmd);
     free ((void*)so_cmd);
@@ -260,4 +413,63 @@ static inline const char* AddLibrary (
     return ccj;
 }
 
+///
+/// Generate a file by running an executable built earlier in this build, as
+/// `<generator> <out_file> <inputs...>`. File is generated again only when it's
+/// missing, or when generator or any input is newer than it. Sources including
+/// a generated header are rebuilt through their dependency files as usual.
+///
+/// out_file[in]    : Path of file to generate, usually inside `BUILD_GEN_DIR`.
+/// gen_name[in]    : Name of executable (in `BUILD_BINARY_DIR`) that generates it.
+/// input_names[in] : Files generator reads, or `NO_INPUTS`.
+///
+/// return true on success
+/// return false otherwise
+///
+static inline bool AddGeneratedFile (
+    const char*  out_file,
+    const char*  gen_name,
+    const char** input_names
+) {
+    if (!out_file || !gen_name) {
+        LOG_ERROR ("Invalid arguments.");
+        return false;
+    }
+
+    const char* gen_file = Appendf (NULL, "%s/%s", BUILD_BINARY_DIR, gen_name);
+    const char* cmd      = Appendf (NULL, "%s %s", gen_file, out_file);
+
+    long long out_mtime = GetFileMtime (out_file);
+    long long gen_mtime = GetFileMtime (gen_file);
+    bool      outdated  = out_mtime < 0 || gen_mtime > out_mtime;
+
+    const char** iter = input_names;
+    while (iter && *iter) {
+        outdated = outdated || GetFileMtime (*iter) > out_mtime;
+        cmd      = Appendf (cmd, " %s", *iter);
+        WatchFileDir (*iter++);
+    }
+
+    bool ok = true;
+    if (gen_mtime < 0) {
+        /* generator itself failed to build */
+        LOG_ERROR ("Generator \"%s\" not found", gen_file);
+        vidyut_failed = 1;
+        ok            = false;
+    } else if (outdated) {
+        const char* dir   = GetDirFromFilePath (out_file);
+        const char* mkdir = Appendf (NULL, "mkdir -p %s", dir);
+        ExecCmd (mkdir);
+        ok = !ExecCmd (cmd);
+
+        free ((void*)mkdir);
+        free ((void*)dir);
+    }
+
+    free ((void*)gen_file);
+    free ((void*)cmd);
+
+    return ok;
+}
+
 #endif
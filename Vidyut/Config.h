@@ -23,8 +23,13 @@
 #    define BUILD_TMP_DIR BUILD_ROOT PATHSEP "tmp"
 #endif
 
+#ifndef BUILD_GEN_DIR
+#    define BUILD_GEN_DIR BUILD_ROOT PATHSEP "gen"
+#endif
+
 #ifndef GLOBAL_INCLUDE_DIRS
-#    define GLOBAL_INCLUDE_DIRS INCLUDE_DIR ("./Include") INCLUDE_DIR ("/usr/local/include")
+#    define GLOBAL_INCLUDE_DIRS                                                                    \
+        INCLUDE_DIR ("./Include") INCLUDE_DIR (BUILD_GEN_DIR) INCLUDE_DIR ("/usr/local/include")
 #endif
 
 #ifndef GLOBAL_LINK_DIRS
@@ -8,8 +8,11 @@
 #ifndef MISRA_SELFSTART_FILE_H
 #define MISRA_SELFSTART_FILE_H
 
+#include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include "Log.h"
@@ -19,6 +22,13 @@
 ///
 #define FILE_EXISTS(x) (access (x, F_OK) == 0)
 
+// stat keeps nanosecond timestamps under different names on different platforms
+#if __APPLE__
+#    define STAT_MTIM(st) ((st).st_mtimespec)
+#else
+#    define STAT_MTIM(st) ((st).st_mtim)
+#endif
+
 // Function to extract the directory from a given file path
 static inline const char *GetDirFromFilePath (const char *file_path) {
     if (!file_path) {
@@ -69,4 +79,92 @@ static inline void WriteToFile (const char *filename, const char *str) {
     fclose (file);
 }
 
+///
+/// Get last modification time of file in nanoseconds.
+///
+/// return modification time on success
+/// return -1 if file does not exist
+///
+static inline long long GetFileMtime (const char *filename) {
+    struct stat st;
+    if (!filename || stat (filename, &st)) {
+        return -1;
+    }
+
+    return (long long)STAT_MTIM (st).tv_sec * 1000000000LL + STAT_MTIM (st).tv_nsec;
+}
+
+///
+/// Read complete contents of a file into a newly allocated, null-terminated string.
+/// Caller must free returned string.
+///
+/// return file contents on success
+/// return NULL otherwise
+///
+static inline const char *ReadFromFile (const char *filename) {
+    if (!filename) {
+        LOG_ERROR ("Invalid arguments");
+        return NULL;
+    }
+
+    FILE *file = fopen (filename, "r");
+    if (!file) {
+        return NULL;
+    }
+
+    size_t cap = 4096;
+    size_t len = 0;
+    char  *buf = malloc (cap);
+    while (buf) {
+        len += fread (buf + len, 1, cap - len - 1, file);
+        if (len < cap - 1) {
+            break;
+        }
+
+        char *tmp = realloc (buf, cap *= 2);
+        if (!tmp) {
+            free (buf);
+        }
+        buf = tmp;
+    }
+    fclose (file);
+
+    if (buf) {
+        buf[len] = 0;
+    }
+
+    return buf;
+}
+
+///
+/// Iterate over file paths listed in a make style dependency file (eg: generated by `gcc -MMD`).
+/// Start with `*iter` pointing to dependency file contents.
+///
+/// iter[in,out] : Current position in dependency file contents.
+/// path[out]    : Next path is stored here.
+/// size[in]     : Size of `path` buffer.
+///
+/// return true if a path was read
+/// return false when there are no more paths
+///
+static inline bool NextDepPath (const char **iter, char *path, size_t size) {
+    while (**iter) {
+        const char *start  = *iter;
+        size_t      len    = strcspn (start, " \t\r\n\\");
+        *iter             += len;
+        if (**iter) {
+            (*iter)++;
+        }
+
+        /* skip line continuations and target name */
+        if (len && len < size && start[len - 1] != ':') {
+            memcpy (path, start, len);
+            path[len] = 0;
+            return true;
+        }
+    }
+
+    return false;
+}
+
 #endif
@@ -17,5 +17,6 @@
 
 #define NO_LIBRARIES NULL
 #define NO_FLAGS     NULL
+#define NO_INPUTS    NULL
 
 #endif
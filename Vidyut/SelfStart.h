@@ -25,23 +25,65 @@
 #define ADD_LIBRARY(lib_name, src_names, lib_names, cflags)                                        \
     ccj = AddLibrary (lib_name, src_names, lib_names, cflags, ccj)
 
+///
+/// Generate a file (usually a header in `BUILD_GEN_DIR`) with an executable
+/// added earlier in the build. Inputs are listed with `SOURCES`.
+///
+#define ADD_GENERATED_FILE(out_file, gen_name, input_names)                                        \
+    AddGeneratedFile (out_file, gen_name, input_names)
+
+///
+/// Pass `--watch` to keep build running, rebuilding whatever is affected when
+/// a source or header changes. Build system rebuilds itself when
+/// `BuildCommands.c` or `Vidyut` changes.
+///
 #define SELF_START(body)                                                                           \
     int main (int argc, char** argv, char** envp) {                                                \
         /* always rebuild self before starting */                                                  \
         RebuildSelf (argc, argv, envp);                                                            \
                                                                                                    \
-        /* start compile commands json string */                                                   \
-        const char* ccj = Appendf (NULL, "[", " ");                                                \
+        /* in watch mode, a failing command must not kill the build */                             \
+        bool watch        = HasArg (argc, argv, "--watch");                                        \
+        vidyut_keep_going = watch;                                                                 \
+        if (watch && !WatchInit ()) {                                                              \
+            return 1;                                                                              \
+        }                                                                                          \
+                                                                                                   \
+        while (true) {                                                                             \
+            vidyut_failed   = 0;                                                                   \
+            vidyut_nrebuilt = 0;                                                                   \
+                                                                                                   \
+            /* start compile commands json string */                                               \
+            const char* ccj = Appendf (NULL, "[", " ");                                            \
+                                                                                                   \
+            {body}                                                                                 \
+                                                                                                   \
+            /* end compile commands json */                                                        \
+            ccj = Appendf (ccj, "]");                                                              \
+                                                                                                   \
+            /* write to compile_commands.json */                                                   \
+            WriteToFile ("compile_commands.json", ccj);                                            \
+                                                                                                   \
+            free ((void*)ccj);                                                                     \
                                                                                                    \
-        {body}                                                                                     \
+            LOG_INFO (                                                                             \
+                "Build %s, %d object(s) rebuilt",                                                  \
+                vidyut_failed ? "failed" : "done",                                                 \
+                vidyut_nrebuilt                                                                    \
+            );                                                                                     \
                                                                                                    \
-        /* end compile commands json */                                                            \
-        ccj = Appendf (ccj, "]");                                                                  \
+            bool self_changed = false;                                                             \
+            if (!watch || !WaitForChanges (&self_changed)) {                                       \
+                break;                                                                             \
+            }                                                                                      \
                                                                                                    \
-        /* write to compile_commands.json */                                                       \
-        WriteToFile ("compile_commands.json", ccj);                                                \
+            /* returns only if build system failed to compile */                                   \
+            if (self_changed) {                                                                    \
+                RestartSelf (argc, argv, envp);                                                    \
+            }                                                                                      \
+        }                                                                                          \
                                                                                                    \
-        free ((void*)ccj);                                                                         \
+        return vidyut_failed;                                                                      \
     }
 
 #endif
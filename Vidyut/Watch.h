@@ -0,0 +1,158 @@
+/// file      : selfstart/watch.h
+/// author    : Siddharth Mishra (admin@brightprogrammer.in)
+/// copyright : Copyright (c) 2025, Siddharth Mishra, All rights reserved.
+///
+/// Watch mode for SelfStart. Directories of every source and header seen during
+/// a build are watched with `Misra/Std/Watch.h`, and build is run again when any
+/// of them change.
+///
+
+#ifndef MISRA_SELFSTART_WATCH_H
+#define MISRA_SELFSTART_WATCH_H
+
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "../Include/Misra/Std/Watch.h"
+#include "File.h"
+#include "Log.h"
+
+#ifndef WATCH_DEBOUNCE_MS
+#    define WATCH_DEBOUNCE_MS 100
+#endif
+
+/// Directories being watched, `fd` is -1 when not in watch mode.
+static Watcher vidyut_watcher = {.fd = -1};
+
+///
+/// Check whether given argument was passed on command line.
+///
+static inline bool HasArg (int argc, char **argv, const char *arg) {
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp (argv[i], arg)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+///
+/// Start watch mode. Build files are always watched, so that build system
+/// can rebuild itself on change. Fails where inotify isn't available.
+///
+/// return true on success
+/// return false otherwise
+///
+static inline bool WatchInit (void) {
+    if (!WatcherInit (&vidyut_watcher, WATCH_DEBOUNCE_MS)) {
+        if (errno == ENOSYS) {
+            LOG_ERROR ("--watch is not supported on this platform");
+        } else {
+            LOG_ERROR ("inotify_init1() failed : %s", strerror (errno));
+        }
+        return false;
+    }
+
+    WatcherAddDir (&vidyut_watcher, ".", false);
+    WatcherAddDir (&vidyut_watcher, "Vidyut", false);
+    WatcherAddDir (&vidyut_watcher, "Include/Misra/Std", false);
+
+    return true;
+}
+
+///
+/// Watch directory containing given file. Does nothing when not in watch mode.
+/// Watching same directory twice is fine, inotify merges them.
+///
+static inline void WatchFileDir (const char *file_path) {
+    if (vidyut_watcher.fd < 0 || !file_path) {
+        return;
+    }
+
+    const char *dir = GetDirFromFilePath (file_path);
+    if (dir && !WatcherAddDir (&vidyut_watcher, dir, false)) {
+        LOG_WARN ("failed to watch \"%s\" : %s", dir, strerror (errno));
+    }
+    free ((void *)dir);
+}
+
+///
+/// Watch all files listed in a make style dependency file generated by `gcc -MMD`.
+///
+static inline void WatchDepFile (const char *dep_file) {
+    if (vidyut_watcher.fd < 0) {
+        return;
+    }
+
+    const char *deps = ReadFromFile (dep_file);
+    if (!deps) {
+        return;
+    }
+
+    const char *iter = deps;
+    char        path[4096];
+    while (NextDepPath (&iter, path, sizeof (path))) {
+        WatchFileDir (path);
+    }
+
+    free ((void *)deps);
+}
+
+static inline bool is_source_file (const char *name) {
+    size_t len = strlen (name);
+    return len > 2 && name[len - 2] == '.' && (name[len - 1] == 'c' || name[len - 1] == 'h');
+}
+
+/// Build files are watched first by `WatchInit`, so their paths are spelled as below.
+static inline bool is_build_file (const char *path) {
+    return !strncmp (path, "Vidyut/", 7) || !strcmp (path, "./BuildCommands.c") ||
+           !strcmp (path, "Include/Misra/Std/Watch.h");
+}
+
+///
+/// Block till a source or header file in any of the watched directories changes.
+/// After first change, keep collecting changes till none arrive for
+/// `WATCH_DEBOUNCE_MS`, so a burst of writes results in a single rebuild.
+///
+/// self_changed[out] : Set to true if build system itself changed.
+///
+/// return true on change
+/// return false on error
+///
+static inline bool WaitForChanges (bool *self_changed) {
+    if (vidyut_watcher.fd < 0 || !self_changed) {
+        LOG_ERROR ("Invalid arguments");
+        return false;
+    }
+
+    WatchChanges changes = {0};
+    bool         changed = false;
+
+    LOG_INFO ("Watching for changes...");
+
+    /* changes to build outputs, editor swap files etc... are not worth a rebuild */
+    while (!changed) {
+        if (!WatcherWait (&vidyut_watcher, &changes, -1)) {
+            LOG_ERROR ("failed to wait for changes : %s", strerror (errno));
+            WatchChangesDeinit (&changes);
+            return false;
+        }
+
+        /* events dropped, rebuild everything to be safe */
+        changed       = changes.overflow;
+        *self_changed = changes.overflow;
+
+        for (size_t i = 0; i < changes.length; i++) {
+            if (is_source_file (changes.paths[i])) {
+                changed       = true;
+                *self_changed = *self_changed || is_build_file (changes.paths[i]);
+            }
+        }
+    }
+
+    WatchChangesDeinit (&changes);
+    return true;
+}
+
+#endif